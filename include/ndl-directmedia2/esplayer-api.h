@@ -75,6 +75,34 @@ extern "C" {
      */
     int NDL_EsplayerLoadEx(NDL_EsplayerHandle player, NDL_ESP_META_DATA* meta, NDL_ESP_PTS_UNITS units);
 
+    /**
+     * Load the resources based on meta data, with the pts timebase of each stream
+     * (NDL_EsplayerLoadEx is 1/90000 or 1/1000000 in 33 bits for both).
+     * The pts given to NDL_EsplayerFeedData are in ticks of the timebase, the secondary audio
+     * has the timebase of the audio.
+     *
+     * @param meta  esplayer configuration data, such as stream information
+     * @param audio timebase of the audio pts, NULL for 1/90000 in 33 bits
+     * @param video timebase of the video pts, NULL for 1/90000 in 33 bits
+     * @return      0 on success
+     */
+    int NDL_EsplayerLoadWithTimebase(NDL_EsplayerHandle player, NDL_ESP_META_DATA* meta,
+            const NDL_ESP_PTS_TIMEBASE* audio, const NDL_ESP_PTS_TIMEBASE* video);
+
+    /**
+     * NDL_EsplayerLoadWithTimebase with the stream formats not in NDL_ESP_META_DATA
+     * (LPCM layout, byte stream feeding). The other loads take the default formats.
+     * The LPCM layout also applies to the secondary audio and the audio tracks added after.
+     *
+     * @param meta   esplayer configuration data, such as stream information
+     * @param format size set to sizeof(NDL_ESP_META_FORMAT), NULL for the default formats
+     * @param audio  timebase of the audio pts, NULL for 1/90000 in 33 bits
+     * @param video  timebase of the video pts, NULL for 1/90000 in 33 bits
+     * @return       0 on success, NDL_ESP_RESULT_FAIL for a size or a format it does not know
+     */
+    int NDL_EsplayerLoadWithFormat(NDL_EsplayerHandle player, NDL_ESP_META_DATA* meta,
+            const NDL_ESP_META_FORMAT* format, const NDL_ESP_PTS_TIMEBASE* audio, const NDL_ESP_PTS_TIMEBASE* video);
+
     /**
      * Unload the resources
      * @return      0 on success
@@ -119,6 +147,15 @@ extern "C" {
      */
     int NDL_EsplayerFlush(NDL_EsplayerHandle player);
 
+    /**
+     * Flush the steam buffer with flush mode.
+     * NDL_ESP_FLUSH_FAST is for seek, it reduces the time to the first frame presented.
+     *
+     * @param mode  flush mode (normal or fast)
+     * @return      0 on success
+     */
+    int NDL_EsplayerFlushEx(NDL_EsplayerHandle player, NDL_ESP_FLUSH_MODE mode);
+
     /**
      * Get audio/video decoder buffer level.
      * @param type  stream type (audio or video)
@@ -126,6 +163,16 @@ extern "C" {
      */
     int NDL_EsplayerGetBufferLevel(NDL_EsplayerHandle player, NDL_ESP_STREAM_T type, uint32_t * level);
 
+    /**
+     * Get OMX call latency statistics, one line per component.
+     * Statistics are collected only if NDL_OMX_STATS=1 is set in the environment.
+     *
+     * @param buf         OUT    summary text (truncated to buf_len)
+     * @param buf_len     IN     allocated buffer length
+     * @return            0 on success, -1 if statistics are disabled
+     */
+    int NDL_EsplayerGetOmxStats(NDL_EsplayerHandle player, char* buf, size_t buf_len);
+
     /**
      * Get the esplayer state.
      */
@@ -133,11 +180,22 @@ extern "C" {
 
     /**
      * Get the esplayer current media time.
+     * Interpolated from the last rendered frames when the clock cannot read it back,
+     * lock-free to be polled at a high rate.
+     * @param start_time  OUT    first pts rendered after load or flush (us)
+     * @param current_time OUT   media time of now (us)
+     * @return            0 on success, -1 before the first frame is rendered
      */
     int NDL_EsplayerGetMediatime(NDL_EsplayerHandle player, int64_t* start_time, int64_t* current_time);
 
     /**
      * Set playback rate.
+     *   0 ~ 2000 (2x) : audio and video played by the clock
+     *   2000 ~ 32000 and -32000 ~ -1 : I-frame trick play, only the key frames of the video are decoded
+     *     (found in H.264/HEVC, NDL_ESP_FLAG_KEY_FRAME set by the client for the other codecs)
+     *     and shown at the interval of the rate, audio is dropped. For negative rates the GOPs are fed
+     *     in reverse order. Flush and feed from the new position when entering or leaving it.
+     *     It fails for the other codecs until a frame tagged NDL_ESP_FLAG_KEY_FRAME is fed after load.
      *
      * @return      0 on success
      */
@@ -218,6 +276,82 @@ extern "C" {
      */
     int NDL_EsplayerSetVolume(NDL_EsplayerHandle player, int volume, int duration, NDL_ESP_EASE_TYPE type);
 
+    /**
+     * Load the decoder of a secondary audio ES (audio description, commentary) after NDL_EsplayerLoad.
+     * Its frames are fed as NDL_ESP_AUDIO_SECONDARY_ES and mixed into the main audio at their PTS.
+     *
+     * @param meta  audio_codec and the audio config of the secondary ES, NDL_ESP_AUDIO_NONE to remove it
+     * @return      0 on success
+     */
+    int NDL_EsplayerLoadSecondaryAudio(NDL_EsplayerHandle player, NDL_ESP_META_DATA* meta);
+
+    /**
+     * Set the mix of the secondary audio ES
+     * @param volume     level of the secondary audio(0-100)
+     * @param ducking    level of the main audio while the secondary audio is playing(0-100), 100 for no ducking
+     * @return    0 on success
+     */
+    int NDL_EsplayerSetSecondaryAudioMix(NDL_EsplayerHandle player, int volume, int ducking);
+
+    /**
+     * Register an alternate audio ES (ex. another language) after NDL_EsplayerLoad.
+     * It is decoded in standby a short window ahead of the main audio (NDL_AUDIO_STANDBY_MS),
+     * so that NDL_EsplayerSelectAudioTrack switches to it without reload or flush.
+     * Streams with PTS only (audio with video).
+     *
+     * @param meta  audio_codec and the audio config of the alternate ES
+     * @return      track id (> 0), < 0 on failure
+     */
+    int NDL_EsplayerAddAudioTrack(NDL_EsplayerHandle player, NDL_ESP_META_DATA* meta);
+
+    /**
+     * Remove an alternate audio track, the main audio is output if it was selected
+     * @return      0 on success
+     */
+    int NDL_EsplayerRemoveAudioTrack(NDL_EsplayerHandle player, int track);
+
+    /**
+     * Write one frame of an alternate audio track, fed alongside the frames of the main audio
+     * @return      the number of bytes written
+     *              NDL_ESP_RESULT_FEED_FULL means the standby window of the track is full
+     */
+    int NDL_EsplayerFeedAudioTrack(NDL_EsplayerHandle player, int track, NDL_EsplayerBuffer buff);
+
+    /**
+     * Output an alternate audio track from its PTS following the audio written so far
+     * @param track    track id, 0 for the main audio
+     * @return         0 on success
+     */
+    int NDL_EsplayerSelectAudioTrack(NDL_EsplayerHandle player, int track);
+
+    /**
+     * Get the memory and decoding cost of the standby audio tracks, one line per track
+     * @param buf         OUT    summary text (truncated to buf_len)
+     * @param buf_len     IN     allocated buffer length
+     * @return            0 on success
+     */
+    int NDL_EsplayerGetAudioTrackStats(NDL_EsplayerHandle player, char* buf, size_t buf_len);
+
+    /**
+     * Get the counts of the video frames dropped or decoded without display when the video is late.
+     * Non-reference frames are dropped before the decoder, reference frames are decoded only
+     * when dropping those did not catch up.
+     * @param stats       OUT    counts since load
+     * @return            0 on success
+     */
+    int NDL_EsplayerGetVideoDropStats(NDL_EsplayerHandle player, NDL_ESP_VIDEO_DROP_STATS* stats);
+
+    /**
+     * Get the A/V offset of the presented frames, its drift and the correction in place,
+     * and the clock drift of the audio renderer with the stretch of the software audio.
+     * The A/V offset is measured only in the non-tunnel build (OMX_NONE_TUNNEL), on the render events
+     * with the pts of both streams. In the tunneled pipeline the clock component presents the video
+     * on the audio clock, the offset fields stay 0 and late video is dropped on the fed pts.
+     * @param stats       OUT    offset, drift and delay now, counts since load
+     * @return            0 on success
+     */
+    int NDL_EsplayerGetAvSyncStats(NDL_EsplayerHandle player, NDL_ESP_AV_SYNC_STATS* stats);
+
 #ifdef __cplusplus
 }
 #endif
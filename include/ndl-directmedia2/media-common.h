@@ -31,6 +31,30 @@ typedef enum {
     NDL_ESP_PTS_MICROSECS,
 } NDL_ESP_PTS_UNITS;
 
+/**
+ * PTS timebase of a stream : 1 tick = num/den second (ex. 1/90000, 1/1000, 1/48000, 1001/30000)
+ * counted in wrap_bits bits going back to 0 (33 for MPEG-2 TS, 0 for a pts which does not wrap, max 62)
+ */
+typedef struct {
+    uint32_t num;
+    uint32_t den;
+    uint32_t wrap_bits;
+} NDL_ESP_PTS_TIMEBASE;
+
+/**
+ * Flush Mode
+ *
+ * NDL_ESP_FLUSH_NORMAL
+ *  pause all the components and flush each port one by one
+ *
+ * NDL_ESP_FLUSH_FAST
+ *  for seek. flush all the ports at once and skip pause if the components allow it
+ */
+typedef enum {
+    NDL_ESP_FLUSH_NORMAL,
+    NDL_ESP_FLUSH_FAST,
+} NDL_ESP_FLUSH_MODE;
+
 /**
  * The stream buffer format.
  */
@@ -69,7 +93,7 @@ typedef struct {
     uint32_t width;
     uint32_t video_encoding;
     uint32_t height;
-    void*    extradata;
+    void*    extradata;     // avcC/hvcC : NDL_ESP_VIDEO_FRAMED frames with NAL lengths, fed in Annex-B
     uint32_t extrasize;
 
     /* config for audio */
@@ -80,6 +104,59 @@ typedef struct {
     uint32_t bitspersample;
 } NDL_ESP_META_DATA;
 
+/**
+ * Stream formats beyond NDL_ESP_META_DATA, given to NDL_EsplayerLoadWithFormat.
+ * NDL_ESP_META_DATA keeps its layout for the binaries built with it, the formats added later go here.
+ * size is sizeof(NDL_ESP_META_FORMAT) the caller is built with, the fields after it keep their default (0).
+ */
+typedef struct {
+    uint32_t size;
+
+    /**
+     * config for NDL_ESP_AUDIO_CODEC_LPCM, with channels, samplerate and bitspersample (16, 20, 24, 32) of the meta data.
+     * blockalign is the bytes of one sample of all channels, 0 if the samples are in the smallest bytes holding bitspersample.
+     */
+    uint32_t pcm_flags;             // NDL_ESP_PCM_FLAG
+    uint8_t  pcm_channel_map[8];    // input channel of each output channel in WAVE order, all 0 for the same order
+
+    /**
+     * NDL_ESP_AUDIO_BYTESTREAM : the pts of a buffer is the one of the first frame starting in it,
+     * the following frames continue from it.
+     */
+    NDL_ESP_AUDIO_FRAMING audio_framing;
+
+    /**
+     * NDL_ESP_VIDEO_BYTESTREAM : as audio_framing, the pts of a buffer is the one of the first access unit
+     * starting in it. The access units are tagged with NDL_ESP_FLAG_KEY_FRAME and NDL_ESP_FLAG_NON_REFERENCE.
+     */
+    NDL_ESP_VIDEO_FRAMING video_framing;
+} NDL_ESP_META_FORMAT;
+
+/**
+ * Video frames not displayed to catch up with the audio since load, by frame type
+ */
+typedef struct {
+    uint32_t dropped_non_reference;   // not given to the decoder
+    uint32_t decode_only_key;         // decoded for the frames referring to them, not displayed
+    uint32_t decode_only_reference;
+    uint32_t decode_only_unknown;     // no frame type (codec without a splitter, frames not tagged by the client)
+} NDL_ESP_VIDEO_DROP_STATS;
+
+/**
+ * A/V sync measured on the presented frames : the pts of each video frame rendered
+ * against the audio position at that time
+ */
+typedef struct {
+    int64_t offset_us;          // video - audio, filtered, positive if the video is ahead
+    int64_t video_delay_us;     // added to the video pts to hold the video back
+    int32_t drift_ppm;          // change of the offset (without the delay) per second, in ppm
+    uint32_t measurements;      // video frames measured against the audio since load
+    uint32_t corrections;       // times the offset went out of the tolerance since load
+    uint32_t locked;            // 1 if the offset is in the tolerance now
+    int32_t audio_drift_ppm;    // audio renderer against the system clock, positive if it plays fast
+    int32_t audio_correction_ppm; // stretch of the software audio for the drift, 0 without the compensation
+} NDL_ESP_AV_SYNC_STATS;
+
 /**
  * The notification events that the callback function should handle.
  *
@@ -110,6 +187,10 @@ typedef enum {
 } NDL_ESP_EVENT;
 
 #define NDL_ESP_FLAG_END_OF_STREAM 1
+// video frame decodable alone : IDR (H.264), IRAP (HEVC)
+#define NDL_ESP_FLAG_KEY_FRAME     2
+// video frame no other frame refers to, it can be dropped
+#define NDL_ESP_FLAG_NON_REFERENCE 4
 
 // TODO : Need to be added more error type.
 #define NDL_ESP_RESULT_SUCCESS      0
@@ -32,6 +32,7 @@ extern "C" {
     typedef enum {
         NDL_ESP_AUDIO_ES,
         NDL_ESP_VIDEO_ES,
+        NDL_ESP_AUDIO_SECONDARY_ES,   // audio description or commentary mixed into NDL_ESP_AUDIO_ES
     } NDL_ESP_STREAM_T;
 
     /**
@@ -65,8 +66,34 @@ extern "C" {
         NDL_ESP_AUDIO_CODEC_HEAAC,
         NDL_ESP_AUDIO_CODEC_PCM_44100_2CH,  // 16bit only
         NDL_ESP_AUDIO_CODEC_PCM_48000_2CH,  // 16bit only
+        NDL_ESP_AUDIO_CODEC_LPCM,           // format in NDL_ESP_META_DATA and NDL_ESP_META_FORMAT
     } NDL_ESP_AUDIO_CODEC;
 
+    /**
+     * NDL_ESP_AUDIO_CODEC_LPCM sample format flags
+     */
+    typedef enum {
+        NDL_ESP_PCM_FLAG_BIG_ENDIAN = 0x1,  // little endian if not set
+    } NDL_ESP_PCM_FLAG;
+
+    /**
+     * how the audio ES is cut into NDL_EsplayerFeedData calls
+     */
+    typedef enum {
+        NDL_ESP_AUDIO_FRAMED,       // one frame per buffer
+        NDL_ESP_AUDIO_BYTESTREAM,   // chunks of any size (ex. from a TS demuxer), split into frames at the sync words :
+                                    // ADTS for AAC, LOAS/LATM for HEAAC, AC3/EAC3 and MPEG audio sync frames
+    } NDL_ESP_AUDIO_FRAMING;
+
+    /**
+     * how the video ES is cut into NDL_EsplayerFeedData calls
+     */
+    typedef enum {
+        NDL_ESP_VIDEO_FRAMED,       // one access unit per buffer
+        NDL_ESP_VIDEO_BYTESTREAM,   // Annex-B chunks of any size, split into access units at the start codes :
+                                    // H.264 and HEVC
+    } NDL_ESP_VIDEO_FRAMING;
+
     /**
      * scan type
      */
@@ -0,0 +1,843 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#if defined(__GNUC__)
+#include <immintrin.h>
+#define AUDIO_CONVERT_HAVE_AVX2 1
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define AUDIO_CONVERT_HAVE_NEON 1
+#endif
+
+#include "audioconvert.h"
+
+using namespace NDL_Esplayer;
+
+#define LOGTAG "audioconvert"
+#include "debug.h"
+
+// samples per channel converted at once before interleaving, stays in L1
+#define CONVERT_BLOCK_SAMPLES 256
+
+namespace {
+
+    /**
+     * Reference kernels, also the tail of the SIMD ones.
+     * Same arithmetic as libswresample : lrintf(x * 32768) clipped, and s32 >> 16
+     */
+    struct ScalarKernels {
+        static void floatToS16(const float* src, int16_t* dst, int count) {
+            for (int i = 0; i < count; i++) {
+                float scaled = src[i] * 32768.0f;
+                // clip before rounding, lrintf of out of range values is undefined
+                if (scaled >= 32767.0f)
+                    dst[i] = 32767;
+                else if (scaled <= -32768.0f)
+                    dst[i] = -32768;
+                else
+                    dst[i] = (int16_t)lrintf(scaled);
+            }
+        }
+
+        static void s32ToS16(const int32_t* src, int16_t* dst, int count) {
+            for (int i = 0; i < count; i++)
+                dst[i] = (int16_t)(src[i] >> 16);
+        }
+
+        static void mulAdd(const float* src, float gain, float* acc, int count) {
+            for (int i = 0; i < count; i++)
+                acc[i] += src[i] * gain;
+        }
+
+        static void copyS16(const int16_t* src, int16_t* dst, int count) {
+            memcpy(dst, src, count * sizeof(int16_t));
+        }
+
+        static int16_t gainSample(int16_t sample, float gain) {
+            float scaled = sample * gain;
+            if (scaled >= 32767.0f)
+                return 32767;
+            if (scaled <= -32768.0f)
+                return -32768;
+            return (int16_t)lrintf(scaled);
+        }
+
+        static void gainS16(int16_t* samples, float gain, int count) {
+            for (int i = 0; i < count; i++)
+                samples[i] = gainSample(samples[i], gain);
+        }
+
+        static void rampS16(int16_t* samples, const float* gains, int count) {
+            for (int i = 0; i < count; i++)
+                samples[i] = gainSample(samples[i], gains[i]);
+        }
+
+        static void mixS16(int16_t* dst, const int16_t* src, float gain, int count) {
+            for (int i = 0; i < count; i++) {
+                int sum = dst[i] + gainSample(src[i], gain);
+                dst[i] = (int16_t)std::min(std::max(sum, -32768), 32767);
+            }
+        }
+
+        // upper 16 bits of each container, the lower bits are cut like s32ToS16
+        static void lpcmToS16(const uint8_t* src, int container, bool big_endian, int16_t* dst, int count) {
+            const int hi = big_endian ? 0 : container - 1;
+            const int lo = big_endian ? 1 : container - 2;
+            for (int i = 0; i < count; i++, src += container)
+                dst[i] = (int16_t)((src[hi] << 8) | src[lo]);
+        }
+
+        static void interleave2(const int16_t* left, const int16_t* right, int16_t* dst, int count) {
+            for (int i = 0; i < count; i++) {
+                dst[2 * i] = left[i];
+                dst[2 * i + 1] = right[i];
+            }
+        }
+    };
+
+#if defined(__SSE2__)
+    struct Sse2Kernels {
+        static void floatToS16(const float* src, int16_t* dst, int count) {
+            const __m128 scale = _mm_set1_ps(32768.0f);
+            const __m128 max = _mm_set1_ps(32767.0f);
+            int i = 0;
+            for (; i + 8 <= count; i += 8) {
+                // cvtps2dq gives INT_MIN on overflow : clip above, packs saturates the rest
+                __m128 a = _mm_min_ps(_mm_mul_ps(_mm_loadu_ps(src + i), scale), max);
+                __m128 b = _mm_min_ps(_mm_mul_ps(_mm_loadu_ps(src + i + 4), scale), max);
+                _mm_storeu_si128((__m128i*)(dst + i),
+                        _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+            }
+            ScalarKernels::floatToS16(src + i, dst + i, count - i);
+        }
+
+        static void s32ToS16(const int32_t* src, int16_t* dst, int count) {
+            int i = 0;
+            for (; i + 8 <= count; i += 8) {
+                __m128i a = _mm_srai_epi32(_mm_loadu_si128((const __m128i*)(src + i)), 16);
+                __m128i b = _mm_srai_epi32(_mm_loadu_si128((const __m128i*)(src + i + 4)), 16);
+                _mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(a, b));
+            }
+            ScalarKernels::s32ToS16(src + i, dst + i, count - i);
+        }
+
+        static void mulAdd(const float* src, float gain, float* acc, int count) {
+            const __m128 g = _mm_set1_ps(gain);
+            int i = 0;
+            for (; i + 4 <= count; i += 4)
+                _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_mul_ps(_mm_loadu_ps(src + i), g)));
+            ScalarKernels::mulAdd(src + i, gain, acc + i, count - i);
+        }
+
+        static void interleave2(const int16_t* left, const int16_t* right, int16_t* dst, int count) {
+            int i = 0;
+            for (; i + 8 <= count; i += 8) {
+                __m128i l = _mm_loadu_si128((const __m128i*)(left + i));
+                __m128i r = _mm_loadu_si128((const __m128i*)(right + i));
+                _mm_storeu_si128((__m128i*)(dst + 2 * i), _mm_unpacklo_epi16(l, r));
+                _mm_storeu_si128((__m128i*)(dst + 2 * i + 8), _mm_unpackhi_epi16(l, r));
+            }
+            ScalarKernels::interleave2(left + i, right + i, dst + 2 * i, count - i);
+        }
+
+        // 8 samples widened to float, scaled, rounded and packed back with saturation
+        static __m128i gain8(__m128i s, __m128 gain_lo, __m128 gain_hi) {
+            const __m128 max = _mm_set1_ps(32767.0f);
+            __m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16));
+            __m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16));
+            lo = _mm_min_ps(_mm_mul_ps(lo, gain_lo), max);
+            hi = _mm_min_ps(_mm_mul_ps(hi, gain_hi), max);
+            return _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi));
+        }
+
+        static void gainS16(int16_t* samples, float gain, int count) {
+            const __m128 g = _mm_set1_ps(gain);
+            int i = 0;
+            for (; i + 8 <= count; i += 8) {
+                __m128i* p = (__m128i*)(samples + i);
+                _mm_storeu_si128(p, gain8(_mm_loadu_si128(p), g, g));
+            }
+            ScalarKernels::gainS16(samples + i, gain, count - i);
+        }
+
+        static void rampS16(int16_t* samples, const float* gains, int count) {
+            int i = 0;
+            for (; i + 8 <= count; i += 8) {
+                __m128i* p = (__m128i*)(samples + i);
+                _mm_storeu_si128(p, gain8(_mm_loadu_si128(p), _mm_loadu_ps(gains + i), _mm_loadu_ps(gains + i + 4)));
+            }
+            ScalarKernels::rampS16(samples + i, gains + i, count - i);
+        }
+
+        static void mixS16(int16_t* dst, const int16_t* src, float gain, int count) {
+            const __m128 g = _mm_set1_ps(gain);
+            int i = 0;
+            for (; i + 8 <= count; i += 8) {
+                __m128i* p = (__m128i*)(dst + i);
+                __m128i scaled = gain8(_mm_loadu_si128((const __m128i*)(src + i)), g, g);
+                _mm_storeu_si128(p, _mm_adds_epi16(_mm_loadu_si128(p), scaled));
+            }
+            ScalarKernels::mixS16(dst + i, src + i, gain, count - i);
+        }
+
+        static void lpcmToS16(const uint8_t* src, int container, bool big_endian, int16_t* dst, int count) {
+            int i = 0;
+            if (container == 2 && !big_endian) {
+                memcpy(dst, src, count * sizeof(int16_t));
+                return;
+            }
+            if (container == 2) {
+                for (; i + 8 <= count; i += 8) {
+                    __m128i x = _mm_loadu_si128((const __m128i*)(src + 2 * i));
+                    _mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8)));
+                }
+            } else if (container == 4) {
+                const __m128i byte1 = _mm_set1_epi32(0x00FF0000);
+                for (; i + 8 <= count; i += 8) {
+                    __m128i a = _mm_loadu_si128((const __m128i*)(src + 4 * i));
+                    __m128i b = _mm_loadu_si128((const __m128i*)(src + 4 * i + 16));
+                    if (big_endian) {
+                        // first two bytes to the top of the lane
+                        a = _mm_or_si128(_mm_slli_epi32(a, 24), _mm_and_si128(_mm_slli_epi32(a, 8), byte1));
+                        b = _mm_or_si128(_mm_slli_epi32(b, 24), _mm_and_si128(_mm_slli_epi32(b, 8), byte1));
+                    }
+                    _mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(_mm_srai_epi32(a, 16), _mm_srai_epi32(b, 16)));
+                }
+            }
+            // 24bit containers need a byte shuffle : ssse3 in the avx2 kernels
+            ScalarKernels::lpcmToS16(src + (size_t)i * container, container, big_endian, dst + i, count - i);
+        }
+    };
+#endif
+
+#if defined(AUDIO_CONVERT_HAVE_AVX2)
+    // built for any x86 target, only selected when the cpu reports avx2
+    struct Avx2Kernels {
+        __attribute__((target("avx2")))
+        static void floatToS16(const float* src, int16_t* dst, int count) {
+            const __m256 scale = _mm256_set1_ps(32768.0f);
+            const __m256 max = _mm256_set1_ps(32767.0f);
+            int i = 0;
+            for (; i + 16 <= count; i += 16) {
+                __m256 a = _mm256_min_ps(_mm256_mul_ps(_mm256_loadu_ps(src + i), scale), max);
+                __m256 b = _mm256_min_ps(_mm256_mul_ps(_mm256_loadu_ps(src + i + 8), scale), max);
+                // packs works per 128bit lane : a0 b0 a1 b1 -> a0 a1 b0 b1
+                __m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+                _mm256_storeu_si256((__m256i*)(dst + i), _mm256_permute4x64_epi64(packed, 0xD8));
+            }
+            Sse2Kernels::floatToS16(src + i, dst + i, count - i);
+        }
+
+        __attribute__((target("avx2")))
+        static void s32ToS16(const int32_t* src, int16_t* dst, int count) {
+            int i = 0;
+            for (; i + 16 <= count; i += 16) {
+                __m256i a = _mm256_srai_epi32(_mm256_loadu_si256((const __m256i*)(src + i)), 16);
+                __m256i b = _mm256_srai_epi32(_mm256_loadu_si256((const __m256i*)(src + i + 8)), 16);
+                _mm256_storeu_si256((__m256i*)(dst + i),
+                        _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8));
+            }
+            Sse2Kernels::s32ToS16(src + i, dst + i, count - i);
+        }
+
+        __attribute__((target("avx2")))
+        static void mulAdd(const float* src, float gain, float* acc, int count) {
+            const __m256 g = _mm256_set1_ps(gain);
+            int i = 0;
+            for (; i + 8 <= count; i += 8) {
+                _mm256_storeu_ps(acc + i,
+                        _mm256_add_ps(_mm256_loadu_ps(acc + i), _mm256_mul_ps(_mm256_loadu_ps(src + i), g)));
+            }
+            Sse2Kernels::mulAdd(src + i, gain, acc + i, count - i);
+        }
+
+        static void interleave2(const int16_t* left, const int16_t* right, int16_t* dst, int count) {
+            Sse2Kernels::interleave2(left, right, dst, count);
+        }
+
+        __attribute__((target("avx2")))
+        static __m256i gain16(const int16_t* src, __m256 gain_a, __m256 gain_b) {
+            const __m256 max = _mm256_set1_ps(32767.0f);
+            __m256 a = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)src)));
+            __m256 b = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(src + 8))));
+            a = _mm256_min_ps(_mm256_mul_ps(a, gain_a), max);
+            b = _mm256_min_ps(_mm256_mul_ps(b, gain_b), max);
+            return _mm256_permute4x64_epi64(_mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b)), 0xD8);
+        }
+
+        __attribute__((target("avx2")))
+        static void gainS16(int16_t* samples, float gain, int count) {
+            const __m256 g = _mm256_set1_ps(gain);
+            int i = 0;
+            for (; i + 16 <= count; i += 16)
+                _mm256_storeu_si256((__m256i*)(samples + i), gain16(samples + i, g, g));
+            Sse2Kernels::gainS16(samples + i, gain, count - i);
+        }
+
+        __attribute__((target("avx2")))
+        static void rampS16(int16_t* samples, const float* gains, int count) {
+            int i = 0;
+            for (; i + 16 <= count; i += 16) {
+                _mm256_storeu_si256((__m256i*)(samples + i),
+                        gain16(samples + i, _mm256_loadu_ps(gains + i), _mm256_loadu_ps(gains + i + 8)));
+            }
+            Sse2Kernels::rampS16(samples + i, gains + i, count - i);
+        }
+
+        __attribute__((target("avx2")))
+        static void mixS16(int16_t* dst, const int16_t* src, float gain, int count) {
+            const __m256 g = _mm256_set1_ps(gain);
+            int i = 0;
+            for (; i + 16 <= count; i += 16) {
+                __m256i* p = (__m256i*)(dst + i);
+                _mm256_storeu_si256(p, _mm256_adds_epi16(_mm256_loadu_si256(p), gain16(src + i, g, g)));
+            }
+            Sse2Kernels::mixS16(dst + i, src + i, gain, count - i);
+        }
+
+        __attribute__((target("avx2")))
+        static void lpcmToS16(const uint8_t* src, int container, bool big_endian, int16_t* dst, int count) {
+            if (container != 3) {
+                Sse2Kernels::lpcmToS16(src, container, big_endian, dst, count);
+                return;
+            }
+            // upper two bytes of 4 samples (12 bytes) into the low 8 bytes
+            const __m128i shuffle = big_endian ?
+                _mm_setr_epi8(1, 0, 4, 3, 7, 6, 10, 9, -1, -1, -1, -1, -1, -1, -1, -1) :
+                _mm_setr_epi8(1, 2, 4, 5, 7, 8, 10, 11, -1, -1, -1, -1, -1, -1, -1, -1);
+            int i = 0;
+            // the second load reads 4 bytes past its samples
+            for (; i + 10 <= count; i += 8) {
+                __m128i a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + 3 * i)), shuffle);
+                __m128i b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + 3 * i + 12)), shuffle);
+                _mm_storeu_si128((__m128i*)(dst + i), _mm_unpacklo_epi64(a, b));
+            }
+            ScalarKernels::lpcmToS16(src + (size_t)i * 3, 3, big_endian, dst + i, count - i);
+        }
+    };
+#endif
+
+#if defined(AUDIO_CONVERT_HAVE_NEON)
+    struct NeonKernels {
+        static void floatToS16(const float* src, int16_t* dst, int count) {
+            const float32x4_t scale = vdupq_n_f32(32768.0f);
+            const float32x4_t min = vdupq_n_f32(-32768.0f);
+            const float32x4_t max = vdupq_n_f32(32767.0f);
+            // 1.5 * 2^23 : adding it rounds to nearest even like lrintf, |x| < 2^22 after the clip
+            const float32x4_t magic = vdupq_n_f32(12582912.0f);
+            const int32x4_t magic_bits = vreinterpretq_s32_f32(magic);
+            int i = 0;
+            for (; i + 8 <= count; i += 8) {
+                float32x4_t a = vminq_f32(vmaxq_f32(vmulq_f32(vld1q_f32(src + i), scale), min), max);
+                float32x4_t b = vminq_f32(vmaxq_f32(vmulq_f32(vld1q_f32(src + i + 4), scale), min), max);
+                int32x4_t ia = vsubq_s32(vreinterpretq_s32_f32(vaddq_f32(a, magic)), magic_bits);
+                int32x4_t ib = vsubq_s32(vreinterpretq_s32_f32(vaddq_f32(b, magic)), magic_bits);
+                vst1q_s16(dst + i, vcombine_s16(vmovn_s32(ia), vmovn_s32(ib)));
+            }
+            ScalarKernels::floatToS16(src + i, dst + i, count - i);
+        }
+
+        static void s32ToS16(const int32_t* src, int16_t* dst, int count) {
+            int i = 0;
+            for (; i + 8 <= count; i += 8) {
+                vst1q_s16(dst + i, vcombine_s16(vshrn_n_s32(vld1q_s32(src + i), 16),
+                            vshrn_n_s32(vld1q_s32(src + i + 4), 16)));
+            }
+            ScalarKernels::s32ToS16(src + i, dst + i, count - i);
+        }
+
+        static void mulAdd(const float* src, float gain, float* acc, int count) {
+            int i = 0;
+            for (; i + 4 <= count; i += 4)
+                vst1q_f32(acc + i, vaddq_f32(vld1q_f32(acc + i), vmulq_n_f32(vld1q_f32(src + i), gain)));
+            ScalarKernels::mulAdd(src + i, gain, acc + i, count - i);
+        }
+
+        static void interleave2(const int16_t* left, const int16_t* right, int16_t* dst, int count) {
+            int i = 0;
+            for (; i + 8 <= count; i += 8) {
+                int16x8x2_t lr = { { vld1q_s16(left + i), vld1q_s16(right + i) } };
+                vst2q_s16(dst + 2 * i, lr);
+            }
+            ScalarKernels::interleave2(left + i, right + i, dst + 2 * i, count - i);
+        }
+
+        static int16x8_t gain8(int16x8_t s, float32x4_t gain_lo, float32x4_t gain_hi) {
+            const float32x4_t min = vdupq_n_f32(-32768.0f);
+            const float32x4_t max = vdupq_n_f32(32767.0f);
+            const float32x4_t magic = vdupq_n_f32(12582912.0f);
+            const int32x4_t magic_bits = vreinterpretq_s32_f32(magic);
+            float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(s)));
+            float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(s)));
+            lo = vminq_f32(vmaxq_f32(vmulq_f32(lo, gain_lo), min), max);
+            hi = vminq_f32(vmaxq_f32(vmulq_f32(hi, gain_hi), min), max);
+            int32x4_t ilo = vsubq_s32(vreinterpretq_s32_f32(vaddq_f32(lo, magic)), magic_bits);
+            int32x4_t ihi = vsubq_s32(vreinterpretq_s32_f32(vaddq_f32(hi, magic)), magic_bits);
+            return vcombine_s16(vmovn_s32(ilo), vmovn_s32(ihi));
+        }
+
+        static void gainS16(int16_t* samples, float gain, int count) {
+            const float32x4_t g = vdupq_n_f32(gain);
+            int i = 0;
+            for (; i + 8 <= count; i += 8)
+                vst1q_s16(samples + i, gain8(vld1q_s16(samples + i), g, g));
+            ScalarKernels::gainS16(samples + i, gain, count - i);
+        }
+
+        static void rampS16(int16_t* samples, const float* gains, int count) {
+            int i = 0;
+            for (; i + 8 <= count; i += 8)
+                vst1q_s16(samples + i, gain8(vld1q_s16(samples + i), vld1q_f32(gains + i), vld1q_f32(gains + i + 4)));
+            ScalarKernels::rampS16(samples + i, gains + i, count - i);
+        }
+
+        static void mixS16(int16_t* dst, const int16_t* src, float gain, int count) {
+            const float32x4_t g = vdupq_n_f32(gain);
+            int i = 0;
+            for (; i + 8 <= count; i += 8)
+                vst1q_s16(dst + i, vqaddq_s16(vld1q_s16(dst + i), gain8(vld1q_s16(src + i), g, g)));
+            ScalarKernels::mixS16(dst + i, src + i, gain, count - i);
+        }
+
+        static void lpcmToS16(const uint8_t* src, int container, bool big_endian, int16_t* dst, int count) {
+            const int hi = big_endian ? 0 : container - 1;
+            const int lo = big_endian ? 1 : container - 2;
+            int i = 0;
+            // structured loads split the bytes of 16 samples into one vector per byte position
+            for (; i + 16 <= count; i += 16) {
+                uint8x16x2_t out;
+                if (container == 2) {
+                    uint8x16x2_t in = vld2q_u8(src + 2 * i);
+                    out.val[0] = in.val[lo];
+                    out.val[1] = in.val[hi];
+                } else if (container == 3) {
+                    uint8x16x3_t in = vld3q_u8(src + 3 * i);
+                    out.val[0] = in.val[lo];
+                    out.val[1] = in.val[hi];
+                } else {
+                    uint8x16x4_t in = vld4q_u8(src + 4 * i);
+                    out.val[0] = in.val[lo];
+                    out.val[1] = in.val[hi];
+                }
+                vst2q_u8((uint8_t*)(dst + i), out);
+            }
+            ScalarKernels::lpcmToS16(src + (size_t)i * container, container, big_endian, dst + i, count - i);
+        }
+    };
+#endif
+
+    // channel count known at build time, the inner loop is unrolled
+    template <int CHANNELS>
+    void interleaveN(const int16_t* const* planes, int count, int16_t* dst)
+    {
+        for (int i = 0; i < count; i++) {
+            for (int ch = 0; ch < CHANNELS; ch++)
+                *dst++ = planes[ch][i];
+        }
+    }
+
+    void interleave(const int16_t* const* planes, int channels, int count, int16_t* dst)
+    {
+        switch (channels) {
+            case 3: interleaveN<3>(planes, count, dst); break;
+            case 4: interleaveN<4>(planes, count, dst); break;
+            case 5: interleaveN<5>(planes, count, dst); break;
+            case 6: interleaveN<6>(planes, count, dst); break;
+            case 7: interleaveN<7>(planes, count, dst); break;
+            case 8: interleaveN<8>(planes, count, dst); break;
+        }
+    }
+
+    template <typename T, void (*convert)(const T*, int16_t*, int)>
+    void convertPacked(const uint8_t* const* src, int channels, int samples, int16_t* dst)
+    {
+        convert((const T*)src[0], dst, samples * channels);
+    }
+
+    template <typename K, typename T, void (*convert)(const T*, int16_t*, int)>
+    void convertPlanar(const uint8_t* const* src, int channels, int samples, int16_t* dst)
+    {
+        if (channels == 1) {
+            convert((const T*)src[0], dst, samples);
+            return;
+        }
+
+        int16_t block[AUDIO_CONVERT_MAX_CHANNELS][CONVERT_BLOCK_SAMPLES];
+        const int16_t* planes[AUDIO_CONVERT_MAX_CHANNELS];
+        for (int done = 0; done < samples; done += CONVERT_BLOCK_SAMPLES) {
+            int count = std::min(CONVERT_BLOCK_SAMPLES, samples - done);
+            for (int ch = 0; ch < channels; ch++) {
+                if (std::is_same<T, int16_t>::value) {
+                    // already S16 : interleave straight from the planes
+                    planes[ch] = (const int16_t*)src[ch] + done;
+                } else {
+                    convert((const T*)src[ch] + done, block[ch], count);
+                    planes[ch] = block[ch];
+                }
+            }
+
+            int16_t* out = dst + (size_t)done * channels;
+            if (channels == 2)
+                K::interleave2(planes[0], planes[1], out, count);
+            else
+                interleave(planes, channels, count, out);
+        }
+    }
+
+    template <typename K>
+    void downmixStereo(const uint8_t* const* src, int channels, int samples,
+            const AudioDownmixMatrix& matrix, int16_t* dst)
+    {
+        float mix[2][CONVERT_BLOCK_SAMPLES];
+        int16_t block[2][CONVERT_BLOCK_SAMPLES];
+        for (int done = 0; done < samples; done += CONVERT_BLOCK_SAMPLES) {
+            int count = std::min(CONVERT_BLOCK_SAMPLES, samples - done);
+            for (int out = 0; out < 2; out++) {
+                memset(mix[out], 0, count * sizeof(float));
+                for (int ch = 0; ch < channels; ch++) {
+                    if (matrix.gain[out][ch] != 0.0f)
+                        K::mulAdd((const float*)src[ch] + done, matrix.gain[out][ch], mix[out], count);
+                }
+                K::floatToS16(mix[out], block[out], count);
+            }
+            K::interleave2(block[0], block[1], dst + (size_t)done * 2, count);
+        }
+    }
+
+    template <typename K>
+    void lpcmConvert(const uint8_t* src, const AudioLpcmFormat& format, int frames, int16_t* dst)
+    {
+        const int channels = format.channels;
+        bool in_order = true;
+        for (int ch = 0; ch < channels; ch++)
+            in_order = in_order && format.channel_map[ch] == ch;
+        if (in_order) {
+            K::lpcmToS16(src, format.container_bytes, format.big_endian, dst, frames * channels);
+            return;
+        }
+
+        int16_t block[CONVERT_BLOCK_SAMPLES * AUDIO_CONVERT_MAX_CHANNELS];
+        for (int done = 0; done < frames; done += CONVERT_BLOCK_SAMPLES) {
+            int count = std::min(CONVERT_BLOCK_SAMPLES, frames - done);
+            K::lpcmToS16(src + (size_t)done * channels * format.container_bytes, format.container_bytes,
+                    format.big_endian, block, count * channels);
+            int16_t* out = dst + (size_t)done * channels;
+            for (int i = 0; i < count; i++) {
+                for (int ch = 0; ch < channels; ch++)
+                    *out++ = block[i * channels + format.channel_map[ch]];
+            }
+        }
+    }
+
+    template <typename K>
+    AudioConvertFunc kernelOf(enum AVSampleFormat format)
+    {
+        switch (format) {
+            case AV_SAMPLE_FMT_FLTP: return convertPlanar<K, float, K::floatToS16>;
+            case AV_SAMPLE_FMT_FLT:  return convertPacked<float, K::floatToS16>;
+            case AV_SAMPLE_FMT_S16P: return convertPlanar<K, int16_t, ScalarKernels::copyS16>;
+            case AV_SAMPLE_FMT_S32P: return convertPlanar<K, int32_t, K::s32ToS16>;
+            case AV_SAMPLE_FMT_S32:  return convertPacked<int32_t, K::s32ToS16>;
+            default:                 return nullptr;
+        }
+    }
+
+    bool isSupported(AUDIO_CONVERT_IMPL impl)
+    {
+        return impl != AUDIO_CONVERT_AUTO && isCpuSimdSupported((CPU_SIMD)impl);
+    }
+
+    AUDIO_CONVERT_IMPL detectImpl()
+    {
+        // NDL_AUDIO_CONVERT=swr|scalar|sse2|avx2|neon, to compare against the kernels on the field
+        const char* value = getenv("NDL_AUDIO_CONVERT");
+        if (value) {
+            if (!strcmp(value, "swr"))
+                return AUDIO_CONVERT_AUTO;
+            for (int impl = AUDIO_CONVERT_SCALAR; impl <= AUDIO_CONVERT_NEON; impl++) {
+                if (!strcmp(value, audioConvertImplName((AUDIO_CONVERT_IMPL)impl)) &&
+                        isSupported((AUDIO_CONVERT_IMPL)impl))
+                    return (AUDIO_CONVERT_IMPL)impl;
+            }
+            NDLLOG(LOGTAG, NDL_LOGE, "NDL_AUDIO_CONVERT=%s is not supported, ignored", value);
+        }
+
+        return (AUDIO_CONVERT_IMPL)getCpuSimd();
+    }
+}
+
+const char* NDL_Esplayer::audioConvertImplName(AUDIO_CONVERT_IMPL impl)
+{
+    switch (impl) {
+        case AUDIO_CONVERT_AUTO:   return "swr";
+        case AUDIO_CONVERT_SCALAR: return "scalar";
+        case AUDIO_CONVERT_SSE2:   return "sse2";
+        case AUDIO_CONVERT_AVX2:   return "avx2";
+        case AUDIO_CONVERT_NEON:   return "neon";
+    }
+    return "unknown";
+}
+
+bool NDL_Esplayer::isAudioConvertImplSupported(AUDIO_CONVERT_IMPL impl)
+{
+    return isSupported(impl);
+}
+
+AUDIO_CONVERT_IMPL NDL_Esplayer::getAudioConvertImpl()
+{
+    static const AUDIO_CONVERT_IMPL impl = [] {
+        AUDIO_CONVERT_IMPL detected = detectImpl();
+        NDLLOG(LOGTAG, NDL_LOGI, "audio sample conversion : %s", audioConvertImplName(detected));
+        return detected;
+    }();
+    return impl;
+}
+
+namespace {
+    AUDIO_CONVERT_IMPL resolveImpl(AUDIO_CONVERT_IMPL impl)
+    {
+        if (impl == AUDIO_CONVERT_AUTO)
+            impl = getAudioConvertImpl();
+        return isSupported(impl) ? impl : AUDIO_CONVERT_AUTO;
+    }
+
+    AUDIO_CONVERT_IMPL resolveKernelImpl(AUDIO_CONVERT_IMPL impl)
+    {
+        // swresample is not used for gains and lpcm : scalar when it is forced
+        AUDIO_CONVERT_IMPL resolved = resolveImpl(impl);
+        return (resolved == AUDIO_CONVERT_AUTO && impl == AUDIO_CONVERT_AUTO) ? AUDIO_CONVERT_SCALAR : resolved;
+    }
+}
+
+AudioConvertFunc NDL_Esplayer::getAudioConvertFunc(enum AVSampleFormat format, int channels,
+        AUDIO_CONVERT_IMPL impl)
+{
+    if (channels < 1 || channels > AUDIO_CONVERT_MAX_CHANNELS)
+        return nullptr;
+
+    switch (resolveImpl(impl)) {
+#if defined(__SSE2__)
+        case AUDIO_CONVERT_SSE2: return kernelOf<Sse2Kernels>(format);
+#endif
+#if defined(AUDIO_CONVERT_HAVE_AVX2)
+        case AUDIO_CONVERT_AVX2: return kernelOf<Avx2Kernels>(format);
+#endif
+#if defined(AUDIO_CONVERT_HAVE_NEON)
+        case AUDIO_CONVERT_NEON: return kernelOf<NeonKernels>(format);
+#endif
+        case AUDIO_CONVERT_SCALAR: return kernelOf<ScalarKernels>(format);
+        default:                   return nullptr;
+    }
+}
+
+AudioDownmixFunc NDL_Esplayer::getAudioDownmixFunc(enum AVSampleFormat format, int channels,
+        AUDIO_CONVERT_IMPL impl)
+{
+    // decoders of multichannel codecs (AC3, EAC3, AAC) give float planes
+    if (format != AV_SAMPLE_FMT_FLTP || channels < 1 || channels > AUDIO_CONVERT_MAX_CHANNELS)
+        return nullptr;
+
+    switch (resolveImpl(impl)) {
+#if defined(__SSE2__)
+        case AUDIO_CONVERT_SSE2: return downmixStereo<Sse2Kernels>;
+#endif
+#if defined(AUDIO_CONVERT_HAVE_AVX2)
+        case AUDIO_CONVERT_AVX2: return downmixStereo<Avx2Kernels>;
+#endif
+#if defined(AUDIO_CONVERT_HAVE_NEON)
+        case AUDIO_CONVERT_NEON: return downmixStereo<NeonKernels>;
+#endif
+        case AUDIO_CONVERT_SCALAR: return downmixStereo<ScalarKernels>;
+        default:                   return nullptr;
+    }
+}
+
+AudioGainFunc NDL_Esplayer::getAudioGainFunc(AUDIO_CONVERT_IMPL impl)
+{
+    switch (resolveKernelImpl(impl)) {
+#if defined(__SSE2__)
+        case AUDIO_CONVERT_SSE2: return Sse2Kernels::gainS16;
+#endif
+#if defined(AUDIO_CONVERT_HAVE_AVX2)
+        case AUDIO_CONVERT_AVX2: return Avx2Kernels::gainS16;
+#endif
+#if defined(AUDIO_CONVERT_HAVE_NEON)
+        case AUDIO_CONVERT_NEON: return NeonKernels::gainS16;
+#endif
+        case AUDIO_CONVERT_SCALAR: return ScalarKernels::gainS16;
+        default:                   return nullptr;
+    }
+}
+
+AudioRampFunc NDL_Esplayer::getAudioRampFunc(AUDIO_CONVERT_IMPL impl)
+{
+    switch (resolveKernelImpl(impl)) {
+#if defined(__SSE2__)
+        case AUDIO_CONVERT_SSE2: return Sse2Kernels::rampS16;
+#endif
+#if defined(AUDIO_CONVERT_HAVE_AVX2)
+        case AUDIO_CONVERT_AVX2: return Avx2Kernels::rampS16;
+#endif
+#if defined(AUDIO_CONVERT_HAVE_NEON)
+        case AUDIO_CONVERT_NEON: return NeonKernels::rampS16;
+#endif
+        case AUDIO_CONVERT_SCALAR: return ScalarKernels::rampS16;
+        default:                   return nullptr;
+    }
+}
+
+AudioMixFunc NDL_Esplayer::getAudioMixFunc(AUDIO_CONVERT_IMPL impl)
+{
+    switch (resolveKernelImpl(impl)) {
+#if defined(__SSE2__)
+        case AUDIO_CONVERT_SSE2: return Sse2Kernels::mixS16;
+#endif
+#if defined(AUDIO_CONVERT_HAVE_AVX2)
+        case AUDIO_CONVERT_AVX2: return Avx2Kernels::mixS16;
+#endif
+#if defined(AUDIO_CONVERT_HAVE_NEON)
+        case AUDIO_CONVERT_NEON: return NeonKernels::mixS16;
+#endif
+        case AUDIO_CONVERT_SCALAR: return ScalarKernels::mixS16;
+        default:                   return nullptr;
+    }
+}
+
+AudioLpcmFunc NDL_Esplayer::getAudioLpcmFunc(const AudioLpcmFormat& format, AUDIO_CONVERT_IMPL impl)
+{
+    if (format.channels < 1 || format.channels > AUDIO_CONVERT_MAX_CHANNELS ||
+            format.container_bytes < 2 || format.container_bytes > 4)
+        return nullptr;
+    for (int ch = 0; ch < format.channels; ch++) {
+        if (format.channel_map[ch] >= format.channels)
+            return nullptr;
+    }
+
+    switch (resolveKernelImpl(impl)) {
+#if defined(__SSE2__)
+        case AUDIO_CONVERT_SSE2: return lpcmConvert<Sse2Kernels>;
+#endif
+#if defined(AUDIO_CONVERT_HAVE_AVX2)
+        case AUDIO_CONVERT_AVX2: return lpcmConvert<Avx2Kernels>;
+#endif
+#if defined(AUDIO_CONVERT_HAVE_NEON)
+        case AUDIO_CONVERT_NEON: return lpcmConvert<NeonKernels>;
+#endif
+        case AUDIO_CONVERT_SCALAR: return lpcmConvert<ScalarKernels>;
+        default:                   return nullptr;
+    }
+}
+
+AudioDownmixGains NDL_Esplayer::getAudioDownmixGains()
+{
+    AudioDownmixGains gains;
+    // NDL_AUDIO_DOWNMIX=<center>,<surround>,<lfe>[,<normalize 0|1>], linear gains
+    const char* value = getenv("NDL_AUDIO_DOWNMIX");
+    if (value) {
+        int normalize = gains.normalize ? 1 : 0;
+        if (sscanf(value, "%f,%f,%f,%d", &gains.center, &gains.surround, &gains.lfe, &normalize) < 3) {
+            NDLLOG(LOGTAG, NDL_LOGE, "NDL_AUDIO_DOWNMIX=%s is not <center>,<surround>,<lfe>, ignored", value);
+            return AudioDownmixGains();
+        }
+        gains.normalize = normalize != 0;
+    }
+    return gains;
+}
+
+bool NDL_Esplayer::buildStereoDownmix(uint64_t layout, const AudioDownmixGains& gains,
+        AudioDownmixMatrix* matrix)
+{
+    memset(matrix, 0, sizeof(AudioDownmixMatrix));
+
+    // channels are in the order of the layout bits (ffmpeg and WAVEFORMATEXTENSIBLE order)
+    int ch = 0;
+    for (int bit = 0; bit < 64 && layout; bit++) {
+        uint64_t speaker = 1ULL << bit;
+        if (!(layout & speaker))
+            continue;
+        layout &= ~speaker;
+        if (ch == AUDIO_CONVERT_MAX_CHANNELS)
+            return false;
+
+        float* left = &matrix->gain[0][ch];
+        float* right = &matrix->gain[1][ch];
+        switch (speaker) {
+            case AV_CH_FRONT_LEFT:
+            case AV_CH_FRONT_LEFT_OF_CENTER:
+                *left = 1.0f;
+                break;
+            case AV_CH_FRONT_RIGHT:
+            case AV_CH_FRONT_RIGHT_OF_CENTER:
+                *right = 1.0f;
+                break;
+            case AV_CH_FRONT_CENTER:
+                *left = *right = gains.center;
+                break;
+            case AV_CH_LOW_FREQUENCY:
+                *left = *right = gains.lfe;
+                break;
+            case AV_CH_BACK_LEFT:
+            case AV_CH_SIDE_LEFT:
+                *left = gains.surround;
+                break;
+            case AV_CH_BACK_RIGHT:
+            case AV_CH_SIDE_RIGHT:
+                *right = gains.surround;
+                break;
+            case AV_CH_BACK_CENTER:
+                *left = *right = gains.surround * AUDIO_DOWNMIX_MINUS_3DB;
+                break;
+            default:
+                // top and wide speakers are not mixed
+                break;
+        }
+        ch++;
+    }
+
+    if (gains.normalize) {
+        // same scale for both sides : full scale on every input can not clip
+        float sum = 0.0f;
+        for (int out = 0; out < 2; out++) {
+            float row = 0.0f;
+            for (int i = 0; i < ch; i++)
+                row += matrix->gain[out][i];
+            sum = std::max(sum, row);
+        }
+        if (sum > 1.0f) {
+            for (int out = 0; out < 2; out++) {
+                for (int i = 0; i < ch; i++)
+                    matrix->gain[out][i] /= sum;
+            }
+        }
+    }
+    return ch > 0;
+}
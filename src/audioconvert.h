@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef NDL_DIRECTMEDIA2_AUDIO_CONVERT_H_
+#define NDL_DIRECTMEDIA2_AUDIO_CONVERT_H_
+
+#include <stdint.h>
+
+#include "cpufeatures.h"
+
+extern "C" {
+#include "libavutil/channel_layout.h"
+#include "libavutil/samplefmt.h"
+}
+
+#define AUDIO_CONVERT_MAX_CHANNELS 8
+
+// ITU-R BS.775 downmix level of center and surround channels
+#define AUDIO_DOWNMIX_MINUS_3DB 0.70710678f
+
+namespace NDL_Esplayer {
+
+    typedef enum {
+        AUDIO_CONVERT_AUTO = CPU_SIMD_AUTO,     // best kernel of the cpu, NDL_AUDIO_CONVERT in the environment can force one
+        AUDIO_CONVERT_SCALAR = CPU_SIMD_SCALAR,
+        AUDIO_CONVERT_SSE2 = CPU_SIMD_SSE2,
+        AUDIO_CONVERT_AVX2 = CPU_SIMD_AVX2,
+        AUDIO_CONVERT_NEON = CPU_SIMD_NEON,
+    } AUDIO_CONVERT_IMPL;
+
+    /**
+     * Convert samples of all the channels into interleaved S16, same result as swr_convert.
+     * src : one plane per channel for planar formats, src[0] only for packed formats
+     */
+    typedef void (*AudioConvertFunc)(const uint8_t* const* src, int channels, int samples, int16_t* dst);
+
+    /**
+     * Conversion kernel for the decoded format into S16 of the same channels,
+     * FLTP, FLT, S16P, S32 and S32P with 1 to AUDIO_CONVERT_MAX_CHANNELS channels.
+     * return nullptr when not supported (or the cpu lacks the requested impl) : use swresample
+     */
+    AudioConvertFunc getAudioConvertFunc(enum AVSampleFormat format, int channels,
+            AUDIO_CONVERT_IMPL impl = AUDIO_CONVERT_AUTO);
+
+    /**
+     * Stereo downmix gains of each input channel : gain[0] left, gain[1] right
+     */
+    struct AudioDownmixMatrix {
+        float gain[2][AUDIO_CONVERT_MAX_CHANNELS];
+    };
+
+    /**
+     * Levels of the channels mixed into both sides (front left/right are 1.0).
+     * Default ITU-R BS.775 without LFE, normalized so that the mix can not clip.
+     */
+    struct AudioDownmixGains {
+        float center {AUDIO_DOWNMIX_MINUS_3DB};
+        float surround {AUDIO_DOWNMIX_MINUS_3DB};
+        float lfe {0.0f};
+        bool normalize {true};
+    };
+
+    /**
+     * Mix planes of all the channels into interleaved S16 stereo
+     */
+    typedef void (*AudioDownmixFunc)(const uint8_t* const* src, int channels, int samples,
+            const AudioDownmixMatrix& matrix, int16_t* dst);
+
+    /**
+     * Downmix kernel for FLTP, nullptr for other formats : use swresample
+     */
+    AudioDownmixFunc getAudioDownmixFunc(enum AVSampleFormat format, int channels,
+            AUDIO_CONVERT_IMPL impl = AUDIO_CONVERT_AUTO);
+
+    /**
+     * Scale interleaved S16 in place by one gain, lrintf(sample * gain) clipped
+     */
+    typedef void (*AudioGainFunc)(int16_t* samples, float gain, int count);
+
+    /**
+     * Scale interleaved S16 in place by a gain of each sample (gains[i] for samples[i])
+     */
+    typedef void (*AudioRampFunc)(int16_t* samples, const float* gains, int count);
+
+    /**
+     * Gain kernels, scalar ones when swresample is forced (it has no gain stage).
+     * return nullptr when the cpu lacks the requested impl
+     */
+    AudioGainFunc getAudioGainFunc(AUDIO_CONVERT_IMPL impl = AUDIO_CONVERT_AUTO);
+    AudioRampFunc getAudioRampFunc(AUDIO_CONVERT_IMPL impl = AUDIO_CONVERT_AUTO);
+
+    /**
+     * Add src scaled by gain into dst (interleaved S16 of the same layout), saturating
+     */
+    typedef void (*AudioMixFunc)(int16_t* dst, const int16_t* src, float gain, int count);
+
+    /**
+     * Mix kernel, scalar when swresample is forced. nullptr when the cpu lacks the requested impl
+     */
+    AudioMixFunc getAudioMixFunc(AUDIO_CONVERT_IMPL impl = AUDIO_CONVERT_AUTO);
+
+    /**
+     * Interleaved LPCM samples, each in the upper bits of container_bytes (2, 3 or 4)
+     */
+    struct AudioLpcmFormat {
+        int channels {2};
+        int container_bytes {2};
+        bool big_endian {false};
+        uint8_t channel_map[AUDIO_CONVERT_MAX_CHANNELS] {0, 1, 2, 3, 4, 5, 6, 7};  // input channel of each output
+    };
+
+    /**
+     * LPCM into interleaved S16 of the same channel count in channel_map order,
+     * the upper 16 bits of each sample (same as 24/32 bit pcm decoded and converted by swresample)
+     */
+    typedef void (*AudioLpcmFunc)(const uint8_t* src, const AudioLpcmFormat& format, int frames, int16_t* dst);
+
+    /**
+     * LPCM kernel, nullptr for a format out of AudioLpcmFormat or an impl the cpu lacks
+     */
+    AudioLpcmFunc getAudioLpcmFunc(const AudioLpcmFormat& format, AUDIO_CONVERT_IMPL impl = AUDIO_CONVERT_AUTO);
+
+    /**
+     * Default gains, or NDL_AUDIO_DOWNMIX=<center>,<surround>,<lfe>[,<normalize>] in the environment
+     */
+    AudioDownmixGains getAudioDownmixGains();
+
+    /**
+     * Matrix for the channels of the layout (AV_CH_*, same bits as the WAVEFORMATEXTENSIBLE mask).
+     * return false if the layout has more than AUDIO_CONVERT_MAX_CHANNELS channels
+     */
+    bool buildStereoDownmix(uint64_t layout, const AudioDownmixGains& gains, AudioDownmixMatrix* matrix);
+
+    /**
+     * impl chosen by AUDIO_CONVERT_AUTO, AUDIO_CONVERT_AUTO itself when swresample is forced
+     */
+    AUDIO_CONVERT_IMPL getAudioConvertImpl();
+    const char* audioConvertImplName(AUDIO_CONVERT_IMPL impl);
+    /**
+     * true if the build and the cpu have the kernels of impl (see isCpuSimdSupported)
+     */
+    bool isAudioConvertImplSupported(AUDIO_CONVERT_IMPL impl);
+
+} //namespace NDL_Esplayer
+
+#endif //NDL_DIRECTMEDIA2_AUDIO_CONVERT_H_
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <algorithm>
+
+#include "audiodecodercache.h"
+
+using namespace NDL_Esplayer;
+
+#define LOGTAG "adecodercache"
+#include "debug.h"
+
+AudioDecoderCache& AudioDecoderCache::instance()
+{
+    static AudioDecoderCache cache;
+    return cache;
+}
+
+void AudioDecoderCache::registerCodecs()
+{
+    static std::once_flag registered;
+    std::call_once(registered, [] { avcodec_register_all(); });
+}
+
+AudioDecoderCache::AudioDecoderCache()
+{
+    const char* value = getenv("NDL_AUDIO_DECODER_CACHE");
+    capacity_ = value ? std::max(atoi(value), 0) : AUDIO_DECODER_CACHE_SIZE;
+}
+
+AudioDecoderCache::~AudioDecoderCache()
+{
+    clear();
+}
+
+AVCodecContext* AudioDecoderCache::acquire(const AudioDecoderKey& key)
+{
+    AVCodecContext* context = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        for (auto entry = entries_.begin(); entry != entries_.end(); ++entry) {
+            if (entry->key == key) {
+                context = entry->context;
+                entries_.erase(entry);
+                break;
+            }
+        }
+    }
+    if (!context)
+        return nullptr;
+
+    // frames of the previous stream must not come out of the new one
+    avcodec_flush_buffers(context);
+    NDLLOG(LOGTAG, NDL_LOGI, "%s: reuse decoder context of codec 0x%x", __func__, (int)key.codec_id);
+    return context;
+}
+
+void AudioDecoderCache::release(const AudioDecoderKey& key, AVCodecContext* context)
+{
+    if (!context)
+        return;
+
+    AVCodecContext* evicted = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        if (capacity_ > 0) {
+            entries_.push_front(Entry {key, context});
+            context = nullptr;
+            if ((int)entries_.size() > capacity_) {
+                evicted = entries_.back().context;
+                entries_.pop_back();
+            }
+        }
+    }
+    // not cached, or the least recently used one
+    if (context)
+        avcodec_free_context(&context);
+    if (evicted)
+        avcodec_free_context(&evicted);
+}
+
+void AudioDecoderCache::setCapacity(int capacity)
+{
+    std::list<Entry> evicted;
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        capacity_ = std::max(capacity, 0);
+        while ((int)entries_.size() > capacity_) {
+            evicted.push_back(entries_.back());
+            entries_.pop_back();
+        }
+    }
+    for (auto& entry : evicted)
+        avcodec_free_context(&entry.context);
+}
+
+int AudioDecoderCache::getCapacity()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    return capacity_;
+}
+
+void AudioDecoderCache::clear()
+{
+    std::list<Entry> entries;
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        entries.swap(entries_);
+    }
+    for (auto& entry : entries)
+        avcodec_free_context(&entry.context);
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef NDL_DIRECTMEDIA2_AUDIO_DECODER_CACHE_H_
+#define NDL_DIRECTMEDIA2_AUDIO_DECODER_CACHE_H_
+
+#include <stdint.h>
+#include <list>
+#include <mutex>
+
+extern "C" {
+#include "libavcodec/avcodec.h"
+}
+
+/**
+ * Default number of idle decoder contexts kept for the next load.
+ * NDL_AUDIO_DECODER_CACHE in the environment overrides it, 0 disables the cache.
+ */
+#define AUDIO_DECODER_CACHE_SIZE 2
+
+namespace NDL_Esplayer {
+
+    /**
+     * Parameters a decoder context is opened with, contexts are reused only for the same ones
+     */
+    struct AudioDecoderKey {
+        enum AVCodecID codec_id;
+        int channels;
+        int sample_rate;
+        int64_t bit_rate;
+        int block_align;
+        int bits_per_coded_sample;
+
+        bool operator==(const AudioDecoderKey& other) const {
+            return codec_id == other.codec_id &&
+                channels == other.channels &&
+                sample_rate == other.sample_rate &&
+                bit_rate == other.bit_rate &&
+                block_align == other.block_align &&
+                bits_per_coded_sample == other.bits_per_coded_sample;
+        }
+    };
+
+    /**
+     * Process wide cache of opened audio decoder contexts.
+     * Zapping between streams of the same codec skips avcodec_alloc_context3/avcodec_open2,
+     * a reused context is only flushed (avcodec_flush_buffers).
+     */
+    class AudioDecoderCache {
+        public:
+            static AudioDecoderCache& instance();
+
+            /**
+             * avcodec_register_all once per process
+             */
+            static void registerCodecs();
+
+            /**
+             * Idle context opened with the same key, removed from the cache. nullptr on miss
+             */
+            AVCodecContext* acquire(const AudioDecoderKey& key);
+            /**
+             * Give back a context opened with key, freed if the cache is full or disabled
+             */
+            void release(const AudioDecoderKey& key, AVCodecContext* context);
+
+            void setCapacity(int capacity);
+            int getCapacity();
+            /**
+             * Free all the idle contexts
+             */
+            void clear();
+
+        private:
+            AudioDecoderCache();
+            ~AudioDecoderCache();
+
+            struct Entry {
+                AudioDecoderKey key;
+                AVCodecContext* context;
+            };
+
+            std::mutex lock_;
+            std::list<Entry> entries_;  // most recently released first
+            int capacity_;
+
+            AudioDecoderCache(AudioDecoderCache const&) = delete;
+            void operator=(AudioDecoderCache const&) = delete;
+    };
+
+} //namespace NDL_Esplayer
+
+#endif //NDL_DIRECTMEDIA2_AUDIO_DECODER_CACHE_H_
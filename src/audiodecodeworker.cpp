@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+
+#include "audiodecodeworker.h"
+#include "audioswdecoder.h"
+
+using namespace NDL_Esplayer;
+
+#define LOGTAG "adecodeworker"
+#include "debug.h"
+
+#define LOG_DECODE_WORKER NDL_LOGV
+
+// ring is sized for the lookahead of 8 channels S16 at 48kHz
+#define RING_BYTES_PER_MS (48 * 8 * 2)
+#define RING_SPARE_CHUNKS 4
+
+int AudioDecodeWorker::configuredAheadMs()
+{
+    const char* value = getenv("NDL_AUDIO_DECODE_AHEAD_MS");
+    if (!value)
+        return AUDIO_DECODE_AHEAD_MS;
+    return std::max(atoi(value), 0);
+}
+
+AudioDecodeWorker::AudioDecodeWorker(std::shared_ptr<AudioSwDecoder> decoder, int ahead_ms, int chunk_size)
+    : decoder_(decoder)
+    , ahead_us_((int64_t)ahead_ms * 1000)
+    , chunk_size_(chunk_size)
+{
+    ring_.resize((size_t)ahead_ms * RING_BYTES_PER_MS + RING_SPARE_CHUNKS * chunk_size);
+    NDLLOG(LOGTAG, NDL_LOGI, "decode ahead %dms, chunk %d bytes, ring %d bytes",
+            ahead_ms, chunk_size, (int)ring_.size());
+    thread_ = std::thread([this] { run(); });
+}
+
+AudioDecodeWorker::~AudioDecodeWorker()
+{
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        quit_ = true;
+    }
+    changed_cond_.notify_all();
+    if (thread_.joinable())
+        thread_.join();
+}
+
+void AudioDecodeWorker::push(NDL_EsplayerBuffer packet, int64_t pts)
+{
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        packets_.push_back(Packet {packet, pts});
+    }
+    changed_cond_.notify_all();
+}
+
+bool AudioDecodeWorker::peek(Chunk* chunk, int timeout_ms)
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    if (chunks_.empty() && timeout_ms > 0) {
+        changed_cond_.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this] {
+                return !chunks_.empty() || (packets_.empty() && !busy_);
+                });
+    }
+    if (chunks_.empty())
+        return false;
+    *chunk = chunks_.front();
+    return true;
+}
+
+int AudioDecodeWorker::read(uint8_t* dst, int capacity)
+{
+    int size = 0;
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        if (chunks_.empty() || chunks_.front().size > capacity)
+            return 0;
+        size = chunks_.front().size;
+        ringRead(dst, size);
+        chunks_.pop_front();
+    }
+    changed_cond_.notify_all();
+    return size;
+}
+
+void AudioDecodeWorker::pop()
+{
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        if (chunks_.empty())
+            return;
+        ringRead(nullptr, chunks_.front().size);
+        chunks_.pop_front();
+    }
+    changed_cond_.notify_all();
+}
+
+void AudioDecodeWorker::flush()
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    generation_++;
+    packets_.clear();
+    chunks_.clear();
+    ring_read_ = 0;
+    ring_used_ = 0;
+    changed_cond_.notify_all();
+
+    // the packet in decoding is dropped by the generation check
+    changed_cond_.wait(lock, [this] { return !busy_; });
+    decoder_->DiscardOutput();
+}
+
+int64_t AudioDecodeWorker::bufferedUs() const
+{
+    if (bytes_per_second_ <= 0)
+        return 0;
+    return (int64_t)ring_used_ * 1000000 / bytes_per_second_;
+}
+
+/**
+ * Read len bytes from the decoder into the free part of the ring at write, split once at the end of the ring.
+ * The free part is not touched by the feeder, the lock is not held.
+ * return bytes read
+ */
+int AudioDecodeWorker::readDecoded(int write, int len)
+{
+    int capacity = (int)ring_.size();
+    int first = std::min(len, capacity - write);
+    int size = decoder_->ReadOutput(ring_.data() + write, first);
+    if (size == first || size >= len)
+        return size;
+
+    // the frame across the end of the ring goes in two parts
+    int gap = first - size;
+    int frame_size = decoder_->GetOutputFrameSize();
+    uint8_t frame[AUDIO_DECODE_MAX_FRAME_SIZE];
+    if (frame_size <= gap || frame_size > (int)sizeof(frame) || size + frame_size > len ||
+            decoder_->ReadOutput(frame, frame_size) != frame_size)
+        return size;
+    memcpy(ring_.data() + write + size, frame, gap);
+    memcpy(ring_.data(), frame + gap, frame_size - gap);
+    size += frame_size;
+
+    return size + decoder_->ReadOutput(ring_.data() + frame_size - gap, len - size);
+}
+
+void AudioDecodeWorker::ringRead(uint8_t* dst, int len)
+{
+    int capacity = (int)ring_.size();
+    if (dst) {
+        int first = std::min(len, capacity - ring_read_);
+        memcpy(dst, ring_.data() + ring_read_, first);
+        memcpy(dst + first, ring_.data(), len - first);
+    }
+    ring_read_ = (ring_read_ + len) % capacity;
+    ring_used_ -= len;
+}
+
+void AudioDecodeWorker::run()
+{
+    pthread_setname_np(pthread_self(), "ADecodeWorker");
+
+    std::unique_lock<std::mutex> lock(lock_);
+    while (!quit_) {
+        // decode only up to the lookahead, the feeder wakes us as it drains the ring
+        if (packets_.empty() || bufferedUs() >= ahead_us_) {
+            changed_cond_.wait(lock);
+            continue;
+        }
+
+        Packet packet = packets_.front();
+        packets_.pop_front();
+        uint64_t generation = generation_;
+        busy_ = true;
+        lock.unlock();
+
+        decode(packet, generation);
+
+        lock.lock();
+        busy_ = false;
+        changed_cond_.notify_all();
+    }
+}
+
+void AudioDecodeWorker::decode(const Packet& packet, uint64_t generation)
+{
+    const NDL_ESP_STREAM_BUFFER* buffer = packet.buffer.get();
+    const bool has_data = buffer->data_len > 0;
+
+    if (has_data && decoder_->DecodeAudio(buffer->data, buffer->data_len, packet.pts, packet.pts) < 0)
+        NDLLOG(LOGTAG, NDL_LOGE, "%s: decode error, pts:%lld size:%d", __func__, packet.pts, buffer->data_len);
+
+    const int frame_size = decoder_->GetOutputFrameSize();
+    int chunk_limit = chunk_size_;
+    if (frame_size > 0 && chunk_limit >= frame_size)
+        chunk_limit -= chunk_limit % frame_size;
+
+    NDLLOG(LOGTAG, LOG_DECODE_WORKER, "%s: pts:%lld size:%d decoded:%d",
+            __func__, packet.pts, buffer->data_len, decoder_->GetOutputBufferSize());
+
+    // a packet without samples still gives one empty chunk to complete its feed
+    bool first = true;
+    bool last = false;
+    while (!last) {
+        Chunk chunk;
+        chunk.pts = has_data ? decoder_->GetOutputPts() : packet.pts;
+        int len = has_data ? std::min(chunk_limit, decoder_->GetOutputBufferSize()) : 0;
+
+        std::unique_lock<std::mutex> lock(lock_);
+        changed_cond_.wait(lock, [&] {
+                return quit_ || generation != generation_ || ringFree() >= len;
+                });
+        if (quit_ || generation != generation_)
+            return;
+        int write = (ring_read_ + ring_used_) % (int)ring_.size();
+        lock.unlock();
+
+        // decoded straight into the ring, no other copy before the omx buffer
+        chunk.size = len > 0 ? readDecoded(write, len) : 0;
+        chunk.packet_pts = packet.pts;
+        chunk.packet_flags = buffer->flags;
+        chunk.first = first;
+        chunk.last = last = (decoder_->GetOutputBufferSize() <= 0 || chunk.size <= 0);
+        first = false;
+
+        lock.lock();
+        if (quit_ || generation != generation_)
+            return;
+        ring_used_ += chunk.size;
+        chunks_.push_back(chunk);
+        if (frame_size > 0 && decoder_->GetOutputSampleRate() > 0)
+            bytes_per_second_ = frame_size * decoder_->GetOutputSampleRate();
+        lock.unlock();
+        changed_cond_.notify_all();
+    }
+}
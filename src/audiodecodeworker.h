@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef NDL_DIRECTMEDIA2_AUDIO_DECODE_WORKER_H_
+#define NDL_DIRECTMEDIA2_AUDIO_DECODE_WORKER_H_
+
+#include <stdint.h>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ndl-directmedia2/esplayer-api.h"
+
+/**
+ * Default decode lookahead of the audio decode worker.
+ * NDL_AUDIO_DECODE_AHEAD_MS in the environment overrides it, 0 decodes inline on the feeder.
+ */
+#define AUDIO_DECODE_AHEAD_MS 200
+/**
+ * Max wait of the feeder for the packet being decoded, before retrying later
+ */
+#define AUDIO_DECODE_WAIT_MS 20
+/**
+ * Largest sample frame (S16 of all channels) split across the end of the PCM ring
+ */
+#define AUDIO_DECODE_MAX_FRAME_SIZE 64
+
+namespace NDL_Esplayer {
+
+    class AudioSwDecoder;
+
+    /**
+     * Software audio decode stage running ahead of the OMX feed.
+     * Packets are decoded on its own thread up to the lookahead straight into a PCM ring,
+     * and the feeder only copies ready PCM chunks into free OMX buffers.
+     */
+    class AudioDecodeWorker {
+        public:
+            /**
+             * One OMX buffer worth of PCM, chunk_size at most
+             */
+            struct Chunk {
+                int size {0};
+                int64_t pts {0};            // pts of the first sample
+                int64_t packet_pts {0};     // pts of the packet the chunk comes from
+                uint32_t packet_flags {0};  // NDL_ESP_FLAG of the packet
+                bool first {false};         // first chunk of the packet
+                bool last {false};          // last chunk of the packet
+            };
+
+            /**
+             * return the lookahead(ms) from the environment or AUDIO_DECODE_AHEAD_MS
+             */
+            static int configuredAheadMs();
+
+            AudioDecodeWorker(std::shared_ptr<AudioSwDecoder> decoder, int ahead_ms, int chunk_size);
+            ~AudioDecodeWorker();
+
+            /**
+             * Queue a packet to decode, pts in microseconds
+             */
+            void push(NDL_EsplayerBuffer packet, int64_t pts);
+            /**
+             * Front chunk of the ring, false if nothing is decoded in timeout_ms
+             */
+            bool peek(Chunk* chunk, int timeout_ms = 0);
+            /**
+             * Copy the front chunk into dst and drop it, return copied bytes
+             */
+            int read(uint8_t* dst, int capacity);
+            /**
+             * Drop the front chunk without copying (ex. empty end of stream chunk)
+             */
+            void pop();
+            /**
+             * Drop queued packets and decoded PCM, and flush the decoder
+             */
+            void flush();
+
+        private:
+            struct Packet {
+                NDL_EsplayerBuffer buffer;
+                int64_t pts;
+            };
+
+            void run();
+            void decode(const Packet& packet, uint64_t generation);
+            int64_t bufferedUs() const;
+            int ringFree() const { return (int)ring_.size() - ring_used_; }
+            int readDecoded(int write, int len);
+            void ringRead(uint8_t* dst, int len);
+
+            std::shared_ptr<AudioSwDecoder> decoder_;
+            const int64_t ahead_us_;
+            const int chunk_size_;
+
+            std::mutex lock_;
+            std::condition_variable changed_cond_;
+            std::deque<Packet> packets_;
+            std::deque<Chunk> chunks_;
+            std::vector<uint8_t> ring_;
+            int ring_read_ {0};
+            int ring_used_ {0};
+            int bytes_per_second_ {0};
+            uint64_t generation_ {0};  // increased by flush, stale decode results are dropped
+            bool busy_ {false};
+            bool quit_ {false};
+
+            std::thread thread_;
+
+            AudioDecodeWorker(AudioDecodeWorker const&) = delete;
+            void operator=(AudioDecodeWorker const&) = delete;
+    };
+
+} //namespace NDL_Esplayer
+
+#endif //NDL_DIRECTMEDIA2_AUDIO_DECODE_WORKER_H_
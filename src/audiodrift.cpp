@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+
+#include "audiodrift.h"
+#include "audioresampler.h"
+#include "mediaclock.h"
+
+using namespace NDL_Esplayer;
+
+#define LOGTAG "audiodrift"
+#include "debug.h"
+
+bool AudioDriftEstimator::configuredCompensation()
+{
+    const char* value = getenv("NDL_AUDIO_DRIFT_COMPENSATION");
+    return value && atoi(value) > 0;
+}
+
+AudioDriftEstimator::AudioDriftEstimator()
+    : compensate_(configuredCompensation())
+{
+}
+
+void AudioDriftEstimator::setCompensation(bool enable)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    compensate_ = enable;
+    if (!compensate_)
+        correction_ppm_ = 0;
+    anchor_ns_ = -1;
+}
+
+void AudioDriftEstimator::reset()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    anchor_ns_ = -1;
+}
+
+void AudioDriftEstimator::clear()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    anchor_ns_ = -1;
+    has_drift_ = false;
+    drift_ppm_ = 0;
+    correction_ppm_ = 0;
+}
+
+void AudioDriftEstimator::setRate(int rate)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    if (rate != rate_)
+        anchor_ns_ = -1;
+    rate_ = rate;
+}
+
+void AudioDriftEstimator::onRender(int64_t pts)
+{
+    onRender(pts, MediaClock::now());
+}
+
+void AudioDriftEstimator::onRender(int64_t pts, int64_t now_ns)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    if (rate_ != AUDIO_DRIFT_NORMAL_RATE)
+        return;
+    if (anchor_ns_ < 0 || now_ns < anchor_ns_) {
+        restartLocked(pts, now_ns);
+        return;
+    }
+
+    // audio position ahead of the system clock since the anchor
+    double t = (now_ns - anchor_ns_) / 1e9;
+    double offset = (double)(pts - anchor_pts_) - (now_ns - anchor_ns_) / 1000;
+    if (fabs(offset - last_offset_) > AUDIO_DRIFT_JUMP_US) {
+        restartLocked(pts, now_ns);
+        return;
+    }
+    last_offset_ = offset;
+    span_ = t;
+    count_ += 1;
+    sum_t_ += t;
+    sum_o_ += offset;
+    sum_tt_ += t * t;
+    sum_to_ += t * offset;
+
+    if (span_ * 1000000 >= (has_drift_ ? AUDIO_DRIFT_WINDOW_US : AUDIO_DRIFT_FIRST_WINDOW_US)) {
+        estimateLocked();
+        restartLocked(pts, now_ns);
+    }
+}
+
+void AudioDriftEstimator::restartLocked(int64_t pts, int64_t now_ns)
+{
+    anchor_ns_ = now_ns;
+    anchor_pts_ = pts;
+    last_offset_ = 0;
+    span_ = 0;
+    count_ = 1;
+    sum_t_ = 0;
+    sum_o_ = 0;
+    sum_tt_ = 0;
+    sum_to_ = 0;
+    window_correction_ = correction_ppm_;
+}
+
+void AudioDriftEstimator::estimateLocked()
+{
+    double denominator = count_ * sum_tt_ - sum_t_ * sum_t_;
+    if (denominator <= 0)
+        return;
+
+    // us per s : ppm of the stretched audio, the renderer runs faster by the stretch
+    double slope = (count_ * sum_to_ - sum_t_ * sum_o_) / denominator;
+    if (fabs(slope) > AUDIO_DRIFT_MAX_ESTIMATE_PPM) {
+        NDLLOG(LOGTAG, NDL_LOGI, "%s: %.0f ppm over %.1f s ignored", __func__, slope, span_);
+        return;
+    }
+    int32_t ppm = (int32_t)lrint(slope) + window_correction_;
+    drift_ppm_ = has_drift_ ? (drift_ppm_ * 3 + ppm) / 4 : ppm;
+    has_drift_ = true;
+
+    if (compensate_)
+        correction_ppm_ = std::max(-AUDIO_RESAMPLE_MAX_DRIFT_PPM, std::min(AUDIO_RESAMPLE_MAX_DRIFT_PPM, drift_ppm_));
+    NDLLOG(LOGTAG, NDL_LOGI, "%s: %d ppm over %.1f s (%d ppm stretch), drift %d ppm, correction %d ppm", __func__,
+            (int)lrint(slope), span_, window_correction_, drift_ppm_, correction_ppm_);
+}
+
+int32_t AudioDriftEstimator::getDrift()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    return drift_ppm_;
+}
+
+int32_t AudioDriftEstimator::getCorrection()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    return correction_ppm_;
+}
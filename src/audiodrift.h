@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+
+#ifndef NDL_DIRECTMEDIA2_AUDIO_DRIFT_H_
+#define NDL_DIRECTMEDIA2_AUDIO_DRIFT_H_
+
+#include <stdint.h>
+#include <mutex>
+
+// render events over FIRST give the first estimate, then one estimate per WINDOW
+#define AUDIO_DRIFT_FIRST_WINDOW_US 20000000
+#define AUDIO_DRIFT_WINDOW_US       60000000
+// audio position moved by more than this between two render events (seek, underrun) : new window
+#define AUDIO_DRIFT_JUMP_US         100000
+// a crystal is not that far off : audio without pts or at another rate, the window is not used
+#define AUDIO_DRIFT_MAX_ESTIMATE_PPM 10000
+// 1x in the rates of setRate (Clock::NORMAL_PLAYBACK_RATE)
+#define AUDIO_DRIFT_NORMAL_RATE     1000
+
+namespace NDL_Esplayer {
+
+    /**
+     * Clock drift of the audio renderer against CLOCK_MONOTONIC.
+     * The rendered audio pts against the time of their render events are fitted by least
+     * squares over a window, the slope is the drift (positive : the renderer plays fast).
+     * With the compensation on, the correction is the drift within +-AUDIO_RESAMPLE_MAX_DRIFT_PPM,
+     * the software audio is stretched by it (AudioResampler drift mode) so that the audio,
+     * and the clock referenced to it, keeps the pace of the system clock.
+     * NDL_AUDIO_DRIFT_COMPENSATION=1 in the environment turns the compensation on.
+     * Render events come from the audio renderer callbacks (non-tunnel) or from the media time of the
+     * clock following the audio renderer (ClockSampler, tunneled), the correction is read by the feeder.
+     */
+    class AudioDriftEstimator {
+        public:
+            static bool configuredCompensation();
+
+            AudioDriftEstimator();
+
+            void setCompensation(bool enable);
+            /**
+             * New window (flush), the estimate and the correction are kept
+             */
+            void reset();
+            /**
+             * The estimate and the correction too (load)
+             */
+            void clear();
+            /**
+             * Playback rate in 1/1000, estimated at AUDIO_DRIFT_NORMAL_RATE only
+             */
+            void setRate(int rate);
+
+            /**
+             * Audio sample with pts (us) rendered now
+             */
+            void onRender(int64_t pts);
+            // at now_ns on CLOCK_MONOTONIC, for tests
+            void onRender(int64_t pts, int64_t now_ns);
+
+            /**
+             * Drift of the audio renderer (ppm), 0 until the first estimate
+             */
+            int32_t getDrift();
+            /**
+             * Stretch of the software audio (ppm), 0 without the compensation
+             */
+            int32_t getCorrection();
+
+        private:
+            void restartLocked(int64_t pts, int64_t now_ns);
+            void estimateLocked();
+
+            std::mutex lock_;
+            bool compensate_ {false};
+            int rate_ {AUDIO_DRIFT_NORMAL_RATE};
+
+            // window : the offset of the audio from the system clock against the time, since the anchor
+            int64_t anchor_ns_ {-1};
+            int64_t anchor_pts_ {0};
+            double last_offset_ {0};
+            double span_ {0};       // s
+            double count_ {0};
+            double sum_t_ {0};
+            double sum_o_ {0};
+            double sum_tt_ {0};
+            double sum_to_ {0};
+            int32_t window_correction_ {0};   // correction the audio of the window was stretched by
+
+            bool has_drift_ {false};
+            int32_t drift_ppm_ {0};
+            int32_t correction_ppm_ {0};
+    };
+
+} //namespace NDL_Esplayer
+
+#endif //NDL_DIRECTMEDIA2_AUDIO_DRIFT_H_
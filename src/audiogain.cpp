@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#include <string.h>
+#include <algorithm>
+
+#include "audiogain.h"
+
+using namespace NDL_Esplayer;
+
+#define LOGTAG "audiogain"
+#include "debug.h"
+
+AudioGain::AudioGain()
+    : gain_func_(getAudioGainFunc())
+    , ramp_func_(getAudioRampFunc())
+{
+}
+
+void AudioGain::setVolume(int volume, int duration, NDL_ESP_EASE_TYPE type)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    float target = std::min(std::max(volume, 0), 100) / 100.0f;
+
+    // a new ramp starts where the running one is now
+    if (ramp_duration_ > 0 && ramp_frames_ > 0)
+        gain_ = easedGain(ramp_position_);
+
+    if (duration <= 0 || target == gain_) {
+        gain_ = target;
+        ramp_duration_ = 0;
+    } else {
+        ramp_start_ = gain_;
+        ramp_target_ = target;
+        ramp_duration_ = duration;
+        ramp_frames_ = 0;
+        ramp_position_ = 0;
+        ease_type_ = type;
+    }
+    NDLLOG(LOGTAG, NDL_LOGD, "%s: gain %.3f -> %.3f in %dms, ease %d",
+            __func__, gain_, target, ramp_duration_, type);
+}
+
+void AudioGain::setMute(bool mute)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    mute_ = mute;
+}
+
+bool AudioGain::isPassthrough()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    return !mute_ && ramp_duration_ == 0 && gain_ == 1.0f;
+}
+
+float AudioGain::easedGain(int64_t frame) const
+{
+    float t = std::min((float)frame / ramp_frames_, 1.0f);
+    float eased;
+    switch (ease_type_) {
+        case EASE_TYPE_INCUNBIC:
+            eased = t * t * t;
+            break;
+        case EASE_TYPE_OUTCUBIC:
+            eased = 1.0f - (1.0f - t) * (1.0f - t) * (1.0f - t);
+            break;
+        default:
+            eased = t;
+            break;
+    }
+    return ramp_start_ + (ramp_target_ - ramp_start_) * eased;
+}
+
+void AudioGain::process(int16_t* samples, int frames, int channels, int sample_rate)
+{
+    if (frames <= 0 || channels <= 0 || channels > AUDIO_CONVERT_MAX_CHANNELS)
+        return;
+
+    std::lock_guard<std::mutex> lock(lock_);
+    if (ramp_duration_ > 0) {
+        // the ramp runs in frames of the stream, not in the time process is called at
+        if (ramp_frames_ == 0)
+            ramp_frames_ = std::max((int64_t)ramp_duration_ * sample_rate / 1000, (int64_t)1);
+
+        float gains[AUDIO_GAIN_BLOCK_FRAMES * AUDIO_CONVERT_MAX_CHANNELS];
+        while (frames > 0 && ramp_position_ < ramp_frames_) {
+            int count = (int)std::min((int64_t)std::min(frames, AUDIO_GAIN_BLOCK_FRAMES), ramp_frames_ - ramp_position_);
+            if (mute_) {
+                memset(samples, 0, (size_t)count * channels * sizeof(int16_t));
+            } else {
+                for (int i = 0; i < count; i++) {
+                    float gain = easedGain(ramp_position_ + i);
+                    for (int ch = 0; ch < channels; ch++)
+                        gains[i * channels + ch] = gain;
+                }
+                ramp_func_(samples, gains, count * channels);
+            }
+            samples += (size_t)count * channels;
+            frames -= count;
+            ramp_position_ += count;
+        }
+        if (ramp_position_ >= ramp_frames_) {
+            gain_ = ramp_target_;
+            ramp_duration_ = 0;
+        }
+    }
+
+    if (frames <= 0)
+        return;
+    if (mute_ || gain_ == 0.0f)
+        memset(samples, 0, (size_t)frames * channels * sizeof(int16_t));
+    else if (gain_ != 1.0f)
+        gain_func_(samples, gain_, frames * channels);
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#ifndef NDL_DIRECTMEDIA2_AUDIO_GAIN_H_
+#define NDL_DIRECTMEDIA2_AUDIO_GAIN_H_
+
+#include <stdint.h>
+#include <mutex>
+
+#include "ndl-directmedia2/media-types.h"
+#include "audioconvert.h"
+
+// frames of gains computed at once during a ramp, stays in L1
+#define AUDIO_GAIN_BLOCK_FRAMES 256
+
+namespace NDL_Esplayer {
+
+    /**
+     * Volume and mute of the S16 pcm written into the audio codec.
+     * setVolume/setMute come from the API thread, process runs on the feeder.
+     * Unity gain leaves the samples untouched, mute zero fills them,
+     * a volume change is eased over its duration with a gain of each sample.
+     */
+    class AudioGain {
+        public:
+            AudioGain();
+
+            /**
+             * Move to volume(0~100) from the current gain in duration(ms), at once if 0
+             */
+            void setVolume(int volume, int duration, NDL_ESP_EASE_TYPE type);
+            void setMute(bool mute);
+
+            /**
+             * Apply the gain in place on interleaved S16 frames,
+             * the ramp advances by frames at sample_rate
+             */
+            void process(int16_t* samples, int frames, int channels, int sample_rate);
+
+            /**
+             * true if process leaves the samples untouched
+             */
+            bool isPassthrough();
+
+        private:
+            float easedGain(int64_t frame) const;
+
+            std::mutex lock_;
+            AudioGainFunc gain_func_;
+            AudioRampFunc ramp_func_;
+
+            float gain_ {1.0f};          // current gain, the end of the ramp when it is done
+            float ramp_start_ {1.0f};
+            float ramp_target_ {1.0f};
+            int ramp_duration_ {0};      // ms, 0 if no ramp
+            int64_t ramp_frames_ {0};    // length of the ramp at the rate it runs, 0 until the first process
+            int64_t ramp_position_ {0};
+            NDL_ESP_EASE_TYPE ease_type_ {EASE_TYPE_LINEAR};
+            bool mute_ {false};
+    };
+
+} //namespace NDL_Esplayer
+
+#endif //NDL_DIRECTMEDIA2_AUDIO_GAIN_H_
@@ -0,0 +1,408 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define AUDIO_RESAMPLE_HAVE_NEON 1
+#endif
+
+#include "audioresampler.h"
+
+using namespace NDL_Esplayer;
+
+#define LOGTAG "audioresampler"
+#include "debug.h"
+
+// M_PI is not there with -std=c++11
+#define RESAMPLE_PI 3.14159265358979323846
+
+namespace {
+
+    struct FilterSpec {
+        int taps;
+        double beta;      // kaiser window
+        double rolloff;   // cutoff of the passband against the nyquist of the lower rate
+    };
+
+    const FilterSpec filter_specs[] = {
+        {  8, 5.0, 0.75 },  // AUDIO_RESAMPLE_LOW
+        { 16, 6.5, 0.85 },  // AUDIO_RESAMPLE_MEDIUM
+        { 32, 8.0, 0.92 },  // AUDIO_RESAMPLE_HIGH
+    };
+
+    // taps are a multiple of 8 : no tail in the SIMD dot products
+    struct ScalarDot {
+        static int32_t dot(const int16_t* x, const int16_t* h, int taps) {
+            int32_t acc = 0;
+            for (int k = 0; k < taps; k++)
+                acc += (int32_t)x[k] * h[k];
+            return acc;
+        }
+    };
+
+#if defined(__SSE2__)
+    struct Sse2Dot {
+        static int32_t dot(const int16_t* x, const int16_t* h, int taps) {
+            __m128i acc = _mm_setzero_si128();
+            for (int k = 0; k < taps; k += 8) {
+                acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(x + k)),
+                            _mm_loadu_si128((const __m128i*)(h + k))));
+            }
+            acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0x4E));
+            acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0xB1));
+            return _mm_cvtsi128_si32(acc);
+        }
+    };
+#endif
+
+#if defined(AUDIO_RESAMPLE_HAVE_NEON)
+    struct NeonDot {
+        static int32_t dot(const int16_t* x, const int16_t* h, int taps) {
+            int32x4_t acc = vdupq_n_s32(0);
+            for (int k = 0; k < taps; k += 8) {
+                int16x8_t a = vld1q_s16(x + k);
+                int16x8_t b = vld1q_s16(h + k);
+                acc = vmlal_s16(acc, vget_low_s16(a), vget_low_s16(b));
+                acc = vmlal_s16(acc, vget_high_s16(a), vget_high_s16(b));
+            }
+            int32x2_t sum = vadd_s32(vget_low_s32(acc), vget_high_s32(acc));
+            return vget_lane_s32(vpadd_s32(sum, sum), 0);
+        }
+    };
+#endif
+
+    /**
+     * All the outputs the planes have input for, the dot product inlined
+     */
+    template <typename D>
+    int resampleLoop(const AudioResampler::Planes& planes, const int16_t* coeffs, int taps,
+            int phases, int step, int* position, int* phase, int16_t* out)
+    {
+        int count = 0;
+        int pos = *position;
+        int ph = *phase;
+        while (pos + taps <= planes.size) {
+            const int16_t* filter = coeffs + (size_t)ph * taps;
+            for (int ch = 0; ch < planes.channels; ch++) {
+                int32_t acc = (D::dot(planes.data + (size_t)ch * planes.stride + pos, filter, taps) + (1 << 14)) >> 15;
+                *out++ = (int16_t)std::min(std::max(acc, (int32_t)-32768), (int32_t)32767);
+            }
+            count++;
+            ph += step;
+            while (ph >= phases) {
+                ph -= phases;
+                pos++;
+            }
+        }
+        *position = pos;
+        *phase = ph;
+        return count;
+    }
+
+    /**
+     * Drift mode : the output between the two phases around its fraction of an input frame,
+     * weighted in Q15 by the rest of the fraction
+     */
+    template <typename D>
+    int driftLoop(const AudioResampler::Planes& planes, const int16_t* coeffs, int taps,
+            int phases, uint64_t step, int* position, uint64_t* fraction, int16_t* out)
+    {
+        int count = 0;
+        int pos = *position;
+        uint64_t frac = *fraction;
+        while (pos + taps <= planes.size) {
+            uint64_t scaled = frac * phases;
+            const int16_t* filter = coeffs + (size_t)(scaled >> 32) * taps;
+            int64_t weight = (int64_t)((scaled >> 17) & 0x7FFF);
+            for (int ch = 0; ch < planes.channels; ch++) {
+                const int16_t* x = planes.data + (size_t)ch * planes.stride + pos;
+                int64_t a = D::dot(x, filter, taps);
+                int64_t b = D::dot(x, filter + taps, taps);
+                int64_t acc = (a + (((b - a) * weight) >> 15) + (1 << 14)) >> 15;
+                *out++ = (int16_t)std::min(std::max(acc, (int64_t)-32768), (int64_t)32767);
+            }
+            count++;
+            frac += step;
+            pos += (int)(frac >> 32);
+            frac &= 0xFFFFFFFFULL;
+        }
+        *position = pos;
+        *fraction = frac;
+        return count;
+    }
+
+    // zeroth order modified bessel function of the first kind, for the kaiser window
+    double besselI0(double x)
+    {
+        double sum = 1.0;
+        double term = 1.0;
+        for (int k = 1; k < 50; k++) {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+            if (term < sum * 1e-12)
+                break;
+        }
+        return sum;
+    }
+
+    int gcd(int a, int b)
+    {
+        while (b) {
+            int t = a % b;
+            a = b;
+            b = t;
+        }
+        return a;
+    }
+}
+
+AUDIO_RESAMPLE_QUALITY AudioResampler::configuredQuality()
+{
+    const char* value = getenv("NDL_AUDIO_RESAMPLE_QUALITY");
+    if (value) {
+        for (int quality = AUDIO_RESAMPLE_LOW; quality <= AUDIO_RESAMPLE_HIGH; quality++) {
+            if (!strcmp(value, qualityName((AUDIO_RESAMPLE_QUALITY)quality)))
+                return (AUDIO_RESAMPLE_QUALITY)quality;
+        }
+        NDLLOG(LOGTAG, NDL_LOGE, "NDL_AUDIO_RESAMPLE_QUALITY=%s is not low|medium|high, ignored", value);
+    }
+    return AUDIO_RESAMPLE_MEDIUM;
+}
+
+const char* AudioResampler::qualityName(AUDIO_RESAMPLE_QUALITY quality)
+{
+    switch (quality) {
+        case AUDIO_RESAMPLE_LOW:    return "low";
+        case AUDIO_RESAMPLE_MEDIUM: return "medium";
+        case AUDIO_RESAMPLE_HIGH:   return "high";
+    }
+    return "unknown";
+}
+
+AudioResampler::AudioResampler()
+{
+}
+
+bool AudioResampler::init(int in_rate, int out_rate, int channels, AUDIO_RESAMPLE_QUALITY quality,
+        AUDIO_CONVERT_IMPL impl)
+{
+    channels_ = 0;
+    if (in_rate <= 0 || out_rate <= 0 || channels <= 0)
+        return false;
+
+    int divisor = gcd(in_rate, out_rate);
+    if (out_rate / divisor > AUDIO_RESAMPLE_MAX_PHASES) {
+        NDLLOG(LOGTAG, NDL_LOGI, "%s: %d -> %d needs %d phases", __func__, in_rate, out_rate, out_rate / divisor);
+        return false;
+    }
+    if (!selectLoops(impl))
+        return false;
+
+    in_rate_ = in_rate;
+    out_rate_ = out_rate;
+    phases_ = out_rate / divisor;
+    step_ = in_rate / divisor;
+    drift_ = false;
+    buildFilter(quality);
+
+    history_stride_ = taps_;
+    history_.assign((size_t)channels * history_stride_, 0);
+    channels_ = channels;
+    reset();
+
+    NDLLOG(LOGTAG, NDL_LOGI, "%s: %d -> %d %dch, %d phases of %d taps (%s)", __func__,
+            in_rate, out_rate, channels, phases_, taps_, qualityName(quality));
+    return true;
+}
+
+bool AudioResampler::initDrift(int rate, int channels, AUDIO_RESAMPLE_QUALITY quality,
+        AUDIO_CONVERT_IMPL impl)
+{
+    channels_ = 0;
+    if (rate <= 0 || channels <= 0 || !selectLoops(impl))
+        return false;
+
+    in_rate_ = rate;
+    out_rate_ = rate;
+    phases_ = AUDIO_RESAMPLE_DRIFT_PHASES;
+    step_ = phases_;
+    drift_ = true;
+    setDrift(0);
+    buildFilter(quality);
+
+    history_stride_ = taps_;
+    history_.assign((size_t)channels * history_stride_, 0);
+    channels_ = channels;
+    reset();
+
+    NDLLOG(LOGTAG, NDL_LOGI, "%s: %d %dch, %d phases of %d taps (%s)", __func__,
+            rate, channels, phases_, taps_, qualityName(quality));
+    return true;
+}
+
+void AudioResampler::setDrift(int ppm)
+{
+    ppm = std::max(-AUDIO_RESAMPLE_MAX_DRIFT_PPM, std::min(AUDIO_RESAMPLE_MAX_DRIFT_PPM, ppm));
+    drift_ppm_ = ppm;
+    drift_step_ = (uint64_t)llrint(4294967296.0 * 1000000.0 / (1000000.0 + ppm));
+}
+
+bool AudioResampler::selectLoops(AUDIO_CONVERT_IMPL impl)
+{
+    if (impl == AUDIO_CONVERT_AUTO)
+        impl = getAudioConvertImpl();
+    switch (impl) {
+        case AUDIO_CONVERT_SCALAR:
+            loop_ = resampleLoop<ScalarDot>;
+            drift_loop_ = driftLoop<ScalarDot>;
+            return true;
+#if defined(__SSE2__)
+        // a few taps per output : avx2 has no gain over sse2 here
+        case AUDIO_CONVERT_SSE2:
+        case AUDIO_CONVERT_AVX2:
+            loop_ = resampleLoop<Sse2Dot>;
+            drift_loop_ = driftLoop<Sse2Dot>;
+            return true;
+#endif
+#if defined(AUDIO_RESAMPLE_HAVE_NEON)
+        case AUDIO_CONVERT_NEON:
+            loop_ = resampleLoop<NeonDot>;
+            drift_loop_ = driftLoop<NeonDot>;
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+void AudioResampler::buildFilter(AUDIO_RESAMPLE_QUALITY quality)
+{
+    const FilterSpec& spec = filter_specs[quality];
+    // downsampling : the cutoff follows the output nyquist, more taps keep the transition band
+    double ratio = std::min(1.0, (double)out_rate_ / in_rate_);
+    taps_ = spec.taps * (int)ceil(1.0 / ratio);
+    double cutoff = 0.5 * ratio * spec.rolloff;  // cycles per input sample
+    int half = taps_ / 2;
+    double window_norm = besselI0(spec.beta);
+
+    // drift mode : the last phase is the first one of the next input frame, for the interpolation
+    int rows = drift_ ? phases_ + 1 : phases_;
+    coeffs_.assign((size_t)rows * taps_, 0);
+    std::vector<double> filter(taps_);
+    for (int phase = 0; phase < rows; phase++) {
+        // output of the phase sits between input half - 1 and half
+        double offset = (half - 1) + (double)phase / phases_;
+        double sum = 0.0;
+        for (int k = 0; k < taps_; k++) {
+            double x = k - offset;
+            double t = x / half;
+            double window = t * t < 1.0 ? besselI0(spec.beta * sqrt(1.0 - t * t)) / window_norm : 0.0;
+            double arg = 2.0 * cutoff * x;
+            double sinc = arg == 0.0 ? 1.0 : sin(RESAMPLE_PI * arg) / (RESAMPLE_PI * arg);
+            filter[k] = sinc * window;
+            sum += filter[k];
+        }
+
+        // unity gain at DC : the rounding error goes to the largest tap
+        int16_t* coeffs = &coeffs_[(size_t)phase * taps_];
+        int total = 0;
+        int largest = 0;
+        for (int k = 0; k < taps_; k++) {
+            coeffs[k] = (int16_t)lrint(filter[k] / sum * 32768.0);
+            total += coeffs[k];
+            if (abs(coeffs[k]) > abs(coeffs[largest]))
+                largest = k;
+        }
+        coeffs[largest] = (int16_t)std::min(coeffs[largest] + 32768 - total, 32767);
+    }
+}
+
+void AudioResampler::reset()
+{
+    // half the taps of silence before the first input : no delay of the output
+    history_size_ = taps_ / 2 - 1;
+    std::fill(history_.begin(), history_.end(), 0);
+    position_ = 0;
+    phase_ = 0;
+    drift_fraction_ = 0;
+}
+
+int AudioResampler::getOutSamples(int in_frames) const
+{
+    if (!isInitialized())
+        return 0;
+    if (drift_) {
+        // outputs while position + taps <= history size
+        int64_t last = (int64_t)history_size_ + in_frames - taps_ - position_;
+        if (last < 0)
+            return 0;
+        return (int)((((last + 1) << 32) - 1 - (int64_t)drift_fraction_) / (int64_t)drift_step_) + 1;
+    }
+    int64_t positions = (int64_t)(history_size_ + in_frames) * phases_ - phase_;
+    return (int)(positions / step_) + 1;
+}
+
+int AudioResampler::process(const int16_t* in, int in_frames, int16_t* out)
+{
+    if (!isInitialized() || in_frames <= 0)
+        return 0;
+
+    if (history_size_ + in_frames > history_stride_) {
+        int stride = history_size_ + in_frames;
+        std::vector<int16_t> grown((size_t)channels_ * stride);
+        for (int ch = 0; ch < channels_; ch++)
+            memcpy(&grown[(size_t)ch * stride], &history_[(size_t)ch * history_stride_], history_size_ * sizeof(int16_t));
+        history_.swap(grown);
+        history_stride_ = stride;
+    }
+
+    for (int ch = 0; ch < channels_; ch++) {
+        int16_t* plane = &history_[(size_t)ch * history_stride_] + history_size_;
+        for (int i = 0; i < in_frames; i++)
+            plane[i] = in[(size_t)i * channels_ + ch];
+    }
+    history_size_ += in_frames;
+
+    Planes planes {history_.data(), history_stride_, history_size_, channels_};
+    int count = drift_ ? drift_loop_(planes, coeffs_.data(), taps_, phases_, drift_step_, &position_, &drift_fraction_, out)
+        : loop_(planes, coeffs_.data(), taps_, phases_, step_, &position_, &phase_, out);
+
+    // frames before the next output are not needed anymore
+    int consumed = std::min(position_, history_size_);
+    if (consumed > 0) {
+        for (int ch = 0; ch < channels_; ch++) {
+            int16_t* plane = &history_[(size_t)ch * history_stride_];
+            memmove(plane, plane + consumed, (history_size_ - consumed) * sizeof(int16_t));
+        }
+        history_size_ -= consumed;
+        position_ -= consumed;
+    }
+    return count;
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#ifndef NDL_DIRECTMEDIA2_AUDIO_RESAMPLER_H_
+#define NDL_DIRECTMEDIA2_AUDIO_RESAMPLER_H_
+
+#include <stdint.h>
+#include <vector>
+
+#include "audioconvert.h"
+
+/**
+ * Most filter phases (interpolation factor after reducing the rates),
+ * rates further apart in their gcd are resampled by swresample
+ */
+#define AUDIO_RESAMPLE_MAX_PHASES 1024
+/**
+ * Drift mode : filter phases between two input samples, the output is interpolated
+ * between the two nearest ones. Stretch of the output within +-MAX_DRIFT_PPM
+ */
+#define AUDIO_RESAMPLE_DRIFT_PHASES 512
+#define AUDIO_RESAMPLE_MAX_DRIFT_PPM 1000
+
+namespace NDL_Esplayer {
+
+    /**
+     * Filter taps of each output sample : cpu against stopband rejection.
+     * NDL_AUDIO_RESAMPLE_QUALITY=low|medium|high in the environment
+     */
+    typedef enum {
+        AUDIO_RESAMPLE_LOW,     // 8 taps
+        AUDIO_RESAMPLE_MEDIUM,  // 16 taps
+        AUDIO_RESAMPLE_HIGH,    // 32 taps
+    } AUDIO_RESAMPLE_QUALITY;
+
+    /**
+     * Polyphase FIR resampler of interleaved S16 between rates of a small ratio
+     * (ex. 44100 -> 48000 is 160/147). Q15 coefficients of a Kaiser windowed sinc,
+     * one phase per output position, dot products on the SIMD kernel of the cpu.
+     * The first output sample is at the time of the first input sample.
+     * The drift mode keeps the rate and stretches the output by a few ppm
+     * (ex. for the clock drift of the audio renderer), the stretch can change at every call.
+     */
+    class AudioResampler {
+        public:
+            static AUDIO_RESAMPLE_QUALITY configuredQuality();
+            static const char* qualityName(AUDIO_RESAMPLE_QUALITY quality);
+
+            AudioResampler();
+
+            /**
+             * return false if the rates need more than AUDIO_RESAMPLE_MAX_PHASES phases,
+             * or impl is not supported (AUDIO_CONVERT_AUTO when swresample is forced)
+             */
+            bool init(int in_rate, int out_rate, int channels, AUDIO_RESAMPLE_QUALITY quality,
+                    AUDIO_CONVERT_IMPL impl = AUDIO_CONVERT_AUTO);
+            /**
+             * Drift mode at rate, no stretch until setDrift.
+             * return false if impl is not supported
+             */
+            bool initDrift(int rate, int channels, AUDIO_RESAMPLE_QUALITY quality,
+                    AUDIO_CONVERT_IMPL impl = AUDIO_CONVERT_AUTO);
+            /**
+             * Drift mode : ppm more output frames than input frames, fewer if negative.
+             * Clipped to +-AUDIO_RESAMPLE_MAX_DRIFT_PPM, applies from the next output
+             */
+            void setDrift(int ppm);
+            int getDrift() const { return drift_ppm_; };
+            bool isInitialized() const { return channels_ > 0; };
+            int getInputRate() const { return in_rate_; };
+            int getOutputRate() const { return out_rate_; };
+            int getChannels() const { return channels_; };
+            int getTaps() const { return taps_; };
+
+            /**
+             * Most output frames of the next process of in_frames
+             */
+            int getOutSamples(int in_frames) const;
+            /**
+             * Resample in_frames frames, the last taps of the input stay for the next call.
+             * return output frames written into out
+             */
+            int process(const int16_t* in, int in_frames, int16_t* out);
+            /**
+             * Forget the history (flush), the next input starts a new stream
+             */
+            void reset();
+
+            /**
+             * Per channel planes of input frames, the kernels read them
+             */
+            struct Planes {
+                const int16_t* data;
+                int stride;
+                int size;
+                int channels;
+            };
+
+        private:
+            typedef int (*LoopFunc)(const Planes& planes, const int16_t* coeffs, int taps,
+                    int phases, int step, int* position, int* phase, int16_t* out);
+            typedef int (*DriftLoopFunc)(const Planes& planes, const int16_t* coeffs, int taps,
+                    int phases, uint64_t step, int* position, uint64_t* fraction, int16_t* out);
+
+            bool selectLoops(AUDIO_CONVERT_IMPL impl);
+            void buildFilter(AUDIO_RESAMPLE_QUALITY quality);
+
+            int in_rate_ {0};
+            int out_rate_ {0};
+            int channels_ {0};
+            int taps_ {0};
+            int phases_ {0};        // L : output positions between two input samples
+            int step_ {0};          // M : phases advanced per output sample
+            LoopFunc loop_ {nullptr};
+            DriftLoopFunc drift_loop_ {nullptr};
+            std::vector<int16_t> coeffs_;   // phases_ * taps_, one more phase in the drift mode
+            std::vector<int16_t> history_;  // per channel planes of history_stride_
+            int history_stride_ {0};
+            int history_size_ {0};  // input frames in each plane
+            int position_ {0};      // first input frame of the next output
+            int phase_ {0};         // phase of the next output
+
+            bool drift_ {false};
+            int drift_ppm_ {0};
+            uint64_t drift_step_ {0};   // input frames per output, 32 bit fraction
+            uint64_t drift_fraction_ {0};   // of the next output after position_, 32 bit fraction
+    };
+
+} //namespace NDL_Esplayer
+
+#endif //NDL_DIRECTMEDIA2_AUDIO_RESAMPLER_H_
@@ -18,6 +18,9 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <string.h>
+#include <algorithm>
+
 #include "audioswdecoder.h"
 
 using namespace NDL_Esplayer;
@@ -30,11 +33,30 @@ AudioSwDecoder::AudioSwDecoder()
     NDLLOG(LOGTAG, NDL_LOGI, "%s", __func__);
     avctx_ = NULL;
     avframe_ = NULL;
+    avctx_opened_ = false;
     swrctx_ = NULL;
-
+    convert_ = NULL;
+    downmix_ = NULL;
+    lpcm_ = NULL;
+    lpcm_prepared_ = false;
+
+    input_layout_ = 0;
+    input_channels_ = 0;
+    input_sample_rate_ = 0;
+    swr_resample_ = false;
+    drift_ppm_ = 0;
+    drift_active_ = false;
+    requested_channels_ = 0;
+    requested_sample_rate_ = 0;
     output_channels_ = 0;
-    output_buffer_size_ = 0;
-    output_buffer_data_ = NULL;
+    output_frame_size_ = 0;
+    output_sample_rate_ = 0;
+    frame_read_ = 0;
+    staged_size_ = 0;
+    output_size_ = 0;
+    output_read_ = 0;
+    output_pts_ = 0;
+    next_pts_ = 0;
     input_sample_fmt_ = AV_SAMPLE_FMT_NONE;
     output_sample_fmt_ = AV_SAMPLE_FMT_NONE;
 }
@@ -43,11 +65,14 @@ AudioSwDecoder::~AudioSwDecoder()
 {
     NDLLOG(LOGTAG, NDL_LOGI, "%s", __func__);
 
-    if (output_buffer_data_)
-        av_free(output_buffer_data_);
-    output_buffer_data_ = NULL;
-    output_buffer_size_ = 0;
     output_channels_ = 0;
+    output_size_ = 0;
+    output_read_ = 0;
+
+    ClearFrames();
+    for (AVFrame* frame : free_frames_)
+        av_frame_free(&frame);
+    free_frames_.clear();
 
     if (swrctx_)
         swr_free(&swrctx_);
@@ -57,7 +82,10 @@ AudioSwDecoder::~AudioSwDecoder()
         av_frame_free(&avframe_);
     avframe_ = NULL;
 
-    if (avctx_)
+    // an opened context is kept for the next decoder of the same stream parameters
+    if (avctx_ && avctx_opened_)
+        AudioDecoderCache::instance().release(avctx_key_, avctx_);
+    else if (avctx_)
         avcodec_free_context(&avctx_);
     avctx_ = NULL;
 }
@@ -65,7 +93,22 @@ AudioSwDecoder::~AudioSwDecoder()
 bool AudioSwDecoder::OpenAudio(enum AVCodecID codec_id)
 {
     AVCodec* codec = NULL;
-    avcodec_register_all();
+    AudioDecoderCache::registerCodecs();
+
+    avctx_key_.codec_id              = codec_id;
+    avctx_key_.channels              = audio_stream_info_.channels;
+    avctx_key_.sample_rate           = audio_stream_info_.sample_rate;
+    avctx_key_.bit_rate              = audio_stream_info_.bit_rate;
+    avctx_key_.block_align           = audio_stream_info_.block_align;
+    avctx_key_.bits_per_coded_sample = audio_stream_info_.bits_per_coded_sample ?
+        audio_stream_info_.bits_per_coded_sample : 16;
+
+    avctx_ = AudioDecoderCache::instance().acquire(avctx_key_);
+    if (avctx_)
+    {
+        avctx_opened_ = true;
+        return InitOutput();
+    }
 
     codec = avcodec_find_decoder(codec_id);
 
@@ -95,7 +138,31 @@ bool AudioSwDecoder::OpenAudio(enum AVCodecID codec_id)
         NDLLOG(LOGTAG, NDL_LOGE, "%s: codec open error AVCodecID:0x%", __func__, (int)codec_id);
         return false;
     }
+    avctx_opened_ = true;
+
+    return InitOutput();
+}
+
+bool AudioSwDecoder::OpenLpcm(const AudioLpcmFormat& format)
+{
+    lpcm_ = getAudioLpcmFunc(format);
+    if (!lpcm_)
+    {
+        NDLLOG(LOGTAG, NDL_LOGE, "%s: unsupported lpcm %dch %d bytes", __func__, format.channels, format.container_bytes);
+        return false;
+    }
+    lpcm_format_ = format;
+    input_channels_ = format.channels;
+    input_sample_rate_ = audio_stream_info_.sample_rate;
+    lpcm_prepared_ = false;
+    output_sample_fmt_ = AV_SAMPLE_FMT_S16;
+    NDLLOG(LOGTAG, NDL_LOGI, "%s: %dch %dHz, %d bytes %s endian", __func__, format.channels, input_sample_rate_,
+            format.container_bytes, format.big_endian ? "big" : "little");
+    return true;
+}
 
+bool AudioSwDecoder::InitOutput()
+{
     avframe_ = av_frame_alloc();
     input_sample_fmt_ = AV_SAMPLE_FMT_NONE;
 
@@ -109,71 +176,519 @@ bool AudioSwDecoder::OpenAudio(enum AVCodecID codec_id)
 int AudioSwDecoder::DecodeAudio(unsigned char* data, int size, double dts, double pts)
 {
     int ret = 0;
-    int got_frame = 0;
-    int outline_size = 0;
-    int output_size = 0;
     AVPacket avpkt;
 
     av_init_packet(&avpkt);
     avpkt.data = data;
     avpkt.size = size;
+    avpkt.dts = dts >= 0 ? (int64_t)dts : AV_NOPTS_VALUE;
+    avpkt.pts = pts >= 0 ? (int64_t)pts : AV_NOPTS_VALUE;
+
+    ClearFrames();
+    staged_size_ = 0;
+    output_size_ = 0;
+    output_read_ = 0;
+    // the packet pts stamps the first sample, the rest is derived from the sample count
+    output_pts_ = pts >= 0 ? (int64_t)pts : next_pts_;
+
+    if (lpcm_) {
+        AppendLpcm(data, size);
+        if (output_frame_size_ > 0 && output_sample_rate_ > 0)
+            next_pts_ = output_pts_ + (int64_t)(output_size_ / output_frame_size_) * 1000000 / output_sample_rate_;
+        return size;
+    }
 
-    ret = avcodec_decode_audio4( avctx_, avframe_, &got_frame, &avpkt);
+    ret = avcodec_send_packet(avctx_, &avpkt);
+    if (ret == AVERROR(EAGAIN)) {
+        // frames left in the codec : take them first and send again
+        while (avcodec_receive_frame(avctx_, avframe_) >= 0)
+            AppendFrame();
+        ret = avcodec_send_packet(avctx_, &avpkt);
+    }
+    if (ret < 0) {
+        NDLLOG(LOGTAG, NDL_LOGE, "%s: send packet error %d (size:%d)", __func__, ret, size);
+        return ret;
+    }
+
+    // a packet can hold several frames (ex. AAC-LATM, AC3 burst)
+    while ((ret = avcodec_receive_frame(avctx_, avframe_)) >= 0)
+        AppendFrame();
+    if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF)
+        NDLLOG(LOGTAG, NDL_LOGE, "%s: receive frame error %d", __func__, ret);
+
+    if (output_frame_size_ > 0 && output_sample_rate_ > 0)
+        next_pts_ = output_pts_ + (int64_t)(output_size_ / output_frame_size_) * 1000000 / output_sample_rate_;
 
-    output_size = av_samples_get_buffer_size(&outline_size, avctx_->channels, avframe_->nb_samples, output_sample_fmt_, 1);
+    return size;
+}
+
+bool AudioSwDecoder::PrepareConvert()
+{
+    uint64_t layout = avctx_->channel_layout ? avctx_->channel_layout : av_get_default_channel_layout(avctx_->channels);
 
-    if (output_buffer_size_ < output_size)
+    if (InputChanged(layout))
     {
-        NDLLOG(LOGTAG, NDL_LOGD, "%s: buffer allocate %d to %d", __func__, output_buffer_size_, output_size);
-        output_buffer_data_ = (unsigned char*)av_realloc(output_buffer_data_, output_size + FF_INPUT_BUFFER_PADDING_SIZE);
-        output_buffer_size_ = output_size;
+        // the kept frames are converted by the kernels prepared for them
+        StageFrames();
+        if (swrctx_)
+            swr_free(&swrctx_);
+        input_sample_fmt_ = avctx_->sample_fmt;
+        input_layout_ = layout;
+        input_channels_ = avctx_->channels;
+        input_sample_rate_ = avctx_->sample_rate;
+        output_channels_ = requested_channels_ > 0 ? requested_channels_ : input_channels_;
+
+        PrepareResampler();
+
+        // common layouts are converted by our kernels, swresample for the rest
+        convert_ = NULL;
+        downmix_ = NULL;
+        if (swr_resample_)
+        {
+            // swrctx_ converts format, channels and rate at once
+        }
+        else if (SameSpeakers(layout, GetOutputChannelLayout()))
+        {
+            convert_ = getAudioConvertFunc(input_sample_fmt_, input_channels_);
+        }
+        else if (output_channels_ == 2 && input_channels_ > 2)
+        {
+            downmix_ = getAudioDownmixFunc(input_sample_fmt_, input_channels_);
+            if (downmix_ && !buildStereoDownmix(layout, getAudioDownmixGains(), &downmix_matrix_))
+                downmix_ = NULL;
+        }
+        NDLLOG(LOGTAG, NDL_LOGI, "%s: fmt:%d %dch(0x%llx) %dHz -> S16 %dch(0x%llx) %dHz by %s%s", __func__,
+                input_sample_fmt_, input_channels_, (long long)layout, input_sample_rate_,
+                output_channels_, (long long)GetOutputChannelLayout(), GetOutputRate(),
+                convert_ ? "convert" : downmix_ ? "downmix" : "swr",
+                resampler_.isInitialized() ? " + resampler" : "");
     }
 
-    if (avctx_->sample_fmt != output_sample_fmt_)
-    {
-        //NDLLOG(LOGTAG, NDL_LOGD, "need to convert format. in sample fmt:%d, output sample fmt:%d", avctx_->sample_fmt, output_sample_fmt_);
+    if (convert_ || downmix_)
+        return true;
+    if (!swr_resample_ && avctx_->sample_fmt == output_sample_fmt_ && SameSpeakers(layout, GetOutputChannelLayout()))
+        return true;
 
-        if (swrctx_ && (avctx_->sample_fmt != input_sample_fmt_ || output_channels_ != avctx_->channels))
+    if (!swrctx_)
+    {
+        swrctx_ = swr_alloc_set_opts(NULL,
+                GetOutputChannelLayout(),
+                output_sample_fmt_, swr_resample_ ? requested_sample_rate_ : avctx_->sample_rate,
+                layout,
+                avctx_->sample_fmt, avctx_->sample_rate,
+                0, NULL);
+
+        if (!swrctx_ || swr_init(swrctx_) < 0)
         {
+            NDLLOG(LOGTAG, NDL_LOGE, "%s: format convert initialization error %d to %d", __func__, avctx_->sample_fmt, output_sample_fmt_);
+            if (swrctx_)
+                swr_free(&swrctx_);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool AudioSwDecoder::InputChanged(uint64_t layout)
+{
+    return avctx_->sample_fmt != input_sample_fmt_ || layout != input_layout_ || avctx_->channels != input_channels_ ||
+        avctx_->sample_rate != input_sample_rate_;
+}
+
+void AudioSwDecoder::PrepareResampler()
+{
+    // fixed output rate : polyphase kernels on the S16 output, swresample does all for odd rates
+    resampler_ = AudioResampler();
+    swr_resample_ = false;
+    if (requested_sample_rate_ > 0 && requested_sample_rate_ != input_sample_rate_)
+    {
+        swr_resample_ = !resampler_.init(input_sample_rate_, requested_sample_rate_, output_channels_,
+                AudioResampler::configuredQuality());
+    }
+}
+
+bool AudioSwDecoder::PrepareLpcm()
+{
+    if (!lpcm_prepared_)
+    {
+        output_channels_ = requested_channels_ > 0 ? requested_channels_ : input_channels_;
+        PrepareResampler();
+        lpcm_prepared_ = true;
+        NDLLOG(LOGTAG, NDL_LOGI, "%s: lpcm %dch %dHz -> S16 %dch(0x%llx) %dHz%s%s", __func__,
+                input_channels_, input_sample_rate_, output_channels_, (long long)GetOutputChannelLayout(),
+                GetOutputRate(), output_channels_ != input_channels_ || swr_resample_ ? " by swr" : "",
+                resampler_.isInitialized() ? " + resampler" : "");
+    }
+
+    if (swrctx_ || (output_channels_ == input_channels_ && !swr_resample_))
+        return true;
+
+    // other channel count (ex. stereo downmix) or odd rates : swresample on the converted S16
+    swrctx_ = swr_alloc_set_opts(NULL,
+            GetOutputChannelLayout(), output_sample_fmt_, swr_resample_ ? requested_sample_rate_ : input_sample_rate_,
+            av_get_default_channel_layout(input_channels_), AV_SAMPLE_FMT_S16, input_sample_rate_,
+            0, NULL);
+    if (!swrctx_ || swr_init(swrctx_) < 0)
+    {
+        NDLLOG(LOGTAG, NDL_LOGE, "%s: lpcm %dch to %dch initialization error", __func__, input_channels_, output_channels_);
+        if (swrctx_)
             swr_free(&swrctx_);
-            output_channels_ = avctx_->channels;
+        return false;
+    }
+    return true;
+}
+
+void AudioSwDecoder::AppendLpcm(const unsigned char* data, int size)
+{
+    const int channels = lpcm_format_.channels;
+    int frames = size / (channels * lpcm_format_.container_bytes);
+    if (frames <= 0 || !PrepareLpcm())
+        return;
+
+    int frame_size = av_get_bytes_per_sample(output_sample_fmt_) * output_channels_;
+    output_frame_size_ = frame_size;
+    output_sample_rate_ = GetOutputRate();
+    const bool drift = PrepareDrift();
+
+    // S16 of the lpcm channels, straight into the output (or the stretch) when nothing else follows
+    int16_t* s16;
+    if (swrctx_ || resampler_.isInitialized())
+    {
+        if (lpcm_s16_.size() < (size_t)frames * channels)
+            lpcm_s16_.resize((size_t)frames * channels);
+        s16 = lpcm_s16_.data();
+    }
+    else
+    {
+        s16 = (int16_t*)GetStageBuffer(frames, drift);
+    }
+    lpcm_(data, lpcm_format_, frames, s16);
+
+    if (swrctx_)
+    {
+        int out_samples = swr_get_out_samples(swrctx_, frames);
+        uint8_t* out;
+        if (resampler_.isInitialized())
+        {
+            if (resample_input_.size() < (size_t)out_samples * frame_size)
+                resample_input_.resize((size_t)out_samples * frame_size);
+            out = resample_input_.data();
         }
+        else
+        {
+            out = GetStageBuffer(out_samples, drift);
+        }
+        const uint8_t* in = (const uint8_t*)s16;
+        frames = swr_convert(swrctx_, &out, out_samples, &in, frames);
+        if (frames < 0)
+        {
+            NDLLOG(LOGTAG, NDL_LOGE, "%s: lpcm convert error %d", __func__, frames);
+            return;
+        }
+        s16 = (int16_t*)out;
+    }
+
+    if (resampler_.isInitialized())
+    {
+        int16_t* out = (int16_t*)GetStageBuffer(resampler_.getOutSamples(frames), drift);
+        frames = resampler_.process(s16, frames, out);
+    }
+    if (drift)
+        frames = ApplyDrift(frames);
+    output_size_ += frames * frame_size;
+    staged_size_ = output_size_;
+}
+
+void AudioSwDecoder::AppendFrame()
+{
+    int samples = avframe_->nb_samples;
+
+    if (samples <= 0 || !PrepareConvert())
+        return;
+
+    int frame_size = av_get_bytes_per_sample(output_sample_fmt_) * output_channels_;
+    int sample_rate = GetOutputRate();
+    if (output_size_ > 0 && (frame_size != output_frame_size_ || sample_rate != output_sample_rate_))
+    {
+        // one output has one layout, the sample count could not give the pts of the rest
+        NDLLOG(LOGTAG, NDL_LOGE, "%s: format changed in a packet, drop %d samples", __func__, samples);
+        return;
+    }
+    output_frame_size_ = frame_size;
+    output_sample_rate_ = sample_rate;
+    const bool drift = PrepareDrift();
 
-        if (!swrctx_)
+    if (KeepsFrame(drift))
+    {
+        // converted by ReadOutput straight into the buffer of the reader
+        AVFrame* frame = NULL;
+        if (!free_frames_.empty())
+        {
+            frame = free_frames_.back();
+            free_frames_.pop_back();
+        }
+        else if (!(frame = av_frame_alloc()))
         {
-            input_sample_fmt_ = avctx_->sample_fmt;
-            swrctx_ = swr_alloc_set_opts(NULL,
-                    av_get_default_channel_layout(avctx_->channels),
-                    output_sample_fmt_, avctx_->sample_rate,
-                    av_get_default_channel_layout(avctx_->channels),
-                    avctx_->sample_fmt, avctx_->sample_rate,
-                    0, NULL);
-
-            if (!swrctx_ || swr_init(swrctx_) < 0)
-            {
-                NDLLOG(LOGTAG, NDL_LOGE, "%s: format convert initialization error %d to %d", __func__, avctx_->sample_fmt, output_sample_fmt_);
-                return 0;
-            }
+            return;
         }
+        av_frame_move_ref(frame, avframe_);
+        frames_.push_back(frame);
+        output_size_ += samples * frame_size;
+        return;
+    }
+    // resampled or stretched : staged in output_, after the frames kept so far
+    StageFrames();
 
-        uint8_t *out_planes[avctx_->channels];
-        if (av_samples_fill_arrays(out_planes, NULL, output_buffer_data_, avctx_->channels, avframe_->nb_samples, output_sample_fmt_, 1) < 0 ||
-                swr_convert(swrctx_, out_planes, avframe_->nb_samples, (const uint8_t **)avframe_->data, avframe_->nb_samples) < 0)
+    int out_samples = swrctx_ ? swr_get_out_samples(swrctx_, samples) : samples;
+    uint8_t* out;
+    if (resampler_.isInitialized())
+    {
+        // converted at the decoded rate first, then resampled into the output
+        if (resample_input_.size() < (size_t)out_samples * frame_size)
+            resample_input_.resize((size_t)out_samples * frame_size);
+        out = resample_input_.data();
+    }
+    else
+    {
+        out = GetStageBuffer(out_samples, drift);
+    }
+
+    if (convert_)
+    {
+        convert_(avframe_->extended_data, input_channels_, samples, (int16_t*)out);
+    }
+    else if (downmix_)
+    {
+        downmix_(avframe_->extended_data, input_channels_, samples, downmix_matrix_, (int16_t*)out);
+    }
+    else if (!swrctx_)
+    {
+        memcpy(out, avframe_->data[0], (size_t)samples * frame_size);
+    }
+    else
+    {
+        int converted = swr_convert(swrctx_, &out, out_samples, (const uint8_t **)avframe_->extended_data, samples);
+        if (converted < 0)
         {
             NDLLOG(LOGTAG, NDL_LOGE, "%s: format convert error %d to %d", __func__, avctx_->sample_fmt, output_sample_fmt_);
-            output_size = 0;
+            return;
         }
+        samples = converted;
     }
-    else
+
+    if (resampler_.isInitialized())
+    {
+        int16_t* resampled = (int16_t*)GetStageBuffer(resampler_.getOutSamples(samples), drift);
+        samples = resampler_.process((const int16_t*)out, samples, resampled);
+    }
+    if (drift)
+        samples = ApplyDrift(samples);
+    output_size_ += samples * frame_size;
+    staged_size_ = output_size_;
+}
+
+/**
+ * A frame only converted by the kernels (no swresample, resampler or stretch) is kept as decoded
+ */
+bool AudioSwDecoder::KeepsFrame(bool drift)
+{
+    return !swrctx_ && !resampler_.isInitialized() && !drift;
+}
+
+/**
+ * Convert len bytes (whole samples) of the kept frames into dst, the frames read to the end are released
+ * return written bytes
+ */
+int AudioSwDecoder::ReadFrames(unsigned char* dst, int len)
+{
+    if (frames_.empty() || output_frame_size_ <= 0)
+        return 0;
+
+    const bool planar = av_sample_fmt_is_planar(input_sample_fmt_);
+    const int planes = planar ? input_channels_ : 1;
+    const int step = av_get_bytes_per_sample(input_sample_fmt_) * (planar ? 1 : input_channels_);
+    frame_planes_.resize(planes);
+
+    int read = 0;
+    while (!frames_.empty())
+    {
+        AVFrame* frame = frames_.front();
+        int samples = std::min(frame->nb_samples - frame_read_, (len - read) / output_frame_size_);
+        if (samples <= 0)
+            break;
+
+        for (int i = 0; i < planes; i++)
+            frame_planes_[i] = frame->extended_data[i] + (size_t)frame_read_ * step;
+        int16_t* out = (int16_t*)(dst + read);
+        if (convert_)
+            convert_(frame_planes_.data(), input_channels_, samples, out);
+        else if (downmix_)
+            downmix_(frame_planes_.data(), input_channels_, samples, downmix_matrix_, out);
+        else
+            memcpy(out, frame_planes_[0], (size_t)samples * output_frame_size_);
+
+        read += samples * output_frame_size_;
+        frame_read_ += samples;
+        if (frame_read_ >= frame->nb_samples)
+        {
+            frames_.pop_front();
+            av_frame_unref(frame);
+            free_frames_.push_back(frame);
+            frame_read_ = 0;
+        }
+    }
+    return read;
+}
+
+/**
+ * Convert the kept frames into output_ before samples which have to follow them there
+ */
+void AudioSwDecoder::StageFrames()
+{
+    if (frames_.empty())
+        return;
+    if (output_.size() < (size_t)output_size_)
+        output_.resize(output_size_);
+    staged_size_ += ReadFrames(output_.data() + staged_size_, output_size_ - staged_size_);
+}
+
+void AudioSwDecoder::ClearFrames()
+{
+    for (AVFrame* frame : frames_)
     {
-        //NDLLOG(LOGTAG, NDL_LOGD, "copy to a contiguous buffer");
-        uint8_t *out_planes[avctx_->channels];
-        if (av_samples_fill_arrays(out_planes, NULL, output_buffer_data_, avctx_->channels, avframe_->nb_samples, output_sample_fmt_, 1) < 0 ||
-                av_samples_copy(out_planes, avframe_->data, 0, 0, avframe_->nb_samples, avctx_->channels, output_sample_fmt_) < 0 )
+        av_frame_unref(frame);
+        free_frames_.push_back(frame);
+    }
+    frames_.clear();
+    frame_read_ = 0;
+}
+
+/**
+ * The stretch runs for the next frames while drift_ppm_ is not 0. It is left at 0 ppm with its history
+ * (a few frames, as a stretch drops them) and entered again when the ppm changes
+ */
+bool AudioSwDecoder::PrepareDrift()
+{
+    int ppm = drift_ppm_;
+    if (ppm == 0)
+    {
+        if (drift_active_)
         {
-            output_size = 0;
+            drift_resampler_.reset();
+            drift_active_ = false;
         }
+        return false;
+    }
+
+    if (drift_resampler_.getInputRate() != output_sample_rate_ || drift_resampler_.getChannels() != output_channels_)
+    {
+        if (!drift_resampler_.initDrift(output_sample_rate_, output_channels_, AudioResampler::configuredQuality()))
+            return false;
+    }
+    drift_resampler_.setDrift(ppm);
+    drift_active_ = true;
+    return true;
+}
+
+/**
+ * Where the stage before the stretch writes frames : drift_input_ when it runs, the output otherwise
+ */
+uint8_t* AudioSwDecoder::GetStageBuffer(int frames, bool drift)
+{
+    if (drift)
+    {
+        size_t samples = (size_t)frames * output_channels_;
+        if (drift_input_.size() < samples)
+            drift_input_.resize(samples);
+        return (uint8_t*)drift_input_.data();
     }
+    size_t needed = output_size_ + (size_t)frames * output_frame_size_;
+    if (output_.size() < needed)
+        output_.resize(needed);
+    return output_.data() + output_size_;
+}
 
-    return ret;
+/**
+ * Stretch the frames written into drift_input_ by drift_ppm_ (a frame per thousand at most) into the output
+ * return the frames there after the stretch
+ */
+int AudioSwDecoder::ApplyDrift(int frames)
+{
+    if (frames <= 0)
+        return frames;
+
+    size_t needed = output_size_ + (size_t)drift_resampler_.getOutSamples(frames) * output_frame_size_;
+    if (output_.size() < needed)
+        output_.resize(needed);
+    return drift_resampler_.process(drift_input_.data(), frames, (int16_t*)(output_.data() + output_size_));
+}
+
+int AudioSwDecoder::GetOutputRate()
+{
+    if (requested_sample_rate_ > 0)
+        return requested_sample_rate_;
+    return avctx_ ? avctx_->sample_rate : input_sample_rate_;
+}
+
+uint64_t AudioSwDecoder::GetOutputChannelLayout()
+{
+    int channels = requested_channels_ > 0 ? requested_channels_ : input_channels_;
+    if (channels <= 0)
+        channels = audio_stream_info_.channels;
+    return av_get_default_channel_layout(channels);
+}
+
+bool AudioSwDecoder::SameSpeakers(uint64_t a, uint64_t b)
+{
+    // back and side surround pairs are the same speakers when only one pair is there (ex. 5.1)
+    const uint64_t back = AV_CH_BACK_LEFT | AV_CH_BACK_RIGHT;
+    const uint64_t side = AV_CH_SIDE_LEFT | AV_CH_SIDE_RIGHT;
+    if ((a & back) == back && !(a & side))
+        a = (a & ~back) | side;
+    if ((b & back) == back && !(b & side))
+        b = (b & ~back) | side;
+    return a == b;
+}
+
+int64_t AudioSwDecoder::GetOutputPts()
+{
+    if (output_frame_size_ <= 0 || output_sample_rate_ <= 0)
+        return output_pts_;
+    return output_pts_ + (int64_t)(output_read_ / output_frame_size_) * 1000000 / output_sample_rate_;
+}
+
+int AudioSwDecoder::ReadOutput(unsigned char* dst, int capacity)
+{
+    if (output_read_ >= output_size_ || output_frame_size_ <= 0)
+        return 0;
+
+    int len = std::min(output_size_ - output_read_, capacity - capacity % output_frame_size_);
+    if (len <= 0)
+        return 0;
+
+    // output_ first, then the kept frames converted in place
+    int staged = std::min(len, std::max(staged_size_ - output_read_, 0));
+    if (staged > 0)
+        memcpy(dst, output_.data() + output_read_, staged);
+    int read = staged + ReadFrames(dst + staged, len - staged);
+    output_read_ += read;
+    return read;
+}
+
+void AudioSwDecoder::DiscardOutput()
+{
+    ClearFrames();
+    staged_size_ = 0;
+    output_size_ = 0;
+    output_read_ = 0;
+    next_pts_ = 0;
+
+    if (avctx_)
+        avcodec_flush_buffers(avctx_);
+    if (swrctx_)
+        swr_free(&swrctx_);
+    if (resampler_.isInitialized())
+        resampler_.reset();
+    if (drift_resampler_.isInitialized())
+        drift_resampler_.reset();
 }
@@ -21,6 +21,11 @@
 #ifndef AUDIO_SW_DECODER_H_
 #define AUDIO_SW_DECODER_H_
 
+#include <stdint.h>
+#include <atomic>
+#include <deque>
+#include <vector>
+
 extern "C" {
 #include "libavutil/avstring.h"
 #include "libavutil/time.h"
@@ -29,6 +34,10 @@ extern "C" {
 #include "libswresample/swresample.h"
 }
 
+#include "audioconvert.h"
+#include "audiodecodercache.h"
+#include "audioresampler.h"
+
 namespace NDL_Esplayer {
 
     typedef struct AudioStreamInfo {
@@ -44,25 +53,129 @@ namespace NDL_Esplayer {
         public:
             AudioSwDecoder();
             ~AudioSwDecoder();
-            int GetOutputBufferSize() { return output_buffer_size_; };
-            unsigned char* GetOutputBufferData() { return output_buffer_data_; };
+            /**
+             * Size of the decoded S16 samples not read yet
+             */
+            int GetOutputBufferSize() { return output_size_ - output_read_; };
+            /**
+             * Bytes per sample of all channels, reads are aligned to it
+             */
+            int GetOutputFrameSize() { return output_frame_size_; };
+            int GetOutputSampleRate() { return output_sample_rate_; };
+            /**
+             * Channels of the output, 0 (default) keeps the decoded channels.
+             * 2 from more channels is a downmix, other counts are remixed by swresample
+             */
+            void SetOutputChannels(int channels) { requested_channels_ = channels; };
+            /**
+             * Fixed rate of the output, 0 (default) keeps the decoded rate.
+             * Other rates go through AudioResampler, or swresample for rates it does not take
+             */
+            void SetOutputSampleRate(int sample_rate) { requested_sample_rate_ = sample_rate; };
+            /**
+             * Stretch of the output in ppm for the clock drift of the audio renderer, from the next frame.
+             * The drift stage of AudioResampler runs while the stretch is not 0. Any thread
+             */
+            void SetDriftPpm(int ppm) { drift_ppm_ = ppm; };
+            /**
+             * Speakers of the output (AV_CH_*, same bits as the WAVEFORMATEXTENSIBLE mask)
+             */
+            uint64_t GetOutputChannelLayout();
+            /**
+             * PTS(us) of the next sample to be read, derived from the samples read so far
+             */
+            int64_t GetOutputPts();
             bool OpenAudio(enum AVCodecID codec_id);
+            /**
+             * LPCM converted by the kernels of audioconvert instead of a libavcodec decoder,
+             * sample_rate of audio_stream_info_ is the rate of the samples
+             */
+            bool OpenLpcm(const AudioLpcmFormat& format);
+            /**
+             * Decode one packet and drain all the frames in it into one contiguous output.
+             * Samples stay in the decoder until ReadOutput : the frames only converted by the kernels
+             * are kept as decoded and converted by ReadOutput, the others (resampled, stretched, LPCM) in output_.
+             * pts < 0 : no pts, continue from the samples of the previous packet
+             * return consumed bytes, < 0 on error
+             */
             int DecodeAudio(unsigned char* data, int size, double dts, double pts);
+            /**
+             * Convert or copy the next decoded samples into dst (ex. OMX buffer pBuffer).
+             * Can be called several times to span the output into several buffers.
+             * return written bytes
+             */
+            int ReadOutput(unsigned char* dst, int capacity);
+            /**
+             * Drop the samples not read yet and the frames buffered in the codec (flush)
+             */
+            void DiscardOutput();
 
         public:
             AudioStreamInfo audio_stream_info_;
 
         private:
+            bool InitOutput();
+            bool PrepareConvert();
+            void PrepareResampler();
+            bool PrepareLpcm();
+            int GetOutputRate();
+            static bool SameSpeakers(uint64_t a, uint64_t b);
+            void AppendFrame();
+            bool InputChanged(uint64_t layout);
+            bool KeepsFrame(bool drift);
+            int ReadFrames(unsigned char* dst, int len);
+            void StageFrames();
+            void ClearFrames();
+            void AppendLpcm(const unsigned char* data, int size);
+            bool PrepareDrift();
+            uint8_t* GetStageBuffer(int frames, bool drift);
+            int ApplyDrift(int frames);
+
             AVCodecContext* avctx_;
             AVFrame* avframe_;
+            AudioDecoderKey avctx_key_;  // avctx_ goes back to AudioDecoderCache with it once opened
+            bool avctx_opened_;
 
+            AudioConvertFunc convert_;  // kernel for the input format, swrctx_ when null
+            AudioDownmixFunc downmix_;  // kernel for the stereo downmix, swrctx_ when null
+            AudioDownmixMatrix downmix_matrix_;
+            AudioLpcmFunc lpcm_;        // set for LPCM, there is no avctx_ then
+            AudioLpcmFormat lpcm_format_;
+            bool lpcm_prepared_;
+            std::vector<int16_t> lpcm_s16_;  // S16 of the LPCM channels before swrctx_ or resampler_
             SwrContext* swrctx_;
             enum AVSampleFormat input_sample_fmt_;
             enum AVSampleFormat output_sample_fmt_;
+            uint64_t input_layout_;   // decoded layout the conversion is prepared for
+            int input_channels_;
+            int input_sample_rate_;
+
+            AudioResampler resampler_;   // initialized when the rate is converted by our kernels
+            bool swr_resample_;          // swrctx_ converts the rate
+            std::vector<uint8_t> resample_input_;  // converted samples at the decoded rate
 
+            std::atomic<int> drift_ppm_;
+            AudioResampler drift_resampler_;     // initialized from the first non zero drift_ppm_
+            bool drift_active_;                  // drift_resampler_ has the history of the last frames
+            std::vector<int16_t> drift_input_;   // output frames before the stretch
+
+            int requested_channels_;
+            int requested_sample_rate_;
             int output_channels_;
-            int output_buffer_size_;
-            unsigned char* output_buffer_data_;
+            int output_frame_size_;  // bytes per sample of all channels
+            int output_sample_rate_;
+
+            std::deque<AVFrame*> frames_;       // decoded frames of the last packet after output_
+            std::vector<AVFrame*> free_frames_;
+            int frame_read_;                    // samples of frames_.front() already read
+            std::vector<const uint8_t*> frame_planes_;
+
+            std::vector<uint8_t> output_;  // S16 samples of the frames of the last packet which are not in frames_
+            int staged_size_;        // bytes in output_
+            int output_size_;        // decoded bytes, output_ and frames_
+            int output_read_;        // bytes already read
+            int64_t output_pts_;     // pts of the first sample in output_
+            int64_t next_pts_;       // pts following the last decoded sample
     };
 
 }
@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+
+#include <stdlib.h>
+#include <algorithm>
+
+#include "avsync.h"
+
+using namespace NDL_Esplayer;
+
+// fed buffers between a delay change and its frame presented, more are forgotten
+#define AV_SYNC_MAX_DELAY_CHANGES 64
+
+AvSyncController::AvSyncController()
+{
+    audio_clock_.setMaster(MediaClock::SOURCE_AUDIO);
+}
+
+void AvSyncController::reset()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    resetLocked();
+}
+
+void AvSyncController::clear()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    resetLocked();
+    measurements_ = 0;
+    corrections_ = 0;
+}
+
+void AvSyncController::resetLocked()
+{
+    audio_clock_.reset();
+    audio_render_ns_ = -1;
+    video_render_ns_ = -1;
+    audio_fed_pts_ = 0;
+    video_fed_pts_ = 0;
+    holding_ = false;
+    has_offset_ = false;
+    offset_ = 0;
+    correcting_ = false;
+    drop_credit_ = 0;
+    delay_ = 0;
+    delay_changes_.clear();
+    drift_offset_ = 0;
+    drift_ns_ = -1;
+    has_drift_ = false;
+    drift_ppm_ = 0;
+}
+
+void AvSyncController::allowVideo()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    holding_ = false;
+}
+
+void AvSyncController::restartAudio()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    audio_fed_pts_ = 0;
+}
+
+void AvSyncController::setRate(int rate)
+{
+    audio_clock_.setRate(rate);
+}
+
+int64_t AvSyncController::lastFedPts(NDL_ESP_STREAM_T stream)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    return stream == NDL_ESP_VIDEO_ES ? video_fed_pts_ : audio_fed_pts_;
+}
+
+AvSyncController::Decision AvSyncController::feed(NDL_ESP_STREAM_T stream, int64_t pts, int video_used_buffers)
+{
+    return feed(stream, pts, video_used_buffers, MediaClock::now());
+}
+
+AvSyncController::Decision AvSyncController::feed(NDL_ESP_STREAM_T stream, int64_t pts,
+        int video_used_buffers, int64_t now_ns)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    Decision decision = {false, false, 0, 0, 0};
+
+    if (stream == NDL_ESP_VIDEO_ES) {
+        int64_t fed_delta = audio_fed_pts_ != 0 ? pts - audio_fed_pts_ : 0;
+        decision.start_time = (video_fed_pts_ == 0);
+
+        if (!decision.start_time && hasOffsetLocked(now_ns)) {
+            // late : a frame dropped each time the lateness of the frames adds up to AV_SYNC_DROP_FULL_US
+            decision.offset = offset_;
+            if (correcting_ && offset_ < 0) {
+                drop_credit_ -= offset_;
+                if (drop_credit_ >= AV_SYNC_DROP_FULL_US) {
+                    drop_credit_ -= AV_SYNC_DROP_FULL_US;
+                    decision.drop = true;
+                }
+            }
+        } else if (!decision.start_time) {
+            decision.offset = fed_delta;
+            decision.drop = fed_delta < AV_SYNC_FEED_SKIP_US;
+        }
+
+        if (!holding_ && (fed_delta > AV_SYNC_FEED_HIGH_US || video_used_buffers > AV_SYNC_VIDEO_BUFFERS_HIGH)) {
+            holding_ = true;
+            decision.hold = 1;
+        }
+
+        if (delay_changes_.empty() ? delay_ != 0 : delay_changes_.back().delay != delay_) {
+            if (delay_changes_.size() >= AV_SYNC_MAX_DELAY_CHANGES)
+                delay_changes_.pop_front();
+            delay_changes_.push_back({pts + delay_, delay_});
+        }
+        decision.delay = delay_;
+        video_fed_pts_ = pts;
+    } else {
+        int64_t fed_delta = video_fed_pts_ != 0 ? video_fed_pts_ - pts : 0;
+        decision.start_time = (audio_fed_pts_ == 0);
+
+        if (holding_ && fed_delta < AV_SYNC_FEED_LOW_US && fed_delta > AV_SYNC_FEED_SKIP_US
+                && video_used_buffers <= AV_SYNC_VIDEO_BUFFERS_HIGH) {
+            holding_ = false;
+            decision.hold = -1;
+        }
+        audio_fed_pts_ = pts;
+    }
+    return decision;
+}
+
+void AvSyncController::onRender(NDL_ESP_STREAM_T stream, int64_t pts)
+{
+    onRender(stream, pts, MediaClock::now());
+}
+
+void AvSyncController::onRender(NDL_ESP_STREAM_T stream, int64_t pts, int64_t now_ns)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    if (stream == NDL_ESP_AUDIO_ES) {
+        audio_clock_.onRender(MediaClock::SOURCE_AUDIO, pts, now_ns);
+        audio_render_ns_ = now_ns;
+        return;
+    }
+
+    video_render_ns_ = now_ns;
+    if (audio_render_ns_ >= 0 && now_ns - audio_render_ns_ < AV_SYNC_RENDER_TIMEOUT_US * 1000LL)
+        measureLocked(pts, now_ns);
+}
+
+bool AvSyncController::hasOffsetLocked(int64_t now_ns) const
+{
+    const int64_t timeout = AV_SYNC_RENDER_TIMEOUT_US * 1000LL;
+    return has_offset_
+        && video_render_ns_ >= 0 && now_ns - video_render_ns_ < timeout
+        && audio_render_ns_ >= 0 && now_ns - audio_render_ns_ < timeout;
+}
+
+/**
+ * Delay the video frame of the rendered pts was fed with
+ */
+int64_t AvSyncController::delayOfLocked(int64_t pts)
+{
+    while (delay_changes_.size() > 1 && delay_changes_[1].pts <= pts)
+        delay_changes_.pop_front();
+    if (delay_changes_.empty() || delay_changes_.front().pts > pts)
+        return 0;
+    return delay_changes_.front().delay;
+}
+
+void AvSyncController::measureLocked(int64_t pts, int64_t now_ns)
+{
+    int64_t audio = 0;
+    if (!audio_clock_.get(nullptr, &audio, now_ns))
+        return;
+
+    // the delay moved the frame later, the content is behind by it
+    int64_t frame_delay = delayOfLocked(pts);
+    int64_t offset = pts - frame_delay - audio;
+    offset_ = has_offset_ ? offset_ + (offset - offset_) / (1 << AV_SYNC_FILTER_SHIFT) : offset;
+    has_offset_ = true;
+    measurements_++;
+
+    // drift of the pipeline, without the correction
+    if (drift_ns_ < 0) {
+        drift_ns_ = now_ns;
+        drift_offset_ = offset_ + delay_;
+    } else if (now_ns - drift_ns_ >= AV_SYNC_DRIFT_PERIOD_US * 1000LL) {
+        int64_t elapsed_us = (now_ns - drift_ns_) / 1000;
+        int32_t ppm = (int32_t)((offset_ + delay_ - drift_offset_) * 1000000 / elapsed_us);
+        drift_ppm_ = has_drift_ ? (drift_ppm_ * 3 + ppm) / 4 : ppm;
+        has_drift_ = true;
+        drift_ns_ = now_ns;
+        drift_offset_ = offset_ + delay_;
+    }
+
+    // hysteresis : no correction within the tolerance, corrections down to AV_SYNC_EXIT_US once out of it
+    if (!correcting_ && std::abs(offset_) > AV_SYNC_ENTER_US) {
+        correcting_ = true;
+        corrections_++;
+    } else if (correcting_ && std::abs(offset_) < AV_SYNC_EXIT_US) {
+        correcting_ = false;
+        drop_credit_ = 0;
+    }
+
+    if (correcting_) {
+        // proportional : ahead moves the delay up, late moves it back down to 0 and dropping catches up the rest
+        int64_t step = std::max<int64_t>(-AV_SYNC_DELAY_STEP_US, std::min<int64_t>(AV_SYNC_DELAY_STEP_US, offset_ / 4));
+        delay_ = std::max<int64_t>(0, std::min<int64_t>(AV_SYNC_DELAY_MAX_US, delay_ + step));
+    }
+}
+
+void AvSyncController::getStats(NDL_ESP_AV_SYNC_STATS* stats)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    stats->offset_us = has_offset_ ? offset_ : 0;
+    stats->video_delay_us = delay_;
+    stats->drift_ppm = drift_ppm_;
+    stats->measurements = measurements_;
+    stats->corrections = corrections_;
+    stats->locked = (has_offset_ && !correcting_) ? 1 : 0;
+}
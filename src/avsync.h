@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+
+#ifndef NDL_DIRECTMEDIA2_AV_SYNC_H_
+#define NDL_DIRECTMEDIA2_AV_SYNC_H_
+
+#include <stdint.h>
+#include <deque>
+#include <mutex>
+
+#include "ndl-directmedia2/media-common.h"
+#include "mediaclock.h"
+
+// fed video pts against the fed audio pts (us), used while the presented offset is not measured
+#define AV_SYNC_FEED_SKIP_US        (-100000)   // video frames behind are dropped
+#define AV_SYNC_FEED_LOW_US         250000      // video feed released below
+#define AV_SYNC_FEED_HIGH_US        1000000     // video feed held above
+#define AV_SYNC_VIDEO_BUFFERS_HIGH  30          // video feed held above this many used codec buffers
+
+// presented offset : render events older than this do not measure it
+#define AV_SYNC_RENDER_TIMEOUT_US   500000
+// hysteresis : corrections start out of ENTER and stop within EXIT
+#define AV_SYNC_ENTER_US            40000
+#define AV_SYNC_EXIT_US             10000
+// video late by this much has every frame dropped, less has a proportional part of them
+#define AV_SYNC_DROP_FULL_US        200000
+// video ahead is held back by a delay on its pts, moved by at most STEP per measurement
+#define AV_SYNC_DELAY_MAX_US        100000
+#define AV_SYNC_DELAY_STEP_US       500
+// offset filter : 1/2^SHIFT of each measurement
+#define AV_SYNC_FILTER_SHIFT        3
+// drift : offset change over at least this time
+#define AV_SYNC_DRIFT_PERIOD_US     1000000
+
+namespace NDL_Esplayer {
+
+    /**
+     * A/V sync of the fed video against the audio.
+     * Measures the offset of the presented video frames from the audio position at the same
+     * time (render events), and drops the late video frames in proportion to their lateness or
+     * delays the video pts when it is ahead, with hysteresis around the tolerance.
+     * Without render events of both streams the decision falls back on the fed pts : the render
+     * events come from the renderer callbacks of the non-tunnel build (OMX_NONE_TUNNEL) only, the
+     * tunneled pipeline leaves the sync of the presented frames to the clock component.
+     * Also holds the video feed (HIGH_THRESHOLD_CROSSED_VIDEO) when it runs too far ahead.
+     * The feeders, the renderer callbacks and the API call it from their threads.
+     */
+    class AvSyncController {
+        public:
+            struct Decision {
+                bool start_time;    // first buffer of the stream since reset
+                bool drop;          // video : not displayed
+                int hold;           // video feed : 1 to hold, -1 to release, 0 unchanged
+                int64_t offset;     // video : offset (us) the decision was made on, negative if late
+                int64_t delay;      // video : added to the pts
+            };
+
+            AvSyncController();
+
+            /**
+             * Forget the fed pts and the measurements (flush), statistics are kept
+             */
+            void reset();
+            /**
+             * Statistics too (load)
+             */
+            void clear();
+            /**
+             * Release the video feed without notification (drained, port reconfigured)
+             */
+            void allowVideo();
+            /**
+             * The next audio buffer carries the start time again (play from loaded)
+             */
+            void restartAudio();
+            /**
+             * Playback rate in 1/1000, audio position between its render events
+             */
+            void setRate(int rate);
+
+            /**
+             * Decision for a buffer of the audio or the video with pts (us),
+             * video_used_buffers : used input buffers of the video codec
+             */
+            Decision feed(NDL_ESP_STREAM_T stream, int64_t pts, int video_used_buffers);
+            /**
+             * pts of the last buffer fed of the stream, 0 if none since reset
+             */
+            int64_t lastFedPts(NDL_ESP_STREAM_T stream);
+
+            /**
+             * Frame of stream with pts (us) presented now
+             */
+            void onRender(NDL_ESP_STREAM_T stream, int64_t pts);
+
+            void getStats(NDL_ESP_AV_SYNC_STATS* stats);
+
+            // at now_ns on CLOCK_MONOTONIC, for tests
+            Decision feed(NDL_ESP_STREAM_T stream, int64_t pts, int video_used_buffers, int64_t now_ns);
+            void onRender(NDL_ESP_STREAM_T stream, int64_t pts, int64_t now_ns);
+
+        private:
+            bool hasOffsetLocked(int64_t now_ns) const;
+            void measureLocked(int64_t pts, int64_t now_ns);
+            int64_t delayOfLocked(int64_t pts);
+            void resetLocked();
+
+            struct DelayChange {
+                int64_t pts;    // first video pts fed with the delay, delay included
+                int64_t delay;
+            };
+
+            std::mutex lock_;
+
+            // audio position between the audio render events
+            MediaClock audio_clock_;
+            int64_t audio_render_ns_ {-1};
+            int64_t video_render_ns_ {-1};
+
+            int64_t audio_fed_pts_ {0};
+            int64_t video_fed_pts_ {0};
+            bool holding_ {false};
+
+            // presented offset and its correction
+            bool has_offset_ {false};
+            int64_t offset_ {0};
+            bool correcting_ {false};
+            int64_t drop_credit_ {0};       // lateness summed over the fed frames, a frame dropped per AV_SYNC_DROP_FULL_US
+            int64_t delay_ {0};
+            // delays the video in the decoder and renderer was fed with
+            std::deque<DelayChange> delay_changes_;
+            int64_t drift_offset_ {0};      // offset without the delay at drift_ns_
+            int64_t drift_ns_ {-1};
+            bool has_drift_ {false};
+            int32_t drift_ppm_ {0};
+
+            uint32_t measurements_ {0};
+            uint32_t corrections_ {0};
+    };
+
+} //namespace NDL_Esplayer
+
+#endif //NDL_DIRECTMEDIA2_AV_SYNC_H_
@@ -59,6 +59,7 @@ namespace NDL_Esplayer {
             virtual bool hasStartTime(int port_index) {return true;}
             virtual int getPlaybackRate() {return NORMAL_PLAYBACK_RATE;}
             virtual void setTrickMode(bool enable) {}
+            virtual const OmxClient* getOmxClient() const { return nullptr; }
 
     };
 
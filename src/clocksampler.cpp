@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+
+#include "clocksampler.h"
+
+using namespace NDL_Esplayer;
+
+ClockSampler::ClockSampler(MediaClock* media_clock, AudioDriftEstimator* audio_drift)
+    : media_clock_(media_clock), audio_drift_(audio_drift)
+{
+}
+
+bool ClockSampler::due(int64_t now_ns)
+{
+    int64_t last = last_ns_;
+    if (last >= 0 && now_ns >= last && now_ns - last < CLOCK_SAMPLE_INTERVAL_US * 1000)
+        return false;
+    return last_ns_.compare_exchange_strong(last, now_ns);
+}
+
+void ClockSampler::onMediaTime(int64_t media_time, bool audio_reference, int64_t now_ns)
+{
+    if (media_time < 0)
+        return;
+    media_clock_->onRender(audio_reference ? MediaClock::SOURCE_AUDIO : MediaClock::SOURCE_VIDEO,
+            media_time, now_ns);
+    if (audio_reference)
+        audio_drift_->onRender(media_time, now_ns);
+}
+
+void ClockSampler::reset()
+{
+    last_ns_ = -1;
+}
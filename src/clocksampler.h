@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+
+#ifndef NDL_DIRECTMEDIA2_CLOCK_SAMPLER_H_
+#define NDL_DIRECTMEDIA2_CLOCK_SAMPLER_H_
+
+#include <stdint.h>
+#include <atomic>
+
+#include "mediaclock.h"
+#include "audiodrift.h"
+
+// media time of the clock component read back at most this often
+#define CLOCK_SAMPLE_INTERVAL_US    100000
+
+namespace NDL_Esplayer {
+
+    /**
+     * Render position of the tunneled pipeline : its renderers give no render events,
+     * the media time of the clock component is read back instead on the buffer events of the codecs
+     * and fed as the render events of the master source into the media clock, and into the audio drift
+     * when the clock follows the audio renderer.
+     * The codec callbacks of both streams call it, one of them reads the clock per interval.
+     */
+    class ClockSampler {
+        public:
+            ClockSampler(MediaClock* media_clock, AudioDriftEstimator* audio_drift);
+
+            /**
+             * true once per CLOCK_SAMPLE_INTERVAL_US for the caller which reads the clock at now_ns
+             */
+            bool due(int64_t now_ns);
+            /**
+             * Media time (us) read at now_ns, audio_reference : the clock follows the audio renderer
+             */
+            void onMediaTime(int64_t media_time, bool audio_reference, int64_t now_ns);
+            /**
+             * The next call is due (flush, load)
+             */
+            void reset();
+
+        private:
+            MediaClock* media_clock_;
+            AudioDriftEstimator* audio_drift_;
+            std::atomic<int64_t> last_ns_ {-1};
+    };
+
+} //namespace NDL_Esplayer
+
+#endif //NDL_DIRECTMEDIA2_CLOCK_SAMPLER_H_
@@ -22,6 +22,11 @@
 #define NDL_DIRECTMEDIA2_COMPONENT_H_
 
 #define SUPPORT_ALSA_RENDERER_COMPONENT 0
+// components can flush their ports in executing state without pause round-trip :
+// off unless the platform build sets it (cmake -DFLUSH_IN_EXECUTING=1), on for the software components
+#ifndef SUPPORT_FLUSH_IN_EXECUTING
+#define SUPPORT_FLUSH_IN_EXECUTING 0
+#endif
 
 #include <memory>
 #include <functional>
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "cpufeatures.h"
+
+#define LOGTAG "cpufeatures"
+#include "debug.h"
+
+using namespace NDL_Esplayer;
+
+namespace {
+    CPU_SIMD detectSimd()
+    {
+        if (isCpuSimdSupported(CPU_SIMD_AVX2))
+            return CPU_SIMD_AVX2;
+        if (isCpuSimdSupported(CPU_SIMD_SSE2))
+            return CPU_SIMD_SSE2;
+        if (isCpuSimdSupported(CPU_SIMD_NEON))
+            return CPU_SIMD_NEON;
+        return CPU_SIMD_SCALAR;
+    }
+}
+
+bool NDL_Esplayer::isCpuSimdSupported(CPU_SIMD simd)
+{
+    switch (simd) {
+        case CPU_SIMD_SCALAR:
+            return true;
+#if defined(__SSE2__)
+        case CPU_SIMD_SSE2:
+            return true;
+#if defined(__GNUC__)
+        case CPU_SIMD_AVX2:
+            // kernels are built with target("avx2"), the cpu decides at run time
+            return __builtin_cpu_supports("avx2");
+#endif
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+        case CPU_SIMD_NEON:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+CPU_SIMD NDL_Esplayer::getCpuSimd()
+{
+    static const CPU_SIMD simd = [] {
+        CPU_SIMD detected = detectSimd();
+        NDLLOG(LOGTAG, NDL_LOGI, "cpu simd : %s", cpuSimdName(detected));
+        return detected;
+    }();
+    return simd;
+}
+
+const char* NDL_Esplayer::cpuSimdName(CPU_SIMD simd)
+{
+    switch (simd) {
+        case CPU_SIMD_AUTO:   return "auto";
+        case CPU_SIMD_SCALAR: return "scalar";
+        case CPU_SIMD_SSE2:   return "sse2";
+        case CPU_SIMD_AVX2:   return "avx2";
+        case CPU_SIMD_NEON:   return "neon";
+    }
+    return "unknown";
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef NDL_DIRECTMEDIA2_CPU_FEATURES_H_
+#define NDL_DIRECTMEDIA2_CPU_FEATURES_H_
+
+namespace NDL_Esplayer {
+
+    typedef enum {
+        CPU_SIMD_AUTO,      // best of the build and the cpu, see getCpuSimd
+        CPU_SIMD_SCALAR,
+        CPU_SIMD_SSE2,
+        CPU_SIMD_AVX2,
+        CPU_SIMD_NEON,
+    } CPU_SIMD;
+
+    /**
+     * true if the build has the kernels of simd and the cpu runs them (scalar always)
+     */
+    bool isCpuSimdSupported(CPU_SIMD simd);
+
+    /**
+     * Best supported simd of the cpu, detected once. Never CPU_SIMD_AUTO
+     */
+    CPU_SIMD getCpuSimd();
+
+    const char* cpuSimdName(CPU_SIMD simd);
+
+} //namespace NDL_Esplayer
+
+#endif // #ifndef NDL_DIRECTMEDIA2_CPU_FEATURES_H_
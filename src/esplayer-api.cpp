@@ -97,6 +97,32 @@ int NDL_EsplayerLoadEx(NDL_EsplayerHandle player,
     return (espWrapper->esplayer)->loadEx(meta, units);
 }
 
+int NDL_EsplayerLoadWithTimebase(NDL_EsplayerHandle player, NDL_ESP_META_DATA* meta,
+        const NDL_ESP_PTS_TIMEBASE* audio, const NDL_ESP_PTS_TIMEBASE* video)
+{
+    NDLLOG(LOGTAG, NDL_LOGI, "NDL_EsplayerLoadWithTimebase!");
+
+    NDLASSERT(player);
+    if (!player)
+        return NDL_ESP_RESULT_FAIL;
+
+    EsplayerWrapper* espWrapper = (EsplayerWrapper*)player;
+    return (espWrapper->esplayer)->loadWithTimebase(meta, audio, video);
+}
+
+int NDL_EsplayerLoadWithFormat(NDL_EsplayerHandle player, NDL_ESP_META_DATA* meta,
+        const NDL_ESP_META_FORMAT* format, const NDL_ESP_PTS_TIMEBASE* audio, const NDL_ESP_PTS_TIMEBASE* video)
+{
+    NDLLOG(LOGTAG, NDL_LOGI, "NDL_EsplayerLoadWithFormat!");
+
+    NDLASSERT(player);
+    if (!player)
+        return NDL_ESP_RESULT_FAIL;
+
+    EsplayerWrapper* espWrapper = (EsplayerWrapper*)player;
+    return (espWrapper->esplayer)->loadWithFormat(meta, format, audio, video);
+}
+
 
 int NDL_EsplayerUnload(NDL_EsplayerHandle player)
 {
@@ -173,6 +199,19 @@ int NDL_EsplayerFlush(NDL_EsplayerHandle player)
 }
 
 
+int NDL_EsplayerFlushEx(NDL_EsplayerHandle player, NDL_ESP_FLUSH_MODE mode)
+{
+    NDLLOG(LOGTAG, NDL_LOGI, "NDL_EsplayerFlushEx! %d", mode);
+
+    NDLASSERT(player);
+    if (!player)
+        return NDL_ESP_RESULT_FAIL;
+
+    EsplayerWrapper* espWrapper = (EsplayerWrapper*)player;
+    return (espWrapper->esplayer)->flush(mode);
+}
+
+
 int NDL_EsplayerGetBufferLevel(
         NDL_EsplayerHandle player,
         NDL_ESP_STREAM_T type,
@@ -187,6 +226,17 @@ int NDL_EsplayerGetBufferLevel(
 }
 
 
+int NDL_EsplayerGetOmxStats(NDL_EsplayerHandle player, char* buf, size_t buf_len)
+{
+    NDLASSERT(player);
+    if (!player)
+        return NDL_ESP_RESULT_FAIL;
+
+    EsplayerWrapper* espWrapper = (EsplayerWrapper*)player;
+    return (espWrapper->esplayer)->getOmxStats(buf, buf_len);
+}
+
+
 NDL_ESP_STATUS NDL_EsplayerGetStatus(NDL_EsplayerHandle player)
 {
     NDLASSERT(player);
@@ -203,7 +253,8 @@ int NDL_EsplayerGetMediatime(
         int64_t* start_time,
         int64_t* current_time)
 {
-    NDLLOG(LOGTAG, NDL_LOGI, "NDL_EsplayerGetMediatime!");
+    // polled by UI threads
+    NDLLOG(LOGTAG, NDL_LOGV, "NDL_EsplayerGetMediatime!");
 
 
     NDLASSERT(player);
@@ -273,6 +324,106 @@ int NDL_EsplayerSetVolume(NDL_EsplayerHandle player, int volume, int duration, N
     return (espWrapper->esplayer)->setVolume(volume, duration, type);
 }
 
+
+int NDL_EsplayerLoadSecondaryAudio(NDL_EsplayerHandle player, NDL_ESP_META_DATA* meta)
+{
+    NDLASSERT(player);
+    if (!player)
+        return NDL_ESP_RESULT_FAIL;
+
+    EsplayerWrapper* espWrapper = (EsplayerWrapper*)player;
+    return (espWrapper->esplayer)->loadSecondaryAudio(meta);
+}
+
+
+int NDL_EsplayerSetSecondaryAudioMix(NDL_EsplayerHandle player, int volume, int ducking)
+{
+    NDLASSERT(player);
+    if (!player)
+        return NDL_ESP_RESULT_FAIL;
+
+    EsplayerWrapper* espWrapper = (EsplayerWrapper*)player;
+    return (espWrapper->esplayer)->setSecondaryAudioMix(volume, ducking);
+}
+
+
+int NDL_EsplayerAddAudioTrack(NDL_EsplayerHandle player, NDL_ESP_META_DATA* meta)
+{
+    NDLASSERT(player);
+    if (!player)
+        return NDL_ESP_RESULT_FAIL;
+
+    EsplayerWrapper* espWrapper = (EsplayerWrapper*)player;
+    return (espWrapper->esplayer)->addAudioTrack(meta);
+}
+
+
+int NDL_EsplayerRemoveAudioTrack(NDL_EsplayerHandle player, int track)
+{
+    NDLASSERT(player);
+    if (!player)
+        return NDL_ESP_RESULT_FAIL;
+
+    EsplayerWrapper* espWrapper = (EsplayerWrapper*)player;
+    return (espWrapper->esplayer)->removeAudioTrack(track);
+}
+
+
+int NDL_EsplayerFeedAudioTrack(NDL_EsplayerHandle player, int track, NDL_EsplayerBuffer buff)
+{
+    NDLASSERT(player);
+    if (!player)
+        return NDL_ESP_RESULT_FAIL;
+
+    EsplayerWrapper* espWrapper = (EsplayerWrapper*)player;
+    return (espWrapper->esplayer)->feedAudioTrack(track, buff);
+}
+
+
+int NDL_EsplayerSelectAudioTrack(NDL_EsplayerHandle player, int track)
+{
+    NDLLOG(LOGTAG, NDL_LOGI, "NDL_EsplayerSelectAudioTrack %d!", track);
+
+    NDLASSERT(player);
+    if (!player)
+        return NDL_ESP_RESULT_FAIL;
+
+    EsplayerWrapper* espWrapper = (EsplayerWrapper*)player;
+    return (espWrapper->esplayer)->selectAudioTrack(track);
+}
+
+
+int NDL_EsplayerGetAudioTrackStats(NDL_EsplayerHandle player, char* buf, size_t buf_len)
+{
+    NDLASSERT(player);
+    if (!player)
+        return NDL_ESP_RESULT_FAIL;
+
+    EsplayerWrapper* espWrapper = (EsplayerWrapper*)player;
+    return (espWrapper->esplayer)->getAudioTrackStats(buf, buf_len);
+}
+
+
+int NDL_EsplayerGetVideoDropStats(NDL_EsplayerHandle player, NDL_ESP_VIDEO_DROP_STATS* stats)
+{
+    NDLASSERT(player);
+    if (!player)
+        return NDL_ESP_RESULT_FAIL;
+
+    EsplayerWrapper* espWrapper = (EsplayerWrapper*)player;
+    return (espWrapper->esplayer)->getVideoDropStats(stats);
+}
+
+int NDL_EsplayerGetAvSyncStats(NDL_EsplayerHandle player, NDL_ESP_AV_SYNC_STATS* stats)
+{
+    NDLASSERT(player);
+    if (!player)
+        return NDL_ESP_RESULT_FAIL;
+
+    EsplayerWrapper* espWrapper = (EsplayerWrapper*)player;
+    return (espWrapper->esplayer)->getAvSyncStats(stats);
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////// Display //////////////////////////////////////////
 
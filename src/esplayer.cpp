@@ -19,9 +19,12 @@
  */
 
 #include <stdio.h>
+#include <stdint.h>
 #include <string.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <algorithm>
+#include <vector>
 
 #include "esplayer.h"
 
@@ -53,6 +56,15 @@ using namespace NDL_Esplayer;
 #define SPEAKER_FRONT_RIGHT_OF_CENTER 0x00080
 #define WAVE_FORMAT_PCM               0x0001
 
+// pcm channels of the audio renderer input (hdmi multichannel lpcm)
+#define AUDIO_MAX_OUTPUT_CHANNELS     8
+
+// timestamp of the frames split by the audio/video parsers after the first one of a chunk
+#define ES_NO_PTS                     INT64_MIN
+
+// I-frame trick play : rates up to 32x both ways, key frames closer than the interval after retiming are dropped
+#define VIDEO_TRICK_MAX_RATE          32000
+
 #define MAX_PORT_WAIT_TIME  1 //1 sec
 #define MAX_STATE_WAIT_TIME  1 //1 sec
 #define MAX_FLUSH_WAIT_TIME  3 //3 sec
@@ -68,11 +80,117 @@ static const GUID KSDATAFORMAT_SUBTYPE_PCM = {
 };
 
 namespace {
+    /**
+     * Channels the audio renderer takes, more are downmixed to stereo.
+     * NDL_AUDIO_MAX_CHANNELS in the environment overrides it (ex. 2 for a stereo only sink)
+     */
+    int maxAudioOutputChannels()
+    {
+        const char* value = getenv("NDL_AUDIO_MAX_CHANNELS");
+        int channels = value ? atoi(value) : AUDIO_MAX_OUTPUT_CHANNELS;
+        return std::min(std::max(channels, 2), AUDIO_MAX_OUTPUT_CHANNELS);
+    }
+
+    /**
+     * Sample layout of NDL_ESP_AUDIO_CODEC_LPCM from the meta data.
+     * 20bit samples are in 3 bytes unless blockalign says otherwise (ex. 32bit containers)
+     */
+    bool getLpcmFormat(const NDL_ESP_META_DATA* meta, const NDL_ESP_META_FORMAT& meta_format, AudioLpcmFormat* format)
+    {
+        int channels = (int)meta->channels;
+        int sample_bytes = ((int)meta->bitspersample + 7) / 8;
+        if (channels < 1 || channels > AUDIO_CONVERT_MAX_CHANNELS || sample_bytes < 2 || sample_bytes > 4)
+            return false;
+
+        format->channels = channels;
+        format->container_bytes = meta->blockalign ? (int)meta->blockalign / channels : sample_bytes;
+        format->big_endian = (meta_format.pcm_flags & NDL_ESP_PCM_FLAG_BIG_ENDIAN) != 0;
+        if (format->container_bytes < sample_bytes || format->container_bytes > 4)
+            return false;
+
+        bool mapped = false;
+        for (int ch = 0; ch < channels; ch++)
+            mapped = mapped || meta_format.pcm_channel_map[ch] != 0;
+        for (int ch = 0; ch < channels; ch++)
+            format->channel_map[ch] = mapped ? meta_format.pcm_channel_map[ch] : ch;
+        return true;
+    }
+
+    /**
+     * libavcodec decoder of the codec, AV_CODEC_ID_NONE for lpcm and unsupported ones.
+     * samplerate is set for the pcm codecs with a fixed rate
+     */
+    enum AVCodecID audioCodecId(NDL_ESP_AUDIO_CODEC codec, uint32_t* samplerate)
+    {
+        switch (codec) {
+            case NDL_ESP_AUDIO_CODEC_MP2:
+                return CODEC_ID_MP2;
+            case NDL_ESP_AUDIO_CODEC_MP3:
+                return CODEC_ID_MP3;
+            case NDL_ESP_AUDIO_CODEC_AC3:
+                return CODEC_ID_AC3;
+            case NDL_ESP_AUDIO_CODEC_EAC3:
+                return CODEC_ID_EAC3;
+            case NDL_ESP_AUDIO_CODEC_AAC:
+                return CODEC_ID_AAC;
+            case NDL_ESP_AUDIO_CODEC_HEAAC:
+                return CODEC_ID_AAC_LATM;
+            case NDL_ESP_AUDIO_CODEC_PCM_44100_2CH:
+                *samplerate = 44100;
+                return AV_CODEC_ID_PCM_S16LE;
+            case NDL_ESP_AUDIO_CODEC_PCM_48000_2CH:
+                *samplerate = 48000;
+                return AV_CODEC_ID_PCM_S16LE;
+            case NDL_ESP_AUDIO_CODEC_LPCM:
+                return AV_CODEC_ID_NONE;
+            default:
+                NDLLOG(LOGTAG, NDL_LOGE, "%s: unsupported audio codec:%d", __func__, codec);
+                return AV_CODEC_ID_NONE;
+        }
+    }
+
+    /**
+     * Fixed rate of the pcm to the audio renderer, 0 for the rate of each stream.
+     * NDL_AUDIO_OUTPUT_RATE=<Hz> in the environment : streams switching between
+     * 44.1 and 48 kHz (ex. ad insertion) are resampled instead of reconfiguring the renderer
+     */
+    int audioOutputRate()
+    {
+        const char* value = getenv("NDL_AUDIO_OUTPUT_RATE");
+        int rate = value ? atoi(value) : 0;
+        return (rate >= 8000 && rate <= 192000) ? rate : 0;
+    }
+
+    void setPcmChannelMapping(OMX_AUDIO_PARAM_PCMMODETYPE* pcm, uint64_t layout)
+    {
+        int ch = 0;
+        for (int bit = 0; bit < 64 && ch < OMX_AUDIO_MAXCHANNELS; bit++) {
+            uint64_t speaker = 1ULL << bit;
+            if (!(layout & speaker))
+                continue;
+            switch (speaker) {
+                case AV_CH_FRONT_LEFT:    pcm->eChannelMapping[ch] = OMX_AUDIO_ChannelLF;  break;
+                case AV_CH_FRONT_RIGHT:   pcm->eChannelMapping[ch] = OMX_AUDIO_ChannelRF;  break;
+                case AV_CH_FRONT_CENTER:  pcm->eChannelMapping[ch] = OMX_AUDIO_ChannelCF;  break;
+                case AV_CH_LOW_FREQUENCY: pcm->eChannelMapping[ch] = OMX_AUDIO_ChannelLFE; break;
+                case AV_CH_BACK_LEFT:     pcm->eChannelMapping[ch] = OMX_AUDIO_ChannelLR;  break;
+                case AV_CH_BACK_RIGHT:    pcm->eChannelMapping[ch] = OMX_AUDIO_ChannelRR;  break;
+                case AV_CH_BACK_CENTER:   pcm->eChannelMapping[ch] = OMX_AUDIO_ChannelCS;  break;
+                case AV_CH_SIDE_LEFT:     pcm->eChannelMapping[ch] = OMX_AUDIO_ChannelLS;  break;
+                case AV_CH_SIDE_RIGHT:    pcm->eChannelMapping[ch] = OMX_AUDIO_ChannelRS;  break;
+                default:                  pcm->eChannelMapping[ch] = OMX_AUDIO_ChannelNone; break;
+            }
+            ch++;
+        }
+    }
+
     inline uint32_t translateToOmxFlags(uint32_t flags)
     {
         uint32_t omxflags = 0;
         if (flags & NDL_ESP_FLAG_END_OF_STREAM)
             omxflags |= OMX_BUFFERFLAG_EOS;
+        if (flags & NDL_ESP_FLAG_KEY_FRAME)
+            omxflags |= OMX_BUFFERFLAG_SYNCFRAME;
         return omxflags;
     }
     inline uint32_t translateToNDLFlags(uint32_t flags)
@@ -139,6 +257,16 @@ void Esplayer::notifyClient(NDL_ESP_EVENT event, void* playerdata)
     }
 }
 
+void Esplayer::reportSeekLatency()
+{
+    // taken once : the renderer callbacks of both streams can race for it
+    int64_t requested = flush_requested_time_.exchange(0);
+    if (requested == 0)
+        return;
+    NDLLOG(SDETTAG, NDL_LOGI, "seek latency (flush to first frame) : %lld ms",
+            (current_time_ns() - requested) / 1000000);
+}
+
 int Esplayer::load(NDL_ESP_META_DATA* meta)
 {
     NDLASSERT(meta);
@@ -189,6 +317,11 @@ int Esplayer::load(NDL_ESP_META_DATA* meta)
 
     enable_audio_ = (meta->audio_codec != NDL_ESP_AUDIO_NONE);
     enable_video_ = (meta->video_codec != NDL_ESP_VIDEO_NONE);
+    av_sync_.clear();
+    audio_drift_.clear();
+    media_clock_.reset();
+    media_clock_.setMaster(enable_audio_ ? MediaClock::SOURCE_AUDIO : MediaClock::SOURCE_VIDEO);
+    clock_sampler_.reset();
 
     ///////////////////////////////////////////////////////////////////////////
     // SW audio decoder initialize
@@ -199,61 +332,76 @@ int Esplayer::load(NDL_ESP_META_DATA* meta)
         meta_.framerate =  meta->framerate;
         meta_.extradata =  meta->extradata;
         meta_.extrasize =  meta->extrasize;
+
+        video_parser_ = nullptr;
+        if (meta_format_.video_framing == NDL_ESP_VIDEO_BYTESTREAM) {
+            video_parser_ = createVideoParser(meta->video_codec);
+            if (!video_parser_) {
+                NDLLOG(LOGTAG, NDL_LOGE, "%s video codec:%d can not be fed as a byte stream", __func__, meta->video_codec);
+                return NDL_ESP_RESULT_FAIL;
+            }
+        }
+
+        annexb_converter_ = nullptr;
+        video_frame_types_ = nullptr;
+        if (meta_format_.video_framing == NDL_ESP_VIDEO_FRAMED) {
+            annexb_converter_ = createAnnexBConverter(meta->video_codec, meta->extradata, meta->extrasize);
+            if (!annexb_converter_ &&
+                    (meta->video_codec == NDL_ESP_VIDEO_CODEC_H264 || meta->video_codec == NDL_ESP_VIDEO_CODEC_H265))
+                video_frame_types_ = createVideoParser(meta->video_codec);
+        }
+        video_drop_stats_ = NDL_ESP_VIDEO_DROP_STATS();
+        video_key_flags_ = false;
     }
 
     if (enable_audio_) {
-        meta_.channels      = 2;//meta->channels;
+        meta_.channels      = 2;
         meta_.samplerate    = meta->samplerate;
         meta_.blockalign    = meta->blockalign;
         meta_.bitrate       = meta->bitrate;
         meta_.bitspersample = 16;//meta->bitspersample;
 
-        enum AVCodecID codec_id = AV_CODEC_ID_NONE;
-
-        switch (meta->audio_codec) {
-            case NDL_ESP_AUDIO_CODEC_MP2:
-                codec_id = CODEC_ID_MP2;
-                break;
-            case NDL_ESP_AUDIO_CODEC_MP3:
-                codec_id = CODEC_ID_MP3;
-                break;
-            case NDL_ESP_AUDIO_CODEC_AC3:
-                codec_id = CODEC_ID_AC3;
-                break;
-            case NDL_ESP_AUDIO_CODEC_EAC3:
-                codec_id = CODEC_ID_EAC3;
-                break;
-            case NDL_ESP_AUDIO_CODEC_AAC:
-                codec_id = CODEC_ID_AAC;
-                break;
-            case NDL_ESP_AUDIO_CODEC_HEAAC:
-                codec_id = CODEC_ID_AAC_LATM;
-                break;
-            case NDL_ESP_AUDIO_CODEC_PCM_44100_2CH:
-            case NDL_ESP_AUDIO_CODEC_PCM_48000_2CH:
-                codec_id = AV_CODEC_ID_PCM_S16LE;
-                break;
-            default:
-                NDLLOG(LOGTAG, NDL_LOGE, "%s: unsupported audio codec:%d", __func__, meta->audio_codec);
-                break;
+        // lpcm has no libavcodec decoder, its samples are converted by the sw stage
+        const bool lpcm = meta->audio_codec == NDL_ESP_AUDIO_CODEC_LPCM;
+        AudioLpcmFormat lpcm_format;
+        if (lpcm && !getLpcmFormat(meta, meta_format_, &lpcm_format)) {
+            NDLLOG(LOGTAG, NDL_LOGE, "%s: unsupported lpcm %dch %dbits, blockalign:%d", __func__,
+                    meta->channels, meta->bitspersample, meta->blockalign);
+            return NDL_ESP_RESULT_FAIL;
         }
+
+        enum AVCodecID codec_id = audioCodecId(meta->audio_codec, &meta_.samplerate);
         NDLLOG(LOGTAG, NDL_LOGD, "metadata audio_codec:%d, channel:%d, samplerate:%d, bitrate:%d, blockalign:%d, bitspersample:%d",
                 meta->audio_codec, meta->channels, meta->samplerate, meta->bitrate, meta->blockalign, meta->bitspersample);
 
-        if (codec_id != AV_CODEC_ID_NONE && codec_id != AV_CODEC_ID_PCM_S16LE) {
+        // raw pcm goes through the sw stage only to be resampled to the fixed output rate
+        const int output_rate = audioOutputRate();
+        const bool resample_pcm = output_rate > 0 && output_rate != (int)meta_.samplerate;
+
+        if (lpcm || (codec_id != AV_CODEC_ID_NONE && (codec_id != AV_CODEC_ID_PCM_S16LE || resample_pcm))) {
+            // multichannel source : native pcm if the renderer takes it, stereo downmix otherwise
+            int source_channels = meta->channels > 0 ? (int)meta->channels : 2;
+            if (source_channels > 2 && source_channels <= maxAudioOutputChannels())
+                meta_.channels = source_channels;
+
             audio_sw_decoder_ = std::make_shared<AudioSwDecoder>();
             if (audio_sw_decoder_ != NULL) {
                 NDLLOG(LOGTAG, NDL_LOGD, "audio sw decoder is created", __func__);
                 audio_sw_decoder_->audio_stream_info_.codec_id              = codec_id;
-                audio_sw_decoder_->audio_stream_info_.channels              = meta_.channels;
+                audio_sw_decoder_->audio_stream_info_.channels              = source_channels;
                 audio_sw_decoder_->audio_stream_info_.sample_rate           = meta_.samplerate;
                 audio_sw_decoder_->audio_stream_info_.bit_rate              = (int64_t)meta_.bitrate;
                 audio_sw_decoder_->audio_stream_info_.block_align           = meta_.blockalign;
                 audio_sw_decoder_->audio_stream_info_.bits_per_coded_sample = meta_.bitspersample;
-                if( audio_sw_decoder_->OpenAudio(codec_id) == false ){
+                if (lpcm ? !audio_sw_decoder_->OpenLpcm(lpcm_format) : !audio_sw_decoder_->OpenAudio(codec_id)) {
                     NDLLOG(LOGTAG, NDL_LOGE, "audio sw decoder codec_id:0x%x open error", __func__, codec_id);
                     return NDL_ESP_RESULT_FAIL;
                 }
+                audio_sw_decoder_->SetOutputChannels(meta_.channels);
+                if (output_rate > 0) {
+                    audio_sw_decoder_->SetOutputSampleRate(output_rate);
+                    meta_.samplerate = output_rate;
+                }
             }
             else {
                 NDLLOG(LOGTAG, NDL_LOGE, "audio sw decoder creation error", __func__);
@@ -265,6 +413,15 @@ int Esplayer::load(NDL_ESP_META_DATA* meta)
             return NDL_ESP_RESULT_FAIL;
         }
 
+        audio_parser_ = nullptr;
+        if (meta_format_.audio_framing == NDL_ESP_AUDIO_BYTESTREAM) {
+            audio_parser_ = createAudioParser(meta->audio_codec);
+            if (!audio_parser_) {
+                NDLLOG(LOGTAG, NDL_LOGE, "%s audio codec:%d can not be fed as a byte stream", __func__, meta->audio_codec);
+                return NDL_ESP_RESULT_FAIL;
+            }
+        }
+
     }
     //save codec infomation
     meta_.video_codec = meta->video_codec;
@@ -399,6 +556,9 @@ int Esplayer::load(NDL_ESP_META_DATA* meta)
             result = NDL_ESP_RESULT_AUDIO_BUFFER_ERROR;
             BREAK_IF_NONZERO(audio_codec_->allocateInputBuffer(),
                     "allocating audio decoder input buffers");
+            if (audio_sw_decoder_ && AudioDecodeWorker::configuredAheadMs() > 0)
+                audio_decode_worker_ = std::make_shared<AudioDecodeWorker>(audio_sw_decoder_,
+                        AudioDecodeWorker::configuredAheadMs(), audio_codec_->getInputBufferSize());
             BREAK_IF_NONZERO(audio_codec_->waitForPortEnable(audio_codec_->getInputPortIndex(), true, MAX_PORT_WAIT_TIME),
                     "waitForPortEnable for audio decoder");
 
@@ -431,7 +591,8 @@ int Esplayer::load(NDL_ESP_META_DATA* meta)
                     (int)pcm.eNumData, (int)pcm.eEndian);
 
             pcm.nSize = sizeof(OMX_AUDIO_PARAM_PCMMODETYPE);
-            pcm.nSamplingRate = 44100;//std::min(std::max((int)pcm.nSamplingRate, 8000), 192000);
+            // fixed output rate : the renderer keeps it across streams of other rates
+            pcm.nSamplingRate = audioOutputRate() > 0 ? meta_.samplerate : 44100;//std::min(std::max((int)pcm.nSamplingRate, 8000), 192000);
             pcm.nBitPerSample = 16;
             pcm.eEndian = OMX_EndianLittle;
             pcm.eNumData = OMX_NumericalDataSigned;
@@ -439,9 +600,7 @@ int Esplayer::load(NDL_ESP_META_DATA* meta)
             pcm.ePCMMode = OMX_AUDIO_PCMModeLinear;
             pcm.nChannels = meta_.channels;
             pcm.nVersion.nVersion= OMX_VERSION;
-
-            pcm.eChannelMapping[0] = OMX_AUDIO_ChannelLF;
-            pcm.eChannelMapping[1] = OMX_AUDIO_ChannelRF;
+            setPcmChannelMapping(&pcm, getAudioChannelLayout());
 
 #if SUPPORT_AUDIOMIXER
             pcm.nPortIndex = audio_mixer_->getOutputPortIndex();
@@ -450,8 +609,23 @@ int Esplayer::load(NDL_ESP_META_DATA* meta)
 #endif
             //audio renderer input port is already enabled during setupTunnel
             pcm.nPortIndex = audio_renderer_->getInputPortIndex();
-            LOG_IF_NONZERO(audio_renderer_->setParam(OMX_IndexParamAudioPcm, &pcm),
-                    "Load: set audio renderer PCM format");
+            int pcm_result = audio_renderer_->setParam(OMX_IndexParamAudioPcm, &pcm);
+            if (pcm_result != 0 && meta_.channels > 2 && audio_sw_decoder_) {
+                // renderer without multichannel input : downmix in the decoder
+                NDLLOG(LOGTAG, NDL_LOGI, "Load: renderer rejects %dch PCM, downmix to stereo", meta_.channels);
+                meta_.channels = 2;
+                audio_sw_decoder_->SetOutputChannels(meta_.channels);
+                pcm.nChannels = meta_.channels;
+                setPcmChannelMapping(&pcm, getAudioChannelLayout());
+#if SUPPORT_AUDIOMIXER
+                pcm.nPortIndex = audio_mixer_->getOutputPortIndex();
+                LOG_IF_NONZERO(audio_mixer_->setParam(OMX_IndexParamAudioPcm, &pcm),
+                        "Load: set audio mixer PCM format");
+#endif
+                pcm.nPortIndex = audio_renderer_->getInputPortIndex();
+                pcm_result = audio_renderer_->setParam(OMX_IndexParamAudioPcm, &pcm);
+            }
+            LOG_IF_NONZERO(pcm_result, "Load: set audio renderer PCM format");
 
             /* setup audio tunneling
             ** audio_codec_ -> audio_mixer_ -> audio_renderer
@@ -585,20 +759,37 @@ void Esplayer::sendVideoDecoderConfig()
 {
     NDLLOG(SDETTAG, LOG_INOUT, "%s +", __func__);
 
-    int write_len = video_codec_->writeToConfigBuffer(video_codec_->getInputPortIndex(),
-            (uint8_t*)meta_.extradata,
-            meta_.extrasize);
+    int write_len = 0;
+    if (annexb_converter_) {
+        // the decoder takes Annex-B as the frames converted
+        const std::vector<uint8_t>& parameter_sets = annexb_converter_->parameterSets();
+        write_len = video_codec_->writeToConfigBuffer(video_codec_->getInputPortIndex(),
+                parameter_sets.data(),
+                parameter_sets.size());
+    } else {
+        write_len = video_codec_->writeToConfigBuffer(video_codec_->getInputPortIndex(),
+                (uint8_t*)meta_.extradata,
+                meta_.extrasize);
+    }
 
     NDLLOG(SDETTAG, LOG_INOUT, "%s write_len:%d -", __func__, write_len);
 }
 
+uint64_t Esplayer::getAudioChannelLayout()
+{
+    // AV_CH_* bits are the SPEAKER_* bits of the WAVEFORMATEXTENSIBLE mask
+    if (audio_sw_decoder_)
+        return audio_sw_decoder_->GetOutputChannelLayout();
+    return SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT;
+}
+
 void Esplayer::sendAudioDecoderConfig()
 {
     NDLLOG(SDETTAG, LOG_INOUT, "%s +", __func__);
     memset(&m_wave_header, 0x0, sizeof(WAVEFORMATEXTENSIBLE));
 
     m_wave_header.Format.nChannels  = meta_.channels;
-    m_wave_header.dwChannelMask     = SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT;
+    m_wave_header.dwChannelMask     = (uint32_t)getAudioChannelLayout();
     m_wave_header.Samples.wSamplesPerBlock    = 0;
     m_wave_header.Format.nChannels            = meta_.channels;
     m_wave_header.Format.nBlockAlign          = meta_.channels *    (meta_.bitspersample >> 3);
@@ -622,10 +813,76 @@ void Esplayer::sendAudioDecoderConfig()
 
 int Esplayer::loadEx(NDL_ESP_META_DATA* meta, NDL_ESP_PTS_UNITS units)
 {
-    pts_units_ = units;
+    NDL_ESP_PTS_TIMEBASE timebase;
+    timebase.num = 1;
+    timebase.den = (units == NDL_ESP_PTS_TICKS ? 90000 : 1000000);
+    timebase.wrap_bits = PTS_DEFAULT_WRAP_BITS;
+    return loadWithTimebase(meta, &timebase, &timebase);
+}
+
+int Esplayer::loadWithTimebase(NDL_ESP_META_DATA* meta,
+        const NDL_ESP_PTS_TIMEBASE* audio, const NDL_ESP_PTS_TIMEBASE* video)
+{
+    // refused or duplicate load : the timelines of the loaded stream stay as they are
+    if (loaded_ || !state_.canTransit(NDL_ESP_STATUS_LOADED))
+        return load(meta);
+
+    const NDL_ESP_PTS_TIMEBASE* timebase[] = {audio, video};
+    PtsTimeline timeline[2];
+
+    for (int i = 0; i < 2; i++) {
+        if (!timebase[i])
+            continue;
+        if (!PtsTimeline::isValid(timebase[i]->num, timebase[i]->den, timebase[i]->wrap_bits)) {
+            NDLLOG(LOGTAG, NDL_LOGE, "invalid %s timebase %u/%u, wrap %u bits", i ? "video" : "audio",
+                    timebase[i]->num, timebase[i]->den, timebase[i]->wrap_bits);
+            return NDL_ESP_RESULT_FAIL;
+        }
+        NDLLOG(LOGTAG, NDL_LOGI, "%s timebase %u/%u, wrap %u bits", i ? "video" : "audio",
+                timebase[i]->num, timebase[i]->den, timebase[i]->wrap_bits);
+        timeline[i] = PtsTimeline(timebase[i]->num, timebase[i]->den, timebase[i]->wrap_bits);
+    }
+
+    pts_timeline_[NDL_ESP_AUDIO_ES] = timeline[0];
+    pts_timeline_[NDL_ESP_VIDEO_ES] = timeline[1];
+    // mixed into the main audio, same demuxer
+    pts_timeline_[NDL_ESP_AUDIO_SECONDARY_ES] = timeline[0];
     return load(meta);
 }
 
+int Esplayer::loadWithFormat(NDL_ESP_META_DATA* meta, const NDL_ESP_META_FORMAT* format,
+        const NDL_ESP_PTS_TIMEBASE* audio, const NDL_ESP_PTS_TIMEBASE* video)
+{
+    // a caller built with fewer fields gets the defaults for the rest, a newer one is refused
+    NDL_ESP_META_FORMAT meta_format = {};
+    if (format) {
+        if (format->size < sizeof(format->size) || format->size > sizeof(meta_format)) {
+            NDLLOG(LOGTAG, NDL_LOGE, "%s: unknown format size %u (%u)", __func__,
+                    format->size, (uint32_t)sizeof(meta_format));
+            return NDL_ESP_RESULT_FAIL;
+        }
+        memcpy(&meta_format, format, format->size);
+    }
+    if ((meta_format.audio_framing != NDL_ESP_AUDIO_FRAMED && meta_format.audio_framing != NDL_ESP_AUDIO_BYTESTREAM) ||
+            (meta_format.video_framing != NDL_ESP_VIDEO_FRAMED && meta_format.video_framing != NDL_ESP_VIDEO_BYTESTREAM)) {
+        NDLLOG(LOGTAG, NDL_LOGE, "%s: unknown framing audio:%d video:%d", __func__,
+                meta_format.audio_framing, meta_format.video_framing);
+        return NDL_ESP_RESULT_FAIL;
+    }
+    if (loaded_) {
+        NDLLOG(LOGTAG, NDL_LOGI, "block duplicate load call");
+        return NDL_ESP_RESULT_SUCCESS;
+    }
+
+    meta_format_ = meta_format;
+    NDLLOG(LOGTAG, NDL_LOGI, "%s: pcm flags:0x%x, framing audio:%d video:%d", __func__,
+            meta_format_.pcm_flags, meta_format_.audio_framing, meta_format_.video_framing);
+    int result = loadWithTimebase(meta, audio, video);
+    if (result != NDL_ESP_RESULT_SUCCESS)
+        meta_format_ = NDL_ESP_META_FORMAT();
+    return result;
+}
+
 int Esplayer::loadClockComponent()
 {
     auto clock = std::make_shared<OmxClock>();
@@ -743,6 +1000,20 @@ int Esplayer::unload()
 
     //clear message looper
     clearFrameQueues();
+    postTrickTiming(true);
+    audio_decode_worker_.reset();
+    secondary_audio_.close();
+    audio_tracks_.clear();
+    audio_parser_ = nullptr;
+    video_parser_ = nullptr;
+    annexb_converter_ = nullptr;
+    video_annexb_left_ = 0;
+    audio_raw_offset_ = -1;
+    audio_sw_flags_set_ = false;
+    video_frame_types_ = nullptr;
+    media_clock_.reset();
+    // the next load without format takes the defaults
+    meta_format_ = NDL_ESP_META_FORMAT();
 
     callback_ = 0;
     userdata_ = 0;
@@ -965,6 +1236,44 @@ int Esplayer::setComponentsFlush(int timeout_seconds)
     return NDL_ESP_RESULT_SUCCESS;
 }
 
+// issue the flush commands of all the ports first, then wait for them together.
+// total wait time is bounded by timeout_seconds instead of the sum of each component.
+int Esplayer::setComponentsFlushParallel(int timeout_seconds)
+{
+    NDLLOG(LOGTAG, LOG_INOUT, "%s(wait:%d) +", __func__, timeout_seconds);
+
+    std::vector<std::pair<Component*, int>> ports;
+    if (video_codec_)       ports.emplace_back(video_codec_.get(), OMX_ALL);
+    if (video_scheduler_)   ports.emplace_back(video_scheduler_.get(), video_scheduler_->getInputPortIndex());
+    if (video_renderer_)    ports.emplace_back(video_renderer_.get(), video_renderer_->getInputPortIndex());
+    if (audio_codec_)       ports.emplace_back(audio_codec_.get(), OMX_ALL);
+#if SUPPORT_AUDIOMIXER
+    if (audio_mixer_)       ports.emplace_back(audio_mixer_.get(), OMX_ALL);
+#endif
+    if (audio_renderer_)    ports.emplace_back(audio_renderer_.get(), audio_renderer_->getInputPortIndex());
+
+    std::vector<Component*> flushing;
+    for (auto& port : ports) {
+        if (port.first->flush(port.second, 0) == 0)
+            flushing.push_back(port.first);
+        else
+            NDLLOG(LOGTAG, NDL_LOGE, "%s : flush command error (port:%d)", __func__, port.second);
+    }
+
+    timespec deadline;
+    if (clock_gettime(CLOCK_MONOTONIC, &deadline) != 0) {
+        NDLLOG(LOGTAG, NDL_LOGE, "system : clock_gettime error...... ");
+        return NDL_ESP_RESULT_FAIL;
+    }
+    deadline.tv_sec += timeout_seconds;
+
+    for (auto component : flushing)
+        LOG_IF_NONZERO(component->waitForFlushing(deadline), "flush done component");
+
+    NDLLOG(LOGTAG, LOG_INOUT, "%s -", __func__);
+    return NDL_ESP_RESULT_SUCCESS;
+}
+
 int Esplayer::notifyForegroundState(const NDL_ESP_APP_STATE appState)
 {
 
@@ -983,135 +1292,87 @@ int Esplayer::notifyForegroundState(const NDL_ESP_APP_STATE appState)
 
 int64_t Esplayer::adjustPtsToMicrosecond(int index, int64_t pts)
 {
-    const int64_t max = ((int64_t)1<<33) - 1; // 2^33-1
-    const int64_t big = ((int64_t)1<<32) - 1; // 2^32-1
-    int64_t ret_pts = 0;
+    PtsTimeline& timeline = pts_timeline_[index];
 
-    if (pts_previous_[index] == -1) {
-        int port_index = (index==/*PORT_CLOCK_VIDEO*/0) ? /*PORT_CLOCK_AUDIO*/1 : /*PORT_CLOCK_VIDEO*/0;
-        if ((pts_previous_[port_index] !=-1) && (std::abs(pts_previous_[port_index] - pts) >= big)) {
+    if (timeline.previous() == -1) {
+        int port_index = (index == NDL_ESP_AUDIO_ES) ? NDL_ESP_VIDEO_ES : NDL_ESP_AUDIO_ES;
+        PtsTimeline& other = pts_timeline_[port_index];
+        if (other.previous() != -1) {
             // Audio/video pts wrap around occurs with different timing independently.
             //   So, if input stream starts in the middle of wraparounds,
             //   there'll be huge gap between audio and video pts.
             // Therefore, if diff between the previous pts of the other port and the first pts of this port is big enough,
             // assume that there was a wraparound before.
-            //
-            NDLLOG(LOGTAG, NDL_LOGI, "already wraparound before... Port : %d, %lld vs %lld ",
-                    port_index, pts_previous_[port_index], pts);
-            if (pts_previous_[port_index] > pts)
-                port_index = index;
-
-            pts_base_[port_index] += max;
-        }
-    }
-
-    if (pts_previous_[index] - pts > big) { // pts drop detected
-        if (pts_drop_count_[index] < PTS_DROP_THRESHOLD) {
-            // just adjust pts, don't increase pts_base_
-            //  don't save current pts here (it'll generate next drop even if there's no real drop)
-            pts_drop_count_[index] += 1;
-            NDLLOG(LOGTAG, NDL_LOGI, "pts[%d] drop count : %d, %lld->%lld, pts_base_[%d]:%lld",
-                    index, pts_drop_count_[index], pts_previous_[index], pts, index, pts_base_[index]);
-            pts += max;
-        } else {
-            // submit pts wraparound
-            pts_drop_count_[index] = 0;
-            pts_base_[index] += max;
-            NDLLOG(LOGTAG, NDL_LOGI, "pts[%d] : 2nd drop detected, %lld->%lld, new pts_base_[%d]:%lld",
-                    index, pts_previous_[index], pts, index, pts_base_[index]);
-            pts_previous_[index] = pts;
+            //   (compared in microseconds, the streams may have different timebases)
+            int64_t ahead = other.toMicrosecond(other.previous()) - timeline.toMicrosecond(pts);
+            PtsTimeline& wrapped = ahead > 0 ? timeline : other;
+            if (wrapped.wrap() && std::abs(ahead) >= wrapped.toMicrosecond(wrapped.wrap() / 2)) {
+                NDLLOG(LOGTAG, NDL_LOGI, "already wraparound before... Port : %d, %lld vs %lld ",
+                        port_index, other.previous(), pts);
+                wrapped.addWrap();
+            }
         }
-    } else {
-        pts_drop_count_[index] = 0;
-        pts_previous_[index] = pts;
     }
 
-    // in the NDL_EPS_PTS_TICKS case PTS is in 90kHz, 1 pts = 1000000 / 90000 microsecods
-    ret_pts = (pts_units_ == NDL_ESP_PTS_TICKS ? (pts+pts_base_[index])*100/9 : pts+pts_base_[index]);
+    int64_t ret_pts = timeline.toMicrosecond(timeline.unwrap(pts));
     //NDLLOG(LOGTAG, LOG_FEEDINGV, "%s(idx:%d),  pts:%lld, ret_pts:%lld", __func__, index, pts, ret_pts);
     return ret_pts;
 }
 
-uint32_t Esplayer::setOmxFlags(int64_t pts, uint32_t buffer_flags, NDL_ESP_STREAM_T stream_type)
+int64_t Esplayer::adjustTrackPtsToMicrosecond(int64_t pts)
 {
-    int video_used_buffer_count = video_codec_->getUsedBufferCount(video_codec_->getInputPortIndex());
-    int audio_used_buffer_count = audio_codec_->getUsedBufferCount(audio_codec_->getInputPortIndex());
-    int video_render_qsize = video_renderer_looper_.size();
-    int audio_render_qsize = audio_renderer_looper_.size();
-    int64_t av_delta = 0;
-
-    syncState sync_state_new = sync_state_;
-
-    if (stream_type == NDL_ESP_VIDEO_ES) {
-        if( video_last_pts_ != 0 && audio_last_pts_ != 0 )
-            av_delta = video_last_pts_ - audio_last_pts_;
-
-        if (video_last_pts_ == 0) {
-            NDLLOG(LOGTAG, LOG_FEEDING, "%s, ALLOW_VIDEO at starttime in pts 0", __func__);
-            sync_state_ = ALLOW_VIDEO;
-            buffer_flags = buffer_flags | OMX_BUFFERFLAG_STARTTIME;
-        }
-        else {
-            if (av_delta < VIDEO_IN_BUFFER_MKSEC_SKIP) {
-                sync_state_ = SKIP_VIDEO;
-                NDLLOG(LOGTAG, LOG_FEEDINGV, "SKIP_VIDEO av_delta:%lld, pts:%lld", av_delta, pts);
-                buffer_flags = buffer_flags | OMX_BUFFERFLAG_DECODEONLY;
-            } else if ((sync_state_ != HOLD_VIDEO) && (av_delta > VIDEO_IN_BUFFER_MKSEC_HIGH)) {
-                sync_state_new = HOLD_VIDEO;
-                NDLLOG(LOGTAG, LOG_FEEDINGV, "HOLD_VIDEO high av_delta:%lld, video_used_buf_cnt:%d", av_delta, video_used_buffer_count);
-            } else if (sync_state_ == SKIP_VIDEO && av_delta < VIDEO_IN_BUFFER_MKSEC_LOW) {
-                sync_state_new = ALLOW_VIDEO;
-                NDLLOG(LOGTAG, LOG_FEEDING, "%s, ALLOW_VIDEO in SKIP", __func__);
-            }
-        }
+    // the track wraps a little before or after the main audio
+    const PtsTimeline& timeline = pts_timeline_[NDL_ESP_AUDIO_ES];
+    return timeline.toMicrosecond(timeline.unwrapNear(pts));
+}
 
-        if ((sync_state_ == ALLOW_VIDEO) && ( video_used_buffer_count > VIDEO_IN_BUFFER_COUNT_HIGH)) {
-            NDLLOG(LOGTAG, LOG_FEEDINGV, "HOLD_VIDEO 2 av_delta:%lld, video_used_buf_cnt:%d, qsize:%d",
-                    av_delta, video_used_buffer_count, video_render_qsize);
-            sync_state_new = HOLD_VIDEO;
-        }
-        video_last_pts_ = pts;
+/**
+ * omx flags of a buffer from the A/V sync decision : start time, decode only for late video,
+ * and the hold/release of the video feed notified to the client.
+ * The decision is on the presented offset in the non-tunnel build, on the fed pts otherwise
+ */
+uint32_t Esplayer::setOmxFlags(int64_t pts, uint32_t buffer_flags, NDL_ESP_STREAM_T stream_type,
+        AvSyncController::Decision* decision)
+{
+    if (stream_type != NDL_ESP_VIDEO_ES && stream_type != NDL_ESP_AUDIO_ES) {
+        NDLLOG(LOGTAG, LOG_FEEDING, "Wrong stream type:%d", stream_type);
+        return buffer_flags;
     }
-    else if (stream_type == NDL_ESP_AUDIO_ES) {
-        if( video_last_pts_ != 0 && audio_last_pts_ != 0 )
-            av_delta = video_last_pts_ - audio_last_pts_;
 
-        if (audio_last_pts_ == 0){
-            NDLLOG(LOGTAG, LOG_FEEDING, "%s, AUDIO set starttime flag in pts 0", __func__);
-            buffer_flags = buffer_flags | OMX_BUFFERFLAG_STARTTIME;
-        }
+    int video_used_buffer_count = video_codec_ ?
+        video_codec_->getUsedBufferCount(video_codec_->getInputPortIndex()) : 0;
+    AvSyncController::Decision sync = av_sync_.feed(stream_type, pts, video_used_buffer_count);
 
-        if ((sync_state_ != ALLOW_VIDEO)
-                && ( av_delta < VIDEO_IN_BUFFER_MKSEC_LOW && av_delta > VIDEO_IN_BUFFER_MKSEC_SKIP )
-                && (video_used_buffer_count <= VIDEO_IN_BUFFER_COUNT_HIGH)){
-            sync_state_new = ALLOW_VIDEO;
-            NDLLOG(LOGTAG, LOG_FEEDINGV, "ALLOW_VIDEO by audio ES. av_delta:%lld", av_delta);
-        }
-        audio_last_pts_ = pts;
+    if (sync.start_time) {
+        NDLLOG(LOGTAG, LOG_FEEDING, "%s, %s set starttime flag in pts %lld", __func__,
+                stream_type == NDL_ESP_VIDEO_ES ? "VIDEO" : "AUDIO", pts);
+        buffer_flags = buffer_flags | OMX_BUFFERFLAG_STARTTIME;
     }
-    else {
-        NDLLOG(LOGTAG, LOG_FEEDING, "Wrong stream type:%d", stream_type);
+    if (sync.drop) {
+        NDLLOG(LOGTAG, LOG_FEEDINGV, "SKIP_VIDEO av offset:%lld, pts:%lld", sync.offset, pts);
+        buffer_flags = buffer_flags | OMX_BUFFERFLAG_DECODEONLY;
     }
 
-    if (sync_state_ != HOLD_VIDEO && (sync_state_new == HOLD_VIDEO)) {
-        sync_state_ = HOLD_VIDEO;
-        NDLLOG(LOGTAG, LOG_FEEDING, "notifyClient PTS HOLD_VIDEO (Apts:%lld/Vpts:%lld, delta:%d)(used a:%d/v:%d)",
-                audio_last_pts_, video_last_pts_, av_delta, video_used_buffer_count, audio_used_buffer_count);
+    if (sync.hold > 0) {
+        NDLLOG(LOGTAG, LOG_FEEDING, "notifyClient PTS HOLD_VIDEO (pts:%lld, stream:%d)(used v:%d)",
+                pts, stream_type, video_used_buffer_count);
         video_message_looper_.post(std::make_shared<Message>([this]{
                     //NDLLOG(LOGTAG, NDL_LOGD, "notifyClient NDL_ESP_HIGH_THRESHOLD_CROSSED_VIDEO by PTS");
                     notifyClient(NDL_ESP_HIGH_THRESHOLD_CROSSED_VIDEO);
                     return NDL_ESP_RESULT_SUCCESS;
                     }));
-    } else if (sync_state_ == HOLD_VIDEO && sync_state_new == ALLOW_VIDEO) {
-        sync_state_ = ALLOW_VIDEO;
-        NDLLOG(LOGTAG, LOG_FEEDING, "notifyClient PTS ALLOW_VIDEO (Apts:%lld/Vpts:%lld, delta:%d)(used a:%d/v:%d)",
-                audio_last_pts_, video_last_pts_, av_delta, video_used_buffer_count, audio_used_buffer_count);
+    } else if (sync.hold < 0) {
+        NDLLOG(LOGTAG, LOG_FEEDING, "notifyClient PTS ALLOW_VIDEO (pts:%lld, stream:%d)(used v:%d)",
+                pts, stream_type, video_used_buffer_count);
         video_message_looper_.post(std::make_shared<Message>([this]{
                     //NDLLOG(LOGTAG, NDL_LOGD, "notifyClient NDL_ESP_LOW_THRESHOLD_CROSSED_VIDEO by PTS");
                     notifyClient(NDL_ESP_LOW_THRESHOLD_CROSSED_VIDEO);
                     return NDL_ESP_RESULT_SUCCESS;
                     }));
     }
+
+    if (decision)
+        *decision = sync;
     return buffer_flags;
 }
 
@@ -1140,36 +1401,59 @@ int Esplayer::Feed_AudioData(void)
         return NDL_ESP_RESULT_FEED_FULL;//buffer full
     }
 
+    // audio decoded from now on is stretched by the drift of the renderer
+    if (audio_sw_decoder_)
+        audio_sw_decoder_->SetDriftPpm(audio_drift_.getCorrection());
+
+    if (audio_decode_worker_)
+        return feedDecodedAudio();
+
     NDL_ESP_STREAM_BUFFER* buff = getBufQueue(stream_type);
     if( buff == nullptr ) {
         NDLLOG(LOGTAG, NDL_LOGD, "%s, buffer is null", __func__);
         return written_len;
     }
 
+    // rest of the raw pcm frame the codec buffers did not take at the previous try
+    if (audio_raw_offset_ >= 0)
+        return writeRawAudio(buff);
+
+    // rest of the frame decoded by the previous try
+    if (audio_sw_decoder_ && audio_sw_decoder_->GetOutputBufferSize() > 0) {
+        if (writeDecodedAudio() > 0)
+            return NDL_ESP_RESULT_FEED_FULL;
+        popBufQueue(stream_type);
+        return audio_sw_consumed_;
+    }
+
     NDLLOG(LOGTAG, LOG_FEEDINGV, "%s, pts:%lld  data_size:%d (qsize:%d, empty_buf_size:%d)",
             __func__, buff->timestamp, buff->data_len, audio_renderer_looper_.size(), audio_codec_->getFreeBufferCount(audio_codec_->getInputPortIndex()));
 
-    int64_t pts = enable_video_ ? adjustPtsToMicrosecond(/*PORT_CLOCK_AUDIO*/ buff->stream_type, buff->timestamp) : 0;
+    int64_t pts = audioFeedPts(buff);
 
     data = buff->data;
     data_len = buff->data_len;
 
     if( data_len > 0 ) {
-        buffer_flags = setOmxFlags(pts,
+        buffer_flags = setOmxFlags(pts >= 0 ? pts : av_sync_.lastFedPts(NDL_ESP_AUDIO_ES),
                 translateToOmxFlags(buff->flags)|OMX_BUFFERFLAG_ENDOFFRAME,
                 buff->stream_type);
 
-        // for audio sw decoder
+        // for audio sw decoder (raw pcm too when it is resampled)
         if (audio_sw_decoder_ != NULL) {
-            if (audio_sw_decoder_->audio_stream_info_.codec_id != AV_CODEC_ID_PCM_S16LE) {
 #ifdef FILEDUMP
-                DUMP_TO_FILE(mInFile, buff->data, buff->data_len);
+            DUMP_TO_FILE(mInFile, buff->data, buff->data_len);
 #endif
-                ret = audio_sw_decoder_->DecodeAudio(buff->data, buff->data_len, pts, pts);
-                data = audio_sw_decoder_->GetOutputBufferData();
-                data_len = audio_sw_decoder_->GetOutputBufferSize();
-                // NDLLOG(LOGTAG, NDL_LOGD, "%s: audio frame is decoded %d(%d)", __func__, data_len, ret);
-            }
+            ret = audio_sw_decoder_->DecodeAudio(buff->data, buff->data_len, pts, pts);
+            // NDLLOG(LOGTAG, NDL_LOGD, "%s: audio frame is decoded %d(%d)", __func__, audio_sw_decoder_->GetOutputBufferSize(), ret);
+
+            // decoded samples of all the frames in the packet go to the omx input buffers
+            audio_sw_flags_ = buffer_flags;
+            audio_sw_consumed_ = ret > 0 ? ret : 0;
+            if (writeDecodedAudio() > 0)
+                return NDL_ESP_RESULT_FEED_FULL;  // packet stays queued until the frame is written
+            popBufQueue(stream_type);
+            return audio_sw_consumed_;
         }
         else {
             NDLLOG(LOGTAG, NDL_LOGE, "%s: audio sw decoder is not created", __func__);
@@ -1181,11 +1465,19 @@ int Esplayer::Feed_AudioData(void)
     DUMP_TO_FILE(mOutFile, data, data_len);
 #endif
 
-    written_len = audio_codec_->writeToFreeBuffer(audio_codec_->getInputPortIndex(),
-            data,
-            data_len,
-            pts,
-            buffer_flags);
+    if (data_len > 0 && (!audio_gain_.isPassthrough() || secondary_audio_.isActive() || audio_tracks_.isActive())) {
+        // raw pcm : track splice, secondary mix and volume applied on the copy in the omx buffers
+        audio_raw_offset_ = 0;
+        audio_raw_pts_ = pts;
+        audio_raw_flags_ = buffer_flags;
+        return writeRawAudio(buff);
+    } else {
+        written_len = audio_codec_->writeToFreeBuffer(audio_codec_->getInputPortIndex(),
+                data,
+                data_len,
+                pts,
+                buffer_flags);
+    }
 
     popBufQueue(stream_type);
 
@@ -1196,6 +1488,170 @@ int Esplayer::Feed_AudioData(void)
     return written_len;
 }
 
+/**
+ * Write the raw pcm of the queued frame from audio_raw_offset_ into free input buffers of the audio codec.
+ * return FEED_FULL with the frame kept queued until the codec buffers take all of it
+ */
+int Esplayer::writeRawAudio(const NDL_ESP_STREAM_BUFFER* buff)
+{
+    const uint8_t* data = buff->data;
+    int32_t offset = audio_raw_offset_;
+    int64_t pts = offset > 0 && enable_video_ ? audioPtsAt(audio_raw_pts_, offset) : audio_raw_pts_;
+    int error = OMX_ErrorNone;
+    int written_len = audio_codec_->writeToFreeBuffer(audio_codec_->getInputPortIndex(),
+            buff->data_len - offset,
+            pts,
+            audio_raw_flags_,
+            [this, data, &offset] (uint8_t* dst, int32_t capacity) {
+                memcpy(dst, data + offset, capacity);
+                processAudioOutput(dst, capacity, audioPtsAt(audio_raw_pts_, offset));
+                offset += capacity;
+                return capacity;
+            },
+            &error);
+    if (written_len > 0)
+        audio_raw_flags_ &= ~OMX_BUFFERFLAG_STARTTIME;
+
+    if (offset < buff->data_len) {
+        NDLLOG(LOGTAG, error != OMX_ErrorNone ? NDL_LOGE : LOG_FEEDINGV, "%s, %d of %d bytes written (error 0x%x)",
+                __func__, offset, buff->data_len, error);
+        audio_raw_offset_ = offset;
+        return NDL_ESP_RESULT_FEED_FULL;
+    }
+    audio_raw_offset_ = -1;
+    popBufQueue(NDL_ESP_AUDIO_ES);
+    return buff->data_len;
+}
+
+/**
+ * Write the decoded audio into free input buffers of the audio codec,
+ * one buffer at a time so that each buffer has the pts of its first sample.
+ * return the size left in the decoder, > 0 if the free buffers ran out
+ */
+int Esplayer::writeDecodedAudio()
+{
+    const int port_index = audio_codec_->getInputPortIndex();
+    const int frame_size = audio_sw_decoder_->GetOutputFrameSize();
+    int chunk_size = audio_codec_->getInputBufferSize();
+    if (frame_size > 0 && chunk_size >= frame_size)
+        chunk_size -= chunk_size % frame_size;
+
+    int data_len = audio_sw_decoder_->GetOutputBufferSize();
+    while (data_len > 0) {
+        int64_t pts = enable_video_ ? audio_sw_decoder_->GetOutputPts() : 0;
+        int error = OMX_ErrorNone;
+        int written_len = audio_codec_->writeToFreeBuffer(port_index,
+                std::min(data_len, chunk_size),
+                pts,
+                audio_sw_flags_,
+                [this] (uint8_t* dst, int32_t capacity) {
+                    int64_t pts = enable_video_ ? audio_sw_decoder_->GetOutputPts() : -1;
+                    int32_t len = (int32_t)audio_sw_decoder_->ReadOutput(dst, capacity);
+                    processAudioOutput(dst, len, pts);
+                    return len;
+                },
+                &error);
+        if (written_len <= 0)
+            break;
+
+        // the rest of the output continues the same access unit
+        audio_sw_flags_ &= ~OMX_BUFFERFLAG_STARTTIME;
+        data_len = audio_sw_decoder_->GetOutputBufferSize();
+        // the codec took what was read, the rest waits for the retry of the feeder
+        if (error != OMX_ErrorNone) {
+            NDLLOG(LOGTAG, NDL_LOGE, "%s, empty buffer error 0x%x, %d bytes left", __func__, error, data_len);
+            break;
+        }
+    }
+    return data_len;
+}
+
+/**
+ * Write the pcm decoded ahead by the decode worker into free input buffers of the audio codec.
+ * One call completes one packet, FEED_FULL until all the chunks of the packet are written.
+ */
+int Esplayer::feedDecodedAudio()
+{
+    const int port_index = audio_codec_->getInputPortIndex();
+    AudioDecodeWorker::Chunk chunk;
+
+    while (audio_decode_worker_->peek(&chunk, AUDIO_DECODE_WAIT_MS)) {
+        if (audio_codec_->getFreeBufferCount(port_index) == 0)
+            return NDL_ESP_RESULT_FEED_FULL;
+
+        // flags are set once per packet, a first chunk the codec did not take keeps them for the retry
+        if (chunk.first && !audio_sw_flags_set_) {
+            uint32_t flags = translateToOmxFlags(chunk.packet_flags)|OMX_BUFFERFLAG_ENDOFFRAME;
+            audio_sw_flags_ = chunk.size > 0 ?
+                setOmxFlags(chunk.packet_pts >= 0 ? chunk.packet_pts : chunk.pts, flags, NDL_ESP_AUDIO_ES) : flags;
+            audio_sw_flags_set_ = true;
+        }
+
+        if (chunk.size > 0) {
+            int64_t pts = enable_video_ ? chunk.pts : 0;
+            int32_t offset = 0;
+            int error = OMX_ErrorNone;
+            int written_len = audio_codec_->writeToFreeBuffer(port_index,
+                    chunk.size,
+                    pts,
+                    audio_sw_flags_,
+                    [this, pts, &offset] (uint8_t* dst, int32_t capacity) {
+                        int32_t len = (int32_t)audio_decode_worker_->read(dst, capacity);
+                        processAudioOutput(dst, len, audioPtsAt(pts, offset));
+                        offset += len;
+                        return len;
+                    },
+                    &error);
+            if (written_len <= 0)
+                return NDL_ESP_RESULT_FEED_FULL;
+            audio_sw_flags_ &= ~OMX_BUFFERFLAG_STARTTIME;
+            // the codec took what was read, the rest of the packet waits for the retry of the feeder
+            if (error != OMX_ErrorNone) {
+                NDLLOG(LOGTAG, NDL_LOGE, "%s, empty buffer error 0x%x", __func__, error);
+                if (!chunk.last || written_len < chunk.size)
+                    return NDL_ESP_RESULT_FEED_FULL;
+            }
+        } else {
+            // packet without samples : only end of stream goes to the codec
+            if (chunk.packet_flags & NDL_ESP_FLAG_END_OF_STREAM)
+                audio_codec_->writeToFreeBuffer(port_index, nullptr, 0, chunk.pts, audio_sw_flags_);
+            audio_decode_worker_->pop();
+        }
+
+        if (chunk.last) {
+            audio_sw_flags_set_ = false;
+            return NDL_ESP_RESULT_SUCCESS;
+        }
+    }
+    NDLLOG(LOGTAG, LOG_FEEDINGV, "%s, audio not decoded yet", __func__);
+    return NDL_ESP_RESULT_FEED_FULL;
+}
+
+/**
+ * Selected alternate track, secondary audio mix, then volume and mute of the S16 pcm just written into an omx buffer.
+ * Applied at the feed, the decode lookahead does not delay a volume change.
+ * pts(us) of the first sample, < 0 without pts (audio only) : secondary audio mixed in feeding order
+ */
+void Esplayer::processAudioOutput(uint8_t* pcm, int32_t size, int64_t pts)
+{
+    int channels = meta_.channels > 0 ? (int)meta_.channels : 2;
+    int frames = size / (channels * (int)sizeof(int16_t));
+    audio_tracks_.process((int16_t*)pcm, frames, channels, meta_.samplerate, pts);
+    secondary_audio_.mix((int16_t*)pcm, frames, pts);
+    audio_gain_.process((int16_t*)pcm, frames, channels, meta_.samplerate);
+}
+
+/**
+ * pts(us) of the sample offset bytes after the one at pts, -1 without pts (audio only)
+ */
+int64_t Esplayer::audioPtsAt(int64_t pts, int32_t offset) const
+{
+    if (!enable_video_)
+        return -1;
+    int frame_size = (meta_.channels > 0 ? (int)meta_.channels : 2) * (int)sizeof(int16_t);
+    return pts + (int64_t)(offset / frame_size) * 1000000 / (meta_.samplerate > 0 ? meta_.samplerate : 44100);
+}
+
 int Esplayer::Feed_VideoData(void)
 {
     int written_len = 0;
@@ -1226,19 +1682,67 @@ int Esplayer::Feed_VideoData(void)
         return NDL_ESP_RESULT_FEED_FULL;//buffer full
     }
 
-    int64_t pts = adjustPtsToMicrosecond(/*PORT_CLOCK_VIDEO*/ buff->stream_type, buff->timestamp);
+    // rest of the converted frame the codec buffers did not take at the previous try
+    if (video_annexb_left_ > 0)
+        return writeAnnexBVideo();
+
+    // an access unit split without pts continues from the previous one
+    const bool has_pts = buff->timestamp != ES_NO_PTS;
+    int64_t pts = has_pts ? adjustPtsToMicrosecond(/*PORT_CLOCK_VIDEO*/ buff->stream_type, buff->timestamp)
+        : av_sync_.lastFedPts(NDL_ESP_VIDEO_ES);
     int remaining_buffer_size = buff->data_len;
     uint8_t* data = nullptr;
     int32_t data_len = 0;
     int32_t running_offset = 0;
     uint32_t buffer_flags = 0;
+    AvSyncController::Decision sync = {false, false, 0, 0, 0};
 
-    if( buff->data_len > 0 )
-        buffer_flags = setOmxFlags(pts, translateToOmxFlags(buff->flags), buff->stream_type);
-    else
-        buffer_flags = translateToOmxFlags(buff->flags);
+    if (trick_retimer_.getRate() != 0 && buff->data_len > 0) {
+        // I-frame trick play : only the key frames reach the decoder, at the pts of the rate
+        if (!has_pts || getVideoFrameType(buff) != FRAME_TYPE_KEY || !trick_retimer_.retime(&pts)) {
+            popBufQueue(stream_type);
+            return written_len;
+        }
+    }
+
+    if( buff->data_len > 0 ) {
+        // the sync decision on the frame (and the feed hold), its flags are made below
+        setOmxFlags(pts, 0, buff->stream_type, &sync);
+        // ahead of the audio : held back by the delay
+        pts += sync.delay;
+    }
 
-    if (remaining_buffer_size > 0) {
+    // behind the audio : the frames nothing refers to are not decoded at all
+    const videoFrameType frame_type = sync.drop ? getVideoFrameType(buff) : FRAME_TYPE_UNKNOWN;
+    if (sync.drop && frame_type == FRAME_TYPE_NON_REFERENCE) {
+        video_drop_stats_.dropped_non_reference++;
+        NDLLOG(LOGTAG, LOG_FEEDINGV, "%s, drop non-reference frame pts:%lld", __func__, pts);
+        popBufQueue(stream_type);
+        return written_len;
+    }
+
+    buffer_flags = getVideoBufferFlags(buff, sync, frame_type);
+    if (buffer_flags & OMX_BUFFERFLAG_DECODEONLY) {
+        if (frame_type == FRAME_TYPE_KEY)
+            video_drop_stats_.decode_only_key++;
+        else if (frame_type == FRAME_TYPE_REFERENCE)
+            video_drop_stats_.decode_only_reference++;
+        else
+            video_drop_stats_.decode_only_unknown++;
+    }
+
+    if (remaining_buffer_size > 0 && annexb_converter_) {
+        // start codes written in place of the length prefixes, straight into the codec buffers
+        int32_t converted = annexb_converter_->begin(buff->data, buff->data_len);
+        if (converted < 0) {
+            NDLLOG(LOGTAG, NDL_LOGE, "%s, NAL lengths do not match the frame size:%d, dropped", __func__, buff->data_len);
+        } else {
+            video_annexb_left_ = converted;
+            video_annexb_pts_ = pts;
+            video_annexb_flags_ = buffer_flags | OMX_BUFFERFLAG_ENDOFFRAME;
+            return writeAnnexBVideo();
+        }
+    } else if (remaining_buffer_size > 0) {
         do {
             //sometime input chunk size is larger than codec input buffer size
             remaining_buffer_size -= video_codec_->getInputBufferSize();
@@ -1319,7 +1823,66 @@ int Esplayer::feedData(NDL_EsplayerBuffer buff)
         std::lock_guard<std::mutex> lock(unload_mutex_);
 
     NDL_ESP_STREAM_T stream_type = buff->stream_type;
-    pushBufQueue(buff);
+    if (stream_type == NDL_ESP_VIDEO_ES && (buff->flags & NDL_ESP_FLAG_KEY_FRAME))
+        video_key_flags_ = true;
+    if (trick_rate_ != 0 && stream_type != NDL_ESP_VIDEO_ES)
+        return buff->data_len;  // no audio in I-frame trick play
+    if (stream_type == NDL_ESP_AUDIO_SECONDARY_ES)
+        return feedSecondaryAudio(buff);
+    if (stream_type == NDL_ESP_AUDIO_ES && audio_parser_)
+        return feedAudioByteStream(buff);
+    if (stream_type == NDL_ESP_VIDEO_ES && video_parser_)
+        return feedVideoByteStream(buff);
+
+    queueStreamBuffer(buff);
+
+    //GETTIME(&endTime, NULL);
+    //TIME_DIFF(startTime, endTime, elapse);
+
+    //NDLLOG(LOGTAG, LOG_INOUT, "%s(type:%d)(elapsed:%dms) -", __FUNCTION__, buff->stream_type, elapse/1000);
+    NDLLOG(LOGTAG, LOG_INOUT, "%s(type:%d) -", __func__, buff->stream_type);
+    return buff->data_len;
+}
+
+/**
+ * Write the rest of the frame begun in annexb_converter_ into free input buffers of the video codec.
+ * return FEED_FULL with the frame kept queued until the codec buffers take all of it
+ */
+int Esplayer::writeAnnexBVideo()
+{
+    int error = OMX_ErrorNone;
+    int written_len = video_codec_->writeToFreeBuffer(video_codec_->getInputPortIndex(),
+            video_annexb_left_,
+            video_annexb_pts_,
+            video_annexb_flags_,
+            [this] (uint8_t* dst, int32_t capacity) { return annexb_converter_->write(dst, capacity); },
+            &error);
+    if (written_len > 0) {
+        video_annexb_left_ -= written_len;
+        video_annexb_flags_ &= ~OMX_BUFFERFLAG_STARTTIME;
+    }
+
+    if (video_annexb_left_ > 0) {
+        NDLLOG(LOGTAG, error != OMX_ErrorNone ? NDL_LOGE : LOG_FEEDINGV, "%s, %d bytes left (error 0x%x)",
+                __func__, video_annexb_left_, error);
+        return NDL_ESP_RESULT_FEED_FULL;
+    }
+    popBufQueue(NDL_ESP_VIDEO_ES);
+    return written_len;
+}
+
+/**
+ * Queue one frame for the feeder of its stream
+ */
+void Esplayer::queueStreamBuffer(NDL_EsplayerBuffer buff)
+{
+    NDL_ESP_STREAM_T stream_type = buff->stream_type;
+    if (stream_type == NDL_ESP_AUDIO_ES && audio_decode_worker_) {
+        // decoded ahead on the worker, Feed_AudioData takes the pcm in the same order
+        audio_decode_worker_->push(buff, audioFeedPts(buff.get()));
+    } else {
+        pushBufQueue(buff);
+    }
 
     switch (stream_type)
     {
@@ -1345,14 +1908,152 @@ int Esplayer::feedData(NDL_EsplayerBuffer buff)
             NDLLOG(LOGTAG, NDL_LOGE, "%s, cannot be here!!!", __func__);
             break;
     }
-    //GETTIME(&endTime, NULL);
-    //TIME_DIFF(startTime, endTime, elapse);
+}
 
-    //NDLLOG(LOGTAG, LOG_INOUT, "%s(type:%d)(elapsed:%dms) -", __FUNCTION__, buff->stream_type, elapse/1000);
-    NDLLOG(LOGTAG, LOG_INOUT, "%s(type:%d) -", __func__, buff->stream_type);
+/**
+ * Split a chunk of the audio byte stream into frames, each one queued as if it was fed alone.
+ * The frames complete in the chunk are not copied, only the ones stitched across chunks are.
+ * As in PES, the pts of the chunk goes to the first frame starting in it,
+ * the others have none and the decoder continues the pts from the previous frame.
+ */
+int Esplayer::feedAudioByteStream(NDL_EsplayerBuffer buff)
+{
+    const uint8_t* data = buff->data + buff->offset;
+    int remained = buff->data_len - buff->offset;
+    bool chunk_pts_used = false;
+    auto takeChunkPts = [&] {
+        int64_t pts = chunk_pts_used ? ES_NO_PTS : buff->timestamp;
+        chunk_pts_used = true;
+        return pts;
+    };
+
+    while (remained > 0) {
+        const uint8_t* begin = data;
+        const int available = remained;
+        const bool had_partial = audio_parser_->hasPartialFrame();
+        int parsed = audio_parser_->parse(data, remained,
+                [&] (const unsigned char* frame, unsigned int size) {
+                    // completed from the bytes kept by the parser : started in an earlier chunk
+                    bool in_chunk = frame >= begin && frame < begin + available;
+                    NDL_EsplayerBuffer frame_buff;
+                    if (in_chunk) {
+                        // a view into the chunk, which is kept until the frame is decoded
+                        frame_buff.reset(new NDL_ESP_STREAM_BUFFER(),
+                                [buff] (NDL_ESP_STREAM_BUFFER* b) { delete b; });
+                        frame_buff->data = const_cast<uint8_t*>(frame);
+                    } else {
+                        // the kept bytes of the parser are reused for the next frame
+                        frame_buff.reset(new NDL_ESP_STREAM_BUFFER(),
+                                [] (NDL_ESP_STREAM_BUFFER* b) { delete [] b->data; delete b; });
+                        frame_buff->data = new uint8_t[size];
+                        memcpy(frame_buff->data, frame, size);
+                    }
+                    frame_buff->data_len = size;
+                    frame_buff->offset = 0;
+                    frame_buff->stream_type = NDL_ESP_AUDIO_ES;
+                    frame_buff->timestamp = in_chunk ? takeChunkPts() : audio_parser_pts_;
+                    if (!in_chunk)
+                        audio_parser_pts_ = ES_NO_PTS;   // for the rest kept after it
+                    frame_buff->flags = 0;
+                    queueStreamBuffer(frame_buff);
+                    return (int)size;
+                });
+        if (parsed < 0)
+            break;
+        if (!had_partial && audio_parser_->hasPartialFrame())
+            audio_parser_pts_ = takeChunkPts();
+        data += parsed;
+        remained -= parsed;
+    }
+
+    if (buff->flags & NDL_ESP_FLAG_END_OF_STREAM) {
+        // a frame cut by the end of stream is not decodable
+        audio_parser_->clear();
+        NDL_EsplayerBuffer eos = std::make_shared<NDL_ESP_STREAM_BUFFER>();
+        eos->data = nullptr;
+        eos->data_len = 0;
+        eos->offset = 0;
+        eos->stream_type = NDL_ESP_AUDIO_ES;
+        eos->timestamp = buff->timestamp;
+        eos->flags = buff->flags;
+        queueStreamBuffer(eos);
+    }
+    return buff->data_len;
+}
+
+/**
+ * Split a chunk of the video byte stream into access units, each one queued as if it was fed alone
+ * with its frame type in the flags. As in PES, the pts of the chunk goes to the first access unit
+ * starting in it, the others have none.
+ */
+int Esplayer::feedVideoByteStream(NDL_EsplayerBuffer buff)
+{
+    bool chunk_pts_used = false;
+    auto takeChunkPts = [&] {
+        int64_t pts = chunk_pts_used ? ES_NO_PTS : buff->timestamp;
+        chunk_pts_used = true;
+        return pts;
+    };
+
+    const uint8_t* chunk = buff->data + buff->offset;
+    const int chunk_len = buff->data_len - buff->offset;
+    video_parser_->push(chunk, chunk_len);
+    if (buff->flags & NDL_ESP_FLAG_END_OF_STREAM)
+        video_parser_->end();
+
+    videoparser::AccessUnit au;
+    while (video_parser_->next(&au)) {
+        NDL_EsplayerBuffer au_buff;
+        if (au.data >= chunk && au.data < chunk + chunk_len) {
+            // a view into the chunk, which is kept until the access unit is fed
+            au_buff.reset(new NDL_ESP_STREAM_BUFFER(),
+                    [buff] (NDL_ESP_STREAM_BUFFER* b) { delete b; });
+            au_buff->data = const_cast<uint8_t*>(au.data);
+        } else {
+            // stitched in the buffer of the parser, reused with the next access unit
+            au_buff.reset(new NDL_ESP_STREAM_BUFFER(),
+                    [] (NDL_ESP_STREAM_BUFFER* b) { delete [] b->data; delete b; });
+            au_buff->data = new uint8_t[au.size];
+            memcpy(au_buff->data, au.data, au.size);
+        }
+        au_buff->data_len = au.size;
+        au_buff->offset = 0;
+        au_buff->stream_type = NDL_ESP_VIDEO_ES;
+        au_buff->timestamp = au.in_chunk ? takeChunkPts() : video_parser_pts_;
+        if (!au.in_chunk)
+            video_parser_pts_ = ES_NO_PTS;
+        au_buff->flags = au.flags;
+        queueStreamBuffer(au_buff);
+    }
+    if (video_parser_->startedInChunk())
+        video_parser_pts_ = takeChunkPts();
+
+    if (buff->flags & NDL_ESP_FLAG_END_OF_STREAM) {
+        video_parser_->clear();
+        NDL_EsplayerBuffer eos = std::make_shared<NDL_ESP_STREAM_BUFFER>();
+        eos->data = nullptr;
+        eos->data_len = 0;
+        eos->offset = 0;
+        eos->stream_type = NDL_ESP_VIDEO_ES;
+        eos->timestamp = buff->timestamp;
+        eos->flags = buff->flags;
+        queueStreamBuffer(eos);
+    }
     return buff->data_len;
 }
 
+/**
+ * pts(us) of an audio buffer at the feed, 0 without video, -1 for the frames split without pts
+ */
+int64_t Esplayer::audioFeedPts(const NDL_ESP_STREAM_BUFFER* buff)
+{
+    if (!enable_video_)
+        return 0;
+    if (buff->timestamp == ES_NO_PTS)
+        return -1;
+    return adjustPtsToMicrosecond(buff->stream_type, buff->timestamp);
+}
+
 int Esplayer::play()
 {
     NDLASSERT(state_.canTransit(NDL_ESP_STATUS_PLAYING));
@@ -1362,10 +2063,10 @@ int Esplayer::play()
         return NDL_ESP_RESULT_FAIL;
     }
     int result = NDL_ESP_RESULT_SUCCESS;
-    sync_state_ = ALLOW_VIDEO;
+    av_sync_.allowVideo();
 
     if (state_.get() != NDL_ESP_STATUS_PAUSED)
-        audio_last_pts_ = 0;
+        av_sync_.restartAudio();
 
     do {
         if (state_.get() != NDL_ESP_STATUS_PLAYING)
@@ -1374,6 +2075,9 @@ int Esplayer::play()
         if (state_.get() == NDL_ESP_STATUS_LOADED) {
             result = NDL_ESP_RESULT_CLOCK_ERROR;
             BREAK_IF_NONZERO(clock_->setPlaybackRate(target_playback_rate_), "setting playback rate");
+            media_clock_.setRate(trick_rate_ != 0 ? trick_rate_.load() : target_playback_rate_);
+            av_sync_.setRate(target_playback_rate_);
+            audio_drift_.setRate(target_playback_rate_);
 
             result = NDL_ESP_RESULT_SET_STATE_ERROR;
             LOG_IF_NONZERO(video_codec_&&video_codec_->setState(OMX_StateExecuting, MAX_STATE_WAIT_TIME),
@@ -1390,6 +2094,9 @@ int Esplayer::play()
         else if (state_.get() == NDL_ESP_STATUS_PAUSED) {
             result = NDL_ESP_RESULT_CLOCK_ERROR;
             BREAK_IF_NONZERO(clock_->setPlaybackRate(target_playback_rate_), "setting playback rate");
+            media_clock_.setRate(trick_rate_ != 0 ? trick_rate_.load() : target_playback_rate_);
+            av_sync_.setRate(target_playback_rate_);
+            audio_drift_.setRate(target_playback_rate_);
 
             result = NDL_ESP_RESULT_SET_STATE_ERROR;
             BREAK_IF_NONZERO(changeComponentsState(OMX_StateExecuting, MAX_STATE_WAIT_TIME),
@@ -1439,6 +2146,9 @@ int Esplayer::pause()
     int result = NDL_ESP_RESULT_CLOCK_ERROR;
     do {
         BREAK_IF_NONZERO(clock_->setPlaybackRate(0), "setting clock paused");
+        media_clock_.setRate(0);
+        av_sync_.setRate(0);
+        audio_drift_.setRate(0);
 
         result = NDL_ESP_RESULT_SET_STATE_ERROR;
 
@@ -1514,7 +2224,7 @@ int Esplayer::stepFrameNonTunnelMode()
     return ret;
 }
 
-int Esplayer::flush()
+int Esplayer::flush(NDL_ESP_FLUSH_MODE mode)
 {
     NDLASSERT(state_.canTransit(NDL_ESP_STATUS_FLUSHING));
     NDLLOG(SDETTAG, LOG_INOUT, "%s (state : %d) +", __func__, state_.get());
@@ -1542,10 +2252,20 @@ int Esplayer::flush()
 
     std::lock_guard<std::mutex> lock(unload_mutex_);
 
+    flush_requested_time_ = current_time_ns();
+    const bool fast_flush = (mode == NDL_ESP_FLUSH_FAST);
+#if SUPPORT_FLUSH_IN_EXECUTING
+    // clock is stopped and feeding is blocked by flushing state,
+    //   so components can be flushed in executing state
+    const bool skip_pause = fast_flush;
+#else
+    const bool skip_pause = false;
+#endif
+
     trick_mode_enabled_ = false;
 
-    audio_last_pts_ = 0;
-    video_last_pts_ = 0;
+    av_sync_.reset();
+    audio_drift_.reset();
 
     if (audio_renderer_) audio_eos_ = false;
     if (video_renderer_) video_eos_ = false;
@@ -1564,13 +2284,28 @@ int Esplayer::flush()
         }
 
         clearFrameQueues();
+        // after the messages cleared, before the frames fed after the flush
+        postTrickTiming(true);
 
         clearBufQueue(NDL_ESP_AUDIO_ES);
         clearBufQueue(NDL_ESP_VIDEO_ES);
+        if (audio_decode_worker_)
+            audio_decode_worker_->flush();
+        else if (audio_sw_decoder_)
+            audio_sw_decoder_->DiscardOutput();
+        secondary_audio_.flush();
+        audio_tracks_.flush();
+        if (audio_parser_)
+            audio_parser_->clear();
+        if (video_parser_)
+            video_parser_->clear();
+        // after the frame the feeders may be writing now
+        postFeedReset(NDL_ESP_VIDEO_ES);
+        postFeedReset(NDL_ESP_AUDIO_ES);
 
         //TODO need to consider the other platforms
         // set all the components state > paused
-        if (save_state != NDL_ESP_STATUS_PAUSED)
+        if (save_state != NDL_ESP_STATUS_PAUSED && !skip_pause)
         {
             result = NDL_ESP_RESULT_SET_STATE_ERROR;
             RETURN_IF_NONZERO(changeComponentsState(OMX_StatePause, MAX_STATE_WAIT_TIME), "set state to pause");
@@ -1578,14 +2313,18 @@ int Esplayer::flush()
 
         // flush all the components
         result = NDL_ESP_RESULT_FAIL;
-        RETURN_IF_NONZERO(setComponentsFlush(MAX_FLUSH_WAIT_TIME), "flush components and wait done");
+        if (fast_flush) {
+            RETURN_IF_NONZERO(setComponentsFlushParallel(MAX_FLUSH_WAIT_TIME), "flush components in parallel and wait done");
+        } else {
+            RETURN_IF_NONZERO(setComponentsFlush(MAX_FLUSH_WAIT_TIME), "flush components and wait done");
+        }
 
         // set clock state waitingForStartTime (for lip sync)
         if (clock_)
         {
             result = NDL_ESP_RESULT_CLOCK_ERROR;
                 int port_mask = 0;
-                if( enable_audio_ )
+                if( enable_audio_ && trick_rate_ == 0 )
                     port_mask = 1;
                 if( enable_video_ )
                     port_mask |= 2;
@@ -1595,13 +2334,13 @@ int Esplayer::flush()
         }
 
         // clear pts wraparound info
-        for (auto& i : pts_base_)
-            i = 0;
-        for (auto& i : pts_previous_)
-            i = -1;
+        for (auto& timeline : pts_timeline_)
+            timeline.reset();
+        media_clock_.reset();
+        clock_sampler_.reset();
 
         //TODO need to consider the other platforms
-        if (save_state == NDL_ESP_STATUS_PLAYING)
+        if (save_state == NDL_ESP_STATUS_PLAYING && !skip_pause)
         {
             // set all the components state > executing (SIC)
             result = NDL_ESP_RESULT_SET_STATE_ERROR;
@@ -1634,28 +2373,116 @@ int Esplayer::getBufferLevel(NDL_ESP_STREAM_T type, uint32_t* level)
     return NDL_ESP_RESULT_FAIL;
 }
 
+int Esplayer::getOmxStats(char* buf, size_t buf_len) const
+{
+    if (buf == NULL || buf_len == 0 || !OmxStats::isEnabled())
+        return NDL_ESP_RESULT_FAIL;
+
+    const OmxClient* clients[] = {
+        clock_ ? clock_->getOmxClient() : nullptr,
+        video_codec_.get(), video_scheduler_.get(), video_renderer_.get(),
+        audio_codec_.get(), audio_mixer_.get(), audio_renderer_.get(),
+    };
+
+    std::string stats;
+    for (auto client : clients) {
+        if (!client)
+            continue;
+        if (!stats.empty())
+            stats += '\n';
+        stats += client->getStats().summary();
+    }
+
+    size_t copylength = stats.copy(buf, buf_len - 1);
+    buf[copylength] = '\0';
+    return NDL_ESP_RESULT_SUCCESS;
+}
+
 int Esplayer::setPlaybackRate(int rate)
 {
     //TODO consider -> without clock component
     NDLLOG(SDETTAG, NDL_LOGI, "set playback rate >> %d", rate);
 
-    // supports speed 0x~2x
-    if (rate<0 || rate>2000)
+    // supports speed 0x~2x by the clock, I-frame trick play beyond it and backward
+    if (rate < -VIDEO_TRICK_MAX_RATE || rate > VIDEO_TRICK_MAX_RATE)
     {
         NDLLOG(LOGTAG, NDL_LOGE, "playbak rate is too small or large.. (%d)", rate);
         return NDL_ESP_RESULT_FAIL;
     }
 
+    if (rate < 0 || rate > 2 * Clock::NORMAL_PLAYBACK_RATE) {
+        if (!enable_video_) {
+            NDLLOG(LOGTAG, NDL_LOGE, "no video for I-frame trick play (%d)", rate);
+            return NDL_ESP_RESULT_FAIL;
+        }
+        // every frame would be dropped as not known to be a key frame
+        if (!hasVideoFrameTypes()) {
+            NDLLOG(LOGTAG, NDL_LOGE, "no key frame found nor tagged by the client for I-frame trick play (%d)", rate);
+            return NDL_ESP_RESULT_FAIL;
+        }
+        if (trick_rate_ == 0)
+            NDLLOG(LOGTAG, NDL_LOGI, "I-frame trick play at %d, audio off", rate);
+        // key frames retimed for the rate, presented by the scheduler on the clock at 1x
+        trick_rate_ = rate;
+        postTrickTiming(false);
+        rate = Clock::NORMAL_PLAYBACK_RATE;
+    } else if (trick_rate_ != 0) {
+        NDLLOG(LOGTAG, NDL_LOGI, "I-frame trick play end");
+        trick_rate_ = 0;
+        postTrickTiming(false);
+    }
+
     target_playback_rate_ = rate;
 
     // set clock scale only if player state is playing or loaded
     if (clock_ && (state_.get() == NDL_ESP_STATUS_PLAYING ||
-                state_.get() == NDL_ESP_STATUS_LOADED))
+                state_.get() == NDL_ESP_STATUS_LOADED)) {
         clock_->setPlaybackRate(target_playback_rate_);
+        // the retimed key frames do not give the media time, it runs at the trick rate
+        media_clock_.setRate(trick_rate_ != 0 ? trick_rate_.load() : target_playback_rate_);
+        av_sync_.setRate(target_playback_rate_);
+        audio_drift_.setRate(target_playback_rate_);
+    }
 
     return NDL_ESP_RESULT_SUCCESS;
 }
 
+/**
+ * Flush of the frame the feeder of stream_type keeps partially written, on its looper :
+ * a handler running during the flush goes on with the state it began with
+ */
+void Esplayer::postFeedReset(NDL_ESP_STREAM_T stream_type)
+{
+    if (stream_type == NDL_ESP_VIDEO_ES) {
+        video_renderer_looper_.append(std::make_shared<Message>([this] {
+                    if (annexb_converter_)
+                        annexb_converter_->reset();
+                    video_annexb_left_ = 0;
+                    return NDL_ESP_RESULT_SUCCESS;
+                    }));
+    } else if (stream_type == NDL_ESP_AUDIO_ES) {
+        audio_renderer_looper_.append(std::make_shared<Message>([this] {
+                    audio_raw_offset_ = -1;
+                    audio_sw_flags_set_ = false;
+                    return NDL_ESP_RESULT_SUCCESS;
+                    }));
+    }
+}
+
+/**
+ * Trick play rate (and flush) for the video feeder : the frames queued before are retimed as before
+ */
+void Esplayer::postTrickTiming(bool reset)
+{
+    const int rate = trick_rate_;
+    video_renderer_looper_.append(std::make_shared<Message>([this, rate, reset] {
+                trick_retimer_.setRate(rate);
+                if (reset)
+                    trick_retimer_.reset();
+                return NDL_ESP_RESULT_SUCCESS;
+                }));
+}
+
 int Esplayer::setTrickMode(bool enable)
 {
     NDLLOG(SDETTAG, LOG_INOUT, "%s(%d) +", __func__, enable);
@@ -1684,17 +2511,253 @@ int Esplayer::setVolume(int volume, int duration, NDL_ESP_EASE_TYPE type)
         NDLLOG(LOGTAG, NDL_LOGE, "volume is too small or large.. (%d)", volume);
         return NDL_ESP_RESULT_FAIL;
     }
+    audio_gain_.setVolume(volume, duration, type);
     return NDL_ESP_RESULT_SUCCESS;
 }
 
-int Esplayer::getMediaTime(int64_t* start_time, int64_t* current_time)
+/**
+ * Decoder of the secondary audio ES, its output has the layout and rate of the main audio output
+ */
+int Esplayer::loadSecondaryAudio(NDL_ESP_META_DATA* meta)
 {
-    if (clock_) {
-        return clock_->getMediaTime(start_time, current_time);
+    NDLLOG(LOGTAG, NDL_LOGI, "%s: audio_codec:%d", __func__, meta ? meta->audio_codec : -1);
+
+    if (!meta || !loaded_ || !enable_audio_) {
+        NDLLOG(LOGTAG, NDL_LOGE, "%s: main audio is not loaded", __func__);
+        return NDL_ESP_RESULT_FAIL;
     }
+    if (meta->audio_codec == NDL_ESP_AUDIO_NONE) {
+        secondary_audio_.close();
+        return NDL_ESP_RESULT_SUCCESS;
+    }
+
+    std::shared_ptr<AudioSwDecoder> decoder;
+    int result = openAudioDecoder(meta, &decoder);
+    if (result != NDL_ESP_RESULT_SUCCESS)
+        return result;
+
+    secondary_audio_.open(decoder, meta_.channels > 0 ? (int)meta_.channels : 2, meta_.samplerate);
+    return NDL_ESP_RESULT_SUCCESS;
+}
+
+/**
+ * Sw decoder of an audio ES beside the main one (secondary or alternate track)
+ */
+int Esplayer::openAudioDecoder(const NDL_ESP_META_DATA* meta, std::shared_ptr<AudioSwDecoder>* decoder)
+{
+    uint32_t samplerate = meta->samplerate;
+    enum AVCodecID codec_id = audioCodecId(meta->audio_codec, &samplerate);
+    const bool lpcm = meta->audio_codec == NDL_ESP_AUDIO_CODEC_LPCM;
+    AudioLpcmFormat lpcm_format;
+    if (lpcm ? !getLpcmFormat(meta, meta_format_, &lpcm_format) : codec_id == AV_CODEC_ID_NONE)
+        return NDL_ESP_RESULT_AUDIO_UNSUPPORTED;
+
+    *decoder = std::make_shared<AudioSwDecoder>();
+    (*decoder)->audio_stream_info_.codec_id              = codec_id;
+    (*decoder)->audio_stream_info_.channels              = meta->channels > 0 ? (int)meta->channels : 2;
+    (*decoder)->audio_stream_info_.sample_rate           = samplerate;
+    (*decoder)->audio_stream_info_.bit_rate              = (int64_t)meta->bitrate;
+    (*decoder)->audio_stream_info_.block_align           = meta->blockalign;
+    (*decoder)->audio_stream_info_.bits_per_coded_sample = 16;
+    if (lpcm ? !(*decoder)->OpenLpcm(lpcm_format) : !(*decoder)->OpenAudio(codec_id)) {
+        NDLLOG(LOGTAG, NDL_LOGE, "%s: decoder open error, codec_id:0x%x", __func__, codec_id);
+        decoder->reset();
+        return NDL_ESP_RESULT_AUDIO_CODEC_ERROR;
+    }
+    return NDL_ESP_RESULT_SUCCESS;
+}
+
+int Esplayer::addAudioTrack(NDL_ESP_META_DATA* meta)
+{
+    NDLLOG(LOGTAG, NDL_LOGI, "%s: audio_codec:%d", __func__, meta ? meta->audio_codec : -1);
+
+    // tracks are spliced at the pts of the main audio
+    if (!meta || !loaded_ || !enable_audio_ || !enable_video_) {
+        NDLLOG(LOGTAG, NDL_LOGE, "%s: needs the main audio of a stream with video", __func__);
+        return NDL_ESP_RESULT_FAIL;
+    }
+
+    std::shared_ptr<AudioSwDecoder> decoder;
+    int result = openAudioDecoder(meta, &decoder);
+    if (result != NDL_ESP_RESULT_SUCCESS)
+        return result;
+    return audio_tracks_.add(decoder, meta_.channels > 0 ? (int)meta_.channels : 2, meta_.samplerate);
+}
+
+int Esplayer::removeAudioTrack(int track)
+{
+    return audio_tracks_.remove(track);
+}
+
+/**
+ * Decoded on the feeding thread like the secondary audio, until the standby window is full
+ */
+int Esplayer::feedAudioTrack(int track, NDL_EsplayerBuffer buff)
+{
+    if (!buff || buff->data_len < buff->offset)
+        return NDL_ESP_RESULT_FEED_INVALID_INPUT;
+    if (!loaded_ || state_.get() == NDL_ESP_STATUS_FLUSHING)
+        return NDL_ESP_RESULT_FEED_INVALID_STATE;
+
+    // a packet without pts continues the previous one of the track
+    int64_t pts = buff->timestamp == ES_NO_PTS ? -1 : adjustTrackPtsToMicrosecond(buff->timestamp);
+    int ret = audio_tracks_.push(track, buff->data + buff->offset, buff->data_len - buff->offset, pts);
+    if (ret == NDL_ESP_RESULT_FEED_FULL || ret == NDL_ESP_RESULT_FEED_INVALID_INPUT)
+        return ret;
+    if (ret < 0) {
+        NDLLOG(LOGTAG, NDL_LOGE, "%s: track %d decode error %d", __func__, track, ret);
+        return NDL_ESP_RESULT_FEED_CODEC_ERROR;
+    }
+    return buff->data_len;
+}
+
+int Esplayer::selectAudioTrack(int track)
+{
+    return audio_tracks_.select(track);
+}
+
+int Esplayer::getAudioTrackStats(char* buf, size_t buf_len)
+{
+    if (buf == NULL || buf_len == 0)
+        return NDL_ESP_RESULT_FAIL;
+
+    std::string stats = audio_tracks_.stats();
+    size_t copylength = stats.copy(buf, buf_len - 1);
+    buf[copylength] = '\0';
+    return NDL_ESP_RESULT_SUCCESS;
+}
+
+int Esplayer::getVideoDropStats(NDL_ESP_VIDEO_DROP_STATS* stats)
+{
+    if (stats == NULL)
+        return NDL_ESP_RESULT_FAIL;
+    *stats = video_drop_stats_;
+    return NDL_ESP_RESULT_SUCCESS;
+}
+
+int Esplayer::getAvSyncStats(NDL_ESP_AV_SYNC_STATS* stats)
+{
+    if (stats == NULL)
+        return NDL_ESP_RESULT_FAIL;
+    av_sync_.getStats(stats);
+    stats->audio_drift_ppm = audio_drift_.getDrift();
+    stats->audio_correction_ppm = audio_drift_.getCorrection();
+    return NDL_ESP_RESULT_SUCCESS;
+}
+
+/**
+ * The EOS buffer gets the flags of the client only
+ */
+uint32_t Esplayer::getVideoBufferFlags(const NDL_ESP_STREAM_BUFFER* buff, const AvSyncController::Decision& sync,
+        videoFrameType frame_type)
+{
+    uint32_t buffer_flags = translateToOmxFlags(buff->flags);
+    if (buff->data_len == 0)
+        return buffer_flags;
+
+    if (sync.start_time)
+        buffer_flags |= OMX_BUFFERFLAG_STARTTIME;
+    // a known frame is still displayed when dropping the non-reference ones did not catch up
+    if (sync.drop && (frame_type == FRAME_TYPE_UNKNOWN || sync.offset < VIDEO_IN_BUFFER_MKSEC_SKIP_REFERENCE))
+        buffer_flags |= OMX_BUFFERFLAG_DECODEONLY;
+#ifdef OMX_BUFFERFLAG_TIME_UNKNOWN
+    if (buff->timestamp == ES_NO_PTS)
+        buffer_flags |= OMX_BUFFERFLAG_TIME_UNKNOWN;
+#endif
+    return buffer_flags;
+}
+
+/**
+ * The key frames are known : found by the splitter or in the NAL headers (H.264/HEVC),
+ * or tagged by the client
+ */
+bool Esplayer::hasVideoFrameTypes() const
+{
+    return video_parser_ || annexb_converter_ || video_frame_types_ || video_key_flags_;
+}
+
+/**
+ * Type of a video frame from the splitter, the NAL headers or the flags set by the client
+ */
+Esplayer::videoFrameType Esplayer::getVideoFrameType(const NDL_ESP_STREAM_BUFFER* buff)
+{
+    uint32_t flags = buff->flags;   // tagged by the splitter of the byte stream or by the client
+    if (!video_parser_) {
+        if (annexb_converter_)
+            flags = annexb_converter_->frameFlags(buff->data, buff->data_len);
+        else if (video_frame_types_)
+            flags = video_frame_types_->frameFlags(buff->data, buff->data_len);
+        else if (!(flags & (NDL_ESP_FLAG_KEY_FRAME | NDL_ESP_FLAG_NON_REFERENCE)))
+            return FRAME_TYPE_UNKNOWN;
+    }
+
+    if (flags & NDL_ESP_FLAG_KEY_FRAME)
+        return FRAME_TYPE_KEY;
+    if (flags & NDL_ESP_FLAG_NON_REFERENCE)
+        return FRAME_TYPE_NON_REFERENCE;
+    return FRAME_TYPE_REFERENCE;
+}
+
+int Esplayer::setSecondaryAudioMix(int volume, int ducking)
+{
+    if (volume < 0 || volume > 100 || ducking < 0 || ducking > 100) {
+        NDLLOG(LOGTAG, NDL_LOGE, "%s: out of range, volume %d, ducking %d", __func__, volume, ducking);
+        return NDL_ESP_RESULT_FAIL;
+    }
+    secondary_audio_.setMix(volume, ducking);
+    return NDL_ESP_RESULT_SUCCESS;
+}
+
+/**
+ * The secondary ES is small (ex. 64kbps audio description), it is decoded here on the feeding thread
+ * and queued until the main audio reaches its pts.
+ */
+int Esplayer::feedSecondaryAudio(NDL_EsplayerBuffer buff)
+{
+    if (!secondary_audio_.isOpen()) {
+        NDLLOG(LOGTAG, NDL_LOGE, "%s: secondary audio is not loaded", __func__);
+        return NDL_ESP_RESULT_FEED_INVALID_INPUT;
+    }
+    // no pts without video, and a packet without pts continues the previous one (the timeline is not touched)
+    int64_t pts = -1;
+    if (enable_video_ && buff->timestamp != ES_NO_PTS)
+        pts = adjustPtsToMicrosecond(NDL_ESP_AUDIO_SECONDARY_ES, buff->timestamp);
+    int ret = secondary_audio_.push(buff->data + buff->offset, buff->data_len - buff->offset, pts);
+    if (ret == NDL_ESP_RESULT_FEED_FULL)
+        return ret;
+    if (ret < 0) {
+        NDLLOG(LOGTAG, NDL_LOGE, "%s: decode error %d", __func__, ret);
+        return NDL_ESP_RESULT_FEED_CODEC_ERROR;
+    }
+    return buff->data_len;
+}
+
+/**
+ * media time interpolated from the render events or the clock samples (no OMX call),
+ * read back from the clock component until the first of them
+ */
+int Esplayer::getMediaTime(int64_t* start_time, int64_t* current_time)
+{
+    if (media_clock_.get(start_time, current_time))
+        return NDL_ESP_RESULT_SUCCESS;
+    if (clock_ && clock_->getMediaTime(start_time, current_time) == 0)
+        return NDL_ESP_RESULT_SUCCESS;
     return NDL_ESP_RESULT_FAIL;
 }
 
+/**
+ * Tunneled pipeline : the renderers give no render events, the media time of the clock
+ * (driven by the audio renderer when there is audio) stands for them
+ */
+void Esplayer::sampleClockMediaTime()
+{
+    if (!clock_ || trick_rate_ != 0 || !clock_sampler_.due(MediaClock::now()))
+        return;
+    int64_t start_time, media_time;
+    if (clock_->getMediaTime(&start_time, &media_time) == 0)
+        clock_sampler_.onMediaTime(media_time, enable_audio_, MediaClock::now());
+}
+
 int Esplayer::reloadAudio(NDL_ESP_META_DATA* meta)
 {
     return NDL_ESP_RESULT_SUCCESS;
@@ -1731,6 +2794,9 @@ int Esplayer::onVideoCodecCallback(int event,
                 NDL_ESP_STREAM_T stream_type = ((int)data1 == video_codec_->getInputPortIndex())? NDL_ESP_VIDEO_ES:NDL_ESP_AUDIO_ES;
                 NDLLOG(LOGTAG, LOG_FEEDINGV, "VIDEO EMPTY BUFFER DONE(port:%u, buf_idx:%u)(u:%d/f:%d)(stream:%d)", data1, data2, used_buf_cnt, free_buf_cnt, stream_type);
                 ++frame_count_;
+#ifndef OMX_NONE_TUNNEL
+                sampleClockMediaTime();
+#endif
                 break;
             }
         case OMX_CLIENT_EVT_FILL_BUFFER_DONE:
@@ -1784,10 +2850,8 @@ int Esplayer::onVideoCodecCallback(int event,
                     is_first_port_setting_change_ = false;
                 }
 
-                if( sync_state_ != ALLOW_VIDEO ){
-                    NDLLOG(LOGTAG, NDL_LOGI, "before notifyClient about port_changed, set threshold_sync_state to ALLOW_VIDEO");
-                    sync_state_ = ALLOW_VIDEO;
-                }
+                NDLLOG(LOGTAG, NDL_LOGI, "before notifyClient about port_changed, allow video feed");
+                av_sync_.allowVideo();
 
                 video_message_looper_.append(std::make_shared<Message>([this]{
                             NDLLOG(LOGTAG, NDL_LOGI, "notifyClient NDL_ESP_VIDEO_PORT_CHANGED");
@@ -1831,6 +2895,7 @@ void Esplayer::onVideoRenderEvent(int64_t timestamp)
         NDLLOG(LOGTAG, NDL_LOGI, "%s, first frame presented", __func__);
 
         waiting_first_frame_presented_ = false;
+        reportSeekLatency();
         rm_->mediaContentReady(true);
         video_message_looper_.post(std::make_shared<Message>([this]{
                     NDLLOG(LOGTAG, NDL_LOGI, "notifyClient NDL_ESP_FIRST_FRAME_PRESENTED");
@@ -1841,6 +2906,10 @@ void Esplayer::onVideoRenderEvent(int64_t timestamp)
         //FIXME : Need to consider timestamp rollover
         NDLLOG(LOGTAG, LOG_FEEDINGV, "video render done >> pts: %lld", timestamp);
     }
+    if (timestamp >= 0 && trick_rate_ == 0) {
+        media_clock_.onRender(MediaClock::SOURCE_VIDEO, timestamp);
+        av_sync_.onRender(NDL_ESP_VIDEO_ES, timestamp);
+    }
 }
 
 int Esplayer::onVideoSchedulerCallback(int event,
@@ -1925,7 +2994,7 @@ int Esplayer::onVideoRendererCallback(int event,
             if ((input_buffer_cnt - free_buffer_cnt) >= VIDEO_IN_BUFFER_COUNT_LOW)
                 break;
 
-            sync_state_ = ALLOW_VIDEO;
+            av_sync_.allowVideo();
             NDLLOG(SDETTAG, NDL_LOGI, "notifyClient NDL_ESP_STREAM_DRAINED from video");
             notifyClient(NDL_ESP_STREAM_DRAINED_VIDEO);
             break;
@@ -1965,6 +3034,9 @@ int Esplayer::onAudioCodecCallback(int event,
             {
                 NDL_ESP_STREAM_T stream_type = ((int)data1 == audio_codec_->getInputPortIndex())? NDL_ESP_AUDIO_ES:NDL_ESP_VIDEO_ES;
                 NDLLOG(LOGTAG, LOG_FEEDINGV, "AUDIO EMPTY BUFFER DONE (port:%u, buf_idx:%u)(stream:%d)", data1, data2, stream_type);
+#ifndef OMX_NONE_TUNNEL
+                sampleClockMediaTime();
+#endif
                 break;
             }
         case OMX_CLIENT_EVT_FILL_BUFFER_DONE:
@@ -2051,10 +3123,16 @@ void Esplayer::onAudioRenderEvent(int64_t timestamp)
 {
     if (enable_audio_ && !enable_video_ && waiting_first_frame_presented_) {
         waiting_first_frame_presented_ = false;
+        reportSeekLatency();
     } else {
         //FIXME : Need to consider timestamp rollover
         NDLLOG(LOGTAG, LOG_FEEDINGV, "audio render done >> %lld", timestamp);
     }
+    if (timestamp >= 0 && trick_rate_ == 0) {
+        media_clock_.onRender(MediaClock::SOURCE_AUDIO, timestamp);
+        av_sync_.onRender(NDL_ESP_AUDIO_ES, timestamp);
+        audio_drift_.onRender(timestamp);
+    }
 }
 
 int Esplayer::onAudioRendererCallback(int event,
@@ -2224,8 +3302,9 @@ int Esplayer::setVideoCustomDisplayWindow(const long src_left, const long src_to
             dst_left, dst_top, dst_width, dst_height, isFullScreen);
 }
 
-// mute controlled by AV block of TV service
+// mute controlled by AV block of TV service, and zero filled pcm of this player
 int Esplayer::muteAudio(bool mute) {
+    audio_gain_.setMute(mute);
     return rm_->muteAudio(mute);
 }
 
@@ -35,6 +35,19 @@
 
 // for audio sw decoder
 #include "audioswdecoder.h"
+#include "audiodecodeworker.h"
+#include "audiogain.h"
+#include "secondaryaudio.h"
+#include "mediaclock.h"
+#include "avsync.h"
+#include "audiodrift.h"
+#include "clocksampler.h"
+#include "ptstimeline.h"
+#include "standbyaudio.h"
+#include "trickretimer.h"
+#include "parser/annexbconverter.h"
+#include "parser/audioparser.h"
+#include "parser/videoparser.h"
 
 //#define VIDEO_THRESHOLD_CONTROL //TODO: under construction
 
@@ -88,15 +101,20 @@ namespace NDL_Esplayer {
 
             int load(NDL_ESP_META_DATA* meta);
             int loadEx(NDL_ESP_META_DATA* meta, NDL_ESP_PTS_UNITS units);
+            int loadWithTimebase(NDL_ESP_META_DATA* meta,
+                    const NDL_ESP_PTS_TIMEBASE* audio, const NDL_ESP_PTS_TIMEBASE* video);
+            int loadWithFormat(NDL_ESP_META_DATA* meta, const NDL_ESP_META_FORMAT* format,
+                    const NDL_ESP_PTS_TIMEBASE* audio, const NDL_ESP_PTS_TIMEBASE* video);
             int unload();
             int getConnectionId(char* buf, size_t buf_len) const;
             const std::string& getConnectionId() const;
             int reloadAudio(NDL_ESP_META_DATA* meta);
 
             int feedData(NDL_EsplayerBuffer buff);
-            int flush();
+            int flush(NDL_ESP_FLUSH_MODE mode = NDL_ESP_FLUSH_NORMAL);
             int getBufferLevel(NDL_ESP_STREAM_T type,
                     uint32_t* level);
+            int getOmxStats(char* buf, size_t buf_len) const;
 
             int play();
             int pause();
@@ -104,6 +122,15 @@ namespace NDL_Esplayer {
             int setPlaybackRate(int rate);
             int setTrickMode(bool enable);
             int setVolume(int volume, int duration = 0, NDL_ESP_EASE_TYPE type = EASE_TYPE_LINEAR);
+            int loadSecondaryAudio(NDL_ESP_META_DATA* meta);
+            int setSecondaryAudioMix(int volume, int ducking);
+            int addAudioTrack(NDL_ESP_META_DATA* meta);
+            int removeAudioTrack(int track);
+            int feedAudioTrack(int track, NDL_EsplayerBuffer buff);
+            int selectAudioTrack(int track);
+            int getAudioTrackStats(char* buf, size_t buf_len);
+            int getVideoDropStats(NDL_ESP_VIDEO_DROP_STATS* stats);
+            int getAvSyncStats(NDL_ESP_AV_SYNC_STATS* stats);
             int getMediaTime(int64_t* start_time, int64_t* current_time);
 
             int notifyForegroundState(const NDL_ESP_APP_STATE appState);
@@ -137,12 +164,15 @@ namespace NDL_Esplayer {
             int waitForComponentsState(OMX_STATETYPE state, int timeout_seconds);
 #endif
             int setComponentsFlush(int timeout_seconds);
+            // issue all port flushes at once and wait with one shared deadline
+            int setComponentsFlushParallel(int timeout_seconds);
 #if 0 //not used
             int waitForComponentsFlush(int timeout_seconds);
 #endif
 
-            void onAudioRenderEvent(int64_t timestamp = 0);
-            void onVideoRenderEvent(int64_t timestamp = 0);
+            // timestamp -1 : render event without the pts of the frame
+            void onAudioRenderEvent(int64_t timestamp = -1);
+            void onVideoRenderEvent(int64_t timestamp = -1);
 
             void onVideoInfoEvent(void* data);
 
@@ -228,21 +258,69 @@ namespace NDL_Esplayer {
             NDL_ESP_STREAM_BUFFER* getBufQueue(const NDL_ESP_STREAM_T& stream_type);
             void clearBufQueue(NDL_ESP_STREAM_T stream_type);
 
-            // to compensate PTS wraparound
-            int64_t pts_base_[2] {0,0}; // increase by max on each wraparound
-            int64_t pts_previous_[2] {-1,-1};
+            // timebase and PTS wraparound compensation, indexed by NDL_ESP_STREAM_T
+            PtsTimeline pts_timeline_[3];
             int64_t adjustPtsToMicrosecond(int index, int64_t pts);
-            uint32_t setOmxFlags(int64_t /*double*/ pts, uint32_t buffer_flags, NDL_ESP_STREAM_T streamType);
-            enum {PTS_DROP_THRESHOLD = 10};
-            int pts_drop_count_[2] {0,0}; // change pts_base_ and pts_previous_
-            //   only if enough number of pts drops are detected
+            // pts of an alternate track with the wraparound state of the main audio
+            int64_t adjustTrackPtsToMicrosecond(int64_t pts);
+            uint32_t setOmxFlags(int64_t /*double*/ pts, uint32_t buffer_flags, NDL_ESP_STREAM_T streamType,
+                    AvSyncController::Decision* decision = nullptr);
 
             void sendVideoDecoderConfig();
             void sendAudioDecoderConfig();
+            uint64_t getAudioChannelLayout();
             WAVEFORMATEXTENSIBLE m_wave_header;
 
             std::shared_ptr<AudioSwDecoder> audio_sw_decoder_ {nullptr};
-
+            // decoded packet waiting for free buffers (spanning several omx buffers)
+            uint32_t audio_sw_flags_ {0};
+            int audio_sw_consumed_ {0};
+            int writeDecodedAudio();
+            // audio_sw_flags_ are set for the front packet of audio_decode_worker_, until its last chunk is written
+            bool audio_sw_flags_set_ {false};
+            // raw pcm frame left in the queue when the codec buffers did not take all of it, -1 if none,
+            //   on the audio feeder only (flush through postFeedReset)
+            int32_t audio_raw_offset_ {-1};
+            int64_t audio_raw_pts_ {0};
+            uint32_t audio_raw_flags_ {0};
+            int writeRawAudio(const NDL_ESP_STREAM_BUFFER* buff);
+            // decodes ahead of Feed_AudioData, null if decoding inline
+            std::shared_ptr<AudioDecodeWorker> audio_decode_worker_ {nullptr};
+            int feedDecodedAudio();
+            // setVolume ramps and mute on the pcm written into the audio codec
+            AudioGain audio_gain_;
+            // NDL_ESP_AUDIO_SECONDARY_ES decoded at the feed, mixed before audio_gain_
+            SecondaryAudio secondary_audio_;
+            int feedSecondaryAudio(NDL_EsplayerBuffer buff);
+            // alternate tracks decoded in standby, the selected one replaces the main pcm
+            StandbyAudioTracks audio_tracks_;
+            int openAudioDecoder(const NDL_ESP_META_DATA* meta, std::shared_ptr<AudioSwDecoder>* decoder);
+            void processAudioOutput(uint8_t* pcm, int32_t size, int64_t pts);
+            int64_t audioPtsAt(int64_t pts, int32_t offset) const;
+
+            // NDL_ESP_AUDIO_BYTESTREAM : frames split from the fed chunks, null if framed by the client
+            std::shared_ptr<parser> audio_parser_ {nullptr};
+            int64_t audio_parser_pts_ {0};  // of the frame kept partially in audio_parser_
+            int feedAudioByteStream(NDL_EsplayerBuffer buff);
+            int64_t audioFeedPts(const NDL_ESP_STREAM_BUFFER* buff);
+
+            // NDL_ESP_VIDEO_BYTESTREAM : access units split from the fed chunks, null if framed by the client
+            std::shared_ptr<videoparser> video_parser_ {nullptr};
+            int64_t video_parser_pts_ {0};  // of the access unit kept partially in video_parser_
+            int feedVideoByteStream(NDL_EsplayerBuffer buff);
+            // avcC/hvcC extradata : the length prefixed frames are written in Annex-B into the codec buffers
+            std::shared_ptr<annexbconverter> annexb_converter_ {nullptr};
+            // bytes of the frame begun in annexb_converter_ not taken by the codec buffers yet,
+            //   on the video feeder only (flush through postFeedReset)
+            int32_t video_annexb_left_ {0};
+            int64_t video_annexb_pts_ {0};
+            uint32_t video_annexb_flags_ {0};
+            int writeAnnexBVideo();
+            void postFeedReset(NDL_ESP_STREAM_T stream_type);
+            // framed Annex-B H.264/HEVC : frame types read from the NAL headers when frames are dropped
+            std::shared_ptr<videoparser> video_frame_types_ {nullptr};
+
+            void queueStreamBuffer(NDL_EsplayerBuffer buff);
             int Feed_AudioData(void);
             int Feed_VideoData(void);
 
@@ -256,19 +334,35 @@ namespace NDL_Esplayer {
 
             const NDL_ESP_VIDEO_INFO_T& getVideoInfo() const { return videoInfo_; }
 
+            enum videoFrameType {
+                FRAME_TYPE_UNKNOWN,
+                FRAME_TYPE_KEY,
+                FRAME_TYPE_REFERENCE,
+                FRAME_TYPE_NON_REFERENCE
+            };
+            /**
+             * OMX flags of a video buffer : the ones of the client, then on a frame STARTTIME and DECODEONLY
+             * of the sync decision on it and TIME_UNKNOWN without pts
+             */
+            static uint32_t getVideoBufferFlags(const NDL_ESP_STREAM_BUFFER* buff,
+                    const AvSyncController::Decision& sync, videoFrameType frame_type);
+
         private:
 
             bool foreground_ = false;
 
-            enum syncState {
-                INVALID = -1,
-                ALLOW_VIDEO = 0,
-                HOLD_VIDEO,
-                SKIP_VIDEO
-            };
+            videoFrameType getVideoFrameType(const NDL_ESP_STREAM_BUFFER* buff);
+            // the client tags the key frames (NDL_ESP_FLAG_KEY_FRAME), since load
+            std::atomic<bool> video_key_flags_ {false};
+            bool hasVideoFrameTypes() const;
+            NDL_ESP_VIDEO_DROP_STATS video_drop_stats_ {};
 
             State state_;
-            syncState sync_state_ {ALLOW_VIDEO};
+            // presented A/V offset and the video drops/delay correcting it (non-tunnel build),
+            //   fed pts fallback and video feed hold
+            AvSyncController av_sync_;
+            // clock drift of the audio renderer, the sw audio stretched by it (NDL_AUDIO_DRIFT_COMPENSATION)
+            AudioDriftEstimator audio_drift_;
             std::string appId_ {nullptr};
             NDL_EsplayerCallback callback_ {nullptr};
             void* userdata_ {nullptr};
@@ -289,13 +383,9 @@ namespace NDL_Esplayer {
                 VIDEO_IN_BUFFER_COUNT_LOW = 10,
                 AUDIO_IN_BUFFER_COUNT_LOW = 10,
 
-                VIDEO_IN_BUFFER_COUNT_HIGH = 30,
-
                 VIDEO_MSG_COUNT_HIGH = 30,
 
-                VIDEO_IN_BUFFER_MKSEC_SKIP = -100000, //100ms
-                VIDEO_IN_BUFFER_MKSEC_LOW = 250000, //250ms
-                VIDEO_IN_BUFFER_MKSEC_HIGH = 1000000 //1000ms
+                VIDEO_IN_BUFFER_MKSEC_SKIP_REFERENCE = -300000 //300ms, dropping non-reference frames did not catch up
             };
 
             std::shared_ptr<Clock> clock_;
@@ -328,27 +418,37 @@ namespace NDL_Esplayer {
             // notify client on the first video render event
             //   if playing audio only, notify on the first audio render event
             bool waiting_first_frame_presented_ {true};
+            // seek latency : flush call to the first frame presented
+            std::atomic<int64_t> flush_requested_time_ {0};
+            void reportSeekLatency();
             bool low_threshold_crossed_audio_ {true};
 
             // renderer should be executed when first port setting change occurs
             bool is_first_port_setting_change_ {true};
 
             int target_playback_rate_ {Clock::NORMAL_PLAYBACK_RATE};
+            // getMediaTime from the render events (non-tunnel) or the media time of the clock (tunneled)
+            MediaClock media_clock_;
+            // tunneled : the media time of the clock as the render events of media_clock_ and audio_drift_
+            ClockSampler clock_sampler_ {&media_clock_, &audio_drift_};
+            void sampleClockMediaTime();
             unsigned int frame_count_ {0};
             bool trick_mode_enabled_ {false};
+            // I-frame trick play (rate above 2x or negative), 0 if off
+            std::atomic<int> trick_rate_ {0};
+            // on the video feeder only, changed by postTrickTiming in order with the fed frames
+            TrickRetimer trick_retimer_;
+            void postTrickTiming(bool reset);
             bool is_video_dropped_ {false};
 
-            int64_t audio_last_pts_ {0};
-            int64_t video_last_pts_ {0};
-
             inline bool isInterlacedVideo() { return videoInfo_.SCANTYPE == SCANTYPE_INTERLACED; }
             int video_lagging_count_ {0};
             int64_t last_video_lag_timestamp_ {0};
 
             NDL_ESP_META_DATA meta_{NDL_ESP_VIDEO_NONE,
                 NDL_ESP_AUDIO_NONE};
-
-            NDL_ESP_PTS_UNITS pts_units_{NDL_ESP_PTS_TICKS};
+            // from NDL_EsplayerLoadWithFormat, defaults (all 0) for the other loads
+            NDL_ESP_META_FORMAT meta_format_ {};
 
             Esplayer(Esplayer const&) = delete;
             void operator=(Esplayer const&) = delete;
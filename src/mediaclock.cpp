@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+
+#include <time.h>
+#include <stdlib.h>
+
+#include "mediaclock.h"
+
+using namespace NDL_Esplayer;
+
+#define MEDIA_CLOCK_NORMAL_RATE 1000
+
+MediaClock::MediaClock()
+    : media_(0), wall_(0), start_(0), rate_(MEDIA_CLOCK_NORMAL_RATE), valid_(false)
+{
+    anchor_.media = 0;
+    anchor_.wall = 0;
+    anchor_.start = 0;
+    anchor_.rate = MEDIA_CLOCK_NORMAL_RATE;
+    anchor_.valid = false;
+}
+
+int64_t MediaClock::now()
+{
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+int64_t MediaClock::interpolate(const Anchor& anchor, int64_t now_ns)
+{
+    return anchor.media + (now_ns - anchor.wall) / 1000 * anchor.rate / MEDIA_CLOCK_NORMAL_RATE;
+}
+
+void MediaClock::setMaster(SOURCE master)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    master_ = master;
+    has_master_ = false;
+}
+
+void MediaClock::onRender(SOURCE source, int64_t timestamp)
+{
+    onRender(source, timestamp, now());
+}
+
+void MediaClock::onRender(SOURCE source, int64_t timestamp, int64_t now_ns)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    if (source == master_)
+        has_master_ = true;
+    else if (has_master_)
+        return;
+
+    if (!anchor_.valid) {
+        anchor_.start = timestamp;
+        anchor_.media = timestamp;
+        anchor_.valid = true;
+    } else {
+        int64_t predicted = interpolate(anchor_, now_ns);
+        int64_t error = timestamp - predicted;
+        // render callbacks come late by a varying delay : follow the timestamps on average
+        anchor_.media = (std::abs(error) < MEDIA_CLOCK_SLEW_MAX_US)
+            ? predicted + error / (1 << MEDIA_CLOCK_SLEW_SHIFT) : timestamp;
+    }
+    anchor_.wall = now_ns;
+    publish();
+}
+
+void MediaClock::setRate(int rate)
+{
+    setRate(rate, now());
+}
+
+void MediaClock::setRate(int rate, int64_t now_ns)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    if (anchor_.rate == rate)
+        return;
+    if (anchor_.valid)
+        anchor_.media = interpolate(anchor_, now_ns);
+    anchor_.wall = now_ns;
+    anchor_.rate = rate;
+    publish();
+}
+
+void MediaClock::reset()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    anchor_.valid = false;
+    has_master_ = false;
+    publish();
+}
+
+/**
+ * seqlock write : readers retry if the sequence is odd or changed while they read
+ */
+void MediaClock::publish()
+{
+    uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+    sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    media_.store(anchor_.media, std::memory_order_relaxed);
+    wall_.store(anchor_.wall, std::memory_order_relaxed);
+    start_.store(anchor_.start, std::memory_order_relaxed);
+    rate_.store(anchor_.rate, std::memory_order_relaxed);
+    valid_.store(anchor_.valid, std::memory_order_relaxed);
+
+    sequence_.store(sequence + 2, std::memory_order_release);
+}
+
+bool MediaClock::get(int64_t* start_time, int64_t* current_time) const
+{
+    return get(start_time, current_time, now());
+}
+
+bool MediaClock::get(int64_t* start_time, int64_t* current_time, int64_t now_ns) const
+{
+    Anchor anchor;
+    uint32_t sequence;
+    do {
+        sequence = sequence_.load(std::memory_order_acquire);
+        anchor.media = media_.load(std::memory_order_relaxed);
+        anchor.wall = wall_.load(std::memory_order_relaxed);
+        anchor.start = start_.load(std::memory_order_relaxed);
+        anchor.rate = rate_.load(std::memory_order_relaxed);
+        anchor.valid = valid_.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((sequence & 1) || sequence != sequence_.load(std::memory_order_relaxed));
+
+    if (!anchor.valid)
+        return false;
+    if (start_time)
+        *start_time = anchor.start;
+    if (current_time)
+        *current_time = interpolate(anchor, now_ns);
+    return true;
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+
+#ifndef NDL_DIRECTMEDIA2_MEDIA_CLOCK_H_
+#define NDL_DIRECTMEDIA2_MEDIA_CLOCK_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+
+// render timestamps closer than this to the interpolated time only slew the clock (render callback jitter),
+//   further ones move it at once (seek, discontinuity, late start)
+#define MEDIA_CLOCK_SLEW_MAX_US     40000
+// part of the error corrected by each render event within MEDIA_CLOCK_SLEW_MAX_US
+#define MEDIA_CLOCK_SLEW_SHIFT      2
+
+namespace NDL_Esplayer {
+
+    /**
+     * Media time interpolated on CLOCK_MONOTONIC between render events : the ones of the renderers
+     * (non-tunnel) or the media time of the clock read back by ClockSampler (tunneled).
+     * The render events and rate changes come from the renderer and API threads under a lock,
+     * get is lock-free (seqlock) to be polled from UI threads.
+     */
+    class MediaClock {
+        public:
+            typedef enum {
+                SOURCE_AUDIO,
+                SOURCE_VIDEO,
+            } SOURCE;
+
+            MediaClock();
+
+            /**
+             * The render events of master drive the clock once it has one, the other source
+             * anchors it only until then (audio late or missing)
+             */
+            void setMaster(SOURCE master);
+
+            /**
+             * timestamp(us) of the frame source presented now
+             */
+            void onRender(SOURCE source, int64_t timestamp);
+            /**
+             * Playback rate in 1/1000 (Clock::NORMAL_PLAYBACK_RATE for 1x, 0 paused, negative backward)
+             * from the media time reached now
+             */
+            void setRate(int rate);
+            /**
+             * No media time until the next render event (flush, unload)
+             */
+            void reset();
+
+            /**
+             * start_time : the first render timestamp after reset, current_time : now, in microseconds
+             * return false before the first render event
+             */
+            bool get(int64_t* start_time, int64_t* current_time) const;
+
+            // at now_ns on CLOCK_MONOTONIC, for tests
+            void onRender(SOURCE source, int64_t timestamp, int64_t now_ns);
+            void setRate(int rate, int64_t now_ns);
+            bool get(int64_t* start_time, int64_t* current_time, int64_t now_ns) const;
+
+            // CLOCK_MONOTONIC in nanoseconds
+            static int64_t now();
+
+        private:
+            struct Anchor {
+                int64_t media;      // microseconds at wall
+                int64_t wall;       // nanoseconds on CLOCK_MONOTONIC
+                int64_t start;
+                int32_t rate;
+                bool valid;
+            };
+
+            static int64_t interpolate(const Anchor& anchor, int64_t now_ns);
+            void publish();
+
+            std::mutex lock_;
+            Anchor anchor_;         // writer copy under lock_
+            SOURCE master_ {SOURCE_AUDIO};
+            bool has_master_ {false};
+
+            // published anchor, odd sequence while being written
+            std::atomic<uint32_t> sequence_ {0};
+            std::atomic<int64_t> media_;
+            std::atomic<int64_t> wall_;
+            std::atomic<int64_t> start_;
+            std::atomic<int32_t> rate_;
+            std::atomic<bool> valid_;
+    };
+
+} //namespace NDL_Esplayer
+
+#endif //NDL_DIRECTMEDIA2_MEDIA_CLOCK_H_
@@ -23,6 +23,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <unistd.h>
+#include <algorithm>
 
 #include <sys/select.h>
 
@@ -190,9 +191,10 @@ void* MessageLooper::loop()
             std::unique_lock<std::mutex> lock(message_queue_lock_);
             NDLLOG(LOGTAG, LOG_MSG_LOCK, "[%10lld] loop locked, queue size = %d", current_time_ns(), message_queue_.size());
 
-            // clearAll can clean all message_queue_ before pop_front
-            if( !message_queue_.empty())
-                message_queue_.pop_front();
+            // clearAll can clean all message_queue_ (and new messages be appended) while handling
+            auto i = std::find(message_queue_.begin(), message_queue_.end(), message);
+            if (i != message_queue_.end())
+                message_queue_.erase(i);
 
             NDLLOG(LOGTAG, LOG_MSG_LOCK, "[%10lld] loop unlock, queue size = %d", current_time_ns(), message_queue_.size());
         } else {
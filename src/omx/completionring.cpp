@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+#include <pthread.h>
+
+#include "completionring.h"
+
+using namespace NDL_Esplayer;
+
+#define LOGTAG "completion"
+#include "debug.h"
+
+CompletionDispatcher& CompletionDispatcher::getInstance()
+{
+    static CompletionDispatcher instance;
+    return instance;
+}
+
+CompletionDispatcher::CompletionDispatcher()
+{
+    sem_init(&wakeup_, 0, 0);
+    thread_ = std::thread([this] { run(); });
+}
+
+CompletionDispatcher::~CompletionDispatcher()
+{
+    quit_ = true;
+    sem_post(&wakeup_);
+    if (thread_.joinable())
+        thread_.join();
+    sem_destroy(&wakeup_);
+}
+
+void CompletionDispatcher::add(const void* owner, DrainFunction drain)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    owners_[owner] = std::make_shared<DrainFunction>(drain);
+}
+
+void CompletionDispatcher::remove(const void* owner)
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    owners_.erase(owner);
+    if (running_owner_ != owner || isDispatcherThread())
+        return;
+    // only the drain of this owner is waited for, not the whole batch
+    uint64_t generation = generation_;
+    drained_.wait(lock, [this, generation] { return finished_generation_ >= generation; });
+}
+
+bool CompletionDispatcher::contains(const void* owner)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    return owners_.count(owner) > 0;
+}
+
+void CompletionDispatcher::run()
+{
+    pthread_setname_np(pthread_self(), "omx_completion");
+    NDLLOG(LOGTAG, NDL_LOGI, "completion dispatcher started");
+
+    while (!quit_) {
+        if (sem_wait(&wakeup_) != 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        // clear before draining : completions pushed from now on wake again
+        pending_.store(false);
+
+        std::vector<const void*> owners;
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            owners.reserve(owners_.size());
+            for (auto& owner : owners_)
+                owners.push_back(owner.first);
+        }
+
+        for (const void* owner : owners) {
+            std::shared_ptr<DrainFunction> drain;
+            {
+                // removed since the copy : not called again
+                std::lock_guard<std::mutex> lock(lock_);
+                auto found = owners_.find(owner);
+                if (found == owners_.end())
+                    continue;
+                drain = found->second;
+                running_owner_ = owner;
+                generation_++;
+            }
+            (*drain)();
+            {
+                std::lock_guard<std::mutex> lock(lock_);
+                running_owner_ = nullptr;
+                finished_generation_ = generation_;
+            }
+            drained_.notify_all();
+        }
+    }
+}
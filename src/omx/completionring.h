@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef NDL_DIRECTMEDIA2_OMX_CLIENTS_COMPLETIONRING_H_
+#define NDL_DIRECTMEDIA2_OMX_CLIENTS_COMPLETIONRING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <semaphore.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace NDL_Esplayer {
+
+    /**
+     * Bounded lock-free ring, multiple producers (OMX IL callback threads)
+     * and a single consumer (completion dispatcher).
+     * Size must be a power of 2.
+     */
+    template <typename T, size_t SIZE>
+    class CompletionRing {
+        public:
+            CompletionRing() {
+                static_assert((SIZE & (SIZE - 1)) == 0, "ring size must be a power of 2");
+                for (size_t i = 0; i < SIZE; i++)
+                    slots_[i].seq.store(i, std::memory_order_relaxed);
+            }
+
+            /**
+             * return false if the ring is full
+             */
+            bool push(const T& value) {
+                size_t pos = tail_.load(std::memory_order_relaxed);
+                Slot* slot;
+                for (;;) {
+                    slot = &slots_[pos & (SIZE - 1)];
+                    size_t seq = slot->seq.load(std::memory_order_acquire);
+                    intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+                    if (diff == 0) {
+                        if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                            break;
+                    } else if (diff < 0) {
+                        return false;
+                    } else {
+                        pos = tail_.load(std::memory_order_relaxed);
+                    }
+                }
+                slot->value = value;
+                slot->seq.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+
+            /**
+             * consumer only, return false if the ring is empty
+             */
+            bool pop(T& value) {
+                size_t pos = head_.load(std::memory_order_relaxed);
+                Slot& slot = slots_[pos & (SIZE - 1)];
+                if (slot.seq.load(std::memory_order_acquire) != pos + 1)
+                    return false;
+                value = slot.value;
+                slot.seq.store(pos + SIZE, std::memory_order_release);
+                head_.store(pos + 1, std::memory_order_relaxed);
+                return true;
+            }
+
+        private:
+            struct Slot {
+                std::atomic<size_t> seq;
+                T value;
+            };
+
+            Slot slots_[SIZE];
+            alignas(64) std::atomic<size_t> tail_ {0};
+            alignas(64) std::atomic<size_t> head_ {0};
+
+            CompletionRing(CompletionRing const&) = delete;
+            void operator=(CompletionRing const&) = delete;
+    };
+
+    /**
+     * Library thread draining the completion rings of all the OMX clients.
+     * Producers only wake it when it is not already pending, so one wake
+     * dispatches a batch of completions. The drains run outside of the lock.
+     */
+    class CompletionDispatcher {
+        public:
+            typedef std::function<void()> DrainFunction;
+
+            static CompletionDispatcher& getInstance();
+
+            void add(const void* owner, DrainFunction drain);
+            /**
+             * After return, drain of the owner is not running and never called again,
+             * except when called from the drain itself (it returns at once)
+             */
+            void remove(const void* owner);
+            bool contains(const void* owner);
+            bool isDispatcherThread() const {
+                return std::this_thread::get_id() == thread_.get_id();
+            }
+            /**
+             * Called from OMX IL callback threads after push
+             */
+            void wake() {
+                if (!pending_.exchange(true))
+                    sem_post(&wakeup_);
+            }
+
+        private:
+            CompletionDispatcher();
+            ~CompletionDispatcher();
+
+            void run();
+
+            std::mutex lock_;
+            std::condition_variable drained_;
+            std::map<const void*, std::shared_ptr<DrainFunction>> owners_;
+            // drain calls started and finished : remove waits for the one running its owner
+            uint64_t generation_ {0};
+            uint64_t finished_generation_ {0};
+            const void* running_owner_ {nullptr};
+            std::atomic<bool> pending_ {false};
+            std::atomic<bool> quit_ {false};
+            sem_t wakeup_;
+            std::thread thread_;
+
+            CompletionDispatcher(CompletionDispatcher const&) = delete;
+            void operator=(CompletionDispatcher const&) = delete;
+    };
+
+} //namespace NDL_Esplayer
+
+#endif //NDL_DIRECTMEDIA2_OMX_CLIENTS_COMPLETIONRING_H_
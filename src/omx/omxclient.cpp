@@ -55,10 +55,18 @@ OmxClient::OmxClient(player_listener_callback listener, void* userdata)
     pthread_condattr_init(&buffer_attr_);
     pthread_condattr_setclock(&buffer_attr_ , CLOCK_MONOTONIC);
     pthread_cond_init(&buffer_cond_, &buffer_attr_);
+
+    // initialize mutex for the completion ring overflow
+    pthread_mutex_init(&completion_lock_, NULL);
+    pthread_cond_init(&completion_cond_, &buffer_attr_);
 }
 
 OmxClient::~OmxClient()
 {
+#if OMX_CLIENT_ASYNC_BUFFER_DONE
+    CompletionDispatcher::getInstance().remove(this);
+#endif
+
     // destroy mutex for state
     pthread_mutex_destroy(&state_lock_);
     pthread_condattr_destroy(&state_attr_);
@@ -69,6 +77,10 @@ OmxClient::~OmxClient()
     pthread_condattr_destroy(&buffer_attr_);
     pthread_cond_destroy(&buffer_cond_);
 
+    // destroy mutex for the completion ring overflow
+    pthread_mutex_destroy(&completion_lock_);
+    pthread_cond_destroy(&completion_cond_);
+
     // clear port map
     enabled_port_map_.clear();
 
@@ -104,6 +116,10 @@ int OmxClient::createByName(const std::string & name)
         std::copy(name.begin(), name.end(), component_name_);
         component_name_[name.size()] = '\0';
         NDLLOG(LOGTAG, NDL_LOGI, "createByName - component name : %s", component_name_);
+        stats_.setName(component_name_);
+#if OMX_CLIENT_ASYNC_BUFFER_DONE
+        CompletionDispatcher::getInstance().add(this, [this] { drainCompletions(); });
+#endif
     }
 
     return 0;
@@ -113,7 +129,9 @@ int OmxClient::sendCommand(OMX_COMMANDTYPE command, int port_index)
 {
     NDLASSERT(component_handle_);
     OMX_ERRORTYPE err = OMX_ErrorNone;
+    OmxStatsTimer timer(stats_, OMX_STATS_SEND_COMMAND);
     err = OMX_SendCommand(component_handle_, command, port_index, NULL);
+    timer.done(err);
     if (err != OMX_ErrorNone) {
         NDLLOG(LOGTAG, NDL_LOGE, "OMX sendCommand  error : 0x%x",err);
         return err;
@@ -128,7 +146,7 @@ int OmxClient::writeToConfigBuffer(int port_index,
     NDLLOG(LOGTAG, LOG_BUFFER_STATUS, "writeToConfigBuffer (port : %d, len : %d)",
             port_index, data_len);
     pthread_mutex_lock(&buffer_lock_);
-    int buffer_index = getFreeBufferIndex(port_index);
+    int buffer_index = emptyHeldBuffer(port_index) == OMX_ErrorNone ? getFreeBufferIndex(port_index) : -1;
     if(buffer_index < 0)
     {
         pthread_mutex_unlock(&buffer_lock_);
@@ -229,6 +247,10 @@ void OmxClient::destroy()
 {
     NDLLOG(LOGTAG, LOG_STATUS, "destroy ");
     NDLLOG(LOGTAG, NDL_LOGI, "Destroy component name : %s", component_name_);
+#if OMX_CLIENT_ASYNC_BUFFER_DONE
+    // buffer done events not dispatched yet are dropped with the component
+    CompletionDispatcher::getInstance().remove(this);
+#endif
     if (component_handle_)
     {
         OMX_ERRORTYPE err = OMX_ErrorNone;
@@ -263,7 +285,11 @@ int OmxClient::setState(OMX_STATETYPE state, int timeout_seconds)
 
     NDLLOG(LOGTAG, LOG_STATUS, "setState (0x%x) ", state);
     current_state_ = state;
+    if (OmxStats::isEnabled())
+        stats_.begin(OMX_STATS_STATE_SET, state);
+    OmxStatsTimer timer(stats_, OMX_STATS_SEND_COMMAND);
     err = OMX_SendCommand(component_handle_, OMX_CommandStateSet, state, 0);
+    timer.done(err);
 
     if (err == OMX_ErrorNone) {
         if ( timeout_seconds ) {
@@ -271,6 +297,8 @@ int OmxClient::setState(OMX_STATETYPE state, int timeout_seconds)
         }
         return 0;
     }
+    if (OmxStats::isEnabled())
+        stats_.end(OMX_STATS_STATE_SET, state, true);
     current_state_ = previous_state;
     return err;
 }
@@ -317,10 +345,8 @@ int OmxClient::waitForState(OMX_STATETYPE state, int timeout_seconds)
 int OmxClient::waitForFlushing(int timeout_seconds)
 {
     timespec ts;
-    int err = 0;
-    NDLLOG(LOGTAG, LOG_STATUS, "%s in (flushing port count: %d)", __func__, flushing_.size());
     if (flushing_.empty())
-        return err;
+        return 0;
 
     if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
     {
@@ -329,6 +355,17 @@ int OmxClient::waitForFlushing(int timeout_seconds)
     }
     ts.tv_sec += timeout_seconds;
 
+    return waitForFlushing(ts);
+}
+
+int OmxClient::waitForFlushing(const timespec& deadline)
+{
+    timespec ts = deadline;
+    int err = 0;
+    NDLLOG(LOGTAG, LOG_STATUS, "%s in (flushing port count: %d)", __func__, flushing_.size());
+    if (flushing_.empty())
+        return err;
+
     do {
         pthread_mutex_lock(&state_lock_);
         err = pthread_cond_timedwait(&state_cond_, &state_lock_, &ts );
@@ -422,10 +459,17 @@ int OmxClient::enablePort(int port_index, bool enable, int timeout_seconds)
     if (enable) cmd = OMX_CommandPortEnable;
     else        cmd = OMX_CommandPortDisable;
 
+    OMX_STATS_CALL stats_call = enable ? OMX_STATS_PORT_ENABLE : OMX_STATS_PORT_DISABLE;
+    if (OmxStats::isEnabled())
+        stats_.begin(stats_call, port_index);
+    OmxStatsTimer timer(stats_, OMX_STATS_SEND_COMMAND);
     OMX_ERRORTYPE ret = OMX_SendCommand(component_handle_, cmd, port_index, 0);
+    timer.done(ret);
     if (ret == OMX_ErrorNone) {
         if ( timeout_seconds )
             return  waitForPortEnable(port_index, enable, timeout_seconds);
+    } else if (OmxStats::isEnabled()) {
+        stats_.end(stats_call, port_index, true);
     }
     return ret;
 }
@@ -452,10 +496,21 @@ int OmxClient::flush(int port_index, int timeout_seconds)
     } else {
         flushing_.push_back(port_index);
     }
+    dropHeldBuffers(port_index);
 
+    if (OmxStats::isEnabled()) {
+        for (int flushing_port : flushing_)
+            stats_.begin(OMX_STATS_FLUSH, flushing_port);
+    }
+    OmxStatsTimer timer(stats_, OMX_STATS_SEND_COMMAND);
     err = OMX_SendCommand(component_handle_, OMX_CommandFlush, port_index, 0);
+    timer.done(err);
     if (err!=OMX_ErrorNone) {
         NDLLOG(LOGTAG, NDL_LOGD, "Flush command error. clear flushing list");
+        if (OmxStats::isEnabled()) {
+            for (int flushing_port : flushing_)
+                stats_.end(OMX_STATS_FLUSH, flushing_port, true);
+        }
         flushing_.clear();
         return err;
     }
@@ -473,7 +528,9 @@ int OmxClient::getPortDefinition(int port_index)
     OMX_PARAM_PORTDEFINITIONTYPE port_def;
     omx_init_structure(&port_def, OMX_PARAM_PORTDEFINITIONTYPE);
     port_def.nPortIndex = port_index;
+    OmxStatsTimer timer(stats_, OMX_STATS_GET_PARAM);
     ret = OMX_GetParameter(component_handle_, OMX_IndexParamPortDefinition, &port_def);
+    timer.done(ret);
     if (ret != OMX_ErrorNone)
     {
         NDLLOG(LOGTAG, NDL_LOGE, "Unable to get port %d th definition.... ", port_index);
@@ -493,8 +550,11 @@ int OmxClient::reconfigureBuffers(int port_index, int buffer_count, int buffer_s
     OMX_PARAM_PORTDEFINITIONTYPE port_def;
     omx_init_structure(&port_def, OMX_PARAM_PORTDEFINITIONTYPE);
     port_def.nPortIndex = port_index;
-    if (OMX_GetParameter(component_handle_, OMX_IndexParamPortDefinition,
-                &port_def)  != OMX_ErrorNone)
+    OmxStatsTimer get_timer(stats_, OMX_STATS_GET_PARAM);
+    OMX_ERRORTYPE ret = OMX_GetParameter(component_handle_, OMX_IndexParamPortDefinition,
+                &port_def);
+    get_timer.done(ret);
+    if (ret != OMX_ErrorNone)
     {
         NDLLOG(LOGTAG, NDL_LOGE, "Unable to get port %d th definition.... ", port_index);
         return -1;
@@ -508,23 +568,32 @@ int OmxClient::reconfigureBuffers(int port_index, int buffer_count, int buffer_s
     port_def.nBufferCountActual = buffer_count;
     port_def.nBufferSize = buffer_size;
 
-    return OMX_SetParameter(component_handle_,
+    OmxStatsTimer set_timer(stats_, OMX_STATS_SET_PARAM);
+    ret = OMX_SetParameter(component_handle_,
             OMX_IndexParamPortDefinition,
             &port_def );
+    set_timer.done(ret);
+    return ret;
 }
 
 int OmxClient::setParam(OMX_INDEXTYPE param_index, OMX_PTR param_data)
 {
     NDLASSERT(component_handle_);
     NDLLOG(LOGTAG, LOG_STATUS, "setParam (param index : 0x%x) ", param_index);
-    return OMX_SetParameter(component_handle_, param_index, param_data);
+    OmxStatsTimer timer(stats_, OMX_STATS_SET_PARAM);
+    OMX_ERRORTYPE ret = OMX_SetParameter(component_handle_, param_index, param_data);
+    timer.done(ret);
+    return ret;
 }
 
 int OmxClient::getParam(OMX_INDEXTYPE param_index, OMX_PTR param_data)
 {
     NDLASSERT(component_handle_);
     NDLLOG(LOGTAG, LOG_STATUS, "getParam (param index : 0x%x) ", param_index);
-    return OMX_GetParameter(component_handle_, param_index, param_data);
+    OmxStatsTimer timer(stats_, OMX_STATS_GET_PARAM);
+    OMX_ERRORTYPE ret = OMX_GetParameter(component_handle_, param_index, param_data);
+    timer.done(ret);
+    return ret;
 }
 
 
@@ -532,14 +601,20 @@ int OmxClient::setConfig(OMX_INDEXTYPE config_index, OMX_PTR config_data)
 {
     NDLASSERT(component_handle_);
     NDLLOG(LOGTAG, LOG_STATUS, "setConfig (config index : 0x%x) ", config_index);
-    return OMX_SetConfig(component_handle_, config_index, config_data);
+    OmxStatsTimer timer(stats_, OMX_STATS_SET_CONFIG);
+    OMX_ERRORTYPE ret = OMX_SetConfig(component_handle_, config_index, config_data);
+    timer.done(ret);
+    return ret;
 }
 
 int OmxClient::getConfig(OMX_INDEXTYPE config_index, OMX_PTR config_data)
 {
     NDLASSERT(component_handle_);
     NDLLOG(LOGTAG, LOG_STATUS, "getConfig (config index : 0x%x) ", config_index);
-    return OMX_GetConfig(component_handle_, config_index, config_data);
+    OmxStatsTimer timer(stats_, OMX_STATS_GET_CONFIG);
+    OMX_ERRORTYPE ret = OMX_GetConfig(component_handle_, config_index, config_data);
+    timer.done(ret);
+    return ret;
 }
 
 int OmxClient::setupTunnel(int source_port_index,
@@ -581,6 +656,7 @@ int OmxClient::freeBuffer(int port_index)
         return -1;
     }
 
+    dropHeldBuffers(port_index);
     auto buffers = port_buffers_.at(port_index);
     for(auto i=buffers.begin(); i!=buffers.end(); ++i) {
         BufferInfo* info = (BufferInfo*)(*i)->pAppPrivate;
@@ -728,8 +804,6 @@ OMX_BUFFERHEADERTYPE* OmxClient::getBuffer(int port_index, int buffer_index)
 
 int OmxClient::emptyBuffer(int port_index, int buffer_index)
 {
-    //struct timeval startTime, endTime;
-    //int32_t elapse = 0;
     OMX_BUFFERHEADERTYPE* buf = getBuffer(port_index, buffer_index);
     if (!buf)
         return -1;
@@ -743,11 +817,9 @@ int OmxClient::emptyBuffer(int port_index, int buffer_index)
     }
 
     setBufferStatus(buf, BUFFER_STATUS_OWNED_BY_COMPONENT);
-    //GETTIME(&startTime, NULL);
+    OmxStatsTimer timer(stats_, OMX_STATS_EMPTY_THIS_BUFFER);
     int ret = OMX_EmptyThisBuffer(component_handle_, buf);
-    //GETTIME(&endTime, NULL);
-    //TIME_DIFF(startTime, endTime, elapse);
-    //NDLLOG(LOGTAG, LOG_BUFFER, "OMX_EmptyThisBuffer elapsed:%dns", elapse);
+    timer.done(ret);
     if (ret != OMX_ErrorNone) {
         setBufferStatus(buf, BUFFER_STATUS_OWNED_BY_CLIENT);
         NDLLOG(LOGTAG, NDL_LOGE, "OMX_EmptyThisBuffer return error : 0x%x", ret);
@@ -776,7 +848,9 @@ int OmxClient::fillBuffer(int port_index, int buffer_index)
     buf->nTimeStamp = to_omx_time(0);
 
     setBufferStatus(buf, BUFFER_STATUS_OWNED_BY_COMPONENT);
+    OmxStatsTimer timer(stats_, OMX_STATS_FILL_THIS_BUFFER);
     int ret = OMX_FillThisBuffer(component_handle_, buf);
+    timer.done(ret);
     if (ret != OMX_ErrorNone) {
         setBufferStatus(buf, BUFFER_STATUS_OWNED_BY_CLIENT);
         NDLLOG(LOGTAG, NDL_LOGE, "OMX_FillThisBuffer return error : 0x%x", ret);
@@ -795,7 +869,7 @@ int OmxClient::writeToFreeBuffer(int port_index,
     NDLLOG(LOGTAG, LOG_BUFFER_STATUS, "writeToFreeBuffer (port : %d, len : %d, pts : %lld)",
             port_index, data_len, pts);
     pthread_mutex_lock(&buffer_lock_);
-    int buffer_index = getFreeBufferIndex(port_index);
+    int buffer_index = emptyHeldBuffer(port_index) == OMX_ErrorNone ? getFreeBufferIndex(port_index) : -1;
     if(buffer_index < 0)
     {
         pthread_mutex_unlock(&buffer_lock_);
@@ -840,6 +914,102 @@ int OmxClient::writeToFreeBuffer(int port_index,
     return 0;
 }
 
+int OmxClient::writeToFreeBuffer(int port_index,
+        int32_t data_len,
+        int64_t pts,
+        uint32_t flags,
+        const std::function<int32_t(uint8_t* dst, int32_t capacity)>& writer,
+        int* error)
+{
+    NDLLOG(LOGTAG, LOG_BUFFER_STATUS, "writeToFreeBuffer in place (port : %d, len : %d, pts : %lld)",
+            port_index, data_len, pts);
+    int32_t written = 0;
+    pthread_mutex_lock(&buffer_lock_);
+    // the part of a previous write which did not go out goes first
+    int err = emptyHeldBuffer(port_index);
+    while (err == OMX_ErrorNone && written < data_len) {
+        int buffer_index = getFreeBufferIndex(port_index);
+        if (buffer_index < 0)
+            break;
+        OMX_BUFFERHEADERTYPE* buf = getBuffer(port_index, buffer_index);
+        if (!buf)
+            break;
+
+        // filled outside of buffer_lock_, the writer takes the locks of its stages (mix, gain)
+        setBufferStatus(buf, BUFFER_STATUS_RESERVED_BY_CLIENT);
+        pthread_mutex_unlock(&buffer_lock_);
+        int32_t len = writer(buf->pBuffer, std::min((int32_t)buf->nAllocLen, data_len - written));
+        pthread_mutex_lock(&buffer_lock_);
+        setBufferStatus(buf, BUFFER_STATUS_OWNED_BY_CLIENT);
+        if (len <= 0)
+            break;
+
+        // continued part of the frame : no start time, frame end only on the last part
+        uint32_t buffer_flags = flags;
+        if (written > 0)
+            buffer_flags &= ~OMX_BUFFERFLAG_STARTTIME;
+        written += len;
+        if (written < data_len)
+            buffer_flags &= ~(OMX_BUFFERFLAG_ENDOFFRAME | OMX_BUFFERFLAG_EOS);
+
+        buf->nOffset = 0;
+        buf->nFilledLen = len;
+        buf->nFlags = buffer_flags;
+        buf->nTimeStamp = to_omx_time((uint64_t)pts);
+        // the samples are already taken from the writer : kept in the buffer for the next write
+        err = emptyBuffer(port_index, buffer_index);
+        if (err != OMX_ErrorNone) {
+            setBufferStatus(buf, BUFFER_STATUS_RESERVED_BY_CLIENT);
+            held_buffers_[port_index] = buffer_index;
+        }
+    }
+    pthread_mutex_unlock(&buffer_lock_);
+    if (error)
+        *error = err;
+    return written;
+}
+
+/**
+ * Empty again the buffer kept by a failed writeToFreeBuffer, buffer_lock_ held
+ */
+int OmxClient::emptyHeldBuffer(int port_index)
+{
+    auto held = held_buffers_.find(port_index);
+    if (held == held_buffers_.end())
+        return OMX_ErrorNone;
+    OMX_BUFFERHEADERTYPE* buf = getBuffer(port_index, held->second);
+    if (!buf) {
+        held_buffers_.erase(held);
+        return OMX_ErrorNone;
+    }
+    setBufferStatus(buf, BUFFER_STATUS_OWNED_BY_CLIENT);
+    int err = emptyBuffer(port_index, held->second);
+    if (err == OMX_ErrorNone)
+        held_buffers_.erase(held);
+    else
+        setBufferStatus(buf, BUFFER_STATUS_RESERVED_BY_CLIENT);
+    return err;
+}
+
+/**
+ * Data of the kept buffers is discarded like the one flushed by the component, they are free again
+ */
+void OmxClient::dropHeldBuffers(int port_index)
+{
+    pthread_mutex_lock(&buffer_lock_);
+    for (auto held = held_buffers_.begin(); held != held_buffers_.end(); ) {
+        if ((uint32_t)port_index != OMX_ALL && held->first != port_index) {
+            ++held;
+            continue;
+        }
+        OMX_BUFFERHEADERTYPE* buf = getBuffer(held->first, held->second);
+        if (buf)
+            setBufferStatus(buf, BUFFER_STATUS_OWNED_BY_CLIENT);
+        held = held_buffers_.erase(held);
+    }
+    pthread_mutex_unlock(&buffer_lock_);
+}
+
 int OmxClient::writeToFreeBuffer(int port_index,
         int buffer_index,
         OmxClient* buffer_owner,
@@ -921,11 +1091,15 @@ OMX_ERRORTYPE OmxClient::eventHandler(OMX_EVENTTYPE event,
             {
                 NDLLOG(LOGTAG,NDL_LOGI, "client state set to 0x%x(%s) ",
                         (uint32_t)data2, omxStateToString[(int)data2].c_str());
+                if (OmxStats::isEnabled())
+                    stats_.end(OMX_STATS_STATE_SET, data2);
                 pthread_cond_signal(&state_cond_);
             }
             else if (data1 == OMX_CommandFlush)
             {
                 NDLLOG(LOGTAG, NDL_LOGI, "flush done %d port ", (uint32_t)data2);
+                if (OmxStats::isEnabled())
+                    stats_.end(OMX_STATS_FLUSH, data2);
 
                 // erase flush port
                 auto iter = std::find(flushing_.begin(), flushing_.end(), (int)data2);
@@ -942,12 +1116,16 @@ OMX_ERRORTYPE OmxClient::eventHandler(OMX_EVENTTYPE event,
             else if (data1 == OMX_CommandPortEnable)
             {
                 NDLLOG(LOGTAG,NDL_LOGI, "port %u enabled", (unsigned int) data2);
+                if (OmxStats::isEnabled())
+                    stats_.end(OMX_STATS_PORT_ENABLE, data2);
                 setPortMapState((int)data2, true);
                 pthread_cond_signal(&state_cond_);
             }
             else if (data1 == OMX_CommandPortDisable)
             {
                 NDLLOG(LOGTAG,NDL_LOGI, "port %u disabled", (unsigned int) data2);
+                if (OmxStats::isEnabled())
+                    stats_.end(OMX_STATS_PORT_DISABLE, data2);
                 setPortMapState((int)data2, false);
                 pthread_cond_signal(&state_cond_);
             }
@@ -997,8 +1175,7 @@ OMX_ERRORTYPE OmxClient::emptyBufferDone(OMX_BUFFERHEADERTYPE* buf)
         {
             NDLLOG(LOGTAG, LOG_BUFFER, "emptyBufferDone (port : %d, buffer index : %d, ts : %lld, high:%d, low:%d)",
                     info->port_index, info->buffer_index, from_omx_time(buf->nTimeStamp), buf->nTimeStamp.nHighPart, buf->nTimeStamp.nLowPart);
-            player_listener_(OMX_CLIENT_EVT_EMPTY_BUFFER_DONE,
-                    info->port_index, buf->nTimeStamp.nLowPart, 0, userdata_);
+            postCompletion(OMX_CLIENT_EVT_EMPTY_BUFFER_DONE, buf);
         } else {
             NDLLOG(LOGTAG, NDL_LOGI, "stop feeding... ");
         }
@@ -1032,8 +1209,7 @@ OMX_ERRORTYPE OmxClient::fillBufferDone(OMX_BUFFERHEADERTYPE* buf)
         {
             NDLLOG(LOGTAG, LOG_BUFFER, "fillBufferDone (port : %d, buffer index : %d, ts : %lld)",
                     info->port_index, info->buffer_index, from_omx_time(buf->nTimeStamp));
-            player_listener_(OMX_CLIENT_EVT_FILL_BUFFER_DONE,
-                    info->port_index, info->buffer_index, 0, userdata_);
+            postCompletion(OMX_CLIENT_EVT_FILL_BUFFER_DONE, buf);
         } else {
             NDLLOG(LOGTAG, NDL_LOGI, "stop request output");
         }
@@ -1044,6 +1220,95 @@ OMX_ERRORTYPE OmxClient::fillBufferDone(OMX_BUFFERHEADERTYPE* buf)
     return OMX_ErrorNone;
 }
 
+void OmxClient::postCompletion(int event, OMX_BUFFERHEADERTYPE* buf)
+{
+    BufferInfo* info = (BufferInfo*)buf->pAppPrivate;
+    Completion completion;
+    completion.event = event;
+    completion.port_index = info->port_index;
+    completion.buffer_index = info->buffer_index;
+    completion.timestamp = from_omx_time(buf->nTimeStamp);
+    completion.flags = buf->nFlags;
+
+#if OMX_CLIENT_ASYNC_BUFFER_DONE
+    // full ring : the callback thread waits for the dispatcher, the completions stay in order
+    CompletionDispatcher& dispatcher = CompletionDispatcher::getInstance();
+    bool overflow = false;
+    while (!completions_.push(completion)) {
+        if (dispatcher.isDispatcherThread()) {
+            // called back from a drain : the consumer makes room itself
+            drainCompletions();
+            continue;
+        }
+        if (!dispatcher.contains(this)) {
+            // destroying, dropped with the component
+            return;
+        }
+        if (!overflow) {
+            overflow = true;
+            NDLLOG(LOGTAG, NDL_LOGE, "%s : completion ring full (%d), waiting for the dispatcher",
+                    component_name_ ? component_name_ : "", OMX_CLIENT_COMPLETION_RING_SIZE);
+        }
+        dispatcher.wake();
+        waitCompletionRoom();
+    }
+    dispatcher.wake();
+#else
+    dispatchCompletion(completion);
+#endif
+}
+
+void OmxClient::dispatchCompletion(const Completion& completion)
+{
+    switch (completion.event) {
+        case OMX_CLIENT_EVT_EMPTY_BUFFER_DONE:
+            // data2 : lower 32 bits of the timestamp
+            player_listener_(OMX_CLIENT_EVT_EMPTY_BUFFER_DONE,
+                    completion.port_index, (uint32_t)completion.timestamp, 0, userdata_);
+            break;
+        case OMX_CLIENT_EVT_FILL_BUFFER_DONE:
+            player_listener_(OMX_CLIENT_EVT_FILL_BUFFER_DONE,
+                    completion.port_index, completion.buffer_index, 0, userdata_);
+            break;
+        default:
+            break;
+    }
+}
+
+void OmxClient::drainCompletions()
+{
+    Completion completion;
+    while (completions_.pop(completion))
+        dispatchCompletion(completion);
+
+    if (completion_waiters_.load()) {
+        pthread_mutex_lock(&completion_lock_);
+        pthread_cond_broadcast(&completion_cond_);
+        pthread_mutex_unlock(&completion_lock_);
+    }
+}
+
+void OmxClient::waitCompletionRoom()
+{
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+        NDLLOG(LOGTAG, NDL_LOGE, "system : clock_gettime error...... ");
+        return;
+    }
+    ts.tv_nsec += OMX_CLIENT_COMPLETION_WAIT_MS * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+
+    // a broadcast between the failed push and the wait is missed : the wait is bounded
+    pthread_mutex_lock(&completion_lock_);
+    completion_waiters_++;
+    pthread_cond_timedwait(&completion_cond_, &completion_lock_, &ts);
+    completion_waiters_--;
+    pthread_mutex_unlock(&completion_lock_);
+}
+
 bool OmxClient::insertPortMap(int portIdx) {
     std::pair<std::map<int, bool>::iterator, bool> pr;
     // set the state for port index. initial setting is false.
@@ -23,9 +23,15 @@
 #include <map>
 #include <list>
 #include <vector>
+#include <string>
+#include <functional>
+#include <atomic>
 #include <stdint.h>
 #include <string.h>
+#include <time.h>
 #include "omxcore.h"
+#include "completionring.h"
+#include "omxstats.h"
 
 #include <OMX_Core.h>
 #include <OMX_Component.h>
@@ -74,6 +80,15 @@ namespace NDL_Esplayer {
      */
 #define SYNC_STATE_TIMEOUT_SECS 3
 
+    /**
+     * Deliver EmptyBufferDone/FillBufferDone to the player on the completion
+     * dispatcher thread instead of the OMX IL callback thread
+     */
+#define OMX_CLIENT_ASYNC_BUFFER_DONE 1
+#define OMX_CLIENT_COMPLETION_RING_SIZE 128
+    // bounded wait of the IL callback thread for the dispatcher when the ring is full
+#define OMX_CLIENT_COMPLETION_WAIT_MS 5
+
     /**
      * Definition of callback event
      */
@@ -103,11 +118,13 @@ namespace NDL_Esplayer {
             virtual ~OmxClient();
 
             /**
-             * Buffer status : OWNED_BY_CLIENT -> free buffer, OWNED_BY_COMPONENT -> using by component
+             * Buffer status : OWNED_BY_CLIENT -> free buffer, OWNED_BY_COMPONENT -> using by component,
+             * RESERVED_BY_CLIENT -> filled by a writer or held after a failed OMX_EmptyThisBuffer, not free
              */
             typedef enum {
                 BUFFER_STATUS_OWNED_BY_CLIENT = 1,
                 BUFFER_STATUS_OWNED_BY_COMPONENT,
+                BUFFER_STATUS_RESERVED_BY_CLIENT,
             }BUFFER_STATUS;
 
             /**
@@ -148,6 +165,11 @@ namespace NDL_Esplayer {
              * Wait for flushing if flush is called without syncronized
              */
             int waitForFlushing(int timeout_seconds);
+            /**
+             * Wait for flushing until absolute deadline (CLOCK_MONOTONIC).
+             * Used to wait for several components sharing one timeout.
+             */
+            int waitForFlushing(const timespec& deadline);
             /**
              * Wait for port enable/disble done event if it is not syncronized
              */
@@ -214,6 +236,20 @@ namespace NDL_Esplayer {
              * Feed data into free buffer
              */
             int writeToFreeBuffer(int port_index, const uint8_t* data, int32_t data_len, int64_t pts,uint32_t flags);
+            /**
+             * Feed data into free buffers in place : writer fills pBuffer of the free buffer directly
+             * (writer(dst, capacity) returns written bytes), and data which does not fit spans
+             * into the next free buffers. ENDOFFRAME/EOS go to the last buffer only.
+             * return length taken from the writer, it can be less than data_len if free buffers run out.
+             * error : OMX_EmptyThisBuffer error, the buffer which failed keeps its data and is
+             *         emptied first by the next write on the port (until flush), so the caller
+             *         only has to retry later with the rest
+             * The writer runs without buffer_lock_ (the buffer is reserved meanwhile) : it may take
+             * the locks of its own stages, which are never held while calling into the client.
+             */
+            int writeToFreeBuffer(int port_index, int32_t data_len, int64_t pts, uint32_t flags,
+                    const std::function<int32_t(uint8_t* dst, int32_t capacity)>& writer,
+                    int* error = nullptr);
             /**
              * Feed data into free buffer for UseBuffer Mode
              */
@@ -279,6 +315,16 @@ namespace NDL_Esplayer {
                 return component_name_;
             }
 
+            /**
+             * OMX call latency statistics of this component (see OmxStats)
+             */
+            OmxStats& getStats() {
+                return stats_;
+            }
+            const OmxStats& getStats() const {
+                return stats_;
+            }
+
             /**
              * Destroy OmxCore signle-tone instance
              */
@@ -316,6 +362,30 @@ namespace NDL_Esplayer {
             OMX_ERRORTYPE emptyBufferDone(OMX_BUFFERHEADERTYPE* buf) ;
             OMX_ERRORTYPE fillBufferDone(OMX_BUFFERHEADERTYPE* buf);
 
+            /**
+             * Buffer done event recorded on the IL callback thread
+             */
+            struct Completion {
+                int event;
+                uint32_t port_index;
+                uint32_t buffer_index;
+                int64_t timestamp;
+                uint32_t flags;
+            };
+            /**
+             * Record buffer done event to be dispatched to the player listener
+             */
+            void postCompletion(int event, OMX_BUFFERHEADERTYPE* buf);
+            void dispatchCompletion(const Completion& completion);
+            /**
+             * Called on the completion dispatcher thread
+             */
+            void drainCompletions();
+            /**
+             * Full ring : wait for the dispatcher to pop, at most OMX_CLIENT_COMPLETION_WAIT_MS
+             */
+            void waitCompletionRoom();
+
         private:
             player_listener_callback player_listener_;
             void* userdata_;
@@ -338,6 +408,17 @@ namespace NDL_Esplayer {
             pthread_condattr_t buffer_attr_;
 
             std::map<int, std::vector<OMX_BUFFERHEADERTYPE*>> port_buffers_;
+            // port : buffer filled by writeToFreeBuffer whose OMX_EmptyThisBuffer failed (reserved)
+            std::map<int, int> held_buffers_;
+            int emptyHeldBuffer(int port_index);
+            void dropHeldBuffers(int port_index);
+
+            CompletionRing<Completion, OMX_CLIENT_COMPLETION_RING_SIZE> completions_;
+            pthread_mutex_t completion_lock_;
+            pthread_cond_t completion_cond_;
+            std::atomic<int> completion_waiters_ {0};
+
+            OmxStats stats_;
 
             std::vector<OMX_BUFFERHEADERTYPE*>& getBuffers(int port_index) {
                 return port_buffers_.at(port_index);
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// OmxCore backed by the software loopback components (ndl-directmedia2-omxsw library).
+// Same interface with omxcore.cpp, so the whole Esplayer pipeline runs without
+// Broadcom IL / bcm_host on any Linux machine.
+
+#include <map>
+#include <mutex>
+
+#include "omxcore.h"
+#include "sw/swcomponent.h"
+
+using namespace NDL_Esplayer;
+
+#define LOGTAG "swomxcore"
+#include "debug.h"
+
+OmxCore *OmxCore::instance = nullptr;
+
+namespace {
+    std::mutex registry_lock;
+    std::map<OMX_HANDLETYPE, std::shared_ptr<SwOmx::SwComponent>> registry;
+
+    std::shared_ptr<SwOmx::SwComponent> findComponent(OMX_HANDLETYPE handle)
+    {
+        std::lock_guard<std::mutex> lock(registry_lock);
+        auto item = registry.find(handle);
+        return item == registry.end() ? nullptr : item->second;
+    }
+
+    OMX_ERRORTYPE createHandle(OMX_HANDLETYPE* pHandle,
+            OMX_STRING cComponentName,
+            OMX_PTR pAppData,
+            OMX_CALLBACKTYPE* pCallBacks)
+    {
+        if (!pHandle || !cComponentName)
+            return OMX_ErrorBadParameter;
+
+        auto component = SwOmx::createComponent(cComponentName);
+        if (!component)
+            return OMX_ErrorComponentNotFound;
+
+        OMX_HANDLETYPE handle = component->getHandle();
+        OMX_ERRORTYPE err = ((OMX_COMPONENTTYPE*)handle)->SetCallbacks(handle, pCallBacks, pAppData);
+        if (err != OMX_ErrorNone)
+            return err;
+
+        {
+            std::lock_guard<std::mutex> lock(registry_lock);
+            registry[handle] = component;
+        }
+        *pHandle = handle;
+        NDLLOG(LOGTAG, NDL_LOGD, "created %s (%p)", cComponentName, handle);
+        return OMX_ErrorNone;
+    }
+
+    OMX_ERRORTYPE destroyHandle(OMX_HANDLETYPE hComponent)
+    {
+        std::shared_ptr<SwOmx::SwComponent> component;
+        {
+            std::lock_guard<std::mutex> lock(registry_lock);
+            auto item = registry.find(hComponent);
+            if (item == registry.end())
+                return OMX_ErrorInvalidComponent;
+            component = item->second;
+            registry.erase(item);
+        }
+        component->disconnect();
+        component->stop();
+        NDLLOG(LOGTAG, NDL_LOGD, "destroyed %s (%p)", component->getName().c_str(), hComponent);
+        return OMX_ErrorNone;
+    }
+}
+
+OmxCore::OmxCore()
+{
+    NDLLOG(LOGTAG, NDL_LOGI, "software OMX core (video decode %dus, audio decode %dus, render %dus)",
+            SwOmx::config().video_decode_us, SwOmx::config().audio_decode_us, SwOmx::config().render_us);
+}
+
+OmxCore::~OmxCore()
+{
+}
+
+OMX_ERRORTYPE OmxCore::getHandle(OMX_HANDLETYPE* pHandle,
+        OMX_STRING cComponentName,
+        OMX_PTR pAppData,
+        OMX_CALLBACKTYPE* pCallBacks)
+{
+    return createHandle(pHandle, cComponentName, pAppData, pCallBacks);
+}
+
+OMX_ERRORTYPE OmxCore::getDRMHandle(OMX_HANDLETYPE* pHandle,
+        OMX_STRING cComponentName,
+        OMX_PTR pAppData,
+        OMX_CALLBACKTYPE* pCallBacks)
+{
+    return createHandle(pHandle, cComponentName, pAppData, pCallBacks);
+}
+
+OMX_ERRORTYPE OmxCore::freeDRMHandle(OMX_HANDLETYPE hComponent)
+{
+    return destroyHandle(hComponent);
+}
+
+OMX_ERRORTYPE OmxCore::getALSAHandle(OMX_HANDLETYPE* pHandle,
+        OMX_STRING cComponentName,
+        OMX_PTR pAppData,
+        OMX_CALLBACKTYPE* pCallBacks)
+{
+    return createHandle(pHandle, cComponentName, pAppData, pCallBacks);
+}
+
+OMX_ERRORTYPE OmxCore::freeALSAHandle(OMX_HANDLETYPE hComponent)
+{
+    return destroyHandle(hComponent);
+}
+
+OMX_ERRORTYPE OmxCore::freeHandle(OMX_HANDLETYPE hComponent)
+{
+    return destroyHandle(hComponent);
+}
+
+OMX_ERRORTYPE OmxCore::setupTunnel(OMX_HANDLETYPE hOutput,
+        OMX_U32 nPortOutput,
+        OMX_HANDLETYPE hInput,
+        OMX_U32 nPortInput)
+{
+    auto output = findComponent(hOutput);
+    auto input = findComponent(hInput);
+    if (!output || !input)
+        return OMX_ErrorBadParameter;
+
+    OMX_ERRORTYPE err = output->connect(nPortOutput, input, nPortInput);
+    if (err != OMX_ErrorNone)
+        return err;
+    return input->connect(nPortInput, output, nPortOutput);
+}
+
+OMX_ERRORTYPE OmxCore::getComponentsOfRole(OMX_STRING role,
+        OMX_U32 *pNumComps,
+        OMX_U8  **compNames)
+{
+    if (pNumComps)
+        *pNumComps = 0;
+    return OMX_ErrorNone;
+}
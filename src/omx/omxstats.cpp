@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "omxstats.h"
+
+using namespace NDL_Esplayer;
+
+#define LOGTAG "omxstats"
+#include "debug.h"
+
+namespace {
+    const char* call_names[OMX_STATS_CALL_COUNT] = {
+        "etb", "ftb", "set_config", "get_config", "set_param", "get_param",
+        "send_cmd", "state", "port_enable", "port_disable", "flush",
+    };
+
+    bool enabledByEnv()
+    {
+        const char* value = getenv("NDL_OMX_STATS");
+        return value && atoi(value) > 0;
+    }
+
+    int64_t intervalByEnv()
+    {
+        const char* value = getenv("NDL_OMX_STATS_INTERVAL");
+        int seconds = value ? atoi(value) : 10;
+        return seconds > 0 ? seconds * 1000000000LL : 0;
+    }
+
+    int bucketOf(int64_t elapsed_ns)
+    {
+        int64_t us = elapsed_ns / 1000;
+        int bucket = 0;
+        while (us > 0 && bucket < OmxStats::BUCKET_COUNT - 1) {
+            us >>= 1;
+            bucket++;
+        }
+        return bucket;
+    }
+
+    // upper bound of the bucket holding the given percentile, in us
+    int64_t percentileOf(const uint32_t* buckets, uint64_t count, int percent)
+    {
+        uint64_t target = (count * percent + 99) / 100;
+        uint64_t sum = 0;
+        for (int i = 0; i < OmxStats::BUCKET_COUNT; i++) {
+            sum += buckets[i];
+            if (sum >= target)
+                return 1LL << i;
+        }
+        return 1LL << (OmxStats::BUCKET_COUNT - 1);
+    }
+}
+
+std::atomic<bool> OmxStats::enabled_ {enabledByEnv()};
+int64_t OmxStats::log_interval_ns_ = intervalByEnv();
+
+OmxStats::OmxStats()
+{
+    reset();
+}
+
+void OmxStats::setEnabled(bool enable)
+{
+    NDLLOG(LOGTAG, NDL_LOGI, "omx call stats %s", enable ? "enabled" : "disabled");
+    enabled_.store(enable, std::memory_order_relaxed);
+}
+
+void OmxStats::record(OMX_STATS_CALL call, int64_t elapsed_ns, bool error)
+{
+    CallStats& stats = calls_[call];
+    stats.count.fetch_add(1, std::memory_order_relaxed);
+    if (error)
+        stats.errors.fetch_add(1, std::memory_order_relaxed);
+    stats.total_ns.fetch_add(elapsed_ns, std::memory_order_relaxed);
+    stats.buckets[bucketOf(elapsed_ns)].fetch_add(1, std::memory_order_relaxed);
+
+    int64_t max = stats.max_ns.load(std::memory_order_relaxed);
+    while (elapsed_ns > max &&
+            !stats.max_ns.compare_exchange_weak(max, elapsed_ns, std::memory_order_relaxed));
+
+    if (log_interval_ns_)
+        logSummaryIfDue(now());
+}
+
+void OmxStats::begin(OMX_STATS_CALL call, uint32_t key)
+{
+    std::lock_guard<std::mutex> lock(pending_lock_);
+    pending_[((uint64_t)call << 32) | key] = now();
+}
+
+void OmxStats::end(OMX_STATS_CALL call, uint32_t key, bool error)
+{
+    int64_t start = 0;
+    {
+        std::lock_guard<std::mutex> lock(pending_lock_);
+        auto item = pending_.find(((uint64_t)call << 32) | key);
+        // command sent while stats were disabled
+        if (item == pending_.end())
+            return;
+        start = item->second;
+        pending_.erase(item);
+    }
+    record(call, now() - start, error);
+}
+
+void OmxStats::logSummaryIfDue(int64_t now_ns)
+{
+    int64_t next = next_log_ns_.load(std::memory_order_relaxed);
+    if (next == 0) {
+        // first record starts the period
+        next_log_ns_.compare_exchange_strong(next, now_ns + log_interval_ns_,
+                std::memory_order_relaxed);
+        return;
+    }
+    if (now_ns < next)
+        return;
+    // only one of the racing callers logs
+    if (!next_log_ns_.compare_exchange_strong(next, now_ns + log_interval_ns_,
+                std::memory_order_relaxed))
+        return;
+    NDLLOG(LOGTAG, NDL_LOGI, "%s", summary().c_str());
+}
+
+std::string OmxStats::summary() const
+{
+    std::string line = name_.empty() ? "omx" : name_;
+    char item[160];
+    for (int call = 0; call < OMX_STATS_CALL_COUNT; call++) {
+        const CallStats& stats = calls_[call];
+        uint64_t count = stats.count.load(std::memory_order_relaxed);
+        if (!count)
+            continue;
+
+        uint32_t buckets[BUCKET_COUNT];
+        uint64_t bucket_count = 0;
+        for (int i = 0; i < BUCKET_COUNT; i++) {
+            buckets[i] = stats.buckets[i].load(std::memory_order_relaxed);
+            bucket_count += buckets[i];
+        }
+        snprintf(item, sizeof(item),
+                " %s(n:%llu err:%llu avg:%lldus p50:<%lldus p99:<%lldus max:%lldus)",
+                call_names[call],
+                (unsigned long long)count,
+                (unsigned long long)stats.errors.load(std::memory_order_relaxed),
+                (long long)(stats.total_ns.load(std::memory_order_relaxed) / count / 1000),
+                (long long)percentileOf(buckets, bucket_count, 50),
+                (long long)percentileOf(buckets, bucket_count, 99),
+                (long long)(stats.max_ns.load(std::memory_order_relaxed) / 1000));
+        line += item;
+    }
+    return line;
+}
+
+void OmxStats::reset()
+{
+    for (auto& stats : calls_) {
+        stats.count.store(0, std::memory_order_relaxed);
+        stats.errors.store(0, std::memory_order_relaxed);
+        stats.total_ns.store(0, std::memory_order_relaxed);
+        stats.max_ns.store(0, std::memory_order_relaxed);
+        for (auto& bucket : stats.buckets)
+            bucket.store(0, std::memory_order_relaxed);
+    }
+    std::lock_guard<std::mutex> lock(pending_lock_);
+    pending_.clear();
+}
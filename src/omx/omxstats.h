@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef NDL_DIRECTMEDIA2_OMX_CLIENTS_OMXSTATS_H_
+#define NDL_DIRECTMEDIA2_OMX_CLIENTS_OMXSTATS_H_
+
+#include <stdint.h>
+#include <time.h>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace NDL_Esplayer {
+
+    /**
+     * OMX IL calls measured by OmxStats.
+     * STATE_SET, PORT_ENABLE, PORT_DISABLE and FLUSH are measured from the command
+     * to its CmdComplete event, the others are the duration of the IL call itself.
+     */
+    typedef enum {
+        OMX_STATS_EMPTY_THIS_BUFFER,
+        OMX_STATS_FILL_THIS_BUFFER,
+        OMX_STATS_SET_CONFIG,
+        OMX_STATS_GET_CONFIG,
+        OMX_STATS_SET_PARAM,
+        OMX_STATS_GET_PARAM,
+        OMX_STATS_SEND_COMMAND,
+        OMX_STATS_STATE_SET,
+        OMX_STATS_PORT_ENABLE,
+        OMX_STATS_PORT_DISABLE,
+        OMX_STATS_FLUSH,
+        OMX_STATS_CALL_COUNT,
+    } OMX_STATS_CALL;
+
+    /**
+     * Per component OMX call latency histogram and error count.
+     * Disabled by default, enabled by NDL_OMX_STATS=1 in the environment or by setEnabled().
+     * When disabled, the cost of each call site is one relaxed atomic load.
+     * A summary line per component is logged every NDL_OMX_STATS_INTERVAL seconds
+     * (default 10, 0 for no periodic log).
+     */
+    class OmxStats {
+        public:
+            /**
+             * log2(us) buckets : [0] < 1us, [i] < 2^i us, [last] everything above
+             */
+            enum { BUCKET_COUNT = 16 };
+
+            OmxStats();
+
+            static inline bool isEnabled() {
+                return enabled_.load(std::memory_order_relaxed);
+            }
+            static void setEnabled(bool enable);
+
+            static inline int64_t now() {
+                timespec ts;
+                clock_gettime(CLOCK_MONOTONIC, &ts);
+                return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+            }
+
+            void setName(const char* name) { name_ = name ? name : ""; }
+
+            void record(OMX_STATS_CALL call, int64_t elapsed_ns, bool error);
+
+            /**
+             * Command completed by an event : begin on the command, end on CmdComplete.
+             * key tells apart the commands in flight (port index, state)
+             */
+            void begin(OMX_STATS_CALL call, uint32_t key);
+            void end(OMX_STATS_CALL call, uint32_t key, bool error = false);
+
+            /**
+             * One line summary, calls never made are skipped
+             */
+            std::string summary() const;
+            void reset();
+
+        private:
+            struct CallStats {
+                std::atomic<uint64_t> count {0};
+                std::atomic<uint64_t> errors {0};
+                std::atomic<uint64_t> total_ns {0};
+                std::atomic<int64_t> max_ns {0};
+                std::atomic<uint32_t> buckets[BUCKET_COUNT];
+            };
+
+            void logSummaryIfDue(int64_t now_ns);
+
+            static std::atomic<bool> enabled_;
+            static int64_t log_interval_ns_;
+
+            std::string name_;
+            CallStats calls_[OMX_STATS_CALL_COUNT];
+            std::atomic<int64_t> next_log_ns_ {0};
+
+            std::mutex pending_lock_;
+            std::map<uint64_t, int64_t> pending_;
+
+            OmxStats(OmxStats const&) = delete;
+            void operator=(OmxStats const&) = delete;
+    };
+
+    /**
+     * Scoped measurement of one OMX IL call
+     */
+    class OmxStatsTimer {
+        public:
+            OmxStatsTimer(OmxStats& stats, OMX_STATS_CALL call)
+                : stats_(stats)
+                , call_(call)
+                , start_(OmxStats::isEnabled() ? OmxStats::now() : 0) {}
+
+            void done(int err) {
+                if (start_)
+                    stats_.record(call_, OmxStats::now() - start_, err != 0);
+            }
+
+        private:
+            OmxStats& stats_;
+            OMX_STATS_CALL call_;
+            int64_t start_;
+    };
+
+} //namespace NDL_Esplayer
+
+#endif //NDL_DIRECTMEDIA2_OMX_CLIENTS_OMXSTATS_H_
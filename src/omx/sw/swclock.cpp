@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "swclock.h"
+#include "omx/omxclient.h"
+
+using namespace NDL_Esplayer;
+using namespace NDL_Esplayer::SwOmx;
+
+#define LOGTAG "swclock"
+#include "debug.h"
+
+SwClock::SwClock(const std::string& name)
+    : SwComponent(name)
+{
+    for (int i = 0; i < PORT_COUNT; i++)
+        addPort(PORT_START + i, OMX_DirOutput, OMX_PortDomainOther, 1, sizeof(OMX_TIME_MEDIATIMETYPE));
+}
+
+int64_t SwClock::mediaTimeLocked(int64_t now) const
+{
+    if (clock_state_ != OMX_TIME_ClockStateRunning)
+        return anchor_media_;
+    // scale is Q16, 0x10000 is normal speed
+    return anchor_media_ + (now - anchor_wall_) / 1000 * scale_ / 0x10000;
+}
+
+void SwClock::startClock(int64_t media_time, int64_t now)
+{
+    clock_state_ = OMX_TIME_ClockStateRunning;
+    anchor_media_ = media_time;
+    anchor_wall_ = now;
+    NDLLOG(LOGTAG, NDL_LOGD, "clock running from %lld", (long long)media_time);
+}
+
+void SwClock::wakeClients()
+{
+    for (int i = 0; i < PORT_COUNT; i++) {
+        auto client = getPeer(PORT_START + i);
+        if (client)
+            client->wake();
+    }
+}
+
+bool SwClock::timeUntil(OMX_U32 port_index, int64_t pts, int64_t* wait_ns)
+{
+    bool started = false;
+    bool running = false;
+    {
+        std::lock_guard<std::mutex> lock(clock_lock_);
+        int64_t now = now_ns();
+        switch (clock_state_) {
+            case OMX_TIME_ClockStateStopped:
+                return false;
+            case OMX_TIME_ClockStateWaitingForStartTime:
+                {
+                    OMX_U32 bit = 1 << (port_index - PORT_START);
+                    // start time is the earliest first timestamp of the waited clients
+                    if (!started_mask_ || pts < start_pts_)
+                        start_pts_ = pts;
+                    started_mask_ |= bit;
+                    if ((started_mask_ & wait_mask_) != wait_mask_)
+                        return false;
+                    startClock(start_pts_ + offset_, now);
+                    started = true;
+                    break;
+                }
+            default:
+                break;
+        }
+        // paused by scale 0 : clients wait for setConfig(scale) to wake them
+        running = (scale_ != 0);
+        if (running) {
+            int64_t diff_us = pts - mediaTimeLocked(now);
+            *wait_ns = diff_us > 0 ? diff_us * 1000 * 0x10000 / scale_ : 0;
+        }
+    }
+    if (started)
+        wakeClients();
+    return running;
+}
+
+OMX_ERRORTYPE SwClock::getConfig(OMX_INDEXTYPE index, OMX_PTR data)
+{
+    std::lock_guard<std::mutex> lock(clock_lock_);
+    switch ((int)index) {
+        case OMX_IndexConfigTimeClockState:
+            {
+                OMX_TIME_CONFIG_CLOCKSTATETYPE* state = (OMX_TIME_CONFIG_CLOCKSTATETYPE*)data;
+                state->eState = clock_state_;
+                state->nStartTime = to_omx_time(anchor_media_);
+                state->nOffset = to_omx_time(offset_);
+                state->nWaitMask = wait_mask_;
+                return OMX_ErrorNone;
+            }
+        case OMX_IndexConfigTimeCurrentMediaTime:
+            {
+                OMX_TIME_CONFIG_TIMESTAMPTYPE* time = (OMX_TIME_CONFIG_TIMESTAMPTYPE*)data;
+                time->nTimestamp = to_omx_time(mediaTimeLocked(now_ns()));
+                return OMX_ErrorNone;
+            }
+        case OMX_IndexConfigTimeScale:
+            {
+                OMX_TIME_CONFIG_SCALETYPE* scale = (OMX_TIME_CONFIG_SCALETYPE*)data;
+                scale->xScale = scale_;
+                return OMX_ErrorNone;
+            }
+        case OMX_IndexConfigTimeActiveRefClock:
+            {
+                OMX_TIME_CONFIG_ACTIVEREFCLOCKTYPE* ref = (OMX_TIME_CONFIG_ACTIVEREFCLOCKTYPE*)data;
+                ref->eClock = ref_clock_;
+                return OMX_ErrorNone;
+            }
+        default:
+            return OMX_ErrorUnsupportedIndex;
+    }
+}
+
+OMX_ERRORTYPE SwClock::setConfig(OMX_INDEXTYPE index, OMX_PTR data)
+{
+    {
+        std::lock_guard<std::mutex> lock(clock_lock_);
+        int64_t now = now_ns();
+        switch ((int)index) {
+            case OMX_IndexConfigTimeClockState:
+                {
+                    OMX_TIME_CONFIG_CLOCKSTATETYPE* state = (OMX_TIME_CONFIG_CLOCKSTATETYPE*)data;
+                    NDLLOG(LOGTAG, NDL_LOGD, "clock state %d -> %d, wait mask:0x%x",
+                            clock_state_, state->eState, state->nWaitMask);
+                    switch (state->eState) {
+                        case OMX_TIME_ClockStateRunning:
+                            startClock(from_omx_time(state->nStartTime), now);
+                            break;
+                        case OMX_TIME_ClockStateWaitingForStartTime:
+                            clock_state_ = OMX_TIME_ClockStateWaitingForStartTime;
+                            wait_mask_ = state->nWaitMask;
+                            offset_ = from_omx_time(state->nOffset);
+                            started_mask_ = 0;
+                            start_pts_ = 0;
+                            break;
+                        case OMX_TIME_ClockStateStopped:
+                            anchor_media_ = mediaTimeLocked(now);
+                            clock_state_ = OMX_TIME_ClockStateStopped;
+                            break;
+                        default:
+                            return OMX_ErrorBadParameter;
+                    }
+                    break;
+                }
+            case OMX_IndexConfigTimeScale:
+                {
+                    OMX_TIME_CONFIG_SCALETYPE* scale = (OMX_TIME_CONFIG_SCALETYPE*)data;
+                    // re-anchor so media time stays continuous across the speed change
+                    anchor_media_ = mediaTimeLocked(now);
+                    anchor_wall_ = now;
+                    scale_ = scale->xScale;
+                    break;
+                }
+            case OMX_IndexConfigTimeActiveRefClock:
+                {
+                    OMX_TIME_CONFIG_ACTIVEREFCLOCKTYPE* ref = (OMX_TIME_CONFIG_ACTIVEREFCLOCKTYPE*)data;
+                    ref_clock_ = ref->eClock;
+                    break;
+                }
+            default:
+                return SwComponent::setConfig(index, data);
+        }
+    }
+    wakeClients();
+    return OMX_ErrorNone;
+}
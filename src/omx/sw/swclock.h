@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef NDL_DIRECTMEDIA2_OMX_SW_SWCLOCK_H_
+#define NDL_DIRECTMEDIA2_OMX_SW_SWCLOCK_H_
+
+#include "swcomponent.h"
+
+namespace NDL_Esplayer {
+namespace SwOmx {
+
+    /**
+     * Clock component (OMX.broadcom.clock stand-in).
+     * media time runs on CLOCK_MONOTONIC from the start time decided by the
+     * first timestamps of the clients in the wait mask.
+     */
+    class SwClock : public SwComponent {
+        public:
+            enum {
+                PORT_START = 80,
+                PORT_COUNT = 6,
+            };
+
+            explicit SwClock(const std::string& name);
+            virtual ~SwClock() {}
+
+            /**
+             * Time left until pts is due for the client on the clock port.
+             * return false if the clock is not running yet(stopped or waiting for start time)
+             */
+            bool timeUntil(OMX_U32 port_index, int64_t pts, int64_t* wait_ns);
+
+        protected:
+            int64_t process() override { return -1; }
+
+            OMX_ERRORTYPE getConfig(OMX_INDEXTYPE index, OMX_PTR data) override;
+            OMX_ERRORTYPE setConfig(OMX_INDEXTYPE index, OMX_PTR data) override;
+
+        private:
+            int64_t mediaTimeLocked(int64_t now) const;
+            void startClock(int64_t media_time, int64_t now);
+            void wakeClients();
+
+            std::mutex clock_lock_;
+            OMX_TIME_CLOCKSTATE clock_state_ {OMX_TIME_ClockStateStopped};
+            OMX_TIME_REFCLOCKTYPE ref_clock_ {OMX_TIME_RefClockNone};
+            OMX_U32 wait_mask_ {0};
+            OMX_U32 started_mask_ {0};
+            int64_t start_pts_ {0};
+            int64_t offset_ {0};
+            OMX_S32 scale_ {0x10000};
+            int64_t anchor_media_ {0};  // microseconds
+            int64_t anchor_wall_ {0};   // nanoseconds
+    };
+
+} //namespace SwOmx
+} //namespace NDL_Esplayer
+
+#endif //NDL_DIRECTMEDIA2_OMX_SW_SWCLOCK_H_
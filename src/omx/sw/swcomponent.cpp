@@ -0,0 +1,653 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <chrono>
+
+#include "swcomponent.h"
+#include "omx/omxclient.h"
+
+using namespace NDL_Esplayer;
+using namespace NDL_Esplayer::SwOmx;
+
+#define LOGTAG "swomx"
+#include "debug.h"
+
+#define LOG_SW_CMD      NDL_LOGD
+#define LOG_SW_BUFFER   NDL_LOGV
+
+namespace {
+    int envOrDefault(const char* name, int value)
+    {
+        const char* env = getenv(name);
+        return env ? atoi(env) : value;
+    }
+}
+
+Config& NDL_Esplayer::SwOmx::config()
+{
+    static Config config = [] {
+        Config c;
+        c.video_decode_us = envOrDefault("NDL_SWOMX_VIDEO_DECODE_US", c.video_decode_us);
+        c.audio_decode_us = envOrDefault("NDL_SWOMX_AUDIO_DECODE_US", c.audio_decode_us);
+        c.render_us = envOrDefault("NDL_SWOMX_RENDER_US", c.render_us);
+        return c;
+    }();
+    return config;
+}
+
+SwComponent::SwComponent(const std::string& name)
+    : name_(name)
+{
+    memset(&handle_, 0, sizeof(handle_));
+    handle_.nSize = sizeof(handle_);
+    handle_.nVersion.nVersion = OMX_VERSION;
+    handle_.pComponentPrivate = (OMX_PTR)this;
+    handle_.GetComponentVersion = GetComponentVersion;
+    handle_.SendCommand = SendCommand;
+    handle_.GetParameter = GetParameter;
+    handle_.SetParameter = SetParameter;
+    handle_.GetConfig = GetConfig;
+    handle_.SetConfig = SetConfig;
+    handle_.GetExtensionIndex = GetExtensionIndex;
+    handle_.GetState = GetState;
+    handle_.ComponentTunnelRequest = ComponentTunnelRequest;
+    handle_.UseBuffer = UseBuffer;
+    handle_.AllocateBuffer = AllocateBuffer;
+    handle_.FreeBuffer = FreeBuffer;
+    handle_.EmptyThisBuffer = EmptyThisBuffer;
+    handle_.FillThisBuffer = FillThisBuffer;
+    handle_.SetCallbacks = SetCallbacks;
+    handle_.ComponentDeInit = ComponentDeInit;
+}
+
+SwComponent::~SwComponent()
+{
+    stop();
+    for (auto& item : ports_) {
+        for (auto buf : item.second.headers) {
+            if (buf->pPlatformPrivate)
+                free(buf->pBuffer);
+            delete buf;
+        }
+    }
+}
+
+void SwComponent::start()
+{
+    worker_ = std::thread([this] { run(); });
+}
+
+void SwComponent::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        quit_ = true;
+    }
+    cond_.notify_one();
+    if (worker_.joinable())
+        worker_.join();
+}
+
+int64_t SwComponent::now_ns()
+{
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+void SwComponent::addPort(OMX_U32 index, OMX_DIRTYPE dir, OMX_PORTDOMAINTYPE domain,
+        OMX_U32 buffer_count, OMX_U32 buffer_size)
+{
+    Port& port = ports_[index];
+    omx_init_structure(&port.def, OMX_PARAM_PORTDEFINITIONTYPE);
+    port.def.nPortIndex = index;
+    port.def.eDir = dir;
+    port.def.eDomain = domain;
+    port.def.nBufferCountActual = buffer_count;
+    port.def.nBufferCountMin = 1;
+    port.def.nBufferSize = buffer_size;
+    port.def.bEnabled = OMX_TRUE;
+    port.def.nBufferAlignment = 16;
+    if (domain == OMX_PortDomainVideo) {
+        port.def.format.video.nFrameWidth = 1920;
+        port.def.format.video.nFrameHeight = 1080;
+        port.def.format.video.nStride = 1920;
+        port.def.format.video.nSliceHeight = 1080;
+    }
+
+    omx_init_structure(&port.pcm, OMX_AUDIO_PARAM_PCMMODETYPE);
+    port.pcm.nPortIndex = index;
+    port.pcm.nChannels = 2;
+    port.pcm.nBitPerSample = 16;
+    port.pcm.nSamplingRate = 48000;
+    port.pcm.eNumData = OMX_NumericalDataSigned;
+    port.pcm.eEndian = OMX_EndianLittle;
+    port.pcm.bInterleaved = OMX_TRUE;
+    port.pcm.ePCMMode = OMX_AUDIO_PCMModeLinear;
+}
+
+SwComponent::Port* SwComponent::getPort(OMX_U32 index)
+{
+    auto item = ports_.find(index);
+    return item == ports_.end() ? nullptr : &item->second;
+}
+
+std::shared_ptr<SwComponent> SwComponent::getPeer(OMX_U32 index, OMX_U32* peer_port)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    Port* port = getPort(index);
+    if (!port)
+        return nullptr;
+    if (peer_port)
+        *peer_port = port->peer_port;
+    return port->peer.lock();
+}
+
+OMX_ERRORTYPE SwComponent::connect(OMX_U32 port_index, std::shared_ptr<SwComponent> peer, OMX_U32 peer_port_index)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    Port* port = getPort(port_index);
+    if (!port)
+        return OMX_ErrorBadPortIndex;
+    port->peer = peer;
+    port->peer_port = peer_port_index;
+    return OMX_ErrorNone;
+}
+
+void SwComponent::disconnect()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    for (auto& item : ports_)
+        item.second.peer.reset();
+}
+
+bool SwComponent::canDeliver(OMX_U32 port_index)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    Port* port = getPort(port_index);
+    if (!port || !port->def.bEnabled)
+        return false;
+    return port->frames.size() < port->def.nBufferCountActual;
+}
+
+bool SwComponent::deliver(OMX_U32 port_index, const Frame& frame)
+{
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        Port* port = getPort(port_index);
+        if (!port || (state_ != OMX_StateExecuting && state_ != OMX_StatePause && state_ != OMX_StateIdle)) {
+            NDLLOG(LOGTAG, LOG_SW_BUFFER, "%s drop frame on port %u (pts:%lld)", name_.c_str(), port_index, frame.pts);
+            return true;
+        }
+        // disabled port holds upstream until it is enabled again (port reconfiguration)
+        if (!port->def.bEnabled || port->frames.size() >= port->def.nBufferCountActual)
+            return false;
+        port->frames.push_back(frame);
+        kicked_ = true;
+    }
+    cond_.notify_one();
+    return true;
+}
+
+void SwComponent::wake()
+{
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        kicked_ = true;
+    }
+    cond_.notify_one();
+}
+
+void SwComponent::notifyUpstream(OMX_U32 port_index)
+{
+    auto peer = getPeer(port_index);
+    if (peer)
+        peer->wake();
+}
+
+void SwComponent::sendEvent(OMX_EVENTTYPE event, OMX_U32 data1, OMX_U32 data2, OMX_PTR data)
+{
+    if (callbacks_.EventHandler)
+        callbacks_.EventHandler(getHandle(), app_data_, event, data1, data2, data);
+}
+
+void SwComponent::returnBuffer(OMX_U32 port_index, OMX_BUFFERHEADERTYPE* buf)
+{
+    Port* port = getPort(port_index);
+    if (!port)
+        return;
+    if (port->def.eDir == OMX_DirInput) {
+        if (callbacks_.EmptyBufferDone)
+            callbacks_.EmptyBufferDone(getHandle(), app_data_, buf);
+    } else {
+        if (callbacks_.FillBufferDone)
+            callbacks_.FillBufferDone(getHandle(), app_data_, buf);
+    }
+}
+
+void SwComponent::returnAllBuffers(OMX_U32 port_index)
+{
+    std::deque<OMX_BUFFERHEADERTYPE*> buffers;
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        Port* port = getPort(port_index);
+        if (!port)
+            return;
+        buffers.swap(port->queue);
+        port->frames.clear();
+        if (port->def.eDir == OMX_DirOutput) {
+            for (auto buf : buffers)
+                buf->nFilledLen = 0;
+        }
+    }
+    for (auto buf : buffers)
+        returnBuffer(port_index, buf);
+}
+
+void SwComponent::flushPort(OMX_U32 port_index)
+{
+    returnAllBuffers(port_index);
+    onFlush(port_index);
+    notifyUpstream(port_index);
+    NDLLOG(LOGTAG, LOG_SW_CMD, "%s flush done port %u", name_.c_str(), port_index);
+    sendEvent(OMX_EventCmdComplete, OMX_CommandFlush, port_index);
+}
+
+void SwComponent::handleCommand(const Command& command)
+{
+    switch (command.cmd) {
+        case OMX_CommandStateSet:
+            {
+                OMX_STATETYPE state = (OMX_STATETYPE)command.param;
+                OMX_STATETYPE previous;
+                {
+                    std::lock_guard<std::mutex> lock(lock_);
+                    previous = state_;
+                }
+                if (previous == state) {
+                    sendEvent(OMX_EventError, (OMX_U32)OMX_ErrorSameState, state);
+                    break;
+                }
+                // leaving executing/pause : all the buffers go back to the client
+                if (state == OMX_StateIdle || state == OMX_StateLoaded) {
+                    for (auto& item : ports_)
+                        returnAllBuffers(item.first);
+                }
+                {
+                    std::lock_guard<std::mutex> lock(lock_);
+                    state_ = state;
+                }
+                onStateChanged(state);
+                NDLLOG(LOGTAG, LOG_SW_CMD, "%s state %d -> %d", name_.c_str(), previous, state);
+                sendEvent(OMX_EventCmdComplete, OMX_CommandStateSet, state);
+                break;
+            }
+        case OMX_CommandFlush:
+            if (command.param == OMX_ALL) {
+                std::vector<OMX_U32> enabled;
+                {
+                    std::lock_guard<std::mutex> lock(lock_);
+                    for (auto& item : ports_)
+                        if (item.second.def.bEnabled)
+                            enabled.push_back(item.first);
+                }
+                for (auto index : enabled)
+                    flushPort(index);
+            } else {
+                flushPort(command.param);
+            }
+            break;
+        case OMX_CommandPortDisable:
+        case OMX_CommandPortEnable:
+            {
+                bool enable = (command.cmd == OMX_CommandPortEnable);
+                std::vector<OMX_U32> targets;
+                {
+                    std::lock_guard<std::mutex> lock(lock_);
+                    for (auto& item : ports_)
+                        if (command.param == OMX_ALL || item.first == command.param)
+                            targets.push_back(item.first);
+                }
+                for (auto index : targets) {
+                    if (!enable)
+                        returnAllBuffers(index);
+                    {
+                        std::lock_guard<std::mutex> lock(lock_);
+                        ports_[index].def.bEnabled = enable ? OMX_TRUE : OMX_FALSE;
+                    }
+                    if (!enable)
+                        onFlush(index);
+                    onPortEnabled(index, enable);
+                    notifyUpstream(index);
+                    sendEvent(OMX_EventCmdComplete, command.cmd, index);
+                }
+                break;
+            }
+        default:
+            sendEvent(OMX_EventError, (OMX_U32)OMX_ErrorNotImplemented, command.cmd);
+            break;
+    }
+}
+
+void SwComponent::run()
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    while (!quit_) {
+        if (!commands_.empty()) {
+            Command command = commands_.front();
+            commands_.pop_front();
+            lock.unlock();
+            handleCommand(command);
+            lock.lock();
+            continue;
+        }
+
+        kicked_ = false;
+        int64_t wait_ns = -1;
+        if (state_ == OMX_StateExecuting) {
+            lock.unlock();
+            wait_ns = process();
+            lock.lock();
+            if (wait_ns == 0)
+                continue;
+        }
+
+        if (quit_ || kicked_ || !commands_.empty())
+            continue;
+
+        if (wait_ns > 0)
+            cond_.wait_for(lock, std::chrono::nanoseconds(wait_ns));
+        else
+            cond_.wait(lock);
+    }
+}
+
+OMX_ERRORTYPE SwComponent::getParameter(OMX_INDEXTYPE index, OMX_PTR data)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    switch ((int)index) {
+        case OMX_IndexParamAudioInit:
+        case OMX_IndexParamVideoInit:
+        case OMX_IndexParamImageInit:
+        case OMX_IndexParamOtherInit:
+            {
+                OMX_PORTDOMAINTYPE domain =
+                    index == OMX_IndexParamAudioInit ? OMX_PortDomainAudio :
+                    index == OMX_IndexParamVideoInit ? OMX_PortDomainVideo :
+                    index == OMX_IndexParamImageInit ? OMX_PortDomainImage : OMX_PortDomainOther;
+                OMX_PORT_PARAM_TYPE* param = (OMX_PORT_PARAM_TYPE*)data;
+                param->nPorts = 0;
+                param->nStartPortNumber = 0;
+                for (auto& item : ports_) {
+                    if (item.second.def.eDomain != domain)
+                        continue;
+                    if (param->nPorts++ == 0)
+                        param->nStartPortNumber = item.first;
+                }
+                return OMX_ErrorNone;
+            }
+        case OMX_IndexParamPortDefinition:
+            {
+                OMX_PARAM_PORTDEFINITIONTYPE* def = (OMX_PARAM_PORTDEFINITIONTYPE*)data;
+                Port* port = getPort(def->nPortIndex);
+                if (!port)
+                    return OMX_ErrorBadPortIndex;
+                port->def.bPopulated = port->headers.size() >= port->def.nBufferCountActual ? OMX_TRUE : OMX_FALSE;
+                memcpy(def, &port->def, sizeof(*def));
+                return OMX_ErrorNone;
+            }
+        case OMX_IndexParamAudioPcm:
+            {
+                OMX_AUDIO_PARAM_PCMMODETYPE* pcm = (OMX_AUDIO_PARAM_PCMMODETYPE*)data;
+                Port* port = getPort(pcm->nPortIndex);
+                if (!port)
+                    return OMX_ErrorBadPortIndex;
+                memcpy(pcm, &port->pcm, sizeof(*pcm));
+                return OMX_ErrorNone;
+            }
+        default:
+            return OMX_ErrorUnsupportedIndex;
+    }
+}
+
+OMX_ERRORTYPE SwComponent::setParameter(OMX_INDEXTYPE index, OMX_PTR data)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    switch ((int)index) {
+        case OMX_IndexParamPortDefinition:
+            {
+                OMX_PARAM_PORTDEFINITIONTYPE* def = (OMX_PARAM_PORTDEFINITIONTYPE*)data;
+                Port* port = getPort(def->nPortIndex);
+                if (!port)
+                    return OMX_ErrorBadPortIndex;
+                port->def.nBufferCountActual = def->nBufferCountActual;
+                port->def.nBufferSize = def->nBufferSize;
+                port->def.format = def->format;
+                return OMX_ErrorNone;
+            }
+        case OMX_IndexParamAudioPcm:
+            {
+                OMX_AUDIO_PARAM_PCMMODETYPE* pcm = (OMX_AUDIO_PARAM_PCMMODETYPE*)data;
+                Port* port = getPort(pcm->nPortIndex);
+                if (!port)
+                    return OMX_ErrorBadPortIndex;
+                memcpy(&port->pcm, pcm, sizeof(*pcm));
+                return OMX_ErrorNone;
+            }
+        default:
+            // vendor and codec specific parameters are accepted and ignored
+            NDLLOG(LOGTAG, NDL_LOGV, "%s ignore parameter 0x%x", name_.c_str(), index);
+            return OMX_ErrorNone;
+    }
+}
+
+OMX_ERRORTYPE SwComponent::getConfig(OMX_INDEXTYPE index, OMX_PTR data)
+{
+    return OMX_ErrorUnsupportedIndex;
+}
+
+OMX_ERRORTYPE SwComponent::setConfig(OMX_INDEXTYPE index, OMX_PTR data)
+{
+    // display region, audio destination and the others are accepted and ignored
+    NDLLOG(LOGTAG, NDL_LOGV, "%s ignore config 0x%x", name_.c_str(), index);
+    return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE SwComponent::addBuffer(OMX_BUFFERHEADERTYPE** buf, OMX_U32 port_index,
+        OMX_PTR app_private, OMX_U32 size, OMX_U8* data, bool allocated)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    Port* port = getPort(port_index);
+    if (!port)
+        return OMX_ErrorBadPortIndex;
+
+    OMX_BUFFERHEADERTYPE* header = new OMX_BUFFERHEADERTYPE;
+    omx_init_structure(header, OMX_BUFFERHEADERTYPE);
+    header->pBuffer = data;
+    header->nAllocLen = size;
+    header->pAppPrivate = app_private;
+    // mark the buffer memory owned by component
+    header->pPlatformPrivate = allocated ? (OMX_PTR)this : nullptr;
+    if (port->def.eDir == OMX_DirInput)
+        header->nInputPortIndex = port_index;
+    else
+        header->nOutputPortIndex = port_index;
+    port->headers.push_back(header);
+    *buf = header;
+    return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE SwComponent::queueBuffer(OMX_U32 port_index, OMX_BUFFERHEADERTYPE* buf)
+{
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        if (state_ != OMX_StateExecuting && state_ != OMX_StatePause && state_ != OMX_StateIdle)
+            return OMX_ErrorIncorrectStateOperation;
+        Port* port = getPort(port_index);
+        if (!port)
+            return OMX_ErrorBadPortIndex;
+        port->queue.push_back(buf);
+        kicked_ = true;
+    }
+    cond_.notify_one();
+    return OMX_ErrorNone;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// OMX IL entry points
+
+OMX_ERRORTYPE SwComponent::GetComponentVersion(OMX_HANDLETYPE handle, OMX_STRING name,
+        OMX_VERSIONTYPE* component_version, OMX_VERSIONTYPE* spec_version, OMX_UUIDTYPE* uuid)
+{
+    SwComponent* component = self(handle);
+    strncpy(name, component->name_.c_str(), OMX_MAX_STRINGNAME_SIZE - 1);
+    name[OMX_MAX_STRINGNAME_SIZE - 1] = '\0';
+    component_version->nVersion = OMX_VERSION;
+    spec_version->nVersion = OMX_VERSION;
+    return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE SwComponent::SendCommand(OMX_HANDLETYPE handle, OMX_COMMANDTYPE cmd,
+        OMX_U32 param, OMX_PTR cmd_data)
+{
+    SwComponent* component = self(handle);
+    if (cmd == OMX_CommandFlush || cmd == OMX_CommandPortDisable || cmd == OMX_CommandPortEnable) {
+        std::lock_guard<std::mutex> lock(component->lock_);
+        if (param != OMX_ALL && !component->getPort(param))
+            return OMX_ErrorBadPortIndex;
+    }
+    {
+        std::lock_guard<std::mutex> lock(component->lock_);
+        component->commands_.push_back(Command{cmd, param});
+    }
+    component->cond_.notify_one();
+    return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE SwComponent::GetParameter(OMX_HANDLETYPE handle, OMX_INDEXTYPE index, OMX_PTR data)
+{
+    return data ? self(handle)->getParameter(index, data) : OMX_ErrorBadParameter;
+}
+
+OMX_ERRORTYPE SwComponent::SetParameter(OMX_HANDLETYPE handle, OMX_INDEXTYPE index, OMX_PTR data)
+{
+    return data ? self(handle)->setParameter(index, data) : OMX_ErrorBadParameter;
+}
+
+OMX_ERRORTYPE SwComponent::GetConfig(OMX_HANDLETYPE handle, OMX_INDEXTYPE index, OMX_PTR data)
+{
+    return data ? self(handle)->getConfig(index, data) : OMX_ErrorBadParameter;
+}
+
+OMX_ERRORTYPE SwComponent::SetConfig(OMX_HANDLETYPE handle, OMX_INDEXTYPE index, OMX_PTR data)
+{
+    return data ? self(handle)->setConfig(index, data) : OMX_ErrorBadParameter;
+}
+
+OMX_ERRORTYPE SwComponent::GetExtensionIndex(OMX_HANDLETYPE handle, OMX_STRING name, OMX_INDEXTYPE* index)
+{
+    return OMX_ErrorUnsupportedIndex;
+}
+
+OMX_ERRORTYPE SwComponent::GetState(OMX_HANDLETYPE handle, OMX_STATETYPE* state)
+{
+    SwComponent* component = self(handle);
+    std::lock_guard<std::mutex> lock(component->lock_);
+    *state = component->state_;
+    return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE SwComponent::ComponentTunnelRequest(OMX_HANDLETYPE handle, OMX_U32 port,
+        OMX_HANDLETYPE peer, OMX_U32 peer_port, OMX_TUNNELSETUPTYPE* setup)
+{
+    // tunnels are linked by OmxCore::setupTunnel
+    return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE SwComponent::UseBuffer(OMX_HANDLETYPE handle, OMX_BUFFERHEADERTYPE** buf,
+        OMX_U32 port, OMX_PTR app_private, OMX_U32 size, OMX_U8* data)
+{
+    return self(handle)->addBuffer(buf, port, app_private, size, data, false);
+}
+
+OMX_ERRORTYPE SwComponent::AllocateBuffer(OMX_HANDLETYPE handle, OMX_BUFFERHEADERTYPE** buf,
+        OMX_U32 port, OMX_PTR app_private, OMX_U32 size)
+{
+    OMX_U8* data = (OMX_U8*)malloc(size ? size : 1);
+    if (!data)
+        return OMX_ErrorInsufficientResources;
+    OMX_ERRORTYPE err = self(handle)->addBuffer(buf, port, app_private, size, data, true);
+    if (err != OMX_ErrorNone)
+        free(data);
+    return err;
+}
+
+OMX_ERRORTYPE SwComponent::FreeBuffer(OMX_HANDLETYPE handle, OMX_U32 port_index, OMX_BUFFERHEADERTYPE* buf)
+{
+    SwComponent* component = self(handle);
+    std::lock_guard<std::mutex> lock(component->lock_);
+    Port* port = component->getPort(port_index);
+    if (!port)
+        return OMX_ErrorBadPortIndex;
+
+    auto item = std::find(port->headers.begin(), port->headers.end(), buf);
+    if (item == port->headers.end())
+        return OMX_ErrorBadParameter;
+    port->headers.erase(item);
+
+    auto queued = std::find(port->queue.begin(), port->queue.end(), buf);
+    if (queued != port->queue.end())
+        port->queue.erase(queued);
+
+    if (buf->pPlatformPrivate)
+        free(buf->pBuffer);
+    delete buf;
+    return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE SwComponent::EmptyThisBuffer(OMX_HANDLETYPE handle, OMX_BUFFERHEADERTYPE* buf)
+{
+    NDLLOG(LOGTAG, LOG_SW_BUFFER, "%s EmptyThisBuffer port:%u len:%u flags:0x%x",
+            self(handle)->name_.c_str(), buf->nInputPortIndex, buf->nFilledLen, buf->nFlags);
+    return self(handle)->queueBuffer(buf->nInputPortIndex, buf);
+}
+
+OMX_ERRORTYPE SwComponent::FillThisBuffer(OMX_HANDLETYPE handle, OMX_BUFFERHEADERTYPE* buf)
+{
+    return self(handle)->queueBuffer(buf->nOutputPortIndex, buf);
+}
+
+OMX_ERRORTYPE SwComponent::SetCallbacks(OMX_HANDLETYPE handle, OMX_CALLBACKTYPE* callbacks, OMX_PTR app_data)
+{
+    SwComponent* component = self(handle);
+    component->callbacks_ = *callbacks;
+    component->app_data_ = app_data;
+    return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE SwComponent::ComponentDeInit(OMX_HANDLETYPE handle)
+{
+    self(handle)->stop();
+    return OMX_ErrorNone;
+}
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef NDL_DIRECTMEDIA2_OMX_SW_SWCOMPONENT_H_
+#define NDL_DIRECTMEDIA2_OMX_SW_SWCOMPONENT_H_
+
+#include <map>
+#include <deque>
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <stdint.h>
+
+#include <OMX_Core.h>
+#include <OMX_Component.h>
+
+namespace NDL_Esplayer {
+namespace SwOmx {
+
+    /**
+     * Cost of the loopback components in microseconds per buffer.
+     * Default values can be overridden by environment variables
+     *  NDL_SWOMX_VIDEO_DECODE_US, NDL_SWOMX_AUDIO_DECODE_US, NDL_SWOMX_RENDER_US
+     */
+    struct Config {
+        int video_decode_us {2000};
+        int audio_decode_us {200};
+        int render_us {0};
+    };
+    Config& config();
+
+    /**
+     * Vendor events sent by the renderers.
+     * same values with OMXdrm render event and Component::EVENT_RENDER
+     */
+    enum {
+        EVENT_VIDEO_RENDER = OMX_EventVendorStartUnused,
+        EVENT_AUDIO_RENDER = OMX_EventVendorStartUnused + 0x10000,
+    };
+
+    /**
+     * Decoded frame passed through a tunnel. Loopback components carry no payload.
+     */
+    struct Frame {
+        int64_t pts;
+        uint32_t flags;
+        uint32_t size;
+    };
+
+    class SwComponent : public std::enable_shared_from_this<SwComponent> {
+        public:
+            explicit SwComponent(const std::string& name);
+            virtual ~SwComponent();
+
+            OMX_HANDLETYPE getHandle() { return (OMX_HANDLETYPE)&handle_; }
+            const std::string& getName() const { return name_; }
+
+            void start();
+            void stop();
+
+            /**
+             * Tunnel : link one port to the port of the peer component.
+             */
+            OMX_ERRORTYPE connect(OMX_U32 port_index, std::shared_ptr<SwComponent> peer, OMX_U32 peer_port_index);
+            void disconnect();
+
+            /**
+             * Push a frame from the tunneled upstream component.
+             * return false if the port is disabled or its queue is full, upstream retries on wake()
+             */
+            bool deliver(OMX_U32 port_index, const Frame& frame);
+            bool canDeliver(OMX_U32 port_index);
+
+            /**
+             * Wake the worker thread to re-evaluate pending work
+             */
+            void wake();
+
+        protected:
+            struct Port {
+                OMX_PARAM_PORTDEFINITIONTYPE def;
+                OMX_AUDIO_PARAM_PCMMODETYPE pcm;
+                std::vector<OMX_BUFFERHEADERTYPE*> headers;  // buffers allocated on the port
+                std::deque<OMX_BUFFERHEADERTYPE*> queue;     // buffers owned by component
+                std::deque<Frame> frames;                    // frames from tunnel
+                std::weak_ptr<SwComponent> peer;
+                OMX_U32 peer_port {0};
+            };
+
+            void addPort(OMX_U32 index, OMX_DIRTYPE dir, OMX_PORTDOMAINTYPE domain,
+                    OMX_U32 buffer_count, OMX_U32 buffer_size);
+            Port* getPort(OMX_U32 index);
+            std::shared_ptr<SwComponent> getPeer(OMX_U32 index, OMX_U32* peer_port = nullptr);
+
+            /**
+             * Called on worker thread in executing state without lock.
+             * return 0 to be called again, >0 to wait at most nanoseconds, <0 to wait for wake()
+             */
+            virtual int64_t process() = 0;
+            virtual void onFlush(OMX_U32 port_index) {}
+            virtual void onPortEnabled(OMX_U32 port_index, bool enable) {}
+            virtual void onStateChanged(OMX_STATETYPE state) {}
+
+            virtual OMX_ERRORTYPE getParameter(OMX_INDEXTYPE index, OMX_PTR data);
+            virtual OMX_ERRORTYPE setParameter(OMX_INDEXTYPE index, OMX_PTR data);
+            virtual OMX_ERRORTYPE getConfig(OMX_INDEXTYPE index, OMX_PTR data);
+            virtual OMX_ERRORTYPE setConfig(OMX_INDEXTYPE index, OMX_PTR data);
+
+            void sendEvent(OMX_EVENTTYPE event, OMX_U32 data1, OMX_U32 data2, OMX_PTR data = nullptr);
+            void returnBuffer(OMX_U32 port_index, OMX_BUFFERHEADERTYPE* buf);
+            void notifyUpstream(OMX_U32 port_index);
+
+            static int64_t now_ns();
+
+        protected:
+            std::string name_;
+            OMX_STATETYPE state_ {OMX_StateLoaded};
+            std::map<OMX_U32, Port> ports_;
+            std::mutex lock_;
+
+        private:
+            struct Command {
+                OMX_COMMANDTYPE cmd;
+                OMX_U32 param;
+            };
+
+            void run();
+            void handleCommand(const Command& command);
+            void flushPort(OMX_U32 port_index);
+            void returnAllBuffers(OMX_U32 port_index);
+
+            static SwComponent* self(OMX_HANDLETYPE handle) {
+                return (SwComponent*)((OMX_COMPONENTTYPE*)handle)->pComponentPrivate;
+            }
+
+            // OMX IL entry points
+            static OMX_ERRORTYPE GetComponentVersion(OMX_HANDLETYPE handle, OMX_STRING name,
+                    OMX_VERSIONTYPE* component_version, OMX_VERSIONTYPE* spec_version, OMX_UUIDTYPE* uuid);
+            static OMX_ERRORTYPE SendCommand(OMX_HANDLETYPE handle, OMX_COMMANDTYPE cmd,
+                    OMX_U32 param, OMX_PTR cmd_data);
+            static OMX_ERRORTYPE GetParameter(OMX_HANDLETYPE handle, OMX_INDEXTYPE index, OMX_PTR data);
+            static OMX_ERRORTYPE SetParameter(OMX_HANDLETYPE handle, OMX_INDEXTYPE index, OMX_PTR data);
+            static OMX_ERRORTYPE GetConfig(OMX_HANDLETYPE handle, OMX_INDEXTYPE index, OMX_PTR data);
+            static OMX_ERRORTYPE SetConfig(OMX_HANDLETYPE handle, OMX_INDEXTYPE index, OMX_PTR data);
+            static OMX_ERRORTYPE GetExtensionIndex(OMX_HANDLETYPE handle, OMX_STRING name, OMX_INDEXTYPE* index);
+            static OMX_ERRORTYPE GetState(OMX_HANDLETYPE handle, OMX_STATETYPE* state);
+            static OMX_ERRORTYPE ComponentTunnelRequest(OMX_HANDLETYPE handle, OMX_U32 port,
+                    OMX_HANDLETYPE peer, OMX_U32 peer_port, OMX_TUNNELSETUPTYPE* setup);
+            static OMX_ERRORTYPE UseBuffer(OMX_HANDLETYPE handle, OMX_BUFFERHEADERTYPE** buf,
+                    OMX_U32 port, OMX_PTR app_private, OMX_U32 size, OMX_U8* data);
+            static OMX_ERRORTYPE AllocateBuffer(OMX_HANDLETYPE handle, OMX_BUFFERHEADERTYPE** buf,
+                    OMX_U32 port, OMX_PTR app_private, OMX_U32 size);
+            static OMX_ERRORTYPE FreeBuffer(OMX_HANDLETYPE handle, OMX_U32 port, OMX_BUFFERHEADERTYPE* buf);
+            static OMX_ERRORTYPE EmptyThisBuffer(OMX_HANDLETYPE handle, OMX_BUFFERHEADERTYPE* buf);
+            static OMX_ERRORTYPE FillThisBuffer(OMX_HANDLETYPE handle, OMX_BUFFERHEADERTYPE* buf);
+            static OMX_ERRORTYPE SetCallbacks(OMX_HANDLETYPE handle, OMX_CALLBACKTYPE* callbacks, OMX_PTR app_data);
+            static OMX_ERRORTYPE ComponentDeInit(OMX_HANDLETYPE handle);
+
+            OMX_ERRORTYPE addBuffer(OMX_BUFFERHEADERTYPE** buf, OMX_U32 port, OMX_PTR app_private,
+                    OMX_U32 size, OMX_U8* data, bool allocated);
+            OMX_ERRORTYPE queueBuffer(OMX_U32 port_index, OMX_BUFFERHEADERTYPE* buf);
+
+        private:
+            OMX_COMPONENTTYPE handle_;
+            OMX_CALLBACKTYPE callbacks_ {nullptr, nullptr, nullptr};
+            OMX_PTR app_data_ {nullptr};
+
+            std::thread worker_;
+            std::condition_variable cond_;
+            std::deque<Command> commands_;
+            bool kicked_ {false};
+            bool quit_ {false};
+
+            SwComponent(SwComponent const&) = delete;
+            void operator=(SwComponent const&) = delete;
+    };
+
+    /**
+     * Create software component by Broadcom/DRM component name
+     */
+    std::shared_ptr<SwComponent> createComponent(const std::string& name);
+
+} //namespace SwOmx
+} //namespace NDL_Esplayer
+
+#endif //NDL_DIRECTMEDIA2_OMX_SW_SWCOMPONENT_H_
@@ -0,0 +1,306 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <unistd.h>
+#include <algorithm>
+
+#include "swloopback.h"
+#include "omx/omxclient.h"
+#include "swclock.h"
+
+using namespace NDL_Esplayer;
+using namespace NDL_Esplayer::SwOmx;
+
+#define LOGTAG "swloopback"
+#include "debug.h"
+
+#define LOG_SW_FRAME    NDL_LOGV
+
+///////////////////////////////////////////////////////////////////////////////
+// SwDecoder
+
+SwDecoder::SwDecoder(const std::string& name, OMX_PORTDOMAINTYPE domain,
+        OMX_U32 input_port, OMX_U32 output_port, int cost_us, bool send_port_settings)
+    : SwComponent(name)
+    , input_port_(input_port)
+    , output_port_(output_port)
+    , cost_us_(cost_us)
+    , send_port_settings_(send_port_settings)
+{
+    if (domain == OMX_PortDomainVideo) {
+        addPort(input_port, OMX_DirInput, domain, 20, 81920);
+        addPort(output_port, OMX_DirOutput, domain, 4, 4096);
+    } else {
+        addPort(input_port, OMX_DirInput, domain, 16, 65536);
+        addPort(output_port, OMX_DirOutput, domain, 16, 65536);
+    }
+}
+
+void SwDecoder::onFlush(OMX_U32 port_index)
+{
+    // output port disable keeps the pending frame for the reconfigured port
+    if (port_index != input_port_)
+        return;
+    has_pending_ = false;
+    accumulating_ = false;
+}
+
+void SwDecoder::onPortEnabled(OMX_U32 port_index, bool enable)
+{
+    if (port_index == output_port_ && enable)
+        wait_reconfigure_ = false;
+}
+
+void SwDecoder::onStateChanged(OMX_STATETYPE state)
+{
+    if (state == OMX_StateLoaded || state == OMX_StateIdle) {
+        has_pending_ = false;
+        accumulating_ = false;
+        wait_reconfigure_ = false;
+    }
+    if (state == OMX_StateLoaded)
+        port_settings_sent_ = false;
+}
+
+bool SwDecoder::output(const Frame& frame)
+{
+    OMX_U32 peer_port = 0;
+    auto peer = getPeer(output_port_, &peer_port);
+    OMX_BUFFERHEADERTYPE* buf = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        Port* out = getPort(output_port_);
+        if (!out->def.bEnabled)
+            return false;
+        if (!peer) {
+            if (out->queue.empty())
+                return false;
+            buf = out->queue.front();
+            out->queue.pop_front();
+        }
+    }
+
+    if (peer)
+        return peer->deliver(peer_port, frame);
+
+    // non-tunnel mode : the frame goes to a client output buffer without payload
+    buf->nFilledLen = std::min(frame.size, buf->nAllocLen);
+    buf->nOffset = 0;
+    buf->nFlags = frame.flags;
+    buf->nTimeStamp = to_omx_time(frame.pts);
+    returnBuffer(output_port_, buf);
+    return true;
+}
+
+int64_t SwDecoder::process()
+{
+    if (wait_reconfigure_)
+        return -1;
+
+    if (has_pending_) {
+        if (!output(pending_))
+            return -1;
+        has_pending_ = false;
+    }
+
+    OMX_BUFFERHEADERTYPE* buf = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        Port* in = getPort(input_port_);
+        if (!in->def.bEnabled || in->queue.empty())
+            return -1;
+        buf = in->queue.front();
+        in->queue.pop_front();
+    }
+
+    bool codec_config = (buf->nFlags & OMX_BUFFERFLAG_CODECCONFIG);
+    if (!codec_config) {
+        if (buf->nFilledLen && cost_us_ > 0)
+            usleep(cost_us_);
+        if (!accumulating_) {
+            accumulated_.pts = from_omx_time(buf->nTimeStamp);
+            accumulated_.flags = 0;
+            accumulated_.size = 0;
+            accumulating_ = true;
+        }
+        accumulated_.size += buf->nFilledLen;
+        accumulated_.flags |= buf->nFlags;
+    }
+    OMX_U32 flags = buf->nFlags;
+    returnBuffer(input_port_, buf);
+
+    if (codec_config || !(flags & (OMX_BUFFERFLAG_ENDOFFRAME | OMX_BUFFERFLAG_EOS)))
+        return 0;
+
+    Frame frame = accumulated_;
+    accumulating_ = false;
+    // decode-only frames are decoded for reference but never displayed
+    if ((frame.flags & OMX_BUFFERFLAG_DECODEONLY) && !(frame.flags & OMX_BUFFERFLAG_EOS))
+        return 0;
+    frame.flags &= ~(OMX_BUFFERFLAG_DECODEONLY | OMX_BUFFERFLAG_CODECCONFIG);
+
+    NDLLOG(LOGTAG, LOG_SW_FRAME, "%s decoded pts:%lld size:%u flags:0x%x",
+            name_.c_str(), (long long)frame.pts, frame.size, frame.flags);
+
+    if (send_port_settings_ && !port_settings_sent_ && frame.size) {
+        // first picture : output port is reconfigured by the client before any frame goes out
+        port_settings_sent_ = true;
+        wait_reconfigure_ = true;
+        pending_ = frame;
+        has_pending_ = true;
+        sendEvent(OMX_EventPortSettingsChanged, output_port_, 0);
+        return 0;
+    }
+
+    if (!output(frame)) {
+        pending_ = frame;
+        has_pending_ = true;
+        return -1;
+    }
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// SwSink
+
+SwSink::SwSink(const std::string& name, OMX_PORTDOMAINTYPE domain,
+        OMX_U32 input_port, OMX_U32 output_port, OMX_U32 clock_port,
+        OMX_U32 input_count, int render_event)
+    : SwComponent(name)
+    , input_port_(input_port)
+    , output_port_(output_port)
+    , clock_port_(clock_port)
+    , render_event_(render_event)
+{
+    addPort(input_port, OMX_DirInput, domain, input_count, 4096);
+    if (output_port != NO_PORT)
+        addPort(output_port, OMX_DirOutput, domain, input_count, 4096);
+    if (clock_port != NO_PORT)
+        addPort(clock_port, OMX_DirInput, OMX_PortDomainOther, 1, sizeof(OMX_TIME_MEDIATIMETYPE));
+}
+
+void SwSink::render(const Frame& frame)
+{
+    if (config().render_us > 0)
+        usleep(config().render_us);
+
+    int64_t pts = frame.pts;
+    if (frame.size && render_event_)
+        sendEvent((OMX_EVENTTYPE)render_event_, input_port_, 0, &pts);
+    if (frame.flags & OMX_BUFFERFLAG_EOS) {
+        NDLLOG(LOGTAG, NDL_LOGD, "%s end of stream", name_.c_str());
+        sendEvent(OMX_EventBufferFlag, input_port_, frame.flags);
+    }
+}
+
+int64_t SwSink::process()
+{
+    Frame frame;
+    OMX_BUFFERHEADERTYPE* buf = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        Port* in = getPort(input_port_);
+        if (!in->def.bEnabled)
+            return -1;
+        if (!in->frames.empty()) {
+            frame = in->frames.front();
+        } else if (!in->queue.empty()) {
+            // non-tunnel mode : client buffer fed directly
+            buf = in->queue.front();
+            frame.pts = from_omx_time(buf->nTimeStamp);
+            frame.flags = buf->nFlags;
+            frame.size = buf->nFilledLen;
+        } else {
+            return -1;
+        }
+    }
+
+    // end of stream marker goes out without waiting for the clock
+    if (frame.size && clock_port_ != NO_PORT) {
+        OMX_U32 clock_output = 0;
+        auto clock = std::dynamic_pointer_cast<SwClock>(getPeer(clock_port_, &clock_output));
+        if (clock) {
+            int64_t wait_ns = 0;
+            if (!clock->timeUntil(clock_output, frame.pts, &wait_ns))
+                return -1;
+            if (wait_ns > 0)
+                return wait_ns;
+        }
+    }
+
+    OMX_U32 peer_port = 0;
+    std::shared_ptr<SwComponent> peer;
+    if (output_port_ != NO_PORT) {
+        peer = getPeer(output_port_, &peer_port);
+        if (peer && !peer->canDeliver(peer_port))
+            return -1;
+    }
+
+    {
+        // flush and port disable run on this thread, so the front is still the same
+        std::lock_guard<std::mutex> lock(lock_);
+        Port* in = getPort(input_port_);
+        if (buf)
+            in->queue.pop_front();
+        else
+            in->frames.pop_front();
+    }
+
+    if (buf)
+        returnBuffer(input_port_, buf);
+    else
+        notifyUpstream(input_port_);
+
+    if (peer)
+        peer->deliver(peer_port, frame);
+    else
+        render(frame);
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<SwComponent> NDL_Esplayer::SwOmx::createComponent(const std::string& name)
+{
+    std::shared_ptr<SwComponent> component;
+    if (name == "OMX.broadcom.clock")
+        component = std::make_shared<SwClock>(name);
+    else if (name == "OMX.broadcom.video_decode")
+        component = std::make_shared<SwDecoder>(name, OMX_PortDomainVideo, 130, 131,
+                config().video_decode_us, true);
+    else if (name == "OMX.broadcom.audio_decode")
+        component = std::make_shared<SwDecoder>(name, OMX_PortDomainAudio, 120, 121,
+                config().audio_decode_us, false);
+    else if (name == "OMX.broadcom.video_scheduler")
+        component = std::make_shared<SwSink>(name, OMX_PortDomainVideo, 10, 11, 12, 4, 0);
+    else if (name == "OMX.drm.video_render" || name == "OMX.broadcom.video_render")
+        component = std::make_shared<SwSink>(name, OMX_PortDomainVideo, 90, SwSink::NO_PORT,
+                SwSink::NO_PORT, 2, EVENT_VIDEO_RENDER);
+    else if (name == "OMX.broadcom.audio_render" || name == "OMX.alsa.audio_render")
+        component = std::make_shared<SwSink>(name, OMX_PortDomainAudio, 100, SwSink::NO_PORT,
+                101, 16, EVENT_AUDIO_RENDER);
+
+    if (!component) {
+        NDLLOG(LOGTAG, NDL_LOGE, "no software component for %s", name.c_str());
+        return nullptr;
+    }
+    component->start();
+    return component;
+}
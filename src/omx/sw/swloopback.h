@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef NDL_DIRECTMEDIA2_OMX_SW_SWLOOPBACK_H_
+#define NDL_DIRECTMEDIA2_OMX_SW_SWLOOPBACK_H_
+
+#include "swcomponent.h"
+
+namespace NDL_Esplayer {
+namespace SwOmx {
+
+    /**
+     * Loopback decoder.
+     * consumes input buffers at the configured cost and emits one frame
+     * descriptor per access unit(ENDOFFRAME) to the tunnel or to client output buffers.
+     */
+    class SwDecoder : public SwComponent {
+        public:
+            SwDecoder(const std::string& name, OMX_PORTDOMAINTYPE domain,
+                    OMX_U32 input_port, OMX_U32 output_port, int cost_us,
+                    bool send_port_settings);
+
+        protected:
+            int64_t process() override;
+            void onFlush(OMX_U32 port_index) override;
+            void onPortEnabled(OMX_U32 port_index, bool enable) override;
+            void onStateChanged(OMX_STATETYPE state) override;
+
+        private:
+            bool output(const Frame& frame);
+
+            OMX_U32 input_port_;
+            OMX_U32 output_port_;
+            int cost_us_;
+            bool send_port_settings_;
+            bool port_settings_sent_ {false};
+            bool wait_reconfigure_ {false};
+
+            bool has_pending_ {false};
+            Frame pending_;
+            bool accumulating_ {false};
+            Frame accumulated_;
+    };
+
+    /**
+     * Frame consumer stage : video scheduler, renderers and mixer.
+     * frames are held until due on the clock port(if any) and then forwarded
+     * to the tunneled output port, or rendered with a render event.
+     */
+    class SwSink : public SwComponent {
+        public:
+            enum { NO_PORT = 0xffffffff };
+
+            SwSink(const std::string& name, OMX_PORTDOMAINTYPE domain,
+                    OMX_U32 input_port, OMX_U32 output_port, OMX_U32 clock_port,
+                    OMX_U32 input_count, int render_event);
+
+        protected:
+            int64_t process() override;
+
+        private:
+            void render(const Frame& frame);
+
+            OMX_U32 input_port_;
+            OMX_U32 output_port_;
+            OMX_U32 clock_port_;
+            int render_event_;
+    };
+
+} //namespace SwOmx
+} //namespace NDL_Esplayer
+
+#endif //NDL_DIRECTMEDIA2_OMX_SW_SWLOOPBACK_H_
@@ -60,6 +60,8 @@ namespace NDL_Esplayer {
             int getRealTime(int64_t* start_time, int64_t* current_time) override;
             int getMediaTime(int64_t* start_time, int64_t* current_time) override;
 
+            const OmxClient* getOmxClient() const override { return clock_.get(); }
+
             bool OMXSetReferenceClock(bool has_audio, bool lock = true);
             int getPortDefinition(int port_index);
 
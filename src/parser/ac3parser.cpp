@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#include "ac3parser.h"
+
+using namespace NDL_Esplayer;
+
+#define AC3_HEADER_SIZE         6
+// bsid of AC3 is up to 10 (8 : A/52, 9/10 : lower sample rates), 11~16 is EAC3
+#define AC3_MAX_BSID            10
+#define EAC3_MAX_BSID           16
+#define EAC3_STRMTYP_DEPENDENT  1
+
+namespace {
+    // kbps of each frmsizecod / 2
+    const int kAc3Bitrates[19] = {
+        32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 448, 512, 576, 640
+    };
+
+    bool isEac3(const unsigned char* data)
+    {
+        return (data[5] >> 3) > AC3_MAX_BSID;
+    }
+}
+
+ac3parser::ac3parser(CPU_SIMD simd)
+    : audioparser(AC3_MAX_FRAME_SIZE, 0x0B, 0xFF, 0x77, simd)
+{
+}
+
+int ac3parser::getFrameSize(const unsigned char* data, unsigned int len)
+{
+    int size = getSyncFrameSize(data, len);
+    if (size <= 0 || !isEac3(data))
+        return size;
+
+    // dependent substreams (ex. 7.1 extension) after the independent frame :
+    // the header of the next sync frame is needed to know where the packet ends
+    while (true) {
+        if (size + AC3_HEADER_SIZE > (int)len)
+            return 0;
+        if ((data[size + 2] >> 6) != EAC3_STRMTYP_DEPENDENT || !isEac3(data + size))
+            return size;
+        int dependent = getSyncFrameSize(data + size, len - size);
+        if (dependent <= 0 || size + dependent > AC3_MAX_FRAME_SIZE)
+            return size;
+        size += dependent;
+    }
+}
+
+int ac3parser::getSyncFrameSize(const unsigned char* data, unsigned int len) const
+{
+    if (len < AC3_HEADER_SIZE)
+        return 0;
+    if (data[0] != 0x0B || data[1] != 0x77)
+        return -1;
+
+    int bsid = data[5] >> 3;
+    if (bsid <= AC3_MAX_BSID) {
+        int fscod = data[4] >> 6;
+        int frmsizecod = data[4] & 0x3F;
+        if (fscod == 3 || frmsizecod >= 38)
+            return -1;
+
+        // 16 bit words of 1536 samples, 44.1kHz frames have one more word in odd frmsizecod
+        int bitrate = kAc3Bitrates[frmsizecod >> 1];
+        switch (fscod) {
+            case 0:  return bitrate * 2 * 2;                                    // 48kHz
+            case 1:  return (bitrate * 320 / 147 + (frmsizecod & 1)) * 2;       // 44.1kHz
+            default: return bitrate * 3 * 2;                                    // 32kHz
+        }
+    }
+
+    if (bsid <= EAC3_MAX_BSID) {
+        int strmtyp = data[2] >> 6;
+        int fscod = data[4] >> 6;
+        if (strmtyp == 3 || (fscod == 3 && ((data[4] >> 4) & 0x03) == 3))
+            return -1;
+        // frmsiz : words - 1
+        int size = ((((data[2] & 0x07) << 8) | data[3]) + 1) * 2;
+        return size > AC3_HEADER_SIZE ? size : -1;
+    }
+    return -1;
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#ifndef PARSER_AC3PARSER_H_
+#define PARSER_AC3PARSER_H_
+
+#include "audioparser.h"
+
+// independent EAC3 frame (4096 bytes at most) and its dependent substreams
+#define AC3_MAX_FRAME_SIZE      16384
+
+namespace NDL_Esplayer {
+
+    /**
+     * AC3 and EAC3 sync frames (ATSC A/52), sync word 0x0B77.
+     * Dependent EAC3 substreams are kept in the packet of their independent frame (the decoder
+     * ignores them when they come alone), so an EAC3 frame is complete with the next header.
+     */
+    class ac3parser : public audioparser {
+        public:
+            explicit ac3parser(CPU_SIMD simd = CPU_SIMD_AUTO);
+
+        protected:
+            int getFrameSize(const unsigned char* data, unsigned int len) override;
+
+        private:
+            int getSyncFrameSize(const unsigned char* data, unsigned int len) const;
+    };
+
+} //namespace NDL_Esplayer
+
+#endif // #ifndef PARSER_AC3PARSER_H_
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#include "adtsparser.h"
+
+using namespace NDL_Esplayer;
+
+#define ADTS_HEADER_SIZE        7
+#define ADTS_HEADER_CRC_SIZE    9
+
+adtsparser::adtsparser(CPU_SIMD simd)
+    : audioparser(ADTS_MAX_FRAME_SIZE, 0xFF, 0xF6, 0xF0, simd)
+{
+}
+
+int adtsparser::getFrameSize(const unsigned char* data, unsigned int len)
+{
+    if (len < ADTS_HEADER_SIZE)
+        return 0;
+    if (data[0] != 0xFF || (data[1] & 0xF6) != 0xF0)
+        return -1;
+
+    // sampling_frequency_index 13~15 are reserved
+    if (((data[2] >> 2) & 0x0F) > 12)
+        return -1;
+
+    int size = ((data[3] & 0x03) << 11) | (data[4] << 3) | (data[5] >> 5);
+    int header_size = (data[1] & 0x01) ? ADTS_HEADER_SIZE : ADTS_HEADER_CRC_SIZE;
+    return size > header_size ? size : -1;
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#ifndef PARSER_ADTSPARSER_H_
+#define PARSER_ADTSPARSER_H_
+
+#include "audioparser.h"
+
+// 13 bit aac_frame_length
+#define ADTS_MAX_FRAME_SIZE     8191
+
+namespace NDL_Esplayer {
+
+    /**
+     * AAC in ADTS frames (ISO/IEC 13818-7), sync word 0xFFF with layer 00
+     */
+    class adtsparser : public audioparser {
+        public:
+            explicit adtsparser(CPU_SIMD simd = CPU_SIMD_AUTO);
+
+        protected:
+            int getFrameSize(const unsigned char* data, unsigned int len) override;
+    };
+
+} //namespace NDL_Esplayer
+
+#endif // #ifndef PARSER_ADTSPARSER_H_
@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#include <string.h>
+#include <algorithm>
+
+#include "annexbconverter.h"
+#include "videoparser.h"
+#include "ndl-directmedia2/media-common.h"
+
+#define LOGTAG "parser"
+#include "debug.h"
+
+using namespace NDL_Esplayer;
+
+namespace {
+    const uint8_t start_code[4] = {0, 0, 0, 1};
+
+    int readUint16(const uint8_t* data)
+    {
+        return (data[0] << 8) | data[1];
+    }
+}
+
+annexbconverter::annexbconverter(bool hevc)
+    : hevc_(hevc)
+{
+}
+
+/**
+ * avcC (ISO/IEC 14496-15 5.3.3.1) : version, profile, compatibility, level, lengthSizeMinusOne,
+ *   numOfSequenceParameterSets then numOfPictureParameterSets, each NAL with a 16 bits length.
+ * hvcC (8.3.3.1) : 21 bytes of profile and format, lengthSizeMinusOne, numOfArrays,
+ *   each array with its NAL type, numNalus and the NALs with a 16 bits length.
+ */
+int annexbconverter::setConfig(const uint8_t* data, int size)
+{
+    parameter_sets_.clear();
+    max_temporal_id_ = -1;
+    if (!data || size < (hevc_ ? 23 : 7) || data[0] != 1)
+        return -1;
+
+    auto append = [this, data, size] (int* pos) {
+        if (*pos + 2 > size)
+            return false;
+        int len = readUint16(data + *pos);
+        *pos += 2;
+        if (*pos + len > size)
+            return false;
+        parameter_sets_.insert(parameter_sets_.end(), start_code, start_code + 4);
+        parameter_sets_.insert(parameter_sets_.end(), data + *pos, data + *pos + len);
+        if (len >= videoparser::nalHeaderSize(hevc_))
+            classify(data + *pos);
+        *pos += len;
+        return true;
+    };
+
+    int pos;
+    if (hevc_) {
+        length_size_ = (data[21] & 0x03) + 1;
+        int arrays = data[22];
+        pos = 23;
+        for (int i = 0; i < arrays; i++) {
+            if (pos + 3 > size)
+                return -1;
+            int count = readUint16(data + pos + 1);
+            pos += 3;
+            for (int j = 0; j < count; j++) {
+                if (!append(&pos))
+                    return -1;
+            }
+        }
+    } else {
+        length_size_ = (data[4] & 0x03) + 1;
+        int sps = data[5] & 0x1F;
+        pos = 6;
+        for (int i = 0; i < sps; i++) {
+            if (!append(&pos))
+                return -1;
+        }
+        if (pos >= size)
+            return -1;
+        int pps = data[pos++];
+        for (int i = 0; i < pps; i++) {
+            if (!append(&pos))
+                return -1;
+        }
+    }
+
+    NDLLOG(LOGTAG, NDL_LOGI, "%s : %s, nal length %d bytes, parameter sets %zu bytes",
+            __func__, hevc_ ? "hvcC" : "avcC", length_size_, parameter_sets_.size());
+    inject_pending_ = true;
+    return 0;
+}
+
+void annexbconverter::reset()
+{
+    inject_pending_ = true;
+    src_ = nullptr;
+    src_size_ = 0;
+    src_pos_ = 0;
+    nal_left_ = 0;
+    code_left_ = 0;
+    ps_size_ = 0;
+}
+
+int annexbconverter::begin(const uint8_t* data, int size)
+{
+    bool key = false;
+    bool has_sps = false;
+    int inject_at = 0;
+    int converted = 0;
+
+    for (int pos = 0; pos < size; ) {
+        if (pos + length_size_ > size)
+            return -1;
+        int len = readLength(data + pos);
+        if (len < 0 || len > size - pos - length_size_)
+            return -1;
+        if (len > 0) {
+            int type = nalType(data + pos + length_size_);
+            key = key || (len >= videoparser::nalHeaderSize(hevc_) &&
+                    videoparser::classify(hevc_, data + pos + length_size_, max_temporal_id_).key);
+            has_sps = has_sps || isSps(type);
+            if (pos == 0 && isAud(type))
+                inject_at = length_size_ + len;
+        }
+        pos += length_size_ + len;
+        converted += 4 + len;
+    }
+
+    src_ = data;
+    src_size_ = size;
+    src_pos_ = 0;
+    nal_left_ = 0;
+    code_left_ = 0;
+    inject_at_ = inject_at;
+    ps_pos_ = 0;
+    ps_size_ = 0;
+    if (has_sps) {
+        inject_pending_ = false;
+    } else if ((inject_pending_ || key) && !parameter_sets_.empty()) {
+        ps_size_ = (int)parameter_sets_.size();
+        converted += ps_size_;
+        inject_pending_ = false;
+    }
+    return converted;
+}
+
+int annexbconverter::write(uint8_t* dst, int capacity)
+{
+    int out = 0;
+    while (out < capacity) {
+        if (code_left_ > 0) {
+            int n = std::min(code_left_, capacity - out);
+            memcpy(dst + out, start_code + 4 - code_left_, n);
+            code_left_ -= n;
+            out += n;
+        } else if (nal_left_ > 0) {
+            int n = std::min(nal_left_, capacity - out);
+            memcpy(dst + out, src_ + src_pos_, n);
+            src_pos_ += n;
+            nal_left_ -= n;
+            out += n;
+        } else if (ps_pos_ < ps_size_ && src_pos_ == inject_at_) {
+            int n = std::min(ps_size_ - ps_pos_, capacity - out);
+            memcpy(dst + out, parameter_sets_.data() + ps_pos_, n);
+            ps_pos_ += n;
+            out += n;
+        } else if (src_pos_ < src_size_) {
+            // the length prefix becomes a start code
+            nal_left_ = readLength(src_ + src_pos_);
+            src_pos_ += length_size_;
+            code_left_ = 4;
+        } else {
+            break;
+        }
+    }
+    return out;
+}
+
+uint32_t annexbconverter::frameFlags(const uint8_t* data, int size)
+{
+    bool key = false;
+    bool vcl = false;
+    bool reference = false;
+    for (int pos = 0; pos + length_size_ <= size; ) {
+        int len = readLength(data + pos);
+        pos += length_size_;
+        if (len < 0 || len > size - pos)
+            break;
+        if (len >= videoparser::nalHeaderSize(hevc_)) {
+            videoparser::NalInfo info = classify(data + pos);
+            vcl = vcl || info.vcl;
+            key = key || (info.vcl && info.key);
+            reference = reference || (info.vcl && info.reference);
+        }
+        pos += len;
+    }
+    // without a slice (parameter sets, SEI or no NAL found) the frame is not known to be droppable
+    return (key ? NDL_ESP_FLAG_KEY_FRAME : 0) | (vcl && !reference ? NDL_ESP_FLAG_NON_REFERENCE : 0);
+}
+
+videoparser::NalInfo annexbconverter::classify(const uint8_t* nal)
+{
+    videoparser::NalInfo info = videoparser::classify(hevc_, nal, max_temporal_id_);
+    if (info.max_temporal_id >= 0)
+        max_temporal_id_ = info.max_temporal_id;
+    return info;
+}
+
+int annexbconverter::readLength(const uint8_t* data) const
+{
+    uint32_t len = 0;
+    for (int i = 0; i < length_size_; i++)
+        len = (len << 8) | data[i];
+    return len > INT32_MAX ? -1 : (int)len;
+}
+
+std::shared_ptr<annexbconverter> NDL_Esplayer::createAnnexBConverter(NDL_ESP_VIDEO_CODEC codec,
+        const void* extradata, int extrasize)
+{
+    if (codec != NDL_ESP_VIDEO_CODEC_H264 && codec != NDL_ESP_VIDEO_CODEC_H265)
+        return nullptr;
+
+    auto converter = std::make_shared<annexbconverter>(codec == NDL_ESP_VIDEO_CODEC_H265);
+    if (converter->setConfig((const uint8_t*)extradata, extrasize) < 0)
+        return nullptr;
+    return converter;
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#ifndef PARSER_ANNEXBCONVERTER_H_
+#define PARSER_ANNEXBCONVERTER_H_
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+#include "ndl-directmedia2/media-types.h"
+#include "videoparser.h"
+
+namespace NDL_Esplayer {
+
+    /**
+     * Converter of H.264/HEVC frames with NAL length prefixes (MP4, avcC/hvcC extradata) into Annex-B.
+     * The output is written piece by piece into the destination (the input buffers of the codec),
+     * the frame is not rewritten beforehand. The parameter sets of the extradata are inserted
+     * before the first frame, the first frame after reset (flush) and every key frame without them.
+     */
+    class annexbconverter {
+        public:
+            explicit annexbconverter(bool hevc);
+
+            /**
+             * Take the avcC/hvcC extradata, < 0 if it is not one (ex. Annex-B extradata)
+             */
+            int setConfig(const uint8_t* data, int size);
+            /**
+             * Parameter sets of the extradata in Annex-B
+             */
+            const std::vector<uint8_t>& parameterSets() const { return parameter_sets_; }
+            /**
+             * The next frame gets the parameter sets (after flush)
+             */
+            void reset();
+
+            /**
+             * Start the conversion of a frame, data is kept until its last byte is written.
+             * return the size of the frame in Annex-B, < 0 if the NAL lengths do not match size
+             */
+            int begin(const uint8_t* data, int size);
+            /**
+             * Write the next bytes of the frame begun, return the bytes written (0 at its end)
+             */
+            int write(uint8_t* dst, int capacity);
+
+            /**
+             * NDL_ESP_FLAG_KEY_FRAME and NDL_ESP_FLAG_NON_REFERENCE of a length prefixed frame
+             * (an SPS in it updates the highest TemporalId of the stream)
+             */
+            uint32_t frameFlags(const uint8_t* data, int size);
+
+        private:
+            int readLength(const uint8_t* data) const;
+            // videoparser::classify, an SPS updates max_temporal_id_
+            videoparser::NalInfo classify(const uint8_t* nal);
+            int nalType(const uint8_t* nal) const { return hevc_ ? (nal[0] >> 1) & 0x3F : nal[0] & 0x1F; }
+            bool isSps(int type) const { return hevc_ ? (type == 32 || type == 33) : type == 7; }
+            bool isAud(int type) const { return hevc_ ? type == 35 : type == 9; }
+
+            const bool hevc_;
+            int length_size_ {4};
+            std::vector<uint8_t> parameter_sets_;
+            int max_temporal_id_ {-1};  // HEVC : from the last SPS, see videoparser::classify
+            bool inject_pending_ {true};
+
+            // frame begun
+            const uint8_t* src_ {nullptr};
+            int src_size_ {0};
+            int src_pos_ {0};       // at the length of the next NAL, or in the payload of the current one
+            int nal_left_ {0};      // payload of the current NAL left to write
+            int code_left_ {0};     // start code bytes of the current NAL left to write
+            int inject_at_ {0};     // src_pos_ where the parameter sets go (after an AUD)
+            int ps_pos_ {0};
+            int ps_size_ {0};       // 0 without parameter sets in this frame
+    };
+
+    /**
+     * Converter for the codec if extradata is avcC (H.264) or hvcC (HEVC), nullptr otherwise
+     */
+    std::shared_ptr<annexbconverter> createAnnexBConverter(NDL_ESP_VIDEO_CODEC codec,
+            const void* extradata, int extrasize);
+
+} //namespace NDL_Esplayer
+
+#endif // #ifndef PARSER_ANNEXBCONVERTER_H_
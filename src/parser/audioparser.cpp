@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#include "audioparser.h"
+#include "ac3parser.h"
+#include "adtsparser.h"
+#include "latmparser.h"
+#include "mpegaudioparser.h"
+
+#define LOGTAG "parser"
+#include "debug.h"
+
+using namespace NDL_Esplayer;
+
+audioparser::audioparser(int frame_buffer_size, unsigned char sync0, unsigned char mask1, unsigned char sync1,
+        CPU_SIMD simd)
+    : parser(frame_buffer_size)
+    , scan_(getSyncScanFunc(simd) ? getSyncScanFunc(simd) : getSyncScanFunc(CPU_SIMD_SCALAR))
+    , sync0_(sync0)
+    , mask1_(mask1)
+    , sync1_(sync1)
+{
+}
+
+void audioparser::clear()
+{
+    parser::clear();
+    locked_ = false;
+}
+
+int audioparser::getFrameOffset(const unsigned char* data, unsigned int len)
+{
+    if (locked_ && isSync(data, len) && getFrameSize(data, len) >= 0)
+        return 0;
+    locked_ = false;
+
+    unsigned int from = 0;
+    while (from < len) {
+        int found = scan_(data + from, len - from, sync0_, mask1_, sync1_);
+        if (found < 0)
+            return -1;
+
+        unsigned int offset = from + found;
+        int size = getFrameSize(data + offset, len - offset);
+        // header cut at the end of data : checked when the rest comes
+        if (size == 0)
+            return offset;
+        if (size > 0) {
+            unsigned int next = offset + size;
+            if (next >= len)
+                return offset;
+            if (isSync(data + next, len - next)) {
+                locked_ = true;
+                return offset;
+            }
+        }
+        from = offset + 1;
+    }
+    return -1;
+}
+
+bool audioparser::isSync(const unsigned char* data, unsigned int len) const
+{
+    return len > 0 && data[0] == sync0_ && (len < 2 || (data[1] & mask1_) == sync1_);
+}
+
+std::shared_ptr<parser> NDL_Esplayer::createAudioParser(NDL_ESP_AUDIO_CODEC codec, CPU_SIMD simd)
+{
+    switch (codec) {
+        case NDL_ESP_AUDIO_CODEC_MP2:
+        case NDL_ESP_AUDIO_CODEC_MP3:
+            return std::make_shared<mpegaudioparser>(simd);
+        case NDL_ESP_AUDIO_CODEC_AC3:
+        case NDL_ESP_AUDIO_CODEC_EAC3:
+            return std::make_shared<ac3parser>(simd);
+        case NDL_ESP_AUDIO_CODEC_AAC:
+            return std::make_shared<adtsparser>(simd);
+        case NDL_ESP_AUDIO_CODEC_HEAAC:
+            return std::make_shared<latmparser>(simd);
+        default:
+            NDLLOG(LOGTAG, NDL_LOGE, "%s: no parser for audio codec:%d", __func__, codec);
+            return nullptr;
+    }
+}
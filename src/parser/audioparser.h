@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#ifndef PARSER_AUDIOPARSER_H_
+#define PARSER_AUDIOPARSER_H_
+
+#include <stdint.h>
+#include <memory>
+
+#include "ndl-directmedia2/media-types.h"
+#include "parser.h"
+#include "syncscan.h"
+
+namespace NDL_Esplayer {
+
+    /**
+     * Parser of an audio ES with a sync word at each frame start (ADTS, LOAS, AC3, MPEG audio).
+     * getFrameOffset scans for the sync word with the SIMD kernel and takes the first candidate
+     * whose header parses and which is followed by another sync word (when that one is in data),
+     * so that a sync pattern in the payload does not start a frame after a loss of sync.
+     * Once in sync, the frame at the start of data is taken as it is.
+     */
+    class audioparser : public parser {
+        public:
+            audioparser(int frame_buffer_size, unsigned char sync0, unsigned char mask1, unsigned char sync1,
+                    CPU_SIMD simd);
+
+            void clear() override;
+
+        protected:
+            int getFrameOffset(const unsigned char* data, unsigned int len) override;
+            bool isSync(const unsigned char* data, unsigned int len) const;
+
+        private:
+            SyncScanFunc scan_;
+            bool locked_ {false};   // frames follow each other, a frame is taken without the next sync word
+            unsigned char sync0_;
+            unsigned char mask1_;
+            unsigned char sync1_;
+    };
+
+    /**
+     * Parser splitting the byte stream of the codec into frames :
+     * ADTS for AAC, LOAS (LATM) for HEAAC, AC3/EAC3 and MPEG audio sync frames.
+     * nullptr for codecs without sync words (pcm). simd : sync scan kernel, see getSyncScanFunc
+     */
+    std::shared_ptr<parser> createAudioParser(NDL_ESP_AUDIO_CODEC codec,
+            CPU_SIMD simd = CPU_SIMD_AUTO);
+
+} //namespace NDL_Esplayer
+
+#endif // #ifndef PARSER_AUDIOPARSER_H_
@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#include "latmparser.h"
+
+using namespace NDL_Esplayer;
+
+#define LATM_HEADER_SIZE        3
+
+latmparser::latmparser(CPU_SIMD simd)
+    : audioparser(LATM_MAX_FRAME_SIZE, 0x56, 0xE0, 0xE0, simd)
+{
+}
+
+int latmparser::getFrameSize(const unsigned char* data, unsigned int len)
+{
+    if (len < LATM_HEADER_SIZE)
+        return 0;
+    if (data[0] != 0x56 || (data[1] & 0xE0) != 0xE0)
+        return -1;
+
+    int length = ((data[1] & 0x1F) << 8) | data[2];
+    return length > 0 ? length + LATM_HEADER_SIZE : -1;
+}
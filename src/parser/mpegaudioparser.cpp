@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#include "mpegaudioparser.h"
+
+using namespace NDL_Esplayer;
+
+#define MPEG_AUDIO_HEADER_SIZE  4
+
+namespace {
+    enum {
+        MPEG_VERSION_2_5 = 0,
+        MPEG_VERSION_RESERVED = 1,
+        MPEG_VERSION_2 = 2,
+        MPEG_VERSION_1 = 3,
+    };
+
+    enum {
+        MPEG_LAYER_RESERVED = 0,
+        MPEG_LAYER_III = 1,
+        MPEG_LAYER_II = 2,
+        MPEG_LAYER_I = 3,
+    };
+
+    // kbps of bitrate index 1~14 : MPEG-1 layer I, II, III, then MPEG-2/2.5 layer I, II and III
+    const int kBitrates[5][14] = {
+        {32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448},
+        {32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384},
+        {32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320},
+        {32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256},
+        {8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160},
+    };
+
+    // Hz of sampling frequency index 0~2 for MPEG-2.5, (reserved), MPEG-2 and MPEG-1
+    const int kSampleRates[4][3] = {
+        {11025, 12000, 8000},
+        {0, 0, 0},
+        {22050, 24000, 16000},
+        {44100, 48000, 32000},
+    };
+}
+
+mpegaudioparser::mpegaudioparser(CPU_SIMD simd)
+    : audioparser(MPEG_AUDIO_MAX_FRAME_SIZE, 0xFF, 0xE0, 0xE0, simd)
+{
+}
+
+int mpegaudioparser::getFrameSize(const unsigned char* data, unsigned int len)
+{
+    if (len < MPEG_AUDIO_HEADER_SIZE)
+        return 0;
+    if (data[0] != 0xFF || (data[1] & 0xE0) != 0xE0)
+        return -1;
+
+    int version = (data[1] >> 3) & 0x03;
+    int layer = (data[1] >> 1) & 0x03;
+    int bitrate_index = data[2] >> 4;
+    int rate_index = (data[2] >> 2) & 0x03;
+    int padding = (data[2] >> 1) & 0x01;
+    if (version == MPEG_VERSION_RESERVED || layer == MPEG_LAYER_RESERVED
+            || bitrate_index == 0 || bitrate_index == 15 || rate_index == 3)
+        return -1;
+
+    int table;
+    if (version == MPEG_VERSION_1)
+        table = MPEG_LAYER_I - layer;
+    else
+        table = layer == MPEG_LAYER_I ? 3 : 4;
+    int bitrate = kBitrates[table][bitrate_index - 1] * 1000;
+    int sample_rate = kSampleRates[version][rate_index];
+
+    switch (layer) {
+        case MPEG_LAYER_I:
+            return (12 * bitrate / sample_rate + padding) * 4;
+        case MPEG_LAYER_II:
+            return 144 * bitrate / sample_rate + padding;
+        default:
+            // MPEG-2/2.5 layer III frames have half the samples (576)
+            return (version == MPEG_VERSION_1 ? 144 : 72) * bitrate / sample_rate + padding;
+    }
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#ifndef PARSER_MPEGAUDIOPARSER_H_
+#define PARSER_MPEGAUDIOPARSER_H_
+
+#include "audioparser.h"
+
+// layer II of MPEG-2.5 at 160kbps 8kHz is the largest one (2881 bytes)
+#define MPEG_AUDIO_MAX_FRAME_SIZE   4096
+
+namespace NDL_Esplayer {
+
+    /**
+     * MPEG-1/2/2.5 audio layer I, II and III frames (MP2, MP3), 11 bit sync word.
+     * Free format (bitrate index 0) has no size in the header and is not supported.
+     */
+    class mpegaudioparser : public audioparser {
+        public:
+            explicit mpegaudioparser(CPU_SIMD simd = CPU_SIMD_AUTO);
+
+        protected:
+            int getFrameSize(const unsigned char* data, unsigned int len) override;
+    };
+
+} //namespace NDL_Esplayer
+
+#endif // #ifndef PARSER_MPEGAUDIOPARSER_H_
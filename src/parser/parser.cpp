@@ -9,6 +9,7 @@
 
 #include "parser.h"
 #include "string.h"
+#include <algorithm>
 
 #define LOGTAG "parser"
 #include "debug.h"
@@ -29,19 +30,14 @@ parser::~parser() {
 }
 
 void parser::clear() {
-    frame_buffer_filled_  = 0;
-    frame_buffer_required_ = 0;
+    clearFrameBuffer();
 }
 
-int parser::parse(const unsigned char* data, unsigned int len,
-        std::function<int(const unsigned char*, unsigned int)> writer)
+int parser::nextFrame(const unsigned char* data, unsigned int len, Frame* frame)
 {
     const unsigned char* pos = data;
     int remained = len;
 
-    if (len == 0) // handle EOS frame
-        return writer(data, len);
-
     if (frame_buffer_filled_ == 0) {
         //
         // We should get here mostly
@@ -69,71 +65,116 @@ int parser::parse(const unsigned char* data, unsigned int len,
         }
 
         // handle frame alignment
-        if (size <= remained) {
-            // write a complete frame
-            int written = writer(pos, size);
-            if (written < 0) {
-                NDLLOG(LOGTAG, NDL_LOGE, "%s : buffer is full, offset:%d, size:%d", __func__, offset, size);
-                return -1;
-            } else if (written == 0) {
-                NDLLOG(LOGTAG, NDL_LOGE, "%s : error in writing frame data, offset:%d, size:%d", __func__, offset, size);
-                return len;
-            }
-
-            pos += written;
-            remained -= written;
-        } else {
-            // discard data if frame size is bigger than frame buffer size
-            if (size > frame_buffer_size_) {
-                NDLLOG(LOGTAG, NDL_LOGE, "%s : error in get frame size. frame size : %d, buffer size : %d",
-                        __func__, size, frame_buffer_size_);
-                return len;
-            }
-
-            // partial frame
-            //  just keep it, and handle later
-            memcpy(frame_buffer_, pos, remained);
-            pos += remained;
-            frame_buffer_filled_ = remained;
-            frame_buffer_required_ = size - remained;
-
-            NDLLOG(LOGTAG, LOG_PARSER, "%s : keep mis-aligned frame data, filled:%d, required %d bytes more",
-                    __func__, frame_buffer_filled_, frame_buffer_required_ );
+        if (size > 0 && size <= remained) {
+            // a complete frame : given as it is in data
+            frame->data = pos;
+            frame->size = size;
+            return offset + size;
         }
-    } else {
 
-        //
-        // at this point, we have some fragmented frame data in frame_buffer_
-        //
+        // discard data if frame size is bigger than frame buffer size
+        if (size > frame_buffer_size_) {
+            NDLLOG(LOGTAG, NDL_LOGE, "%s : error in get frame size. frame size : %d, buffer size : %d",
+                    __func__, size, frame_buffer_size_);
+            return len;
+        }
+
+        // partial frame (or partial header, size is known later)
+        //  just keep it, and handle later
+        memcpy(frame_buffer_, pos, remained);
+        frame_buffer_start_ = 0;
+        frame_buffer_filled_ = remained;
+        frame_buffer_required_ = size > 0 ? size - remained : 0;
 
-        int copy_to_frame_buffer = (remained < frame_buffer_required_) ? remained : frame_buffer_required_;
-        memcpy(frame_buffer_+frame_buffer_filled_, pos, copy_to_frame_buffer);
-
-        if (copy_to_frame_buffer < frame_buffer_required_) { // need more data
-            pos += copy_to_frame_buffer;
-            remained -= copy_to_frame_buffer;
-            frame_buffer_required_ -= copy_to_frame_buffer;
-            frame_buffer_filled_ += copy_to_frame_buffer;
-        } else { // a complete frame has been built
-            int written = writer(frame_buffer_, frame_buffer_filled_ + copy_to_frame_buffer);
-            if (written < 0) { // buffer full
-                // will try again in the next parse() call (no member was updated here)
-                NDLLOG(LOGTAG, NDL_LOGE, "%s : buffer is full", __func__);
-                return -1;
-            } else if (written == 0) { // failed, discard all data.
-                NDLLOG(LOGTAG, NDL_LOGE, "%s : error in writing frame merged, size:%d", __func__, frame_buffer_filled_);
-                frame_buffer_required_ = 0;
-                frame_buffer_filled_ = 0;
-                return len;
-            } else {
-                NDLLOG(LOGTAG, LOG_PARSER, "%s : write merged frame, size:%d", __func__, written);
-                pos += copy_to_frame_buffer;
-                remained -= copy_to_frame_buffer;
-                frame_buffer_required_ = 0;
-                frame_buffer_filled_ = 0;
-            }
+        NDLLOG(LOGTAG, LOG_PARSER, "%s : keep mis-aligned frame data, filled:%d, required %d bytes more",
+                __func__, frame_buffer_filled_, frame_buffer_required_ );
+        return len;
+    }
+
+    //
+    // at this point, we have some fragmented frame data in frame_buffer_
+    //
+
+    if (frame_buffer_required_ == 0) {
+        // the header was cut : get the size with the new data appended (not consumed yet)
+        if (frame_buffer_start_ + frame_buffer_filled_ + remained > frame_buffer_size_)
+            compactFrameBuffer();
+        int peek = std::min(remained, frame_buffer_size_ - frame_buffer_filled_);
+        unsigned char* kept = frame_buffer_ + frame_buffer_start_;
+        memcpy(kept + frame_buffer_filled_, pos, peek);
+        int size = getFrameSize(kept, frame_buffer_filled_ + peek);
+        if (size == 0 && peek > 0) { // header is still incomplete
+            frame_buffer_filled_ += peek;
+            return peek;
+        }
+        if (size <= 0 || size > frame_buffer_size_) {
+            // no frame : drop the kept bytes and sync again in data
+            NDLLOG(LOGTAG, NDL_LOGE, "%s : error in parsing kept frame header, size:%d", __func__, size);
+            frame_buffer_start_ = 0;
+            frame_buffer_filled_ = 0;
+            return 0;
+        }
+        if (size <= frame_buffer_filled_) {
+            // the kept bytes (waiting for the header of the next frame) complete a frame
+            frame->data = kept;
+            frame->size = size;
+            return 0;
         }
+        frame_buffer_required_ = size - frame_buffer_filled_;
+    }
+
+    if (frame_buffer_start_ + frame_buffer_filled_ + frame_buffer_required_ > frame_buffer_size_)
+        compactFrameBuffer();
+
+    // stitch the frame straddling the chunks
+    unsigned char* kept = frame_buffer_ + frame_buffer_start_;
+    int copy_to_frame_buffer = (remained < frame_buffer_required_) ? remained : frame_buffer_required_;
+    memcpy(kept + frame_buffer_filled_, pos, copy_to_frame_buffer);
+
+    if (copy_to_frame_buffer < frame_buffer_required_) { // need more data
+        frame_buffer_required_ -= copy_to_frame_buffer;
+        frame_buffer_filled_ += copy_to_frame_buffer;
+        NDLLOG(LOGTAG, LOG_PARSERV, "%s : kept %d bytes, required %d bytes more",
+                __func__, frame_buffer_filled_, frame_buffer_required_);
+        return copy_to_frame_buffer;
+    }
+
+    // a complete frame has been built, kept until it is written
+    frame->data = kept;
+    frame->size = frame_buffer_filled_ + copy_to_frame_buffer;
+    NDLLOG(LOGTAG, LOG_PARSER, "%s : merged frame, size:%d", __func__, frame->size);
+    return copy_to_frame_buffer;
+}
+
+void parser::releaseFrame(const Frame& frame)
+{
+    if (frame.data < frame_buffer_ || frame.data >= frame_buffer_ + frame_buffer_size_)
+        return;
+
+    if ((int)frame.size > frame_buffer_filled_) {
+        // merged with the data : nothing is kept
+        clearFrameBuffer();
+    } else {
+        // the rest of the kept bytes starts the next frame
+        frame_buffer_start_ += frame.size;
+        frame_buffer_filled_ -= frame.size;
+        frame_buffer_required_ = 0;
+        if (frame_buffer_filled_ == 0)
+            frame_buffer_start_ = 0;
     }
-    NDLLOG(LOGTAG, LOG_PARSERV, "%s : parsed %d bytes, remained : %d bytes", __func__, pos-data, remained);
-    return pos-data;
+}
+
+void parser::clearFrameBuffer()
+{
+    frame_buffer_start_ = 0;
+    frame_buffer_filled_ = 0;
+    frame_buffer_required_ = 0;
+}
+
+void parser::compactFrameBuffer()
+{
+    if (frame_buffer_start_ == 0)
+        return;
+    memmove(frame_buffer_, frame_buffer_ + frame_buffer_start_, frame_buffer_filled_);
+    frame_buffer_start_ = 0;
 }
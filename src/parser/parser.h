@@ -16,8 +16,6 @@
 #ifndef PARSER_PARSER_H_
 #define PARSER_PARSER_H_
 
-#include <functional>
-
 namespace NDL_Esplayer {
 
     class parser {
@@ -25,22 +23,69 @@ namespace NDL_Esplayer {
             parser(int frame_buffer_size);
             virtual ~parser();
 
-            void clear();
-            int parse(const unsigned char* data, unsigned int len,
-                    std::function<int(const unsigned char*, unsigned int)> writer);
+            virtual void clear();
+            /**
+             * Write at most one frame found in data. A frame complete in data is given as a view into data,
+             * only a frame straddling the end of data is copied to be stitched with the next calls.
+             * writer(const unsigned char* frame, unsigned int size) : bytes written, < 0 if full, 0 on error
+             * return the bytes of data consumed (call again with the rest), -1 if writer is full
+             */
+            template <typename Writer>
+            int parse(const unsigned char* data, unsigned int len, Writer&& writer);
+            /**
+             * true if the start of a frame is kept from the previous data
+             */
+            bool hasPartialFrame() const { return frame_buffer_filled_ > 0; }
 
         protected:
+            // offset of the first frame start in data, -1 if none
             virtual int getFrameOffset(const unsigned char* data, unsigned int len) = 0;
+            // size of the frame at data, 0 if its header is cut at the end of data, -1 if it is no frame
             virtual int getFrameSize(const unsigned char* data, unsigned int len) = 0;
 
         private:
+            struct Frame {
+                const unsigned char* data {nullptr};
+                unsigned int size {0};
+            };
+
+            // parse without writing : the frame found (size 0 if none) and the bytes of data consumed
+            int nextFrame(const unsigned char* data, unsigned int len, Frame* frame);
+            // the frame of nextFrame has been written, its kept bytes can be reused
+            void releaseFrame(const Frame& frame);
+            void clearFrameBuffer();
+            void compactFrameBuffer();
+
             unsigned char* frame_buffer_ = nullptr;
             int frame_buffer_size_ {0};
 
-            int frame_buffer_filled_ {0};   // number of bytes written to frame_buffer_
+            // the kept bytes are at frame_buffer_start_, moved to the front only when the rest does not fit
+            int frame_buffer_start_ {0};
+            int frame_buffer_filled_ {0};   // number of bytes kept from frame_buffer_start_
             int frame_buffer_required_ {0}; // number of bytes required to complete a frame
     };
 
+    template <typename Writer>
+    int parser::parse(const unsigned char* data, unsigned int len, Writer&& writer)
+    {
+        if (len == 0) // handle EOS frame
+            return writer(data, len);
+
+        Frame frame;
+        int consumed = nextFrame(data, len, &frame);
+        if (frame.size == 0)
+            return consumed;
+
+        int written = writer(frame.data, frame.size);
+        if (written < 0) // buffer full : the same data is given again, a stitched frame is built again
+            return -1;
+        if (written == 0) { // failed, discard all data.
+            clear();
+            return len;
+        }
+        releaseFrame(frame);
+        return consumed;
+    }
 
 } //namespace NDL_Esplayer {
 
@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#if defined(__GNUC__)
+#include <immintrin.h>
+#define START_CODE_HAVE_AVX2 1
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define START_CODE_HAVE_NEON 1
+#endif
+
+#include "startcode.h"
+
+using namespace NDL_Esplayer;
+
+namespace {
+    int scanScalarFrom(const unsigned char* data, unsigned int len, unsigned int from)
+    {
+        // the byte 2 after a candidate is checked first : most bytes are > 1, skip 3 at once
+        unsigned int i = from;
+        while (i + 2 < len) {
+            unsigned char third = data[i + 2];
+            if (third > 1) {
+                i += 3;
+            } else if (third == 0) {
+                i += 1;
+            } else {
+                if (data[i] == 0 && data[i + 1] == 0)
+                    return (int)i;
+                i += 3;
+            }
+        }
+        return -1;
+    }
+
+    int scanScalar(const unsigned char* data, unsigned int len)
+    {
+        return scanScalarFrom(data, len, 0);
+    }
+
+#if defined(__SSE2__)
+    /**
+     * 16 candidates at a time : the bytes at i and i + 1 against 0, the one at i + 2 against 1
+     */
+    int scanSse2(const unsigned char* data, unsigned int len)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i one = _mm_set1_epi8(1);
+        unsigned int i = 0;
+        for (; i + 18 <= len; i += 16) {
+            __m128i a = _mm_loadu_si128((const __m128i*)(data + i));
+            __m128i b = _mm_loadu_si128((const __m128i*)(data + i + 1));
+            __m128i c = _mm_loadu_si128((const __m128i*)(data + i + 2));
+            __m128i hit = _mm_and_si128(_mm_cmpeq_epi8(_mm_or_si128(a, b), zero), _mm_cmpeq_epi8(c, one));
+            int bits = _mm_movemask_epi8(hit);
+            if (bits)
+                return (int)i + __builtin_ctz(bits);
+        }
+        return scanScalarFrom(data, len, i);
+    }
+#endif
+
+#if defined(START_CODE_HAVE_AVX2)
+    __attribute__((target("avx2")))
+    int scanAvx2(const unsigned char* data, unsigned int len)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i one = _mm256_set1_epi8(1);
+        unsigned int i = 0;
+        for (; i + 34 <= len; i += 32) {
+            __m256i a = _mm256_loadu_si256((const __m256i*)(data + i));
+            __m256i b = _mm256_loadu_si256((const __m256i*)(data + i + 1));
+            __m256i c = _mm256_loadu_si256((const __m256i*)(data + i + 2));
+            __m256i hit = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_or_si256(a, b), zero),
+                    _mm256_cmpeq_epi8(c, one));
+            unsigned int bits = (unsigned int)_mm256_movemask_epi8(hit);
+            if (bits)
+                return (int)i + __builtin_ctz(bits);
+        }
+        return scanScalarFrom(data, len, i);
+    }
+#endif
+
+#if defined(START_CODE_HAVE_NEON)
+    /**
+     * NEON has no movemask : a block with a hit is located by the scalar loop
+     */
+    int scanNeon(const unsigned char* data, unsigned int len)
+    {
+        const uint8x16_t zero = vdupq_n_u8(0);
+        const uint8x16_t one = vdupq_n_u8(1);
+        unsigned int i = 0;
+        for (; i + 18 <= len; i += 16) {
+            uint8x16_t hit = vandq_u8(vceqq_u8(vorrq_u8(vld1q_u8(data + i), vld1q_u8(data + i + 1)), zero),
+                    vceqq_u8(vld1q_u8(data + i + 2), one));
+            uint64x2_t lanes = vreinterpretq_u64_u8(hit);
+            if (vgetq_lane_u64(lanes, 0) | vgetq_lane_u64(lanes, 1))
+                return scanScalarFrom(data, i + 18, i);
+        }
+        return scanScalarFrom(data, len, i);
+    }
+#endif
+}
+
+StartCodeScanFunc NDL_Esplayer::getStartCodeScanFunc(CPU_SIMD simd)
+{
+    if (simd == CPU_SIMD_AUTO)
+        simd = getCpuSimd();
+    if (!isCpuSimdSupported(simd))
+        return nullptr;
+
+    switch (simd) {
+#if defined(__SSE2__)
+        case CPU_SIMD_SSE2: return scanSse2;
+#endif
+#if defined(START_CODE_HAVE_AVX2)
+        case CPU_SIMD_AVX2: return scanAvx2;
+#endif
+#if defined(START_CODE_HAVE_NEON)
+        case CPU_SIMD_NEON: return scanNeon;
+#endif
+        case CPU_SIMD_SCALAR: return scanScalar;
+        default:              return nullptr;
+    }
+}
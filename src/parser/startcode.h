@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#ifndef PARSER_STARTCODE_H_
+#define PARSER_STARTCODE_H_
+
+#include "cpufeatures.h"
+
+namespace NDL_Esplayer {
+
+    /**
+     * Offset of the first Annex-B start code prefix (00 00 01) in data, -1 if none.
+     * A prefix cut at the end of data is not found, the caller scans its last 2 bytes again
+     * with the next data. A 4 bytes start code is found at its second byte.
+     */
+    typedef int (*StartCodeScanFunc)(const unsigned char* data, unsigned int len);
+
+    /**
+     * Start code scan kernel of simd, the best one of the cpu for CPU_SIMD_AUTO.
+     * nullptr when the build or the cpu lacks simd
+     */
+    StartCodeScanFunc getStartCodeScanFunc(CPU_SIMD simd = CPU_SIMD_AUTO);
+
+} //namespace NDL_Esplayer
+
+#endif // #ifndef PARSER_STARTCODE_H_
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#if defined(__GNUC__)
+#include <immintrin.h>
+#define SYNC_SCAN_HAVE_AVX2 1
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SYNC_SCAN_HAVE_NEON 1
+#endif
+
+#include "syncscan.h"
+
+using namespace NDL_Esplayer;
+
+namespace {
+    int scanScalarFrom(const unsigned char* data, unsigned int len,
+            unsigned char sync0, unsigned char mask1, unsigned char sync1, unsigned int from)
+    {
+        for (unsigned int i = from; i < len; i++) {
+            if (data[i] == sync0 && (i + 1 == len || (data[i + 1] & mask1) == sync1))
+                return (int)i;
+        }
+        return -1;
+    }
+
+    int scanScalar(const unsigned char* data, unsigned int len,
+            unsigned char sync0, unsigned char mask1, unsigned char sync1)
+    {
+        return scanScalarFrom(data, len, sync0, mask1, sync1, 0);
+    }
+
+#if defined(__SSE2__)
+    /**
+     * 16 candidates at a time : the byte at i against sync0 and the one at i + 1 against sync1
+     */
+    int scanSse2(const unsigned char* data, unsigned int len,
+            unsigned char sync0, unsigned char mask1, unsigned char sync1)
+    {
+        const __m128i first = _mm_set1_epi8((char)sync0);
+        const __m128i mask = _mm_set1_epi8((char)mask1);
+        const __m128i second = _mm_set1_epi8((char)sync1);
+        unsigned int i = 0;
+        for (; i + 17 <= len; i += 16) {
+            __m128i a = _mm_loadu_si128((const __m128i*)(data + i));
+            __m128i b = _mm_loadu_si128((const __m128i*)(data + i + 1));
+            __m128i hit = _mm_and_si128(_mm_cmpeq_epi8(a, first),
+                    _mm_cmpeq_epi8(_mm_and_si128(b, mask), second));
+            int bits = _mm_movemask_epi8(hit);
+            if (bits)
+                return (int)i + __builtin_ctz(bits);
+        }
+        return scanScalarFrom(data, len, sync0, mask1, sync1, i);
+    }
+#endif
+
+#if defined(SYNC_SCAN_HAVE_AVX2)
+    __attribute__((target("avx2")))
+    int scanAvx2(const unsigned char* data, unsigned int len,
+            unsigned char sync0, unsigned char mask1, unsigned char sync1)
+    {
+        const __m256i first = _mm256_set1_epi8((char)sync0);
+        const __m256i mask = _mm256_set1_epi8((char)mask1);
+        const __m256i second = _mm256_set1_epi8((char)sync1);
+        unsigned int i = 0;
+        for (; i + 33 <= len; i += 32) {
+            __m256i a = _mm256_loadu_si256((const __m256i*)(data + i));
+            __m256i b = _mm256_loadu_si256((const __m256i*)(data + i + 1));
+            __m256i hit = _mm256_and_si256(_mm256_cmpeq_epi8(a, first),
+                    _mm256_cmpeq_epi8(_mm256_and_si256(b, mask), second));
+            unsigned int bits = (unsigned int)_mm256_movemask_epi8(hit);
+            if (bits)
+                return (int)i + __builtin_ctz(bits);
+        }
+        return scanScalarFrom(data, len, sync0, mask1, sync1, i);
+    }
+#endif
+
+#if defined(SYNC_SCAN_HAVE_NEON)
+    /**
+     * NEON has no movemask : a block with a hit is located by the scalar loop
+     */
+    int scanNeon(const unsigned char* data, unsigned int len,
+            unsigned char sync0, unsigned char mask1, unsigned char sync1)
+    {
+        const uint8x16_t first = vdupq_n_u8(sync0);
+        const uint8x16_t mask = vdupq_n_u8(mask1);
+        const uint8x16_t second = vdupq_n_u8(sync1);
+        unsigned int i = 0;
+        for (; i + 17 <= len; i += 16) {
+            uint8x16_t hit = vandq_u8(vceqq_u8(vld1q_u8(data + i), first),
+                    vceqq_u8(vandq_u8(vld1q_u8(data + i + 1), mask), second));
+            uint64x2_t lanes = vreinterpretq_u64_u8(hit);
+            if (vgetq_lane_u64(lanes, 0) | vgetq_lane_u64(lanes, 1))
+                return scanScalarFrom(data, i + 16, sync0, mask1, sync1, i);
+        }
+        return scanScalarFrom(data, len, sync0, mask1, sync1, i);
+    }
+#endif
+}
+
+SyncScanFunc NDL_Esplayer::getSyncScanFunc(CPU_SIMD simd)
+{
+    if (simd == CPU_SIMD_AUTO)
+        simd = getCpuSimd();
+    if (!isCpuSimdSupported(simd))
+        return nullptr;
+
+    switch (simd) {
+#if defined(__SSE2__)
+        case CPU_SIMD_SSE2: return scanSse2;
+#endif
+#if defined(SYNC_SCAN_HAVE_AVX2)
+        case CPU_SIMD_AVX2: return scanAvx2;
+#endif
+#if defined(SYNC_SCAN_HAVE_NEON)
+        case CPU_SIMD_NEON: return scanNeon;
+#endif
+        case CPU_SIMD_SCALAR: return scanScalar;
+        default:              return nullptr;
+    }
+}
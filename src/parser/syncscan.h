@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#ifndef PARSER_SYNCSCAN_H_
+#define PARSER_SYNCSCAN_H_
+
+#include "cpufeatures.h"
+
+namespace NDL_Esplayer {
+
+    /**
+     * Offset of the first sync word candidate in data :
+     * data[i] == sync0 and (data[i + 1] & mask1) == sync1, or the last byte if it is sync0
+     * (the rest of the sync word comes with the next data). return -1 if none
+     */
+    typedef int (*SyncScanFunc)(const unsigned char* data, unsigned int len,
+            unsigned char sync0, unsigned char mask1, unsigned char sync1);
+
+    /**
+     * Sync word scanner of simd, CPU_SIMD_AUTO for the fastest one of the cpu.
+     * All of them find the same candidates, nullptr when the build or the cpu lacks simd
+     */
+    SyncScanFunc getSyncScanFunc(CPU_SIMD simd = CPU_SIMD_AUTO);
+
+} //namespace NDL_Esplayer
+
+#endif // #ifndef PARSER_SYNCSCAN_H_
@@ -0,0 +1,288 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#include <algorithm>
+
+#include "videoparser.h"
+#include "ndl-directmedia2/media-common.h"
+
+#define LOGTAG "parser"
+#include "debug.h"
+
+using namespace NDL_Esplayer;
+
+videoparser::videoparser(bool hevc, CPU_SIMD simd)
+    : hevc_(hevc)
+    , scan_(getStartCodeScanFunc(simd) ? getStartCodeScanFunc(simd) : getStartCodeScanFunc(CPU_SIMD_SCALAR))
+{
+}
+
+void videoparser::push(const unsigned char* data, unsigned int len)
+{
+    keepChunk();
+
+    chunk_ = data;
+    chunk_size_ = (int)len;
+    chunk_start_ = kept_;
+}
+
+bool videoparser::next(AccessUnit* au)
+{
+    const int header = nalHeaderSize(hevc_);
+    while (true) {
+        const int size = this->size();
+        int code = findStartCode(scanned_);
+        if (code < 0) {
+            scanned_ = std::max(scanned_, size - 2);
+            if (ended_ && au_start_ >= 0 && au_has_vcl_) {
+                take(au, size);
+                return true;
+            }
+            keepChunk();
+            return false;
+        }
+
+        const int nal = code + 3;
+        if (nal + header > size) {
+            if (!ended_) {
+                // the NAL header comes with the next chunk
+                scanned_ = code;
+                keepChunk();
+                return false;
+            }
+            scanned_ = size;
+            continue;
+        }
+        scanned_ = nal;
+
+        // a zero before the prefix is the zero_byte of a 4 bytes start code : it goes with the NAL
+        const int nal_start = (code > 0 && byteAt(code - 1) == 0) ? code - 1 : code;
+        unsigned char tmp[3];
+        const NalInfo info = classify(hevc_, bytesAt(nal, header, tmp), max_temporal_id_);
+        if (info.max_temporal_id >= 0)
+            max_temporal_id_ = info.max_temporal_id;
+
+        bool taken = false;
+        if (au_start_ < 0) {
+            au_start_ = nal_start;  // bytes before the first start code are dropped
+        } else if (info.starts_au && au_has_vcl_) {
+            take(au, nal_start);
+            taken = true;
+        }
+
+        if (info.vcl) {
+            au_has_vcl_ = true;
+            au_key_ = au_key_ || info.key;
+            au_reference_ = au_reference_ || info.reference;
+        }
+        if (taken)
+            return true;
+    }
+}
+
+void videoparser::end()
+{
+    ended_ = true;
+}
+
+void videoparser::clear()
+{
+    buffer_.clear();
+    kept_ = 0;
+    chunk_ = nullptr;
+    chunk_size_ = 0;
+    au_start_ = -1;
+    scanned_ = 0;
+    chunk_start_ = 0;
+    ended_ = false;
+    resetAccessUnit();
+}
+
+/**
+ * H.264 7.4.1.2.3 and HEVC 7.4.2.4.4 : order of the NAL units in an access unit.
+ * The first slice of a picture is told by first_mb_in_slice == 0 (H.264, without ASO)
+ * or first_slice_segment_in_pic_flag (HEVC), the first bit after the NAL header.
+ * A sub-layer non-reference picture (HEVC 7.4.2.2) may still be referenced by the pictures
+ * of the higher sub-layers : it is droppable only in the highest one (TemporalId of
+ * sps_max_sub_layers_minus1, 0 in a single sub-layer stream).
+ */
+videoparser::NalInfo videoparser::classify(bool hevc, const unsigned char* nal, int max_temporal_id)
+{
+    NalInfo info = {false, false, false, false, -1};
+    if (!hevc) {
+        int type = nal[0] & 0x1F;
+        if (type >= 1 && type <= 5) {
+            info.vcl = true;
+            info.starts_au = (nal[1] & 0x80) != 0;
+            info.key = (type == 5);
+            info.reference = (nal[0] & 0x60) != 0;  // nal_ref_idc
+        } else {
+            // SEI, SPS, PPS, AUD, prefix NAL, subset SPS and reserved 16..18
+            info.starts_au = (type >= 6 && type <= 9) || (type >= 14 && type <= 18);
+        }
+        return info;
+    }
+
+    int type = (nal[0] >> 1) & 0x3F;
+    int layer = ((nal[0] & 0x01) << 5) | (nal[1] >> 3);
+    if (layer > 0)  // other layers of the same access unit
+        return info;
+    if (type < 32) {
+        int temporal_id = (nal[1] & 0x07) - 1;
+        bool sub_layer_non_reference = (type <= 14 && type % 2 == 0);
+        info.vcl = true;
+        info.starts_au = (nal[2] & 0x80) != 0;
+        info.key = (type >= 16 && type <= 23);          // IRAP : BLA, IDR, CRA
+        info.reference = !sub_layer_non_reference || max_temporal_id < 0 || temporal_id != max_temporal_id;
+    } else {
+        // SPS : sps_video_parameter_set_id (4 bits), sps_max_sub_layers_minus1 (3 bits)
+        if (type == 33)
+            info.max_temporal_id = (nal[2] >> 1) & 0x07;
+        // VPS, SPS, PPS, AUD, prefix SEI and reserved 41..44, 48..55
+        info.starts_au = (type >= 32 && type <= 35) || type == 39 ||
+            (type >= 41 && type <= 44) || (type >= 48 && type <= 55);
+    }
+    return info;
+}
+
+uint32_t videoparser::frameFlags(const unsigned char* data, unsigned int len)
+{
+    const int header = nalHeaderSize(hevc_);
+    bool key = false;
+    bool vcl = false;
+    bool reference = false;
+    unsigned int pos = 0;
+    while (pos < len) {
+        int found = scan_(data + pos, len - pos);
+        if (found < 0)
+            break;
+        pos += found + 3;
+        if (pos + header > len)
+            break;
+        NalInfo info = classify(hevc_, data + pos, max_temporal_id_);
+        if (info.max_temporal_id >= 0)
+            max_temporal_id_ = info.max_temporal_id;
+        vcl = vcl || info.vcl;
+        key = key || (info.vcl && info.key);
+        reference = reference || (info.vcl && info.reference);
+    }
+    // without a slice (parameter sets, SEI or no NAL found) the frame is not known to be droppable
+    return (key ? NDL_ESP_FLAG_KEY_FRAME : 0) | (vcl && !reference ? NDL_ESP_FLAG_NON_REFERENCE : 0);
+}
+
+const unsigned char* videoparser::bytesAt(int pos, int len, unsigned char* tmp) const
+{
+    if (pos >= kept_)
+        return chunk_ + pos - kept_;
+    if (pos + len <= kept_)
+        return buffer_.data() + pos;
+    for (int i = 0; i < len; i++)
+        tmp[i] = byteAt(pos + i);
+    return tmp;
+}
+
+int videoparser::findStartCode(int pos) const
+{
+    const int size = this->size();
+    if (pos < kept_) {
+        int found = kept_ - pos >= 3 ? scan_(buffer_.data() + pos, kept_ - pos) : -1;
+        if (found >= 0)
+            return pos + found;
+        // a prefix cut at the end of the kept bytes
+        for (int code = std::max(pos, kept_ - 2); code < kept_ && code + 2 < size; code++) {
+            if (byteAt(code) == 0 && byteAt(code + 1) == 0 && byteAt(code + 2) == 1)
+                return code;
+        }
+        pos = kept_;
+    }
+    if (size - pos < 3)
+        return -1;
+    int found = scan_(chunk_ + pos - kept_, size - pos);
+    return found < 0 ? -1 : pos + found;
+}
+
+void videoparser::keepChunk()
+{
+    if (!chunk_)
+        return;
+
+    // the access unit not complete yet, or before the first one a prefix cut at the end or a start code
+    // waiting for its NAL header (with the zero_byte before it)
+    const int keep = au_start_ >= 0 ? au_start_ :
+        std::min(std::max(scanned_ - 1, 0), std::max(size() - 2, 0));
+    buffer_.resize(kept_);  // a stitched access unit
+    if (keep >= kept_) {
+        buffer_.assign(chunk_ + keep - kept_, chunk_ + chunk_size_);
+    } else {
+        buffer_.erase(buffer_.begin(), buffer_.begin() + keep);
+        buffer_.insert(buffer_.end(), chunk_, chunk_ + chunk_size_);
+    }
+
+    chunk_start_ = std::max(kept_ - keep, 0);
+    scanned_ -= keep;
+    if (au_start_ >= 0)
+        au_start_ -= keep;
+    kept_ = (int)buffer_.size();
+    chunk_ = nullptr;
+    chunk_size_ = 0;
+
+    if (au_start_ >= 0 && kept_ - au_start_ > VIDEO_PARSER_MAX_AU_SIZE) {
+        NDLLOG(LOGTAG, NDL_LOGE, "%s : no access unit end in %d bytes, dropped", __func__, VIDEO_PARSER_MAX_AU_SIZE);
+        clear();
+    }
+}
+
+void videoparser::take(AccessUnit* au, int end)
+{
+    if (au_start_ >= kept_) {
+        au->data = chunk_ + au_start_ - kept_;
+    } else {
+        // stitched : the bytes of the chunk are appended to the ones kept
+        if (end > kept_)
+            buffer_.insert(buffer_.end(), chunk_, chunk_ + end - kept_);
+        au->data = buffer_.data() + au_start_;
+    }
+    au->size = end - au_start_;
+    au->flags = (au_key_ ? NDL_ESP_FLAG_KEY_FRAME : 0) | (au_reference_ ? 0 : NDL_ESP_FLAG_NON_REFERENCE);
+    au->in_chunk = au_start_ >= chunk_start_;
+    au_start_ = end;
+    resetAccessUnit();
+}
+
+void videoparser::resetAccessUnit()
+{
+    au_has_vcl_ = false;
+    au_key_ = false;
+    au_reference_ = false;
+}
+
+std::shared_ptr<videoparser> NDL_Esplayer::createVideoParser(NDL_ESP_VIDEO_CODEC codec, CPU_SIMD simd)
+{
+    switch (codec) {
+        case NDL_ESP_VIDEO_CODEC_H264:
+            return std::make_shared<videoparser>(false, simd);
+        case NDL_ESP_VIDEO_CODEC_H265:
+            return std::make_shared<videoparser>(true, simd);
+        default:
+            NDLLOG(LOGTAG, NDL_LOGE, "%s: no parser for video codec:%d", __func__, codec);
+            return nullptr;
+    }
+}
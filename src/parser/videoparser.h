@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#ifndef PARSER_VIDEOPARSER_H_
+#define PARSER_VIDEOPARSER_H_
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+#include "ndl-directmedia2/media-types.h"
+#include "startcode.h"
+
+// an access unit growing beyond it is dropped (lost start codes)
+#define VIDEO_PARSER_MAX_AU_SIZE    (8 * 1024 * 1024)
+
+namespace NDL_Esplayer {
+
+    /**
+     * Splitter of an Annex-B H.264/HEVC byte stream into access units.
+     * The start codes are found by the SIMD kernel, the NAL headers tell where an access unit
+     * starts (AUD, parameter sets, prefix SEI or the first slice of a picture after a picture)
+     * and what it is : IDR (H.264) / IRAP (HEVC), reference or not.
+     * A chunk is read in place : an access unit in it is a view into the chunk, only one straddling
+     * chunks is stitched in the buffer of the parser.
+     */
+    class videoparser {
+        public:
+            struct AccessUnit {
+                const unsigned char* data;
+                unsigned int size;
+                uint32_t flags;     // NDL_ESP_FLAG_KEY_FRAME, NDL_ESP_FLAG_NON_REFERENCE
+                bool in_chunk;      // starts in the chunk of the last push
+            };
+
+            struct NalInfo {
+                bool vcl;
+                bool starts_au;     // a new access unit starts with it when the current one has a picture
+                bool key;
+                bool reference;
+                int max_temporal_id;    // sps_max_sub_layers_minus1 of an HEVC SPS, -1 for the other NAL units
+            };
+
+            /**
+             * Kind of the NAL at nal (its header, past the start code or the length),
+             * which has at least nalHeaderSize bytes.
+             * max_temporal_id : highest TemporalId of the HEVC stream (from its SPS), -1 until it is known
+             */
+            static NalInfo classify(bool hevc, const unsigned char* nal, int max_temporal_id);
+            // bytes of the NAL header and of the slice header up to its first slice flag
+            static int nalHeaderSize(bool hevc) { return hevc ? 3 : 2; }
+
+            explicit videoparser(bool hevc, CPU_SIMD simd = CPU_SIMD_AUTO);
+
+            /**
+             * Parse a chunk of any size, data is read until next returns false
+             * (then the bytes of the access unit not complete yet are kept)
+             */
+            void push(const unsigned char* data, unsigned int len);
+            /**
+             * Take the next access unit completed by the chunks (or by end), false if none.
+             * au is a view into the chunk, or into the buffer of the parser until the next call
+             * when it is stitched from earlier chunks
+             */
+            bool next(AccessUnit* au);
+            /**
+             * End of stream : the bytes after the last start code complete the last access unit
+             */
+            void end();
+            void clear();
+            /**
+             * true if the access unit not complete yet starts in the chunk of the last push
+             */
+            bool startedInChunk() const { return au_start_ >= chunk_start_; }
+
+            /**
+             * Flags of one whole access unit (framed input), as next gives them
+             * (an SPS in it updates the highest TemporalId of the stream)
+             */
+            uint32_t frameFlags(const unsigned char* data, unsigned int len);
+
+        private:
+            // the bytes kept then the chunk make the stream, a position is in buffer_ before kept_
+            int size() const { return kept_ + chunk_size_; }
+            unsigned char byteAt(int pos) const { return pos < kept_ ? buffer_[pos] : chunk_[pos - kept_]; }
+            // len bytes at pos in one piece, copied in tmp when they straddle the chunk
+            const unsigned char* bytesAt(int pos, int len, unsigned char* tmp) const;
+            // position of the first start code prefix from pos, -1 if none
+            int findStartCode(int pos) const;
+            // the chunk is done : keep its bytes still needed
+            void keepChunk();
+            void take(AccessUnit* au, int end);
+            void resetAccessUnit();
+
+            const bool hevc_;
+            StartCodeScanFunc scan_;
+
+            std::vector<unsigned char> buffer_;     // bytes kept from the earlier chunks, then a stitched access unit
+            int kept_ {0};
+            const unsigned char* chunk_ {nullptr};
+            int chunk_size_ {0};
+
+            int au_start_ {-1};         // -1 before the first start code
+            int scanned_ {0};           // start codes before it are handled
+            int chunk_start_ {0};       // of the last push, in buffer_ once it is kept
+            bool ended_ {false};
+
+            // access unit from au_start_
+            bool au_has_vcl_ {false};
+            bool au_key_ {false};
+            bool au_reference_ {false};
+
+            int max_temporal_id_ {-1};  // HEVC : from the last SPS, kept across clear
+    };
+
+    /**
+     * Splitter of the byte stream of the codec into access units (H.264, HEVC), nullptr for the others.
+     * simd : start code scan kernel, see getStartCodeScanFunc
+     */
+    std::shared_ptr<videoparser> createVideoParser(NDL_ESP_VIDEO_CODEC codec,
+            CPU_SIMD simd = CPU_SIMD_AUTO);
+
+} //namespace NDL_Esplayer
+
+#endif // #ifndef PARSER_VIDEOPARSER_H_
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+
+#include "ptstimeline.h"
+
+using namespace NDL_Esplayer;
+
+static uint64_t gcd(uint64_t a, uint64_t b)
+{
+    while (b) {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/**
+ * a * b / c with a < c < 2^32 and b < 2^53, in 32 bit digits (no 128 bit type on 32 bit ARM)
+ */
+static uint64_t mulDivSmall(uint64_t a, uint64_t b, uint64_t c)
+{
+    uint64_t high = a * (b >> 32);            // < 2^53
+    uint64_t low = a * (b & 0xffffffffULL);   // < 2^64
+    high += low >> 32;
+    uint64_t q = high / c;
+    uint64_t rest = ((high % c) << 32) | (low & 0xffffffffULL);
+    return (q << 32) + rest / c;
+}
+
+PtsTimeline::PtsTimeline()
+    : PtsTimeline(PTS_DEFAULT_NUM, PTS_DEFAULT_DEN, PTS_DEFAULT_WRAP_BITS)
+{
+}
+
+PtsTimeline::PtsTimeline(uint32_t num, uint32_t den, int wrap_bits)
+{
+    if (!isValid(num, den, wrap_bits)) {
+        num = PTS_DEFAULT_NUM;
+        den = PTS_DEFAULT_DEN;
+        wrap_bits = PTS_DEFAULT_WRAP_BITS;
+    }
+    scale_num_ = (uint64_t)num * 1000000;
+    scale_den_ = den;
+    uint64_t div = gcd(scale_num_, scale_den_);
+    scale_num_ /= div;
+    scale_den_ /= div;
+    wrap_ = wrap_bits ? (int64_t)1 << wrap_bits : 0;
+}
+
+bool PtsTimeline::isValid(uint32_t num, uint32_t den, int wrap_bits)
+{
+    return num > 0 && den > 0 && wrap_bits >= 0 && wrap_bits <= PTS_MAX_WRAP_BITS;
+}
+
+int64_t PtsTimeline::toMicrosecond(int64_t ticks) const
+{
+    if (ticks < 0)
+        return -toMicrosecond(-ticks);
+
+    uint64_t t = ticks;
+    if (scale_den_ == 1)
+        return t * scale_num_;
+    // whole periods of the reduced scale, then the remainder (< scale_den_ < 2^32)
+    return (t / scale_den_) * scale_num_ + mulDivSmall(t % scale_den_, scale_num_, scale_den_);
+}
+
+int64_t PtsTimeline::unwrap(int64_t pts)
+{
+    if (wrap_ == 0) {
+        previous_ = pts;
+        return pts;
+    }
+
+    if (previous_ - pts > wrap_ / 2) { // pts drop detected
+        if (drop_count_ < PTS_WRAP_DROP_THRESHOLD) {
+            // just adjust pts, don't increase base_
+            //  don't save current pts here (it'll generate next drop even if there's no real drop)
+            drop_count_++;
+            return pts + base_ + wrap_;
+        }
+        // submit pts wraparound
+        drop_count_ = 0;
+        base_ += wrap_;
+    } else {
+        drop_count_ = 0;
+    }
+    previous_ = pts;
+    return pts + base_;
+}
+
+int64_t PtsTimeline::unwrapNear(int64_t pts) const
+{
+    int64_t base = base_;
+    if (wrap_ && previous_ != -1) {
+        if (previous_ - pts > wrap_ / 2)
+            base += wrap_;
+        else if (pts - previous_ > wrap_ / 2 && base >= wrap_)
+            base -= wrap_;
+    }
+    return pts + base;
+}
+
+void PtsTimeline::reset()
+{
+    base_ = 0;
+    previous_ = -1;
+    drop_count_ = 0;
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+
+#ifndef NDL_DIRECTMEDIA2_PTS_TIMELINE_H_
+#define NDL_DIRECTMEDIA2_PTS_TIMELINE_H_
+
+#include <stdint.h>
+
+// MPEG-2 TS/PES pts : 90kHz ticks in a 33 bit counter
+#define PTS_DEFAULT_NUM             1
+#define PTS_DEFAULT_DEN             90000
+#define PTS_DEFAULT_WRAP_BITS       33
+#define PTS_MAX_WRAP_BITS           62
+// consecutive pts drops taken as a wraparound, fewer are a discontinuity of the stream
+#define PTS_WRAP_DROP_THRESHOLD     10
+
+namespace NDL_Esplayer {
+
+    /**
+     * Timestamps of one stream in ticks of num/den second, from a counter of wrap_bits
+     * bits going back to 0 (0 : 64 bit counter, no wraparound), to unwrapped microseconds.
+     */
+    class PtsTimeline {
+        public:
+            PtsTimeline();
+            PtsTimeline(uint32_t num, uint32_t den, int wrap_bits);
+
+            static bool isValid(uint32_t num, uint32_t den, int wrap_bits);
+
+            /**
+             * ticks to microseconds without overflow of the intermediate product, rounded toward 0
+             */
+            int64_t toMicrosecond(int64_t ticks) const;
+
+            /**
+             * Unwrapped ticks of the next pts of the stream.
+             * A pts more than half the counter below the previous one is a wraparound once
+             * PTS_WRAP_DROP_THRESHOLD come in a row, the ones before are moved up by the wrap
+             * without changing the base.
+             */
+            int64_t unwrap(int64_t pts);
+            /**
+             * Unwrapped ticks of a pts of another stream sharing the counter (alternate track),
+             * which wraps a little before or after this one. The state is not changed.
+             */
+            int64_t unwrapNear(int64_t pts) const;
+
+            /**
+             * The counter wrapped before the first pts (stream joined after a wraparound)
+             */
+            void addWrap() { base_ += wrap_; }
+            // ticks of one wraparound, 0 if none
+            int64_t wrap() const { return wrap_; }
+            // the last pts before unwrapping, -1 before the first one
+            int64_t previous() const { return previous_; }
+            void reset();
+
+        private:
+            uint64_t scale_num_;    // microseconds = ticks * scale_num_ / scale_den_, reduced
+            uint64_t scale_den_;
+            int64_t wrap_;
+            int64_t base_ {0};      // increase by wrap_ on each wraparound
+            int64_t previous_ {-1};
+            int drop_count_ {0};
+    };
+
+} //namespace NDL_Esplayer
+
+#endif //NDL_DIRECTMEDIA2_PTS_TIMELINE_H_
@@ -253,10 +253,29 @@ int OmxClock::getRealTime(int64_t* start_time, int64_t* current_time)
     return -1;
 }
 
-//Not support in RPI
+/**
+ * Media time of the running clock (OMX_IndexConfigTimeCurrentMediaTime), start_time : its start time
+ */
 int OmxClock::getMediaTime(int64_t* start_time, int64_t* current_time)
 {
-    return -1;
+    if (!clock_)
+        return NDL_ESP_RESULT_FAIL;
+
+    OMX_TIME_CONFIG_CLOCKSTATETYPE clock_state;
+    omx_init_structure(&clock_state, OMX_TIME_CONFIG_CLOCKSTATETYPE);
+    if (clock_->getConfig(OMX_IndexConfigTimeClockState, &clock_state) != OMX_ErrorNone
+            || clock_state.eState != OMX_TIME_ClockStateRunning)
+        return NDL_ESP_RESULT_FAIL;
+
+    OMX_TIME_CONFIG_TIMESTAMPTYPE media_time;
+    omx_init_structure(&media_time, OMX_TIME_CONFIG_TIMESTAMPTYPE);
+    media_time.nPortIndex = OMX_ALL;
+    if (clock_->getConfig(OMX_IndexConfigTimeCurrentMediaTime, &media_time) != OMX_ErrorNone)
+        return NDL_ESP_RESULT_FAIL;
+
+    *start_time = from_omx_time(clock_state.nStartTime);
+    *current_time = from_omx_time(media_time.nTimestamp);
+    return NDL_ESP_RESULT_SUCCESS;
 }
 
 int OmxClock::onCallback(int event,
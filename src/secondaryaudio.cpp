@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#include <algorithm>
+
+#include "secondaryaudio.h"
+#include "ndl-directmedia2/media-common.h"
+
+using namespace NDL_Esplayer;
+
+#define LOGTAG "secondaryaudio"
+#include "debug.h"
+
+SecondaryAudio::SecondaryAudio()
+    : mix_func_(getAudioMixFunc())
+{
+}
+
+void SecondaryAudio::open(std::shared_ptr<AudioSwDecoder> decoder, int channels, int sample_rate)
+{
+    decoder->SetOutputChannels(channels);
+    decoder->SetOutputSampleRate(sample_rate);
+
+    std::lock_guard<std::mutex> decode_lock(decode_lock_);
+    std::lock_guard<std::mutex> lock(lock_);
+    decoder_ = decoder;
+    channels_ = channels;
+    sample_rate_ = sample_rate;
+    blocks_.clear();
+    queued_frames_ = 0;
+    has_pts_ = false;
+    NDLLOG(LOGTAG, NDL_LOGI, "%s: mixed as %dch %dHz, volume %.2f, ducking %d",
+            __func__, channels, sample_rate, volume_, ducking_);
+}
+
+void SecondaryAudio::close()
+{
+    std::lock_guard<std::mutex> decode_lock(decode_lock_);
+    std::lock_guard<std::mutex> lock(lock_);
+    decoder_ = nullptr;
+    blocks_.clear();
+    queued_frames_ = 0;
+    resetDucking();
+}
+
+bool SecondaryAudio::isOpen()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    return decoder_ != nullptr;
+}
+
+int SecondaryAudio::push(const uint8_t* data, int size, int64_t pts)
+{
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        if (!decoder_)
+            return NDL_ESP_RESULT_FAIL;
+        if (queued_frames_ >= usToFrames(SECONDARY_AUDIO_MAX_QUEUE_MS * 1000LL))
+            return NDL_ESP_RESULT_FEED_FULL;
+    }
+
+    // decoded outside of lock_, mix does not wait for it
+    std::lock_guard<std::mutex> decode_lock(decode_lock_);
+    if (!decoder_)
+        return NDL_ESP_RESULT_FAIL;
+    if (pts >= 0)
+        has_pts_ = true;
+
+    int ret = decoder_->DecodeAudio((unsigned char*)data, size, pts, pts);
+    int bytes = decoder_->GetOutputBufferSize();
+    if (bytes <= 0)
+        return ret;
+
+    Block block;
+    // a packet without pts continues the previous one
+    block.pts = has_pts_ ? decoder_->GetOutputPts() : -1;
+    block.read = 0;
+    block.samples.resize(bytes / sizeof(int16_t));
+    decoder_->ReadOutput((unsigned char*)block.samples.data(), bytes);
+
+    std::lock_guard<std::mutex> lock(lock_);
+    queued_frames_ += bytes / (channels_ * (int)sizeof(int16_t));
+    blocks_.push_back(std::move(block));
+    return ret;
+}
+
+void SecondaryAudio::setMix(int volume, int ducking)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    volume_ = std::min(std::max(volume, 0), 100) / 100.0f;
+    ducking_ = std::min(std::max(ducking, 0), 100);
+    if (ducked_)
+        duck_.setVolume(ducking_, SECONDARY_AUDIO_DUCK_RAMP_MS, EASE_TYPE_LINEAR);
+    NDLLOG(LOGTAG, NDL_LOGI, "%s: volume %.2f, ducking %d", __func__, volume_, ducking_);
+}
+
+void SecondaryAudio::mix(int16_t* samples, int frames, int64_t pts)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!decoder_ || frames <= 0)
+        return;
+
+    // secondary audio the main stream has passed (ex. fed late)
+    while (pts >= 0 && !blocks_.empty() && blocks_.front().pts >= 0) {
+        const Block& block = blocks_.front();
+        int block_frames = (int)block.samples.size() / channels_;
+        if (block.pts + framesToUs(block_frames) > pts - SECONDARY_AUDIO_SYNC_US)
+            break;
+        queued_frames_ -= block_frames - block.read;
+        blocks_.pop_front();
+    }
+
+    // ducking starts ahead by the ramp, the main level is down when the secondary audio starts
+    bool playing = !blocks_.empty();
+    if (playing && pts >= 0 && blocks_.front().pts >= 0) {
+        const Block& block = blocks_.front();
+        playing = block.pts + framesToUs(block.read) <
+            pts + framesToUs(frames) + SECONDARY_AUDIO_DUCK_RAMP_MS * 1000LL;
+    }
+    updateDucking(playing, frames);
+    duck_.process(samples, frames, channels_, sample_rate_);
+
+    mixBlocks(samples, frames, pts);
+}
+
+bool SecondaryAudio::isActive()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    return decoder_ && (!blocks_.empty() || !duck_.isPassthrough());
+}
+
+void SecondaryAudio::flush()
+{
+    std::lock_guard<std::mutex> decode_lock(decode_lock_);
+    std::lock_guard<std::mutex> lock(lock_);
+    if (decoder_)
+        decoder_->DiscardOutput();
+    blocks_.clear();
+    queued_frames_ = 0;
+    resetDucking();
+}
+
+int64_t SecondaryAudio::usToFrames(int64_t us) const
+{
+    return (us * sample_rate_ + 500000) / 1000000;
+}
+
+/**
+ * Add the queued samples at their position in the main frames.
+ * Blocks are consumed in order, a gap in the secondary pts leaves the main frames as they are.
+ */
+void SecondaryAudio::mixBlocks(int16_t* samples, int frames, int64_t pts)
+{
+    int done = 0;  // main frames before it have the secondary samples due there
+    while (!blocks_.empty() && done < frames) {
+        Block& block = blocks_.front();
+        int block_frames = (int)block.samples.size() / channels_;
+        int offset = done;
+
+        if (pts >= 0 && block.pts >= 0) {
+            int64_t diff = block.pts + framesToUs(block.read) - (pts + framesToUs(done));
+            if (diff > SECONDARY_AUDIO_SYNC_US) {
+                offset = done + (int)usToFrames(diff);
+                if (offset >= frames)
+                    break;
+            } else if (diff < -SECONDARY_AUDIO_SYNC_US) {
+                int late = (int)std::min<int64_t>(usToFrames(-diff), block_frames - block.read);
+                block.read += late;
+                queued_frames_ -= late;
+                if (block.read >= block_frames)
+                    blocks_.pop_front();
+                continue;
+            }
+        }
+
+        int count = std::min(block_frames - block.read, frames - offset);
+        mix_func_(samples + offset * channels_, block.samples.data() + block.read * channels_,
+                volume_, count * channels_);
+        block.read += count;
+        queued_frames_ -= count;
+        done = offset + count;
+        if (block.read >= block_frames)
+            blocks_.pop_front();
+    }
+}
+
+void SecondaryAudio::updateDucking(bool playing, int frames)
+{
+    if (playing) {
+        silent_frames_ = 0;
+        if (!ducked_ && ducking_ < 100) {
+            duck_.setVolume(ducking_, SECONDARY_AUDIO_DUCK_RAMP_MS, EASE_TYPE_LINEAR);
+            ducked_ = true;
+        }
+        return;
+    }
+
+    silent_frames_ = std::min(silent_frames_ + frames, sample_rate_);
+    if (ducked_ && silent_frames_ >= usToFrames(SECONDARY_AUDIO_DUCK_HOLD_MS * 1000LL)) {
+        duck_.setVolume(100, SECONDARY_AUDIO_DUCK_RAMP_MS, EASE_TYPE_LINEAR);
+        ducked_ = false;
+    }
+}
+
+void SecondaryAudio::resetDucking()
+{
+    duck_.setVolume(100, 0, EASE_TYPE_LINEAR);
+    ducked_ = false;
+    silent_frames_ = 0;
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#ifndef NDL_DIRECTMEDIA2_SECONDARY_AUDIO_H_
+#define NDL_DIRECTMEDIA2_SECONDARY_AUDIO_H_
+
+#include <stdint.h>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "audioconvert.h"
+#include "audiogain.h"
+#include "audioswdecoder.h"
+
+// decoded secondary audio kept ahead of the main stream, feeds beyond it get FEED_FULL
+#define SECONDARY_AUDIO_MAX_QUEUE_MS    3000
+// main stream level change when the secondary stream starts or stops
+#define SECONDARY_AUDIO_DUCK_RAMP_MS    150
+// pause of the secondary stream (ex. between sentences) before the main level comes back
+#define SECONDARY_AUDIO_DUCK_HOLD_MS    500
+// pts difference mixed as continuous audio, more is a gap or a drop
+#define SECONDARY_AUDIO_SYNC_US         1000
+
+namespace NDL_Esplayer {
+
+    /**
+     * Secondary audio ES (audio description, commentary) mixed into the main pcm.
+     * push decodes on the feeding thread into S16 of the main output layout and rate,
+     * mix adds the samples due at the pts of each main chunk before it goes to the audio codec.
+     * pts < 0 on both sides : mixed in feeding order (audio only playback has no pts)
+     */
+    class SecondaryAudio {
+        public:
+            SecondaryAudio();
+
+            /**
+             * Take an opened decoder, its output is set to channels/sample_rate of the main stream
+             */
+            void open(std::shared_ptr<AudioSwDecoder> decoder, int channels, int sample_rate);
+            void close();
+            bool isOpen();
+
+            /**
+             * Decode one packet of the secondary ES, pts(us) < 0 if none.
+             * return consumed bytes, NDL_ESP_RESULT_FEED_FULL if enough is queued, < 0 on error
+             */
+            int push(const uint8_t* data, int size, int64_t pts);
+
+            /**
+             * volume(0~100) of the secondary stream,
+             * ducking(0~100) level of the main stream while the secondary one is playing (100 : no ducking)
+             */
+            void setMix(int volume, int ducking);
+
+            /**
+             * Duck and mix in place the interleaved S16 main frames starting at pts(us)
+             */
+            void mix(int16_t* samples, int frames, int64_t pts);
+
+            /**
+             * true if mix may change the samples (secondary audio queued or main level not back)
+             */
+            bool isActive();
+
+            /**
+             * Drop the queued and buffered secondary samples (seek)
+             */
+            void flush();
+
+        private:
+            struct Block {
+                int64_t pts;                   // of the first sample, < 0 if none
+                std::vector<int16_t> samples;
+                int read;                      // frames already mixed
+            };
+
+            int64_t framesToUs(int64_t frames) const { return frames * 1000000 / sample_rate_; }
+            int64_t usToFrames(int64_t us) const;
+            void mixBlocks(int16_t* samples, int frames, int64_t pts);
+            void updateDucking(bool playing, int frames);
+            void resetDucking();
+
+            std::mutex decode_lock_;       // decoder_ and has_pts_, taken before lock_
+            std::mutex lock_;
+            std::shared_ptr<AudioSwDecoder> decoder_;
+            bool has_pts_ {false};
+            std::deque<Block> blocks_;
+            int queued_frames_ {0};
+            int channels_ {2};
+            int sample_rate_ {48000};
+            AudioMixFunc mix_func_;
+
+            float volume_ {1.0f};
+            int ducking_ {100};
+            AudioGain duck_;               // main stream level
+            bool ducked_ {false};
+            int silent_frames_ {0};        // since the last secondary sample, ducking ends after the hold
+    };
+
+} //namespace NDL_Esplayer
+
+#endif //NDL_DIRECTMEDIA2_SECONDARY_AUDIO_H_
@@ -0,0 +1,364 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+
+#include "standbyaudio.h"
+#include "ndl-directmedia2/media-common.h"
+
+using namespace NDL_Esplayer;
+
+#define LOGTAG "standbyaudio"
+#include "debug.h"
+
+namespace {
+    int64_t threadCpuNs()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+    }
+}
+
+StandbyAudioTrack::StandbyAudioTrack(std::shared_ptr<AudioSwDecoder> decoder, int channels, int sample_rate,
+        int window_ms)
+    : decoder_(decoder)
+    , channels_(channels)
+    , sample_rate_(sample_rate)
+    , window_frames_((int)((int64_t)sample_rate * window_ms / 1000))
+{
+    decoder_->SetOutputChannels(channels);
+    decoder_->SetOutputSampleRate(sample_rate);
+    // a packet decoded when the window is nearly full still fits (8192 : longest frame of the codecs)
+    capacity_ = window_frames_ + 8192;
+    ring_.resize((size_t)capacity_ * channels_);
+}
+
+int StandbyAudioTrack::push(const uint8_t* data, int size, int64_t pts)
+{
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        if (size_ >= window_frames_)
+            return NDL_ESP_RESULT_FEED_FULL;
+    }
+
+    // decoded outside of lock_, the output thread does not wait for it
+    std::lock_guard<std::mutex> decode_lock(decode_lock_);
+    int64_t begin = threadCpuNs();
+    int ret = decoder_->DecodeAudio((unsigned char*)data, size, pts, pts);
+    int bytes = decoder_->GetOutputBufferSize();
+    int64_t block_pts = decoder_->GetOutputPts();
+    if (bytes > 0) {
+        decoded_.resize(bytes);
+        decoder_->ReadOutput(decoded_.data(), bytes);
+    }
+    int64_t cost = threadCpuNs() - begin;
+
+    std::lock_guard<std::mutex> lock(lock_);
+    decode_ns_ += cost;
+    if (bytes > 0) {
+        int frames = bytes / (channels_ * (int)sizeof(int16_t));
+        decoded_frames_ += frames;
+        append((const int16_t*)decoded_.data(), frames, block_pts);
+    }
+    return ret;
+}
+
+void StandbyAudioTrack::peek(int16_t* dst, int frames, int64_t pts)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    if (size_ == 0)
+        return;
+
+    // frame of dst the oldest sample goes to, < 0 if it is before pts
+    int64_t diff = startPts() - pts;
+    int64_t offset = std::abs(diff) <= AUDIO_STANDBY_SYNC_US ? 0 : usToFrames(diff);
+    int64_t first = offset < 0 ? -offset : 0;
+    int64_t dst_frame = offset > 0 ? offset : 0;
+    if (first >= size_ || dst_frame >= frames)
+        return;
+
+    int count = (int)std::min(size_ - first, frames - dst_frame);
+    int index = (int)((head_ + first) % capacity_);
+    int part = std::min(count, capacity_ - index);
+    memcpy(dst + dst_frame * channels_, &ring_[(size_t)index * channels_], part * channels_ * sizeof(int16_t));
+    if (count > part)
+        memcpy(dst + (dst_frame + part) * channels_, &ring_[0], (count - part) * channels_ * sizeof(int16_t));
+}
+
+void StandbyAudioTrack::advance(int64_t pts)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    int64_t played = pts - startPts();
+    if (size_ > 0 && played > AUDIO_STANDBY_SYNC_US)
+        drop((int)std::min<int64_t>(usToFrames(played), size_));
+}
+
+void StandbyAudioTrack::flush()
+{
+    std::lock_guard<std::mutex> decode_lock(decode_lock_);
+    std::lock_guard<std::mutex> lock(lock_);
+    decoder_->DiscardOutput();
+    head_ = 0;
+    size_ = 0;
+}
+
+std::string StandbyAudioTrack::stats(int id)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    // decode time for one second of audio, in ms and in percent of a core
+    double decoded_seconds = (double)decoded_frames_ / sample_rate_;
+    double ms_per_second = decoded_seconds > 0 ? decode_ns_ / 1e6 / decoded_seconds : 0;
+    char line[160];
+    snprintf(line, sizeof(line), "track %d: %dch %dHz, ring %zu KB, %lld ms ahead, decode %.2f ms/s (%.2f%% cpu)",
+            id, channels_, sample_rate_, ring_.size() * sizeof(int16_t) / 1024,
+            (long long)(framesToUs(size_) / 1000), ms_per_second, ms_per_second / 10);
+    return line;
+}
+
+/**
+ * Append decoded samples at their pts.
+ * A gap in the track is filled with silence, a jump back or far ahead restarts the ring.
+ */
+void StandbyAudioTrack::append(const int16_t* samples, int frames, int64_t pts)
+{
+    if (size_ > 0) {
+        int64_t gap = pts - (startPts() + framesToUs(size_));
+        if (gap > AUDIO_STANDBY_SYNC_US && gap < framesToUs(window_frames_)) {
+            write(nullptr, (int)usToFrames(gap));
+        } else if (std::abs(gap) > AUDIO_STANDBY_SYNC_US) {
+            NDLLOG(LOGTAG, NDL_LOGD, "%s: pts jump %lld us, restart", __func__, (long long)gap);
+            head_ = 0;
+            size_ = 0;
+        }
+    }
+    if (size_ == 0) {
+        base_pts_ = pts;
+        base_frames_ = 0;
+    }
+    write(samples, frames);
+}
+
+/**
+ * Copy frames after the newest sample, the oldest ones are dropped if they do not fit
+ */
+void StandbyAudioTrack::write(const int16_t* samples, int frames)
+{
+    if (frames > capacity_) {
+        if (samples)
+            samples += (size_t)(frames - capacity_) * channels_;
+        drop(size_);
+        base_frames_ += frames - capacity_;
+        frames = capacity_;
+    }
+    if (size_ + frames > capacity_)
+        drop(size_ + frames - capacity_);
+
+    int done = 0;
+    while (done < frames) {
+        int index = (head_ + size_) % capacity_;
+        int count = std::min(frames - done, capacity_ - index);
+        int16_t* dst = &ring_[(size_t)index * channels_];
+        if (samples)
+            memcpy(dst, samples + (size_t)done * channels_, count * channels_ * sizeof(int16_t));
+        else
+            memset(dst, 0, count * channels_ * sizeof(int16_t));
+        size_ += count;
+        done += count;
+    }
+}
+
+void StandbyAudioTrack::drop(int frames)
+{
+    head_ = (head_ + frames) % capacity_;
+    size_ -= frames;
+    base_frames_ += frames;
+}
+
+StandbyAudioTracks::StandbyAudioTracks()
+{
+    const char* value = getenv("NDL_AUDIO_STANDBY_MS");
+    window_ms_ = value ? std::min(std::max(atoi(value), 100), 10000) : AUDIO_STANDBY_WINDOW_MS;
+}
+
+int StandbyAudioTracks::add(std::shared_ptr<AudioSwDecoder> decoder, int channels, int sample_rate)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    if (tracks_.size() >= AUDIO_STANDBY_MAX_TRACKS) {
+        NDLLOG(LOGTAG, NDL_LOGE, "%s: %d tracks already", __func__, AUDIO_STANDBY_MAX_TRACKS);
+        return NDL_ESP_RESULT_FAIL;
+    }
+    int id = next_id_++;
+    tracks_[id] = std::make_shared<StandbyAudioTrack>(decoder, channels, sample_rate, window_ms_);
+    NDLLOG(LOGTAG, NDL_LOGI, "%s: track %d, %dch %dHz, %dms window", __func__, id, channels, sample_rate, window_ms_);
+    return id;
+}
+
+int StandbyAudioTracks::remove(int id)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    auto track = tracks_.find(id);
+    if (track == tracks_.end())
+        return NDL_ESP_RESULT_FAIL;
+
+    NDLLOG(LOGTAG, NDL_LOGI, "%s: %s", __func__, track->second->stats(id).c_str());
+    tracks_.erase(track);
+    if (selected_ == id)
+        selected_ = 0;
+    if (fade_from_ == id)
+        fade_from_ = 0;
+    return NDL_ESP_RESULT_SUCCESS;
+}
+
+void StandbyAudioTracks::clear()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    for (auto& track : tracks_)
+        NDLLOG(LOGTAG, NDL_LOGI, "%s: %s", __func__, track.second->stats(track.first).c_str());
+    tracks_.clear();
+    selected_ = 0;
+    fade_from_ = 0;
+    fade_pending_ = false;
+    fade_frames_ = 0;
+}
+
+int StandbyAudioTracks::push(int id, const uint8_t* data, int size, int64_t pts)
+{
+    std::shared_ptr<StandbyAudioTrack> track = find(id);
+    if (!track)
+        return NDL_ESP_RESULT_FEED_INVALID_INPUT;
+    return track->push(data, size, pts);
+}
+
+int StandbyAudioTracks::select(int id)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    if (id != 0 && tracks_.find(id) == tracks_.end())
+        return NDL_ESP_RESULT_FAIL;
+    if (id == selected_)
+        return NDL_ESP_RESULT_SUCCESS;
+
+    NDLLOG(LOGTAG, NDL_LOGI, "%s: track %d -> %d", __func__, selected_, id);
+    fade_from_ = selected_;
+    selected_ = id;
+    fade_pending_ = true;
+    return NDL_ESP_RESULT_SUCCESS;
+}
+
+bool StandbyAudioTracks::isActive()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    return !tracks_.empty();
+}
+
+void StandbyAudioTracks::process(int16_t* samples, int frames, int channels, int sample_rate, int64_t pts)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    if (tracks_.empty() || pts < 0 || frames <= 0 || sample_rate <= 0)
+        return;
+
+    auto findLocked = [this] (int id) {
+        auto track = tracks_.find(id);
+        return track != tracks_.end() ? track->second : nullptr;
+    };
+    std::shared_ptr<StandbyAudioTrack> to = findLocked(selected_);
+
+    if (fade_pending_) {
+        fade_total_ = std::max(sample_rate * AUDIO_STANDBY_CROSSFADE_MS / 1000, 1);
+        fade_frames_ = fade_total_;
+        fade_done_ = 0;
+        fade_pending_ = false;
+    }
+
+    // crossfade from the previous source, the main audio where a track has no samples
+    int fade = std::min(fade_frames_, frames);
+    if (fade > 0) {
+        size_t count = (size_t)fade * channels;
+        fade_out_.assign(samples, samples + count);
+        fade_in_.assign(samples, samples + count);
+        std::shared_ptr<StandbyAudioTrack> from = findLocked(fade_from_);
+        if (from)
+            from->peek(fade_out_.data(), fade, pts);
+        if (to)
+            to->peek(fade_in_.data(), fade, pts);
+        for (int i = 0; i < fade; i++) {
+            float in = (float)(fade_done_ + i + 1) / fade_total_;
+            for (int ch = 0; ch < channels; ch++) {
+                size_t n = (size_t)i * channels + ch;
+                samples[n] = (int16_t)lrintf(fade_out_[n] * (1.0f - in) + fade_in_[n] * in);
+            }
+        }
+        fade_done_ += fade;
+        fade_frames_ -= fade;
+    }
+
+    if (to && frames > fade)
+        to->peek(samples + (size_t)fade * channels, frames - fade, pts + (int64_t)fade * 1000000 / sample_rate);
+
+    // the main audio has passed these frames on every track
+    int64_t end = pts + (int64_t)frames * 1000000 / sample_rate;
+    for (auto& track : tracks_)
+        track.second->advance(end);
+}
+
+/**
+ * The tracks are flushed outside of lock_ : one waits for a decode in flight,
+ * process keeps running meanwhile
+ */
+void StandbyAudioTracks::flush()
+{
+    std::vector<std::shared_ptr<StandbyAudioTrack>> tracks;
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        for (auto& track : tracks_)
+            tracks.push_back(track.second);
+        fade_pending_ = false;
+        fade_frames_ = 0;
+    }
+    for (auto& track : tracks)
+        track->flush();
+}
+
+std::string StandbyAudioTracks::stats()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    std::string stats;
+    for (auto& track : tracks_) {
+        if (!stats.empty())
+            stats += '\n';
+        stats += track.second->stats(track.first);
+        if (track.first == selected_)
+            stats += " (selected)";
+    }
+    return stats;
+}
+
+std::shared_ptr<StandbyAudioTrack> StandbyAudioTracks::find(int id)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    auto track = tracks_.find(id);
+    return track != tracks_.end() ? track->second : nullptr;
+}
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#ifndef NDL_DIRECTMEDIA2_STANDBY_AUDIO_H_
+#define NDL_DIRECTMEDIA2_STANDBY_AUDIO_H_
+
+#include <stdint.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "audioswdecoder.h"
+
+/**
+ * Default pcm kept decoded ahead of the main audio on each standby track.
+ * NDL_AUDIO_STANDBY_MS in the environment overrides it.
+ */
+#define AUDIO_STANDBY_WINDOW_MS         1000
+#define AUDIO_STANDBY_MAX_TRACKS        8
+// crossfade of a track switch, hides the step between the two waveforms
+#define AUDIO_STANDBY_CROSSFADE_MS      10
+// pts difference taken as continuous audio
+#define AUDIO_STANDBY_SYNC_US           1000
+
+namespace NDL_Esplayer {
+
+    /**
+     * One alternate audio ES (ex. another language) decoded into a ring of S16 pcm
+     * in the layout and rate of the main output. The ring covers the pts from the
+     * position of the main audio to the window ahead of it.
+     */
+    class StandbyAudioTrack {
+        public:
+            StandbyAudioTrack(std::shared_ptr<AudioSwDecoder> decoder, int channels, int sample_rate, int window_ms);
+
+            /**
+             * Decode one packet into the ring, pts(us) < 0 continues the previous packet.
+             * return consumed bytes, NDL_ESP_RESULT_FEED_FULL if the window is full, < 0 on error
+             */
+            int push(const uint8_t* data, int size, int64_t pts);
+            /**
+             * Copy the samples of [pts, pts + frames) the ring has into dst, the others stay as they are
+             */
+            void peek(int16_t* dst, int frames, int64_t pts);
+            /**
+             * Drop the samples before pts (played by the main audio)
+             */
+            void advance(int64_t pts);
+            void flush();
+
+            /**
+             * Memory and decoding cost of the track, one line
+             */
+            std::string stats(int id);
+
+        private:
+            int64_t framesToUs(int64_t frames) const { return frames * 1000000 / sample_rate_; }
+            int64_t usToFrames(int64_t us) const { return (us * sample_rate_ + 500000) / 1000000; }
+            int64_t startPts() const { return base_pts_ + framesToUs(base_frames_); }
+            void append(const int16_t* samples, int frames, int64_t pts);
+            void write(const int16_t* samples, int frames);
+            void drop(int frames);
+
+            std::mutex decode_lock_;  // decoder_, taken before lock_
+            std::mutex lock_;
+            std::shared_ptr<AudioSwDecoder> decoder_;
+            std::vector<uint8_t> decoded_;  // decoder output of one packet
+
+            int channels_;
+            int sample_rate_;
+            int window_frames_;
+            std::vector<int16_t> ring_;     // capacity_ frames
+            int capacity_;
+            int head_ {0};                  // frame index of the oldest sample
+            int size_ {0};                  // frames in the ring
+            int64_t base_pts_ {0};          // the oldest sample is base_frames_ after base_pts_(us)
+            int64_t base_frames_ {0};
+
+            // cost of the standby decoding
+            int64_t decode_ns_ {0};
+            int64_t decoded_frames_ {0};
+    };
+
+    /**
+     * Alternate audio tracks registered beside the main audio ES.
+     * The main ES keeps driving the output (pts and pace of the audio codec input), selecting
+     * a track replaces the main pcm by the pcm of the track at the same pts from the next
+     * chunk written, without reloading or flushing the audio components.
+     */
+    class StandbyAudioTracks {
+        public:
+            StandbyAudioTracks();
+
+            /**
+             * return the id (> 0) of the new track, < 0 if too many
+             */
+            int add(std::shared_ptr<AudioSwDecoder> decoder, int channels, int sample_rate);
+            int remove(int id);
+            void clear();
+            int push(int id, const uint8_t* data, int size, int64_t pts);
+            /**
+             * Output the track from the next chunk, 0 for the main audio
+             */
+            int select(int id);
+            /**
+             * true if process may change the samples (tracks registered)
+             */
+            bool isActive();
+            /**
+             * Splice the selected track over the main S16 frames starting at pts(us), trim all the rings
+             */
+            void process(int16_t* samples, int frames, int channels, int sample_rate, int64_t pts);
+            void flush();
+            /**
+             * Cost of each standby track, one line per track
+             */
+            std::string stats();
+
+        private:
+            std::shared_ptr<StandbyAudioTrack> find(int id);
+
+            std::mutex lock_;
+            std::map<int, std::shared_ptr<StandbyAudioTrack>> tracks_;
+            int next_id_ {1};
+            int window_ms_;
+            int selected_ {0};
+            int fade_from_ {0};             // track faded out, 0 for the main audio
+            bool fade_pending_ {false};     // starts with the next chunk, its rate gives the length
+            int fade_total_ {0};
+            int fade_done_ {0};
+            int fade_frames_ {0};           // left of the crossfade
+            std::vector<int16_t> fade_in_;
+            std::vector<int16_t> fade_out_;
+    };
+
+} //namespace NDL_Esplayer
+
+#endif //NDL_DIRECTMEDIA2_STANDBY_AUDIO_H_
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+
+#include "trickretimer.h"
+
+#define LOGTAG "trick"
+#include "debug.h"
+
+using namespace NDL_Esplayer;
+
+void TrickRetimer::setRate(int rate)
+{
+    if (rate == 0) {
+        rate_ = 0;
+        reset();
+        return;
+    }
+    rate_ = rate;
+    in_base_ = -1;
+}
+
+bool TrickRetimer::retime(int64_t* pts)
+{
+    if (rate_ == 0)
+        return true;
+
+    if (in_base_ < 0) {
+        in_base_ = *pts;
+        out_base_ = last_out_ < 0 ? *pts : last_out_ + TRICK_MIN_INTERVAL_US;
+    }
+
+    int64_t out = out_base_ + (*pts - in_base_) * TRICK_NORMAL_RATE / rate_;
+    if (last_out_ >= 0 && out < last_out_ + TRICK_MIN_INTERVAL_US) {
+        NDLLOG(LOGTAG, NDL_LOGV, "%s, skip key frame pts:%lld (%lld after %lld)", __func__,
+                (long long)*pts, (long long)out, (long long)last_out_);
+        return false;
+    }
+    last_out_ = out;
+    *pts = out;
+    return true;
+}
+
+void TrickRetimer::reset()
+{
+    in_base_ = -1;
+    out_base_ = 0;
+    last_out_ = -1;
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+
+#ifndef NDL_DIRECTMEDIA2_TRICK_RETIMER_H_
+#define NDL_DIRECTMEDIA2_TRICK_RETIMER_H_
+
+#include <stdint.h>
+
+// rate of the normal playback, as Clock::NORMAL_PLAYBACK_RATE
+#define TRICK_NORMAL_RATE           1000
+// key frames closer than this once retimed are skipped (25 fps at most)
+#define TRICK_MIN_INTERVAL_US       40000
+
+namespace NDL_Esplayer {
+
+    /**
+     * pts(us) of the key frames in I-frame trick play : the distance from the first key frame
+     * scaled by the rate (backward for a negative rate, the key frames coming in reverse order),
+     * presented by the scheduler on the clock at 1x. After a rate change the key frames go on
+     * from the last one retimed.
+     * Used by the video feeder only, the API changes it through a message to the feeder.
+     */
+    class TrickRetimer {
+        public:
+            /**
+             * rate in TRICK_NORMAL_RATE units, 0 : off (the timing is forgotten)
+             */
+            void setRate(int rate);
+            int getRate() const { return rate_; }
+
+            /**
+             * Retime the pts of a key frame, false if it comes less than TRICK_MIN_INTERVAL_US
+             * after the last one (skipped)
+             */
+            bool retime(int64_t* pts);
+            /**
+             * Flush : the next key frame starts the timing, the rate is kept
+             */
+            void reset();
+
+        private:
+            int rate_ {0};
+            int64_t in_base_ {-1};      // pts of the first key frame, -1 until it comes
+            int64_t out_base_ {0};      // its pts once retimed
+            int64_t last_out_ {-1};
+    };
+
+} //namespace NDL_Esplayer
+
+#endif // #ifndef NDL_DIRECTMEDIA2_TRICK_RETIMER_H_
@@ -0,0 +1,331 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+
+// Conversion of length prefixed H.264/HEVC frames (annexbconverter.h) checked against
+// a reference Annex-B rewrite, written piece by piece at capacities 1, 3, 7 and the whole frame :
+// avcC/hvcC parsing and where the parameter sets are inserted
+//
+//   annexbconverter-test
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+
+#include "parser/annexbconverter.h"
+#include "ndl-directmedia2/media-common.h"
+
+using namespace NDL_Esplayer;
+
+typedef std::vector<uint8_t> Bytes;
+
+// H.264 NAL units
+static const Bytes h264_aud = {0x09, 0xF0};
+static const Bytes h264_sps = {0x67, 0x42, 0x00, 0x1E, 0x95, 0xA8, 0x28, 0x0F, 0x64};
+static const Bytes h264_pps = {0x68, 0xCE, 0x38, 0x80};
+static const Bytes h264_idr = {0x65, 0x88, 0x84, 0x00, 0x33, 0xFF, 0x00, 0x00, 0x03, 0x01, 0x12};
+static const Bytes h264_p = {0x41, 0x9A, 0x21, 0x6C, 0x00, 0x00, 0x03, 0x00, 0x7E};
+
+// HEVC NAL units : type << 1, nuh_temporal_id_plus1
+static const Bytes hevc_aud = {35 << 1, 0x01, 0x50};
+static const Bytes hevc_vps = {32 << 1, 0x01, 0x0C, 0x01, 0xFF, 0xFF};
+static const Bytes hevc_sps = {33 << 1, 0x01, 0x01, 0x01, 0x60, 0x00, 0x00, 0x03};
+static const Bytes hevc_pps = {34 << 1, 0x01, 0xC1, 0x72, 0xB4};
+static const Bytes hevc_idr = {19 << 1, 0x01, 0xAF, 0x08, 0x40, 0x00, 0x00, 0x03, 0x02, 0x5C};
+static const Bytes hevc_trail = {1 << 1, 0x01, 0xD0, 0x2E, 0x71, 0x00, 0x00, 0x00, 0x19};
+
+static void appendLength(Bytes* out, int length_size, size_t len)
+{
+    for (int i = length_size - 1; i >= 0; i--)
+        out->push_back((uint8_t)(len >> (8 * i)));
+}
+
+static Bytes makeFrame(int length_size, const std::vector<Bytes>& nals)
+{
+    Bytes frame;
+    for (const Bytes& nal : nals) {
+        appendLength(&frame, length_size, nal.size());
+        frame.insert(frame.end(), nal.begin(), nal.end());
+    }
+    return frame;
+}
+
+static Bytes annexB(const std::vector<Bytes>& nals)
+{
+    Bytes out;
+    for (const Bytes& nal : nals) {
+        out.insert(out.end(), {0, 0, 0, 1});
+        out.insert(out.end(), nal.begin(), nal.end());
+    }
+    return out;
+}
+
+static Bytes makeAvcC(int length_size, const Bytes& sps, const Bytes& pps)
+{
+    Bytes config = {1, sps[1], sps[2], sps[3], (uint8_t)(0xFC | (length_size - 1)), 0xE1};
+    appendLength(&config, 2, sps.size());
+    config.insert(config.end(), sps.begin(), sps.end());
+    config.push_back(1);
+    appendLength(&config, 2, pps.size());
+    config.insert(config.end(), pps.begin(), pps.end());
+    return config;
+}
+
+static Bytes makeHvcC(int length_size, const std::vector<Bytes>& nals)
+{
+    Bytes config(23, 0);
+    config[0] = 1;
+    config[21] = (uint8_t)(0xFC | (length_size - 1));
+    config[22] = (uint8_t)nals.size();
+    for (const Bytes& nal : nals) {
+        config.push_back(0x80 | (nal[0] >> 1));     // array_completeness, NAL_unit_type
+        appendLength(&config, 2, 1);
+        appendLength(&config, 2, nal.size());
+        config.insert(config.end(), nal.begin(), nal.end());
+    }
+    return config;
+}
+
+/**
+ * Reference rewrite : each length becomes a start code, the parameter sets (if any) go first
+ * or after a leading AUD
+ */
+static Bytes reference(const std::vector<Bytes>& nals, const Bytes& parameter_sets, bool after_aud)
+{
+    Bytes out;
+    for (size_t i = 0; i < nals.size(); i++) {
+        if (i == (after_aud ? 1u : 0u))
+            out.insert(out.end(), parameter_sets.begin(), parameter_sets.end());
+        out.insert(out.end(), {0, 0, 0, 1});
+        out.insert(out.end(), nals[i].begin(), nals[i].end());
+    }
+    return out;
+}
+
+/**
+ * Write the frame begun at capacity (0 : the whole frame at once), false if it differs from expected
+ */
+static bool write(annexbconverter* converter, const Bytes& frame, const Bytes& expected, int capacity)
+{
+    int size = converter->begin(frame.data(), (int)frame.size());
+    if (size != (int)expected.size())
+        return false;
+    if (capacity == 0)
+        capacity = size;
+
+    Bytes out;
+    Bytes dst(capacity);
+    for (int written; (written = converter->write(dst.data(), capacity)) > 0; ) {
+        if (written > capacity)
+            return false;
+        out.insert(out.end(), dst.begin(), dst.begin() + written);
+    }
+    return out == expected;
+}
+
+/**
+ * Convert the frame at capacities 1, 3 and 7 with copies of the converter, then at once with it
+ */
+static bool convert(annexbconverter* converter, const Bytes& frame, const Bytes& expected)
+{
+    bool ok = true;
+    for (int capacity : {1, 3, 7}) {
+        annexbconverter copy = *converter;
+        ok &= write(&copy, frame, expected, capacity);
+    }
+    return write(converter, frame, expected, 0) && ok;
+}
+
+struct Step {
+    const char* name;
+    std::vector<Bytes> nals;
+    bool inserted;      // the parameter sets go before this frame
+    bool reset;         // flush before it
+};
+
+static bool checkSequence(const char* codec, bool hevc, const Bytes& config, const Bytes& parameter_sets,
+        int length_size, const std::vector<Step>& steps)
+{
+    annexbconverter converter(hevc);
+    bool ok = converter.setConfig(config.data(), (int)config.size()) == 0 &&
+        converter.parameterSets() == parameter_sets;
+    printf("%s config : %s\n", codec, ok ? "passed" : "FAILED");
+
+    for (const Step& step : steps) {
+        if (step.reset)
+            converter.reset();
+        Bytes frame = makeFrame(length_size, step.nals);
+        const bool after_aud = hevc ? (step.nals[0][0] >> 1) == 35 : (step.nals[0][0] & 0x1F) == 9;
+        Bytes expected = reference(step.nals, step.inserted ? parameter_sets : Bytes(), after_aud);
+        bool passed = convert(&converter, frame, expected);
+        printf("%s %s : %s\n", codec, step.name, passed ? "passed" : "FAILED");
+        ok &= passed;
+    }
+    return ok;
+}
+
+static bool checkH264()
+{
+    const std::vector<Step> steps = {
+        {"first frame", {h264_aud, h264_idr}, true, false},
+        {"frame after", {h264_aud, h264_p}, false, false},
+        {"idr without sps", {h264_idr}, true, false},
+        {"idr with sps", {h264_aud, h264_sps, h264_pps, h264_idr}, false, false},
+        {"frame after reset", {h264_p, h264_p}, true, true},
+        {"sps after reset", {h264_sps, h264_pps, h264_p}, false, true},
+        {"frame after sps", {h264_p}, false, false},
+    };
+    bool ok = checkSequence("avcC", false, makeAvcC(4, h264_sps, h264_pps), annexB({h264_sps, h264_pps}), 4, steps);
+    // 2 bytes lengths
+    ok &= checkSequence("avcC 2 bytes", false, makeAvcC(2, h264_sps, h264_pps), annexB({h264_sps, h264_pps}), 2,
+            {steps[0], steps[1], steps[2]});
+    return ok;
+}
+
+static bool checkHevc()
+{
+    const std::vector<Step> steps = {
+        {"first frame", {hevc_idr}, true, false},
+        {"frame after", {hevc_aud, hevc_trail, hevc_trail}, false, false},
+        {"irap after aud", {hevc_aud, hevc_idr}, true, false},
+        {"irap with sps", {hevc_vps, hevc_sps, hevc_pps, hevc_idr}, false, false},
+        {"frame after reset", {hevc_aud, hevc_trail}, true, true},
+    };
+    const Bytes parameter_sets = annexB({hevc_vps, hevc_sps, hevc_pps});
+    bool ok = checkSequence("hvcC", true, makeHvcC(4, {hevc_vps, hevc_sps, hevc_pps}), parameter_sets, 4, steps);
+    ok &= checkSequence("hvcC 2 bytes", true, makeHvcC(2, {hevc_vps, hevc_sps, hevc_pps}), parameter_sets, 2,
+            {steps[0], steps[2]});
+    return ok;
+}
+
+/**
+ * Flags of the frames : a frame without slice is not marked droppable
+ */
+static bool checkFrameFlags()
+{
+    annexbconverter converter(false);
+    Bytes config = makeAvcC(4, h264_sps, h264_pps);
+    const Bytes h264_b = {0x01, 0x9E, 0x42, 0x6A};    // nal_ref_idc 0
+    struct {
+        std::vector<Bytes> nals;
+        uint32_t flags;
+    } frames[] = {
+        {{h264_aud, h264_sps, h264_pps, h264_idr}, NDL_ESP_FLAG_KEY_FRAME},
+        {{h264_aud, h264_p}, 0},
+        {{h264_aud, h264_b, h264_b}, NDL_ESP_FLAG_NON_REFERENCE},
+        {{h264_b, h264_p}, 0},
+        {{h264_sps, h264_pps}, 0},
+        {{h264_aud}, 0},
+        {{}, 0},
+    };
+    bool ok = converter.setConfig(config.data(), (int)config.size()) == 0;
+    for (const auto& frame : frames) {
+        Bytes data = makeFrame(4, frame.nals);
+        ok &= converter.frameFlags(data.data(), (int)data.size()) == frame.flags;
+    }
+    printf("frame flags : %s\n", ok ? "passed" : "FAILED");
+    return ok;
+}
+
+/**
+ * HEVC sub-layer non-reference pictures : droppable only in the highest temporal sub-layer
+ * of the SPS (hvcC or in the frames), not known to be before an SPS
+ */
+static bool checkHevcSubLayers()
+{
+    // sps_max_sub_layers_minus1 2
+    const Bytes hevc_sps_3_layers = {33 << 1, 0x01, 0x05, 0x01, 0x60, 0x00, 0x00, 0x03};
+    // TRAIL_N, TSA_N, RASL_N at TemporalId 0, 1 and 2
+    const Bytes trail_n_0 = {0 << 1, 0x01, 0xD0, 0x2E};
+    const Bytes tsa_n_1 = {2 << 1, 0x02, 0xD0, 0x2E};
+    const Bytes trail_n_2 = {0 << 1, 0x03, 0xD0, 0x2E};
+    const Bytes rasl_n_2 = {8 << 1, 0x03, 0xD0, 0x2E};
+    struct {
+        std::vector<Bytes> nals;
+        uint32_t flags;
+    } frames[] = {
+        {{hevc_idr}, NDL_ESP_FLAG_KEY_FRAME},
+        {{trail_n_0}, 0},
+        {{tsa_n_1}, 0},
+        {{trail_n_2}, NDL_ESP_FLAG_NON_REFERENCE},
+        {{rasl_n_2, rasl_n_2}, NDL_ESP_FLAG_NON_REFERENCE},
+        {{trail_n_2, hevc_trail}, 0},
+        // single sub-layer from now on
+        {{hevc_vps, hevc_sps, hevc_pps, hevc_idr}, NDL_ESP_FLAG_KEY_FRAME},
+        {{trail_n_0}, NDL_ESP_FLAG_NON_REFERENCE},
+        {{hevc_vps, hevc_sps_3_layers, hevc_pps, hevc_idr}, NDL_ESP_FLAG_KEY_FRAME},
+        {{trail_n_0}, 0},
+    };
+
+    annexbconverter converter(true);
+    Bytes config = makeHvcC(4, {hevc_vps, hevc_sps_3_layers, hevc_pps});
+    bool ok = converter.setConfig(config.data(), (int)config.size()) == 0;
+    for (const auto& frame : frames) {
+        Bytes data = makeFrame(4, frame.nals);
+        ok &= converter.frameFlags(data.data(), (int)data.size()) == frame.flags;
+    }
+
+    // no SPS yet : the highest sub-layer is not known
+    annexbconverter no_sps(true);
+    config = makeHvcC(4, {hevc_vps, hevc_pps});
+    ok &= no_sps.setConfig(config.data(), (int)config.size()) == 0;
+    Bytes data = makeFrame(4, {trail_n_0});
+    ok &= no_sps.frameFlags(data.data(), (int)data.size()) == 0;
+    printf("hevc sub-layers : %s\n", ok ? "passed" : "FAILED");
+    return ok;
+}
+
+/**
+ * Extradata which is no avcC/hvcC, and frames whose lengths do not match their size
+ */
+static bool checkInvalid()
+{
+    annexbconverter avc(false);
+    annexbconverter hevc(true);
+    Bytes annexb_config = annexB({h264_sps, h264_pps});
+    Bytes truncated = makeAvcC(4, h264_sps, h264_pps);
+    truncated.pop_back();
+    bool ok = avc.setConfig(annexb_config.data(), (int)annexb_config.size()) < 0 &&
+        avc.setConfig(truncated.data(), (int)truncated.size()) < 0 &&
+        hevc.setConfig(truncated.data(), (int)truncated.size()) < 0 &&
+        avc.setConfig(nullptr, 0) < 0;
+
+    Bytes config = makeAvcC(4, h264_sps, h264_pps);
+    ok &= avc.setConfig(config.data(), (int)config.size()) == 0;
+    Bytes frame = makeFrame(4, {h264_idr, h264_p});
+    Bytes longer = frame;
+    longer[3]++;
+    ok &= avc.begin(longer.data(), (int)longer.size()) < 0 &&
+        avc.begin(frame.data(), (int)frame.size() - 1) < 0 &&
+        avc.begin(frame.data(), 3) < 0;
+    printf("invalid config and frames : %s\n", ok ? "passed" : "FAILED");
+    return ok;
+}
+
+int main()
+{
+    bool ok = checkH264();
+    ok &= checkHevc();
+    ok &= checkFrameFlags();
+    ok &= checkHevcSubLayers();
+    ok &= checkInvalid();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,410 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Sample format conversion kernels (audioconvert.h) checked bit exact against
+// swr_convert for 1 to 8 channels, stereo downmix checked against a double
+// precision mix of the same matrix, S16 gain kernels checked against lrintf,
+// LPCM kernels checked against the upper 16 bits of the samples packed in them,
+// then conversion and downmix timed against swr_convert
+//
+//   audioconvert-test [bench iterations]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+extern "C" {
+#include "libavutil/channel_layout.h"
+#include "libswresample/swresample.h"
+}
+
+#include "audioconvert.h"
+
+using namespace NDL_Esplayer;
+
+// odd count : the scalar tail of the SIMD kernels and more than one block
+#define TEST_SAMPLES 1031
+#define BENCH_SAMPLES 1024
+
+static const enum AVSampleFormat formats[] = {
+    AV_SAMPLE_FMT_FLTP, AV_SAMPLE_FMT_FLT, AV_SAMPLE_FMT_S16P, AV_SAMPLE_FMT_S32P, AV_SAMPLE_FMT_S32,
+};
+
+static const AUDIO_CONVERT_IMPL impls[] = {
+    AUDIO_CONVERT_SCALAR, AUDIO_CONVERT_SSE2, AUDIO_CONVERT_AVX2, AUDIO_CONVERT_NEON,
+};
+
+static const uint64_t downmix_layouts[] = {
+    AV_CH_LAYOUT_SURROUND, AV_CH_LAYOUT_4POINT0, AV_CH_LAYOUT_5POINT0, AV_CH_LAYOUT_5POINT1,
+    AV_CH_LAYOUT_5POINT1_BACK, AV_CH_LAYOUT_6POINT1, AV_CH_LAYOUT_7POINT1,
+};
+
+static int64_t current_time_ns()
+{
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+/**
+ * Decoder like frame : one plane per channel, or one interleaved plane
+ */
+struct TestFrame {
+    std::vector<std::vector<uint8_t>> planes;
+    std::vector<const uint8_t*> data;
+
+    TestFrame(enum AVSampleFormat format, int channels, int samples) {
+        bool planar = av_sample_fmt_is_planar(format);
+        int plane_count = planar ? channels : 1;
+        int plane_samples = planar ? samples : samples * channels;
+        planes.resize(plane_count);
+        for (auto& plane : planes) {
+            plane.resize(plane_samples * av_get_bytes_per_sample(format));
+            fill(format, plane.data(), plane_samples);
+            data.push_back(plane.data());
+        }
+    }
+
+    static void fill(enum AVSampleFormat format, uint8_t* plane, int count) {
+        for (int i = 0; i < count; i++) {
+            switch (av_get_packed_sample_fmt(format)) {
+                case AV_SAMPLE_FMT_FLT: {
+                    float value;
+                    if (i % 7 == 0)       // exact ties of the rounding
+                        value = ((rand() % 65536) - 32768 + 0.5f) / 32768.0f;
+                    else if (i % 11 == 0) // clipped
+                        value = (rand() % 2) ? 1.0f + (rand() % 100) / 100.0f : -1.0f - (rand() % 100) / 100.0f;
+                    else
+                        value = (rand() / (float)RAND_MAX) * 2.0f - 1.0f;
+                    ((float*)plane)[i] = value;
+                    break;
+                }
+                case AV_SAMPLE_FMT_S32:
+                    ((int32_t*)plane)[i] = (int32_t)(((uint32_t)rand() << 16) ^ (uint32_t)rand());
+                    break;
+                case AV_SAMPLE_FMT_S16:
+                    ((int16_t*)plane)[i] = (int16_t)rand();
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+};
+
+static SwrContext* openSwr(enum AVSampleFormat format, int channels)
+{
+    int64_t layout = av_get_default_channel_layout(channels);
+    SwrContext* swr = swr_alloc_set_opts(NULL, layout, AV_SAMPLE_FMT_S16, 48000,
+            layout, format, 48000, 0, NULL);
+    if (swr && swr_init(swr) < 0)
+        swr_free(&swr);
+    return swr;
+}
+
+static bool checkBitExact(enum AVSampleFormat format, int channels)
+{
+    TestFrame frame(format, channels, TEST_SAMPLES);
+    std::vector<int16_t> expected(TEST_SAMPLES * channels);
+    std::vector<int16_t> result(TEST_SAMPLES * channels);
+
+    SwrContext* swr = openSwr(format, channels);
+    if (!swr) {
+        printf("FAIL %s %dch : swr init\n", av_get_sample_fmt_name(format), channels);
+        return false;
+    }
+    uint8_t* out = (uint8_t*)expected.data();
+    int converted = swr_convert(swr, &out, TEST_SAMPLES, (const uint8_t**)frame.data.data(), TEST_SAMPLES);
+    swr_free(&swr);
+    if (converted != TEST_SAMPLES) {
+        printf("FAIL %s %dch : swr converted %d\n", av_get_sample_fmt_name(format), channels, converted);
+        return false;
+    }
+
+    bool passed = true;
+    for (AUDIO_CONVERT_IMPL impl : impls) {
+        AudioConvertFunc convert = getAudioConvertFunc(format, channels, impl);
+        if (!convert)
+            continue;
+        memset(result.data(), 0, result.size() * sizeof(int16_t));
+        convert(frame.data.data(), channels, TEST_SAMPLES, result.data());
+        for (size_t i = 0; i < result.size(); i++) {
+            if (result[i] != expected[i]) {
+                printf("FAIL %s %dch %s : sample %zu ch %zu, %d != swr %d\n",
+                        av_get_sample_fmt_name(format), channels, audioConvertImplName(impl),
+                        i / channels, i % channels, result[i], expected[i]);
+                passed = false;
+                break;
+            }
+        }
+    }
+    return passed;
+}
+
+static bool checkDownmix(uint64_t layout)
+{
+    int channels = av_get_channel_layout_nb_channels(layout);
+    TestFrame frame(AV_SAMPLE_FMT_FLTP, channels, TEST_SAMPLES);
+    std::vector<int16_t> result(TEST_SAMPLES * 2);
+
+    AudioDownmixMatrix matrix;
+    if (!buildStereoDownmix(layout, AudioDownmixGains(), &matrix)) {
+        printf("FAIL downmix 0x%llx : matrix\n", (unsigned long long)layout);
+        return false;
+    }
+
+    bool passed = true;
+    for (AUDIO_CONVERT_IMPL impl : impls) {
+        AudioDownmixFunc downmix = getAudioDownmixFunc(AV_SAMPLE_FMT_FLTP, channels, impl);
+        if (!downmix)
+            continue;
+        downmix(frame.data.data(), channels, TEST_SAMPLES, matrix, result.data());
+        for (int i = 0; i < TEST_SAMPLES * 2 && passed; i++) {
+            double mix = 0;
+            for (int ch = 0; ch < channels; ch++)
+                mix += (double)matrix.gain[i % 2][ch] * ((const float*)frame.data[ch])[i / 2];
+            double expected = std::min(std::max(mix * 32768, -32768.0), 32767.0);
+            // float accumulation against double : one step of rounding apart at most
+            if (std::abs(result[i] - expected) > 1.0) {
+                printf("FAIL downmix 0x%llx %s : sample %d side %d, %d != %.2f\n",
+                        (unsigned long long)layout, audioConvertImplName(impl), i / 2, i % 2, result[i], expected);
+                passed = false;
+            }
+        }
+    }
+    return passed;
+}
+
+static int16_t gainReference(int16_t sample, float gain)
+{
+    float scaled = sample * gain;
+    return (int16_t)std::min(std::max(lrintf(scaled), -32768L), 32767L);
+}
+
+static bool checkGain()
+{
+    std::vector<int16_t> input(TEST_SAMPLES);
+    std::vector<float> gains(TEST_SAMPLES);
+    std::vector<int16_t> result(TEST_SAMPLES);
+    TestFrame::fill(AV_SAMPLE_FMT_S16, (uint8_t*)input.data(), TEST_SAMPLES);
+    for (int i = 0; i < TEST_SAMPLES; i++)
+        gains[i] = (i % 13 == 0) ? 1.5f : (float)i / TEST_SAMPLES;  // clipped above unity
+
+    bool passed = true;
+    for (AUDIO_CONVERT_IMPL impl : impls) {
+        AudioGainFunc gain = getAudioGainFunc(impl);
+        AudioRampFunc ramp = getAudioRampFunc(impl);
+        AudioMixFunc mix = getAudioMixFunc(impl);
+        if (!gain || !ramp || !mix)
+            continue;
+        for (float value : {0.5f, 0.3f, 1.7f}) {
+            result = input;
+            gain(result.data(), value, TEST_SAMPLES);
+            for (int i = 0; i < TEST_SAMPLES && passed; i++) {
+                if (result[i] != gainReference(input[i], value)) {
+                    printf("FAIL gain %.2f %s : sample %d, %d != %d\n", value, audioConvertImplName(impl),
+                            i, result[i], gainReference(input[i], value));
+                    passed = false;
+                }
+            }
+        }
+        result = input;
+        ramp(result.data(), gains.data(), TEST_SAMPLES);
+        for (int i = 0; i < TEST_SAMPLES && passed; i++) {
+            if (result[i] != gainReference(input[i], gains[i])) {
+                printf("FAIL ramp %s : sample %d, %d != %d\n", audioConvertImplName(impl),
+                        i, result[i], gainReference(input[i], gains[i]));
+                passed = false;
+            }
+        }
+        // the reversed input as main stream, sums clip at both ends
+        for (int i = 0; i < TEST_SAMPLES; i++)
+            result[i] = input[TEST_SAMPLES - 1 - i];
+        mix(result.data(), input.data(), 0.8f, TEST_SAMPLES);
+        for (int i = 0; i < TEST_SAMPLES && passed; i++) {
+            int sum = input[TEST_SAMPLES - 1 - i] + gainReference(input[i], 0.8f);
+            int16_t expected = (int16_t)std::min(std::max(sum, -32768), 32767);
+            if (result[i] != expected) {
+                printf("FAIL mix %s : sample %d, %d != %d\n", audioConvertImplName(impl), i, result[i], expected);
+                passed = false;
+            }
+        }
+    }
+    return passed;
+}
+
+static bool checkLpcm(int container, bool big_endian, bool reorder)
+{
+    const int channels = 6;
+    AudioLpcmFormat format;
+    format.channels = channels;
+    format.container_bytes = container;
+    format.big_endian = big_endian;
+    for (int ch = 0; ch < channels; ch++)
+        format.channel_map[ch] = reorder ? channels - 1 - ch : ch;
+
+    // samples in the upper bits of the containers
+    std::vector<int32_t> samples(TEST_SAMPLES * channels);
+    std::vector<uint8_t> packed(samples.size() * container);
+    for (size_t i = 0; i < samples.size(); i++) {
+        samples[i] = (int32_t)(((uint32_t)rand() << 16) ^ (uint32_t)rand()) & (int32_t)(0xFFFFFFFFu << (32 - container * 8));
+        for (int b = 0; b < container; b++) {
+            uint8_t byte = (uint8_t)((uint32_t)samples[i] >> (24 - 8 * b));  // most significant first
+            packed[i * container + (big_endian ? b : container - 1 - b)] = byte;
+        }
+    }
+
+    std::vector<int16_t> result(samples.size());
+    bool passed = true;
+    for (AUDIO_CONVERT_IMPL impl : impls) {
+        AudioLpcmFunc convert = getAudioLpcmFunc(format, impl);
+        if (!convert)
+            continue;
+        memset(result.data(), 0, result.size() * sizeof(int16_t));
+        convert(packed.data(), format, TEST_SAMPLES, result.data());
+        for (size_t i = 0; i < result.size() && passed; i++) {
+            int16_t expected = (int16_t)(samples[i - i % channels + format.channel_map[i % channels]] >> 16);
+            if (result[i] != expected) {
+                printf("FAIL lpcm %dbit %s%s %s : sample %zu ch %zu, %d != %d\n", container * 8,
+                        big_endian ? "be" : "le", reorder ? " reordered" : "", audioConvertImplName(impl),
+                        i / channels, i % channels, result[i], expected);
+                passed = false;
+            }
+        }
+    }
+    return passed;
+}
+
+static void bench(enum AVSampleFormat format, int channels, int iterations)
+{
+    TestFrame frame(format, channels, BENCH_SAMPLES);
+    std::vector<int16_t> result(BENCH_SAMPLES * channels);
+    uint8_t* out = (uint8_t*)result.data();
+
+    SwrContext* swr = openSwr(format, channels);
+    if (!swr)
+        return;
+    int64_t start = current_time_ns();
+    for (int i = 0; i < iterations; i++)
+        swr_convert(swr, &out, BENCH_SAMPLES, (const uint8_t**)frame.data.data(), BENCH_SAMPLES);
+    double swr_ns = (double)(current_time_ns() - start) / iterations / BENCH_SAMPLES;
+    swr_free(&swr);
+
+    printf("%-5s %dch  swr %6.2f ns/sample", av_get_sample_fmt_name(format), channels, swr_ns);
+    for (AUDIO_CONVERT_IMPL impl : impls) {
+        AudioConvertFunc convert = getAudioConvertFunc(format, channels, impl);
+        if (!convert)
+            continue;
+        start = current_time_ns();
+        for (int i = 0; i < iterations; i++)
+            convert(frame.data.data(), channels, BENCH_SAMPLES, result.data());
+        double ns = (double)(current_time_ns() - start) / iterations / BENCH_SAMPLES;
+        printf("  %s %6.2f (x%.1f)", audioConvertImplName(impl), ns, ns > 0 ? swr_ns / ns : 0);
+    }
+    printf("\n");
+}
+
+static void benchDownmix(uint64_t layout, int iterations)
+{
+    int channels = av_get_channel_layout_nb_channels(layout);
+    TestFrame frame(AV_SAMPLE_FMT_FLTP, channels, BENCH_SAMPLES);
+    std::vector<int16_t> result(BENCH_SAMPLES * 2);
+    uint8_t* out = (uint8_t*)result.data();
+
+    SwrContext* swr = swr_alloc_set_opts(NULL, AV_CH_LAYOUT_STEREO, AV_SAMPLE_FMT_S16, 48000,
+            layout, AV_SAMPLE_FMT_FLTP, 48000, 0, NULL);
+    if (!swr || swr_init(swr) < 0)
+        return;
+    int64_t start = current_time_ns();
+    for (int i = 0; i < iterations; i++)
+        swr_convert(swr, &out, BENCH_SAMPLES, (const uint8_t**)frame.data.data(), BENCH_SAMPLES);
+    double swr_ns = (double)(current_time_ns() - start) / iterations / BENCH_SAMPLES;
+    swr_free(&swr);
+
+    AudioDownmixMatrix matrix;
+    buildStereoDownmix(layout, AudioDownmixGains(), &matrix);
+    printf("fltp  %dch->2ch  swr %6.2f ns/sample", channels, swr_ns);
+    for (AUDIO_CONVERT_IMPL impl : impls) {
+        AudioDownmixFunc downmix = getAudioDownmixFunc(AV_SAMPLE_FMT_FLTP, channels, impl);
+        if (!downmix)
+            continue;
+        start = current_time_ns();
+        for (int i = 0; i < iterations; i++)
+            downmix(frame.data.data(), channels, BENCH_SAMPLES, matrix, result.data());
+        double ns = (double)(current_time_ns() - start) / iterations / BENCH_SAMPLES;
+        printf("  %s %6.2f (x%.1f)", audioConvertImplName(impl), ns, ns > 0 ? swr_ns / ns : 0);
+    }
+    printf("\n");
+}
+
+int main(int argc, char* argv[])
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 2000;
+    int failures = 0;
+
+    srand(1);
+    for (enum AVSampleFormat format : formats) {
+        for (int channels = 1; channels <= AUDIO_CONVERT_MAX_CHANNELS; channels++) {
+            if (!checkBitExact(format, channels))
+                failures++;
+        }
+    }
+    printf("bit exact against swr : %s (auto selects %s)\n",
+            failures ? "FAILED" : "passed", audioConvertImplName(getAudioConvertImpl()));
+
+    int downmix_failures = 0;
+    for (uint64_t layout : downmix_layouts) {
+        if (!checkDownmix(layout))
+            downmix_failures++;
+    }
+    printf("stereo downmix        : %s\n", downmix_failures ? "FAILED" : "passed");
+    failures += downmix_failures;
+
+    bool gain_passed = checkGain();
+    printf("gain, ramp and mix    : %s\n", gain_passed ? "passed" : "FAILED");
+    if (!gain_passed)
+        failures++;
+
+    int lpcm_failures = 0;
+    for (int container = 2; container <= 4; container++) {
+        for (int endian = 0; endian < 2; endian++) {
+            for (int reorder = 0; reorder < 2; reorder++) {
+                if (!checkLpcm(container, endian != 0, reorder != 0))
+                    lpcm_failures++;
+            }
+        }
+    }
+    printf("lpcm                  : %s\n", lpcm_failures ? "FAILED" : "passed");
+    failures += lpcm_failures;
+
+    if (iterations > 0) {
+        for (enum AVSampleFormat format : formats) {
+            bench(format, 2, iterations);
+            bench(format, 6, iterations);
+        }
+        benchDownmix(AV_CH_LAYOUT_5POINT1, iterations);
+        benchDownmix(AV_CH_LAYOUT_7POINT1, iterations);
+    }
+    return failures ? 1 : 0;
+}
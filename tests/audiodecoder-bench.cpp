@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Throughput of the software audio decoder over an ES dump directory
+// (audio-es.bin, pts-audio.bin, audio-info.txt, see esdumpreader.cpp),
+// and its startup time with and without the decoder context cache
+//
+//   audiodecoder-bench <es dump dir> [repeat count]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <algorithm>
+#include <memory>
+
+#include "esdumpreader.h"
+#include "audioswdecoder.h"
+#include "audiodecodercache.h"
+
+using namespace NDL_Esplayer;
+
+// same buffer size with the audio decoder input port
+#define BENCH_OUTPUT_CHUNK_SIZE 65536
+// decoder open/close per startup measurement, like zapping between channels
+#define BENCH_STARTUP_CYCLES 20
+
+static int64_t current_time_ns(clockid_t clock)
+{
+    timespec t;
+    clock_gettime(clock, &t);
+    return t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+static enum AVCodecID toCodecId(NDL_ESP_AUDIO_CODEC codec)
+{
+    switch (codec) {
+        case NDL_ESP_AUDIO_CODEC_MP2:   return AV_CODEC_ID_MP2;
+        case NDL_ESP_AUDIO_CODEC_MP3:   return AV_CODEC_ID_MP3;
+        case NDL_ESP_AUDIO_CODEC_AC3:   return AV_CODEC_ID_AC3;
+        case NDL_ESP_AUDIO_CODEC_EAC3:  return AV_CODEC_ID_EAC3;
+        case NDL_ESP_AUDIO_CODEC_AAC:   return AV_CODEC_ID_AAC;
+        case NDL_ESP_AUDIO_CODEC_HEAAC: return AV_CODEC_ID_AAC_LATM;
+        default:                        return AV_CODEC_ID_NONE;
+    }
+}
+
+struct BenchResult {
+    int packets {0};
+    int errors {0};
+    int64_t input_bytes {0};
+    int64_t output_bytes {0};
+    int64_t samples {0};
+    int64_t wall_ns {0};
+    int64_t cpu_ns {0};
+    int64_t max_packet_ns {0};
+    int frame_size {0};
+    int sample_rate {0};
+    enum AVCodecID codec_id {AV_CODEC_ID_NONE};
+};
+
+static bool openDecoder(AudioSwDecoder* decoder, enum AVCodecID codec_id)
+{
+    decoder->audio_stream_info_.codec_id              = codec_id;
+    decoder->audio_stream_info_.channels              = 2;
+    decoder->audio_stream_info_.sample_rate           = 48000;
+    decoder->audio_stream_info_.bit_rate              = 0;
+    decoder->audio_stream_info_.block_align           = 0;
+    decoder->audio_stream_info_.bits_per_coded_sample = 16;
+    return decoder->OpenAudio(codec_id);
+}
+
+/**
+ * Average time of one load (decoder open) in ns, the decoder is closed before the next one
+ */
+static int64_t measureStartup(enum AVCodecID codec_id, int cache_capacity)
+{
+    AudioDecoderCache& cache = AudioDecoderCache::instance();
+    int saved_capacity = cache.getCapacity();
+    cache.setCapacity(cache_capacity);
+    cache.clear();
+
+    int64_t total = 0;
+    for (int i = 0; i < BENCH_STARTUP_CYCLES; i++) {
+        int64_t start = current_time_ns(CLOCK_MONOTONIC);
+        {
+            AudioSwDecoder decoder;
+            if (!openDecoder(&decoder, codec_id))
+                return -1;
+            total += current_time_ns(CLOCK_MONOTONIC) - start;
+        }
+    }
+
+    cache.clear();
+    cache.setCapacity(saved_capacity);
+    return total / BENCH_STARTUP_CYCLES;
+}
+
+static bool runOnce(const char* path, BenchResult* result)
+{
+    EsDumpReader reader(false, true);
+    if (!reader.init(path) || !reader.contains(NDL_ESP_AUDIO_ES)) {
+        printf("no audio es dump in %s\n", path);
+        return false;
+    }
+
+    enum AVCodecID codec_id = toCodecId(reader.getAudioCodec());
+    if (codec_id == AV_CODEC_ID_NONE) {
+        printf("audio codec %d is not decoded by software\n", reader.getAudioCodec());
+        return false;
+    }
+
+    AudioSwDecoder decoder;
+    if (!openDecoder(&decoder, codec_id))
+        return false;
+
+    std::unique_ptr<unsigned char[]> chunk(new unsigned char[BENCH_OUTPUT_CHUNK_SIZE]);
+
+    int64_t wall_start = current_time_ns(CLOCK_MONOTONIC);
+    int64_t cpu_start = current_time_ns(CLOCK_PROCESS_CPUTIME_ID);
+    while (!reader.isEnded(NDL_ESP_AUDIO_ES)) {
+        std::shared_ptr<Frame> frame = reader.getFrame(NDL_ESP_AUDIO_ES);
+        if (!frame || frame->data_len == 0)
+            break;
+
+        int64_t packet_start = current_time_ns(CLOCK_MONOTONIC);
+        if (decoder.DecodeAudio(frame->data, frame->data_len, frame->timestamp, frame->timestamp) < 0)
+            result->errors++;
+        // read out the way the feeder does, one input buffer at a time
+        int len;
+        while ((len = decoder.ReadOutput(chunk.get(), BENCH_OUTPUT_CHUNK_SIZE)) > 0)
+            result->output_bytes += len;
+        result->max_packet_ns = std::max(result->max_packet_ns,
+                current_time_ns(CLOCK_MONOTONIC) - packet_start);
+
+        result->packets++;
+        result->input_bytes += frame->data_len;
+        reader.popFrame(NDL_ESP_AUDIO_ES);
+    }
+    result->wall_ns += current_time_ns(CLOCK_MONOTONIC) - wall_start;
+    result->cpu_ns += current_time_ns(CLOCK_PROCESS_CPUTIME_ID) - cpu_start;
+
+    result->frame_size = decoder.GetOutputFrameSize();
+    if (result->frame_size > 0)
+        result->samples = result->output_bytes / result->frame_size;
+    result->sample_rate = decoder.GetOutputSampleRate();
+    result->codec_id = codec_id;
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        printf("usage: %s <es dump dir> [repeat count]\n", argv[0]);
+        return -1;
+    }
+    int repeat = argc > 2 ? std::max(atoi(argv[2]), 1) : 1;
+
+    BenchResult result;
+    for (int i = 0; i < repeat; i++) {
+        if (!runOnce(argv[1], &result))
+            return -1;
+    }
+
+    double wall_s = result.wall_ns / 1e9;
+    double media_s = result.sample_rate > 0 ? (double)result.samples / result.sample_rate : 0;
+    printf("packets        : %d (errors %d)\n", result.packets, result.errors);
+    printf("input          : %lld bytes\n", (long long)result.input_bytes);
+    printf("output         : %lld bytes, %lld samples (%.2f s of audio)\n",
+            (long long)result.output_bytes, (long long)result.samples, media_s);
+    printf("decode time    : wall %.3f s, cpu %.3f s, max %.3f ms per packet\n",
+            wall_s, result.cpu_ns / 1e9, result.max_packet_ns / 1e6);
+    if (wall_s > 0) {
+        printf("throughput     : %.1f packets/s, %.2f MB/s in, %.1fx realtime\n",
+                result.packets / wall_s, result.input_bytes / wall_s / 1e6, media_s / wall_s);
+    }
+
+    int64_t cold_ns = measureStartup(result.codec_id, 0);
+    int64_t cached_ns = measureStartup(result.codec_id, AUDIO_DECODER_CACHE_SIZE);
+    if (cold_ns >= 0 && cached_ns >= 0) {
+        printf("startup        : %.3f ms without cache, %.3f ms cached, %.3f ms saved per load\n",
+                cold_ns / 1e6, cached_ns / 1e6, (cold_ns - cached_ns) / 1e6);
+    }
+    return result.errors ? 1 : 0;
+}
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+// Software audio decode worker (audiodecodeworker.h) on an LPCM decoder : chunks come out
+// in feeding order and split at the chunk size, flush drops the queued packets and the one
+// in decoding, and the worker stops with packets queued and a decode blocked on the ring
+//
+//   audiodecodeworker-test
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "audioswdecoder.h"
+#include "audiodecodeworker.h"
+
+using namespace NDL_Esplayer;
+
+#define TEST_CHANNELS 2
+#define TEST_RATE 48000
+#define TEST_FRAME_SIZE (TEST_CHANNELS * 2)
+#define TEST_CHUNK_SIZE 1024
+#define TEST_WAIT_MS 500
+
+// packet data lives until the end of the test, the worker reads it on its own thread
+static std::deque<std::vector<uint8_t>> packet_data;
+
+static std::shared_ptr<AudioSwDecoder> openDecoder()
+{
+    auto decoder = std::make_shared<AudioSwDecoder>();
+    decoder->audio_stream_info_.codec_id = AV_CODEC_ID_NONE;
+    decoder->audio_stream_info_.channels = TEST_CHANNELS;
+    decoder->audio_stream_info_.sample_rate = TEST_RATE;
+    decoder->audio_stream_info_.bit_rate = 0;
+    decoder->audio_stream_info_.block_align = 0;
+    decoder->audio_stream_info_.bits_per_coded_sample = 16;
+    AudioLpcmFormat format;
+    if (!decoder->OpenLpcm(format))
+        return nullptr;
+    return decoder;
+}
+
+static NDL_EsplayerBuffer packet(int16_t value, int frames)
+{
+    std::vector<uint8_t> data;
+    for (int i = 0; i < frames * TEST_CHANNELS; i++) {
+        data.push_back((uint8_t)(value & 0xFF));
+        data.push_back((uint8_t)((value >> 8) & 0xFF));
+    }
+    packet_data.push_back(data);
+
+    auto buffer = std::make_shared<NDL_ESP_STREAM_BUFFER>();
+    memset(buffer.get(), 0, sizeof(NDL_ESP_STREAM_BUFFER));
+    buffer->data = packet_data.back().data();
+    buffer->data_len = (uint32_t)packet_data.back().size();
+    return buffer;
+}
+
+/**
+ * Read the chunks of one packet, true if they carry frames of value in order
+ */
+static bool readPacket(AudioDecodeWorker* worker, int16_t value, int frames, int64_t pts)
+{
+    std::vector<uint8_t> data(TEST_CHUNK_SIZE);
+    int read_frames = 0;
+    for (bool first = true; ; first = false) {
+        AudioDecodeWorker::Chunk chunk;
+        if (!worker->peek(&chunk, TEST_WAIT_MS)) {
+            printf("packet %d : no chunk after %d of %d frames\n", value, read_frames, frames);
+            return false;
+        }
+        if (chunk.first != first || chunk.packet_pts != pts || chunk.size > TEST_CHUNK_SIZE ||
+                chunk.size % TEST_FRAME_SIZE) {
+            printf("packet %d : chunk first:%d pts:%lld size:%d\n", value, chunk.first,
+                    (long long)chunk.packet_pts, chunk.size);
+            return false;
+        }
+        if (first && chunk.pts != pts) {
+            printf("packet %d : first sample pts %lld, expected %lld\n", value,
+                    (long long)chunk.pts, (long long)pts);
+            return false;
+        }
+        if (worker->read(data.data(), (int)data.size()) != chunk.size)
+            return false;
+        const int16_t* samples = (const int16_t*)data.data();
+        for (int i = 0; i < chunk.size / 2; i++) {
+            if (samples[i] != value) {
+                printf("packet %d : sample %d is %d\n", value, read_frames * TEST_CHANNELS + i, samples[i]);
+                return false;
+            }
+        }
+        read_frames += chunk.size / TEST_FRAME_SIZE;
+        if (chunk.last)
+            break;
+    }
+    if (read_frames != frames) {
+        printf("packet %d : %d frames, expected %d\n", value, read_frames, frames);
+        return false;
+    }
+    return true;
+}
+
+static bool checkOrder()
+{
+    AudioDecodeWorker worker(openDecoder(), AUDIO_DECODE_AHEAD_MS, TEST_CHUNK_SIZE);
+    bool ok = true;
+    for (int i = 0; i < 8; i++)
+        worker.push(packet(i + 1, 300 + i * 37), i * 10000);
+    for (int i = 0; i < 8 && ok; i++)
+        ok = readPacket(&worker, i + 1, 300 + i * 37, i * 10000);
+
+    // a packet without data still completes its feed with one empty chunk
+    auto empty = std::make_shared<NDL_ESP_STREAM_BUFFER>();
+    memset(empty.get(), 0, sizeof(NDL_ESP_STREAM_BUFFER));
+    worker.push(empty, 90000);
+    AudioDecodeWorker::Chunk chunk;
+    ok &= worker.peek(&chunk, TEST_WAIT_MS) && chunk.size == 0 && chunk.first && chunk.last &&
+            chunk.packet_pts == 90000;
+    worker.pop();
+    ok &= !worker.peek(&chunk, 0);
+
+    printf("decode worker order : %s\n", ok ? "passed" : "FAILED");
+    return ok;
+}
+
+/**
+ * 1ms lookahead : the first packet is decoded, the others stay queued
+ */
+static bool checkFlushQueued()
+{
+    AudioDecodeWorker worker(openDecoder(), 1, TEST_CHUNK_SIZE);
+    for (int i = 0; i < 10; i++)
+        worker.push(packet(i + 1, 480), i * 10000);
+    AudioDecodeWorker::Chunk chunk;
+    bool ok = worker.peek(&chunk, TEST_WAIT_MS);
+
+    worker.flush();
+    ok &= !worker.peek(&chunk, 50);
+    worker.push(packet(77, 480), 1000000);
+    ok &= readPacket(&worker, 77, 480, 1000000);
+    ok &= !worker.peek(&chunk, 50);
+
+    printf("decode worker flush of queued packets : %s\n", ok ? "passed" : "FAILED");
+    return ok;
+}
+
+/**
+ * A packet larger than the ring : the decode waits for the feeder to read
+ */
+static bool checkFlushRunning()
+{
+    AudioDecodeWorker worker(openDecoder(), 1, TEST_CHUNK_SIZE);
+    worker.push(packet(5, 4800), 0);
+    worker.push(packet(6, 480), 100000);
+    AudioDecodeWorker::Chunk chunk;
+    bool ok = worker.peek(&chunk, TEST_WAIT_MS);
+
+    // returns once the blocked decode gave up, its samples are not read after
+    worker.flush();
+    ok &= !worker.peek(&chunk, 50);
+    worker.push(packet(77, 480), 1000000);
+    ok &= readPacket(&worker, 77, 480, 1000000);
+    ok &= !worker.peek(&chunk, 50);
+
+    printf("decode worker flush while decoding : %s\n", ok ? "passed" : "FAILED");
+    return ok;
+}
+
+static bool checkStop()
+{
+    bool ok = true;
+    {
+        AudioDecodeWorker worker(openDecoder(), 1, TEST_CHUNK_SIZE);
+        worker.push(packet(5, 4800), 0);
+        for (int i = 0; i < 10; i++)
+            worker.push(packet(i + 6, 480), (i + 1) * 100000);
+        AudioDecodeWorker::Chunk chunk;
+        ok = worker.peek(&chunk, TEST_WAIT_MS);
+        // destroyed with the decode blocked on the ring and packets queued
+    }
+    printf("decode worker stop : %s\n", ok ? "passed" : "FAILED");
+    return ok;
+}
+
+int main()
+{
+    if (!openDecoder()) {
+        printf("decode worker lpcm decoder : FAILED\n");
+        return 1;
+    }
+
+    bool ok = checkOrder();
+    ok &= checkFlushQueued();
+    ok &= checkFlushRunning();
+    ok &= checkStop();
+    return ok ? 0 : 1;
+}
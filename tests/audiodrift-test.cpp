@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+
+// Audio clock drift (audiodrift.h) estimated from simulated render events with jitter,
+// and compensated by the drift mode of the resampler (audioresampler.h) checked against
+// an ideal stretched sine, the stretch changing between calls
+//
+//   audiodrift-test
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "audiodrift.h"
+#include "audioresampler.h"
+
+using namespace NDL_Esplayer;
+
+#define TEST_CHANNELS 2
+#define TEST_RATE 48000
+#define TEST_FRAMES (TEST_RATE * 4)
+// odd packet size : history carried over calls at every fraction
+#define TEST_CHUNK 1031
+#define TONE_HZ 1000.0
+#define TONE_LEVEL 16384.0
+#define TEST_PI 3.14159265358979323846
+#define RENDER_PERIOD_US 21333
+
+/**
+ * Renderer playing drift_ppm fast, audio stretched by the correction of the estimator :
+ * render events every RENDER_PERIOD_US with up to 4ms of jitter for seconds
+ */
+static void render(AudioDriftEstimator& drift, double drift_ppm, int seconds, double* pts, int64_t* now_us)
+{
+    int64_t end = *now_us + seconds * 1000000LL;
+    while (*now_us < end) {
+        *now_us += RENDER_PERIOD_US;
+        *pts += RENDER_PERIOD_US * (1 + drift_ppm / 1e6) / (1 + drift.getCorrection() / 1e6);
+        int64_t jitter = ((*now_us / RENDER_PERIOD_US) * 7919 % 9 - 4) * 1000;
+        drift.onRender((int64_t)*pts, (*now_us + jitter) * 1000);
+    }
+}
+
+static bool checkEstimate()
+{
+    bool ok = true;
+    double pts = 0;
+    int64_t now_us = 1000000;
+
+    // measured only
+    AudioDriftEstimator measured;
+    measured.setCompensation(false);
+    render(measured, 250, 19, &pts, &now_us);
+    ok &= measured.getDrift() == 0;
+    render(measured, 250, 2, &pts, &now_us);
+    ok &= abs(measured.getDrift() - 250) <= 10 && measured.getCorrection() == 0;
+    // audio without pts : not a drift
+    AudioDriftEstimator still;
+    for (int64_t t = 0; t < 30000000; t += RENDER_PERIOD_US)
+        still.onRender(0, t * 1000);
+    ok &= still.getDrift() == 0;
+    printf("estimate : %d ppm for 250 ppm : %s\n", measured.getDrift(), ok ? "passed" : "FAILED");
+
+    // compensated : the audio stretched by the drift keeps the pace of the system clock
+    AudioDriftEstimator compensated;
+    compensated.setCompensation(true);
+    render(compensated, -400, 200, &pts, &now_us);
+    double before = pts - now_us;
+    render(compensated, -400, 60, &pts, &now_us);
+    double behind = pts - now_us - before;
+    bool locked = abs(compensated.getDrift() + 400) <= 10 && abs(compensated.getCorrection() + 400) <= 10
+        && fabs(behind) < 1000;
+    printf("compensation : %d ppm, %.0f us in 60 s : %s\n", compensated.getCorrection(), behind,
+            locked ? "passed" : "FAILED");
+    ok &= locked;
+
+    // seek and pause : new windows, the estimate is kept
+    pts += 30000000;
+    render(compensated, -400, 10, &pts, &now_us);
+    now_us += 5000000;
+    render(compensated, -400, 10, &pts, &now_us);
+    compensated.setRate(2000);
+    render(compensated, 3000, 100, &pts, &now_us);
+    bool kept = abs(compensated.getDrift() + 400) <= 10;
+
+    // beyond the range : the correction stops at the limit, the drift is still measured
+    compensated.clear();
+    compensated.setRate(1000);
+    kept &= compensated.getDrift() == 0 && compensated.getCorrection() == 0;
+    render(compensated, 1500, 200, &pts, &now_us);
+    kept &= compensated.getCorrection() == AUDIO_RESAMPLE_MAX_DRIFT_PPM && abs(compensated.getDrift() - 1500) <= 15;
+    printf("jumps, rate and range : %d ppm, %d ppm stretch : %s\n", compensated.getDrift(),
+            compensated.getCorrection(), kept ? "passed" : "FAILED");
+    return ok && kept;
+}
+
+static std::vector<int16_t> makeTone(int frames)
+{
+    std::vector<int16_t> tone((size_t)frames * TEST_CHANNELS);
+    for (int i = 0; i < frames; i++) {
+        for (int ch = 0; ch < TEST_CHANNELS; ch++)
+            tone[(size_t)i * TEST_CHANNELS + ch] = (int16_t)lrint(TONE_LEVEL * sin(2 * TEST_PI * TONE_HZ * i / TEST_RATE + ch));
+    }
+    return tone;
+}
+
+/**
+ * Stretched by +1000 ppm for the first half, -700 ppm after : output frame n is the tone
+ * at the input time reached by the steps of the outputs before it
+ */
+static bool checkStretch()
+{
+    std::vector<int16_t> input = makeTone(TEST_FRAMES);
+    std::vector<int16_t> reference;
+    const AUDIO_CONVERT_IMPL impls[] = {
+        AUDIO_CONVERT_SCALAR, AUDIO_CONVERT_SSE2, AUDIO_CONVERT_AVX2, AUDIO_CONVERT_NEON,
+    };
+    bool ok = true;
+
+    for (AUDIO_CONVERT_IMPL impl : impls) {
+        AudioResampler resampler;
+        if (!resampler.initDrift(TEST_RATE, TEST_CHANNELS, AUDIO_RESAMPLE_MEDIUM, impl))
+            continue;
+
+        std::vector<int16_t> output;
+        std::vector<double> times;  // input frame of each output
+        double time = 0;
+        for (int done = 0; done < TEST_FRAMES; done += TEST_CHUNK) {
+            resampler.setDrift(done < TEST_FRAMES / 2 ? 1000 : -700);
+            double step = 1e6 / (1e6 + resampler.getDrift());
+            int count = std::min(TEST_CHUNK, TEST_FRAMES - done);
+            size_t size = output.size();
+            output.resize(size + (size_t)resampler.getOutSamples(count) * TEST_CHANNELS);
+            int written = resampler.process(&input[(size_t)done * TEST_CHANNELS], count, &output[size]);
+            ok &= (size_t)written * TEST_CHANNELS == output.size() - size;
+            output.resize(size + (size_t)written * TEST_CHANNELS);
+            for (int i = 0; i < written; i++, time += step)
+                times.push_back(time);
+        }
+
+        if (!reference.empty()) {
+            if (output != reference) {
+                printf("FAIL %s : differs from scalar\n", audioConvertImplName(impl));
+                ok = false;
+            }
+            continue;
+        }
+        reference = output;
+
+        double signal = 0, noise = 0;
+        int frames = output.size() / TEST_CHANNELS;
+        for (int i = resampler.getTaps(); i < frames; i++) {
+            for (int ch = 0; ch < TEST_CHANNELS; ch++) {
+                double ideal = TONE_LEVEL * sin(2 * TEST_PI * TONE_HZ * times[i] / TEST_RATE + ch);
+                double error = output[(size_t)i * TEST_CHANNELS + ch] - ideal;
+                signal += ideal * ideal;
+                noise += error * error;
+            }
+        }
+        double snr = 10 * log10(signal / std::max(noise, 1e-9));
+        // +1000 ppm over half, -700 ppm over the other half, the last taps are still in the history
+        int expected = lrint(TEST_FRAMES / 2 * 1.001 + TEST_FRAMES / 2 * 0.9993);
+        bool passed = snr >= 65.0 && abs(frames - expected) <= resampler.getTaps() + 2;
+        printf("stretch : %d frames for %d, snr %5.1f dB : %s\n", frames, expected, snr, passed ? "passed" : "FAILED");
+        ok &= passed;
+    }
+    return ok;
+}
+
+int main()
+{
+    bool ok = checkEstimate();
+    ok &= checkStretch();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Throughput of the audio ES parsers (MB/s) over synthetic byte streams cut into TS sized chunks,
+// with each sync scan kernel the cpu has. The frames found are checked against the ones written,
+// also across garbage between frames (loss of sync).
+//
+//   audioparser-bench [repeat count]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <vector>
+
+#include "parser/audioparser.h"
+
+using namespace NDL_Esplayer;
+
+// payload of 7 TS packets, as a demuxer gives a PES
+#define BENCH_CHUNK_SIZE        1316
+#define BENCH_STREAM_FRAMES     4000
+// garbage after every BENCH_GARBAGE_INTERVAL frames
+#define BENCH_GARBAGE_INTERVAL  97
+#define BENCH_GARBAGE_SIZE      333
+
+struct Stream {
+    const char* name;
+    NDL_ESP_AUDIO_CODEC codec;
+    unsigned char sync0;
+    std::vector<unsigned char> data;
+    std::vector<int> frame_sizes;   // as the parser gives them
+};
+
+static int64_t current_time_ns()
+{
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+static void appendPayload(Stream* stream, int size)
+{
+    for (int i = 0; i < size; i++)
+        stream->data.push_back((unsigned char)rand());
+}
+
+static void appendGarbage(Stream* stream)
+{
+    // without the first sync byte, a sync word can not start in it
+    for (int i = 0; i < BENCH_GARBAGE_SIZE; i++) {
+        unsigned char byte = (unsigned char)rand();
+        stream->data.push_back(byte == stream->sync0 ? 0 : byte);
+    }
+}
+
+static void appendAdts(Stream* stream, int size)
+{
+    // MPEG-4 AAC LC, 48kHz, 2ch, no crc
+    const unsigned char header[7] = {
+        0xFF, 0xF1, (1 << 6) | (3 << 2), (unsigned char)((2 << 6) | ((size >> 11) & 0x03)),
+        (unsigned char)(size >> 3), (unsigned char)(((size & 0x07) << 5) | 0x1F), 0xFC
+    };
+    stream->data.insert(stream->data.end(), header, header + 7);
+    appendPayload(stream, size - 7);
+    stream->frame_sizes.push_back(size);
+}
+
+static void appendLatm(Stream* stream, int size)
+{
+    int length = size - 3;
+    const unsigned char header[3] = {0x56, (unsigned char)(0xE0 | (length >> 8)), (unsigned char)length};
+    stream->data.insert(stream->data.end(), header, header + 3);
+    appendPayload(stream, length);
+    stream->frame_sizes.push_back(size);
+}
+
+static void appendEac3(Stream* stream, int strmtyp, int size, bool merged)
+{
+    // 48kHz, 6 blocks, bsid 16
+    int frmsiz = size / 2 - 1;
+    const unsigned char header[6] = {
+        0x0B, 0x77, (unsigned char)((strmtyp << 6) | (frmsiz >> 8)), (unsigned char)frmsiz, (3 << 4) | (7 << 1), 16 << 3
+    };
+    stream->data.insert(stream->data.end(), header, header + 6);
+    appendPayload(stream, size - 6);
+    if (merged)
+        stream->frame_sizes.back() += size;
+    else
+        stream->frame_sizes.push_back(size);
+}
+
+static bool buildStream(Stream* stream)
+{
+    srand(1);
+    for (int i = 0; i < BENCH_STREAM_FRAMES; i++) {
+        if (i % BENCH_GARBAGE_INTERVAL == BENCH_GARBAGE_INTERVAL - 1)
+            appendGarbage(stream);
+
+        if (stream->codec == NDL_ESP_AUDIO_CODEC_AAC) {
+            appendAdts(stream, 200 + rand() % 600);
+        } else if (stream->codec == NDL_ESP_AUDIO_CODEC_HEAAC) {
+            appendLatm(stream, 100 + rand() % 400);
+        } else if (stream->codec == NDL_ESP_AUDIO_CODEC_AC3) {
+            // 448kbps 48kHz, bsid 8
+            const unsigned char header[6] = {0x0B, 0x77, 0, 0, 30, 8 << 3};
+            stream->data.insert(stream->data.end(), header, header + 6);
+            appendPayload(stream, 1792 - 6);
+            stream->frame_sizes.push_back(1792);
+        } else if (stream->codec == NDL_ESP_AUDIO_CODEC_EAC3) {
+            // 7.1 : independent frame with a dependent substream
+            appendEac3(stream, 0, 1536, false);
+            appendEac3(stream, 1, 512, true);
+        } else if (stream->codec == NDL_ESP_AUDIO_CODEC_MP3) {
+            // MPEG-1 layer III, 128kbps 48kHz, padding on odd frames
+            int padding = i & 1;
+            const unsigned char header[4] = {0xFF, 0xFB, (unsigned char)((9 << 4) | (1 << 2) | (padding << 1)), 0xC4};
+            stream->data.insert(stream->data.end(), header, header + 4);
+            appendPayload(stream, 384 + padding - 4);
+            stream->frame_sizes.push_back(384 + padding);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Parse the stream in chunks, return the ns taken or -1 if the frames differ from the ones written
+ */
+static int64_t parseStream(const Stream& stream, CPU_SIMD simd)
+{
+    std::shared_ptr<parser> audio_parser = createAudioParser(stream.codec, simd);
+    if (!audio_parser)
+        return -1;
+
+    std::vector<int> sizes;
+    sizes.reserve(stream.frame_sizes.size());
+    auto writer = [&sizes] (const unsigned char* frame, unsigned int size) {
+        sizes.push_back(size);
+        return (int)size;
+    };
+
+    int64_t start = current_time_ns();
+    for (size_t pos = 0; pos < stream.data.size(); pos += BENCH_CHUNK_SIZE) {
+        const unsigned char* chunk = stream.data.data() + pos;
+        int remained = (int)std::min<size_t>(BENCH_CHUNK_SIZE, stream.data.size() - pos);
+        while (remained > 0) {
+            int parsed = audio_parser->parse(chunk, remained, writer);
+            if (parsed < 0)
+                return -1;
+            chunk += parsed;
+            remained -= parsed;
+        }
+    }
+    int64_t elapsed = current_time_ns() - start;
+
+    // the last frame stays in the parser until the next one starts (or the chunk ends with it)
+    if (sizes.size() + 1 < stream.frame_sizes.size() ||
+            !std::equal(sizes.begin(), sizes.end(), stream.frame_sizes.begin())) {
+        printf("%s (%s) : %zu frames of %zu\n", stream.name, cpuSimdName(simd),
+                sizes.size(), stream.frame_sizes.size());
+        return -1;
+    }
+    return elapsed;
+}
+
+/**
+ * Scan kernel alone over data without sync words, as when the stream is lost
+ */
+static int64_t scanNoise(SyncScanFunc scan, const std::vector<unsigned char>& noise)
+{
+    int64_t start = current_time_ns();
+    int found = scan(noise.data(), noise.size(), 0x0B, 0xFF, 0x77);
+    int64_t elapsed = current_time_ns() - start;
+    return found < 0 ? elapsed : -1;
+}
+
+int main(int argc, char* argv[])
+{
+    int repeat = argc > 1 ? std::max(atoi(argv[1]), 1) : 20;
+
+    Stream streams[] = {
+        {"adts", NDL_ESP_AUDIO_CODEC_AAC, 0xFF, {}, {}},
+        {"latm", NDL_ESP_AUDIO_CODEC_HEAAC, 0x56, {}, {}},
+        {"ac3", NDL_ESP_AUDIO_CODEC_AC3, 0x0B, {}, {}},
+        {"eac3", NDL_ESP_AUDIO_CODEC_EAC3, 0x0B, {}, {}},
+        {"mpeg audio", NDL_ESP_AUDIO_CODEC_MP3, 0xFF, {}, {}},
+    };
+
+    std::vector<unsigned char> noise(16 * 1024 * 1024);
+    for (size_t i = 0; i < noise.size(); i++)
+        noise[i] = (unsigned char)(rand() % 0x0B);
+
+    int failed = 0;
+    for (int simd = CPU_SIMD_SCALAR; simd <= CPU_SIMD_NEON; simd++) {
+        SyncScanFunc scan = getSyncScanFunc((CPU_SIMD)simd);
+        if (!scan)
+            continue;
+        const char* name = cpuSimdName((CPU_SIMD)simd);
+
+        int64_t scan_ns = scanNoise(scan, noise);
+        if (scan_ns < 0) {
+            printf("%-6s sync scan found a sync word in noise\n", name);
+            failed++;
+        } else {
+            printf("%-6s sync scan  : %8.1f MB/s\n", name, noise.size() / (scan_ns / 1e9) / 1e6);
+        }
+
+        for (Stream& stream : streams) {
+            if (stream.data.empty() && !buildStream(&stream))
+                continue;
+            int64_t total_ns = 0;
+            for (int i = 0; i < repeat && total_ns >= 0; i++) {
+                int64_t ns = parseStream(stream, (CPU_SIMD)simd);
+                total_ns = ns < 0 ? -1 : total_ns + ns;
+            }
+            if (total_ns < 0) {
+                failed++;
+                continue;
+            }
+            double mb = (double)stream.data.size() * repeat / 1e6;
+            printf("%-6s %-11s: %8.1f MB/s, %zu frames\n", name, stream.name, mb / (total_ns / 1e9),
+                    stream.frame_sizes.size());
+        }
+    }
+    return failed ? 1 : 0;
+}
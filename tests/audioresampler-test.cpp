@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+// Polyphase resampler (audioresampler.h) checked against an ideal sine at the
+// output rate and the SIMD dot products against the scalar one, then timed in
+// cpu cycles per output sample against swr_convert
+//
+//   audioresampler-test [bench iterations]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+extern "C" {
+#include "libavutil/channel_layout.h"
+#include "libswresample/swresample.h"
+}
+
+#include "audioresampler.h"
+
+using namespace NDL_Esplayer;
+
+#define TEST_CHANNELS 2
+#define TEST_FRAMES 48000
+// odd packet size : history carried over calls at every phase
+#define TEST_CHUNK 1031
+#define BENCH_FRAMES 4096
+#define TONE_HZ 1000.0
+#define TONE_LEVEL 16384.0
+#define TEST_PI 3.14159265358979323846
+
+struct RatePair {
+    int in;
+    int out;
+};
+
+static const RatePair rates[] = {
+    {44100, 48000}, {48000, 44100}, {32000, 48000}, {22050, 48000}, {96000, 48000},
+};
+
+static const AUDIO_CONVERT_IMPL impls[] = {
+    AUDIO_CONVERT_SCALAR, AUDIO_CONVERT_SSE2, AUDIO_CONVERT_AVX2, AUDIO_CONVERT_NEON,
+};
+
+// least signal to noise ratio (dB) of the tone for each quality
+static const double min_snr[] = { 50.0, 65.0, 70.0 };
+
+static int64_t current_time_ns()
+{
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+static uint64_t current_cycles()
+{
+#if defined(__i386__) || defined(__x86_64__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static std::vector<int16_t> makeTone(int rate, int frames)
+{
+    std::vector<int16_t> tone((size_t)frames * TEST_CHANNELS);
+    for (int i = 0; i < frames; i++) {
+        for (int ch = 0; ch < TEST_CHANNELS; ch++)
+            tone[(size_t)i * TEST_CHANNELS + ch] = (int16_t)lrint(TONE_LEVEL * sin(2 * TEST_PI * TONE_HZ * i / rate + ch));
+    }
+    return tone;
+}
+
+static std::vector<int16_t> resample(AudioResampler& resampler, const std::vector<int16_t>& input)
+{
+    int frames = input.size() / TEST_CHANNELS;
+    std::vector<int16_t> output;
+    for (int done = 0; done < frames; done += TEST_CHUNK) {
+        int count = std::min(TEST_CHUNK, frames - done);
+        size_t size = output.size();
+        output.resize(size + (size_t)resampler.getOutSamples(count) * TEST_CHANNELS);
+        int written = resampler.process(&input[(size_t)done * TEST_CHANNELS], count, &output[size]);
+        output.resize(size + (size_t)written * TEST_CHANNELS);
+    }
+    return output;
+}
+
+static bool check(const RatePair& pair, AUDIO_RESAMPLE_QUALITY quality)
+{
+    std::vector<int16_t> input = makeTone(pair.in, TEST_FRAMES);
+    std::vector<int16_t> reference;
+    bool passed = true;
+
+    for (AUDIO_CONVERT_IMPL impl : impls) {
+        AudioResampler resampler;
+        if (!resampler.init(pair.in, pair.out, TEST_CHANNELS, quality, impl))
+            continue;
+        std::vector<int16_t> output = resample(resampler, input);
+
+        if (reference.empty()) {
+            reference = output;
+            // no delay : output frame n is the tone at n / out rate, the last taps are still in the history
+            int frames = output.size() / TEST_CHANNELS;
+            int expected = (int)((int64_t)TEST_FRAMES * pair.out / pair.in);
+            if (abs(frames - expected) > resampler.getTaps() * pair.out / pair.in + 1) {
+                printf("FAIL %d->%d %s : %d frames, %d expected\n", pair.in, pair.out,
+                        AudioResampler::qualityName(quality), frames, expected);
+                return false;
+            }
+            double signal = 0, noise = 0;
+            for (int i = resampler.getTaps(); i < frames; i++) {
+                for (int ch = 0; ch < TEST_CHANNELS; ch++) {
+                    double ideal = TONE_LEVEL * sin(2 * TEST_PI * TONE_HZ * i / pair.out + ch);
+                    double error = output[(size_t)i * TEST_CHANNELS + ch] - ideal;
+                    signal += ideal * ideal;
+                    noise += error * error;
+                }
+            }
+            double snr = 10 * log10(signal / std::max(noise, 1e-9));
+            printf("%5d->%5d %-6s %2d taps  snr %5.1f dB\n", pair.in, pair.out,
+                    AudioResampler::qualityName(quality), resampler.getTaps(), snr);
+            if (snr < min_snr[quality]) {
+                printf("FAIL %d->%d %s : snr %.1f < %.1f\n", pair.in, pair.out,
+                        AudioResampler::qualityName(quality), snr, min_snr[quality]);
+                passed = false;
+            }
+        } else if (output != reference) {
+            printf("FAIL %d->%d %s %s : differs from scalar\n", pair.in, pair.out,
+                    AudioResampler::qualityName(quality), audioConvertImplName(impl));
+            passed = false;
+        }
+    }
+    return passed;
+}
+
+static void bench(const RatePair& pair, int iterations)
+{
+    std::vector<int16_t> input = makeTone(pair.in, BENCH_FRAMES);
+    std::vector<int16_t> output((size_t)BENCH_FRAMES * 4 * TEST_CHANNELS);
+    uint8_t* out = (uint8_t*)output.data();
+    const uint8_t* in = (const uint8_t*)input.data();
+    int64_t out_samples = (int64_t)iterations * BENCH_FRAMES * pair.out / pair.in * TEST_CHANNELS;
+
+    int64_t layout = av_get_default_channel_layout(TEST_CHANNELS);
+    SwrContext* swr = swr_alloc_set_opts(NULL, layout, AV_SAMPLE_FMT_S16, pair.out,
+            layout, AV_SAMPLE_FMT_S16, pair.in, 0, NULL);
+    if (!swr || swr_init(swr) < 0)
+        return;
+    int64_t start = current_time_ns();
+    uint64_t cycles = current_cycles();
+    for (int i = 0; i < iterations; i++)
+        swr_convert(swr, &out, BENCH_FRAMES * 4, &in, BENCH_FRAMES);
+    cycles = current_cycles() - cycles;
+    double ns = (double)(current_time_ns() - start) / out_samples;
+    swr_free(&swr);
+    printf("%5d->%5d  swr %6.2f cycles/sample (%5.2f ns)\n", pair.in, pair.out,
+            (double)cycles / out_samples, ns);
+
+    for (int quality = AUDIO_RESAMPLE_LOW; quality <= AUDIO_RESAMPLE_HIGH; quality++) {
+        printf("%5d->%5d  %-6s", pair.in, pair.out, AudioResampler::qualityName((AUDIO_RESAMPLE_QUALITY)quality));
+        for (AUDIO_CONVERT_IMPL impl : impls) {
+            AudioResampler resampler;
+            if (!resampler.init(pair.in, pair.out, TEST_CHANNELS, (AUDIO_RESAMPLE_QUALITY)quality, impl))
+                continue;
+            start = current_time_ns();
+            cycles = current_cycles();
+            for (int i = 0; i < iterations; i++)
+                resampler.process(input.data(), BENCH_FRAMES, output.data());
+            cycles = current_cycles() - cycles;
+            ns = (double)(current_time_ns() - start) / out_samples;
+            printf("  %s %6.2f cycles/sample (%5.2f ns)", audioConvertImplName(impl),
+                    (double)cycles / out_samples, ns);
+        }
+        printf("\n");
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 200;
+    int failures = 0;
+
+    for (const RatePair& pair : rates) {
+        for (int quality = AUDIO_RESAMPLE_LOW; quality <= AUDIO_RESAMPLE_HIGH; quality++) {
+            if (!check(pair, (AUDIO_RESAMPLE_QUALITY)quality))
+                failures++;
+        }
+    }
+    printf("resampled tone : %s\n", failures ? "FAILED" : "passed");
+
+    if (iterations > 0) {
+        bench(rates[0], iterations);
+        bench(rates[1], iterations);
+    }
+    return failures ? 1 : 0;
+}
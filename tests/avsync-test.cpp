@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+
+// AvSyncController (avsync.h) : presented A/V offset from simulated render events,
+// proportional drops of late video, delay of early video, drift and the fed pts fallback
+//
+//   avsync-test
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <deque>
+
+#include "avsync.h"
+
+using namespace NDL_Esplayer;
+
+#define FRAME_US 20000LL
+#define US_NS 1000LL
+
+/**
+ * Audio rendered on time, the video frames presented bias_us(t) ahead of their pts.
+ * The frames are fed 10 frames ahead with the delay of the controller, and presented when
+ * the audio reaches their fed pts less the bias. return the dropped frames
+ */
+static int run(AvSyncController& sync, int frames, int64_t (*bias_us)(int64_t t))
+{
+    std::deque<int64_t> fed;
+    int dropped = 0;
+    for (int i = 1; i <= frames; i++) {
+        int64_t t = i * FRAME_US;  // audio position, wall time in us
+        sync.onRender(NDL_ESP_AUDIO_ES, t, t * US_NS);
+
+        int64_t pts = t + 10 * FRAME_US;
+        sync.feed(NDL_ESP_AUDIO_ES, pts, 0, t * US_NS);
+        AvSyncController::Decision decision = sync.feed(NDL_ESP_VIDEO_ES, pts, 0, t * US_NS);
+        if (decision.drop)
+            dropped++;
+        else
+            fed.push_back(pts + decision.delay);
+
+        while (!fed.empty() && fed.front() - bias_us(t) <= t) {
+            sync.onRender(NDL_ESP_VIDEO_ES, fed.front(), (fed.front() - bias_us(t)) * US_NS);
+            fed.pop_front();
+        }
+    }
+    return dropped;
+}
+
+static int64_t late(int64_t) { return -120000; }
+static int64_t early(int64_t) { return 60000; }
+static int64_t drifting(int64_t t) { return 5000 + t / 20000; } // 50ppm
+
+static bool checkLate()
+{
+    AvSyncController sync;
+    run(sync, 100, late);
+    int dropped = run(sync, 500, late);
+    NDL_ESP_AV_SYNC_STATS stats;
+    sync.getStats(&stats);
+
+    // 120ms late : 120/200 of the frames dropped, no delay
+    bool ok = dropped >= 290 && dropped <= 310 && stats.video_delay_us == 0
+        && !stats.locked && stats.corrections == 1 && llabs(stats.offset_us + 120000) < 1000;
+    printf("late video : %d/500 dropped, offset %lld : %s\n", dropped, (long long)stats.offset_us,
+            ok ? "passed" : "FAILED");
+    return ok;
+}
+
+static bool checkEarly()
+{
+    AvSyncController sync;
+    int dropped = run(sync, 1000, early);
+    NDL_ESP_AV_SYNC_STATS stats;
+    sync.getStats(&stats);
+
+    // held back by the delay until within the tolerance, nothing dropped
+    bool ok = dropped == 0 && stats.locked && stats.corrections == 1
+        && stats.video_delay_us > 60000 - AV_SYNC_ENTER_US && stats.video_delay_us <= 60000
+        && llabs(stats.offset_us) < AV_SYNC_EXIT_US;
+    printf("early video : delay %lld, offset %lld : %s\n", (long long)stats.video_delay_us,
+            (long long)stats.offset_us, ok ? "passed" : "FAILED");
+    return ok;
+}
+
+static bool checkDrift()
+{
+    AvSyncController sync;
+    int dropped = run(sync, 1500, drifting);
+    NDL_ESP_AV_SYNC_STATS stats;
+    sync.getStats(&stats);
+
+    // within the tolerance : measured only
+    bool ok = dropped == 0 && stats.locked && stats.corrections == 0 && stats.video_delay_us == 0
+        && stats.drift_ppm >= 45 && stats.drift_ppm <= 55 && stats.measurements > 1400;
+    printf("drift : %d ppm : %s\n", stats.drift_ppm, ok ? "passed" : "FAILED");
+    return ok;
+}
+
+/**
+ * Without render events : drops and hold on the fed pts
+ */
+static bool checkFeedFallback()
+{
+    AvSyncController sync;
+    bool ok = true;
+
+    ok &= sync.feed(NDL_ESP_AUDIO_ES, 1000000, 0, 0).start_time;
+    ok &= sync.feed(NDL_ESP_VIDEO_ES, 700000, 0, 0).start_time;
+    AvSyncController::Decision decision = sync.feed(NDL_ESP_VIDEO_ES, 850000, 0, 0);
+    ok &= decision.drop && decision.offset == -150000 && decision.hold == 0;
+    ok &= !sync.feed(NDL_ESP_VIDEO_ES, 950000, 0, 0).drop;
+
+    // too far ahead : held until the audio catches up
+    ok &= sync.feed(NDL_ESP_VIDEO_ES, 2100000, 0, 0).hold == 1;
+    ok &= sync.feed(NDL_ESP_VIDEO_ES, 2200000, 0, 0).hold == 0;
+    ok &= sync.feed(NDL_ESP_AUDIO_ES, 1500000, 0, 0).hold == 0;
+    ok &= sync.feed(NDL_ESP_AUDIO_ES, 2000000, 0, 0).hold == -1;
+    ok &= sync.feed(NDL_ESP_VIDEO_ES, 2300000, AV_SYNC_VIDEO_BUFFERS_HIGH + 1, 0).hold == 1;
+
+    sync.reset();
+    ok &= sync.lastFedPts(NDL_ESP_VIDEO_ES) == 0 && sync.feed(NDL_ESP_VIDEO_ES, 5000, 0, 0).start_time;
+
+    printf("fed pts fallback : %s\n", ok ? "passed" : "FAILED");
+    return ok;
+}
+
+int main()
+{
+    bool ok = checkLate();
+    ok &= checkEarly();
+    ok &= checkDrift();
+    ok &= checkFeedFallback();
+    return ok ? 0 : 1;
+}
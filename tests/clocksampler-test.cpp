@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+
+// ClockSampler (clocksampler.h) : the media time of the clock component read back in the tunneled
+// pipeline (no render events) drives getMediaTime and the audio drift estimate, one reader per interval
+//
+//   clocksampler-test
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "clocksampler.h"
+
+using namespace NDL_Esplayer;
+
+#define MS_NS 1000000LL
+// buffer events of the codecs, several per sample interval
+#define EVENT_PERIOD_US 21333
+
+/**
+ * Clock running drift_ppm fast from media_start, the codecs returning buffers every EVENT_PERIOD_US
+ * for seconds : the media time is read when the sampler is due
+ */
+static int run(ClockSampler& sampler, bool audio_reference, double drift_ppm, int seconds,
+        int64_t media_start, int64_t wall_start)
+{
+    int samples = 0;
+    for (int64_t t = 0; t < seconds * 1000000LL; t += EVENT_PERIOD_US) {
+        int64_t now_ns = wall_start + t * 1000;
+        if (!sampler.due(now_ns))
+            continue;
+        sampler.onMediaTime(media_start + (int64_t)(t * (1 + drift_ppm / 1e6)), audio_reference, now_ns);
+        samples++;
+    }
+    return samples;
+}
+
+static bool checkInterval()
+{
+    MediaClock media_clock;
+    AudioDriftEstimator drift;
+    ClockSampler sampler(&media_clock, &drift);
+
+    bool ok = sampler.due(1000 * MS_NS);
+    ok &= !sampler.due(1000 * MS_NS + CLOCK_SAMPLE_INTERVAL_US * 1000 - 1);
+    ok &= sampler.due(1000 * MS_NS + CLOCK_SAMPLE_INTERVAL_US * 1000);
+    // a clock going back (other thread read now earlier) is due
+    ok &= sampler.due(900 * MS_NS);
+    sampler.reset();
+    ok &= sampler.due(900 * MS_NS);
+
+    // 10 s of events : one sample per interval
+    ClockSampler timed(&media_clock, &drift);
+    int samples = run(timed, true, 0, 10, 0, 2000 * MS_NS);
+    ok &= samples >= 10000000 / (CLOCK_SAMPLE_INTERVAL_US + EVENT_PERIOD_US) && samples <= 10000000 / CLOCK_SAMPLE_INTERVAL_US;
+    printf("interval : %d samples in 10s : %s\n", samples, ok ? "passed" : "FAILED");
+    return ok;
+}
+
+/**
+ * The codec callbacks of the audio and the video ask at once : a single one reads the clock
+ */
+static bool checkConcurrent()
+{
+    MediaClock media_clock;
+    AudioDriftEstimator drift;
+    ClockSampler sampler(&media_clock, &drift);
+
+    bool ok = true;
+    for (int round = 0; round < 200 && ok; round++) {
+        int64_t now_ns = (1000 + round * 200) * MS_NS;
+        std::atomic<int> readers {0};
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 4; i++)
+            threads.push_back(std::thread([&] {
+                        if (sampler.due(now_ns))
+                            readers++;
+                        }));
+        for (auto& thread : threads)
+            thread.join();
+        ok &= readers == 1;
+    }
+    printf("concurrent callbacks : %s\n", ok ? "passed" : "FAILED");
+    return ok;
+}
+
+/**
+ * Audio and video in the tunneled pipeline : the media time follows the clock, the drift
+ * of the audio renderer it follows is estimated
+ */
+static bool checkAudioReference()
+{
+    MediaClock media_clock;
+    AudioDriftEstimator drift;
+    drift.setCompensation(true);
+    ClockSampler sampler(&media_clock, &drift);
+    media_clock.setMaster(MediaClock::SOURCE_AUDIO);
+
+    int64_t start = 0, current = 0;
+    bool ok = !media_clock.get(&start, &current, 1000 * MS_NS);
+
+    const int64_t wall0 = 1000 * MS_NS;
+    const int seconds = 25;
+    run(sampler, true, 300, seconds, 5000000, wall0);
+    const int64_t end_us = seconds * 1000000LL;
+    ok &= media_clock.get(&start, &current, wall0 + end_us * 1000);
+    ok &= start == 5000000 && llabs(current - (5000000 + end_us + end_us * 300 / 1000000)) <= 5000;
+    ok &= abs(drift.getDrift() - 300) <= 10 && drift.getCorrection() == drift.getDrift();
+    printf("audio reference : media time %lld, drift %d ppm for 300 ppm : %s\n",
+            (long long)current, drift.getDrift(), ok ? "passed" : "FAILED");
+    return ok;
+}
+
+/**
+ * Video only : the clock runs on the system clock, it is no audio drift
+ */
+static bool checkVideoOnly()
+{
+    MediaClock media_clock;
+    AudioDriftEstimator drift;
+    ClockSampler sampler(&media_clock, &drift);
+    media_clock.setMaster(MediaClock::SOURCE_VIDEO);
+
+    const int64_t wall0 = 1000 * MS_NS;
+    run(sampler, false, 300, 25, 0, wall0);
+    int64_t start = 0, current = 0;
+    bool ok = media_clock.get(&start, &current, wall0 + 25000 * MS_NS);
+    ok &= start == 0 && llabs(current - 25000000) <= 15000 && drift.getDrift() == 0;
+
+    // the clock not running yet (flush) gives a negative media time : not a render event
+    MediaClock flushed;
+    ClockSampler waiting(&flushed, &drift);
+    waiting.onMediaTime(-1, true, wall0);
+    ok &= !flushed.get(&start, &current, wall0);
+    printf("video only : %s\n", ok ? "passed" : "FAILED");
+    return ok;
+}
+
+int main()
+{
+    bool ok = checkInterval();
+    ok &= checkConcurrent();
+    ok &= checkAudioReference();
+    ok &= checkVideoOnly();
+    return ok ? 0 : 1;
+}
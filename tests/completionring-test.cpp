@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+
+// CompletionRing and CompletionDispatcher (omx/completionring.h) : ring order and full ring,
+// remove from a drain, remove waiting only for the drain of its owner
+//
+//   completionring-test
+
+#include <stdio.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "omx/completionring.h"
+
+using namespace NDL_Esplayer;
+
+static bool checkRing()
+{
+    CompletionRing<int, 8> ring;
+    bool ok = true;
+    for (int i = 0; i < 8; i++)
+        ok &= ring.push(i);
+    ok &= !ring.push(8);
+
+    int value = -1;
+    for (int i = 0; i < 8; i++)
+        ok &= ring.pop(value) && value == i;
+    ok &= !ring.pop(value);
+    return ok;
+}
+
+static bool waitFor(const std::atomic<int>& value, int expected)
+{
+    for (int i = 0; i < 2000 && value.load() != expected; i++)
+        usleep(1000);
+    return value.load() == expected;
+}
+
+// the drain of an owner removes the owner : used to deadlock on the dispatcher lock
+static bool checkRemoveFromDrain()
+{
+    CompletionDispatcher& dispatcher = CompletionDispatcher::getInstance();
+    static int owner;
+    std::atomic<int> calls {0};
+    dispatcher.add(&owner, [&] {
+        dispatcher.remove(&owner);
+        calls++;
+    });
+    dispatcher.wake();
+    bool ok = waitFor(calls, 1);
+
+    // never called again
+    dispatcher.wake();
+    usleep(20000);
+    return ok && calls.load() == 1 && !dispatcher.contains(&owner);
+}
+
+// remove waits for the running drain of its owner but not for a slow drain of another owner
+static bool checkRemoveWaits()
+{
+    CompletionDispatcher& dispatcher = CompletionDispatcher::getInstance();
+    static int slow, fast;
+    std::atomic<int> slow_state {0};
+    std::atomic<int> fast_calls {0};
+
+    dispatcher.add(&slow, [&] {
+        if (slow_state.load() == 0) {
+            slow_state = 1;
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            slow_state = 2;
+        }
+    });
+    dispatcher.add(&fast, [&] { fast_calls++; });
+    dispatcher.wake();
+    bool ok = waitFor(slow_state, 1);
+
+    // fast is not running : removed at once while slow is running
+    auto start = std::chrono::steady_clock::now();
+    dispatcher.remove(&fast);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    ok &= slow_state.load() == 1 && elapsed < std::chrono::milliseconds(100);
+
+    // slow is running : remove returns after its drain
+    dispatcher.remove(&slow);
+    ok &= slow_state.load() == 2;
+    return ok;
+}
+
+int main()
+{
+    bool ring_ok = checkRing();
+    printf("ring order, full ring : %s\n", ring_ok ? "passed" : "FAILED");
+
+    bool drain_ok = checkRemoveFromDrain();
+    printf("remove from the drain : %s\n", drain_ok ? "passed" : "FAILED");
+
+    bool wait_ok = checkRemoveWaits();
+    printf("remove waits for its own drain : %s\n", wait_ok ? "passed" : "FAILED");
+
+    return (ring_ok && drain_ok && wait_ok) ? 0 : 1;
+}
@@ -21,6 +21,7 @@
 #include <stdio.h>
 #include <unistd.h>
 
+#include <atomic>
 #include <thread>
 
 #include "message.h"
@@ -67,6 +68,35 @@ void postMessage(int64_t delay, const char* desc) {
     messagelooper.post(msg);
 }
 
+/**
+ * A message appended after clearAll while a handler runs (flush posting a reset to the feeder)
+ * is run, not popped in place of the cleared one
+ */
+bool checkClearWhileHandling()
+{
+    MessageLooper looper;
+    std::atomic<bool> handling {false};
+    std::atomic<bool> appended_run {false};
+
+    looper.append(std::make_shared<Message>([&] {
+                handling = true;
+                usleep(100000);
+                return 0;
+                }));
+    while (!handling)
+        usleep(1000);
+    looper.clearAll();
+    looper.append(std::make_shared<Message>([&] {
+                appended_run = true;
+                return 0;
+                }));
+    usleep(300000);
+
+    bool ok = appended_run;
+    printf("clear while handling : %s\n", ok ? "passed" : "FAILED");
+    return ok;
+}
+
 int main(int argc, const char* argv[])
 {
     const int64_t ns = 1;
@@ -97,7 +127,7 @@ int main(int argc, const char* argv[])
 
     sleep(9);
 
-    return 0;
+    return checkClearWhileHandling() ? 0 : 1;
 }
 
 
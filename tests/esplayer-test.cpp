@@ -690,7 +690,9 @@ void EsplayerContext::run(const char* input_file)
     pthread_condattr_setclock(&video_attr , CLOCK_MONOTONIC);
     pthread_cond_init(&video_cond, &video_attr);
 
-    NDL_ESP_META_DATA metadata;
+    NDL_ESP_META_DATA metadata = {};
+    NDL_ESP_META_FORMAT metaformat = {};
+    metaformat.size = sizeof(metaformat);
     metadata.audio_codec = reader->getAudioCodec();
     metadata.video_codec = reader->getVideoCodec();
 
@@ -729,6 +731,7 @@ void EsplayerContext::run(const char* input_file)
             metadata.blockalign    = audio_config->blockalign;
             metadata.bitrate       = 16;//audio_config->bitrate;
             metadata.bitspersample = audio_config->bitspersample;
+            metaformat.pcm_flags   = audio_config->pcm_flags;
         }
     }
 
@@ -737,8 +740,8 @@ void EsplayerContext::run(const char* input_file)
         esp_handle = NDL_EsplayerCreate("com.omx.app", ::esplayer_callback, this);
         BREAK_IF(!esp_handle, "error in NDL_EsplayerCreate", 0);
 
-        result = NDL_EsplayerLoad(esp_handle, &metadata);
-        BREAK_IF(result != 0, "error in NDL_EsplayerLoad", result);
+        result = NDL_EsplayerLoadWithFormat(esp_handle, &metadata, &metaformat, NULL, NULL);
+        BREAK_IF(result != 0, "error in NDL_EsplayerLoadWithFormat", result);
 
 PLAY:
         result = NDL_EsplayerSetTrickMode(esp_handle, trickmode);
@@ -21,6 +21,7 @@
 #include <iostream>
 #include <gtest/gtest.h>
 #include <array>
+#include <atomic>
 #include <execinfo.h>
 #include <getopt.h>
 #include <poll.h>
@@ -28,6 +29,7 @@
 #include <signal.h>
 #include <stdio.h>
 #include <stddef.h>
+#include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <termios.h>
@@ -36,10 +38,12 @@
 #include "ffmpegreader.h"
 #include "framereader.h"
 #include "ndl-directmedia2/esplayer-api.h"
+#include "esplayer.h"
 
 #define FEEDING_INTERVAL 300000000 // 300 ms
 #define LOOP_COUNT  60  // run 60 seconds..
 #define LOG_PER_FEED  60
+#define SEEK_LATENCY_WAIT_LIMIT 3000 // wait 3 seconds for the first frame after flush
 
 #define UNITTEST_PRECONDITION_LOAD { \
     player = NDL_EsplayerCreate("com.webos.app.ndl.unit.test",::esplayer_callback, this); \
@@ -81,6 +85,16 @@
 
 using namespace std;
 
+inline int64_t current_time_ns()
+{
+    timespec t;
+    if(clock_gettime(CLOCK_MONOTONIC, &t) == 0) {
+        int64_t ns = t.tv_sec * 1000000000LL + t.tv_nsec;
+        return ns;
+    }
+    return -1;
+}
+
 // The fixture for testing class
 class esplayer_unit_test : public ::testing::Test {
 
@@ -90,7 +104,7 @@ class esplayer_unit_test : public ::testing::Test {
     public:
         NDL_EsplayerHandle player;
         FrameReader* framereader = nullptr;
-        NDL_ESP_META_DATA metadata;
+        NDL_ESP_META_DATA metadata = {};
 
         char* input_file ="/tmp/usb/sda/sda1/test.ts";
         char connectionId[CONNECTION_ID_BUFFER_SIZE] = "";
@@ -112,6 +126,9 @@ class esplayer_unit_test : public ::testing::Test {
         bool trickmode = false;
         bool quit_all = false;
 
+        // monotonic time of the first frame presented event, for seek latency
+        std::atomic<int64_t> first_frame_time {0};
+
         pthread_t event_handler_thread;
         // mutex for feeding thread
         pthread_mutex_t event_lock;
@@ -133,6 +150,7 @@ void esplayer_unit_test::esplayer_callback(NDL_ESP_EVENT event, void* playerdata
     switch(event) {
         case NDL_ESP_FIRST_FRAME_PRESENTED: {
                                                 printf("%s NDL_ESP_FIRST_FRAME_PRESENTED\n", __FUNCTION__);
+                                                first_frame_time = current_time_ns();
                                                 break;
                                             }
         case NDL_ESP_LOW_THRESHOLD_CROSSED_VIDEO:
@@ -204,16 +222,6 @@ int esplayer_unit_test::feed_frame(NDL_ESP_STREAM_T type)
     return -1;
 }
 
-inline int64_t current_time_ns()
-{
-    timespec t;
-    if(clock_gettime(CLOCK_MONOTONIC, &t) == 0) {
-        int64_t ns = t.tv_sec * 1000000000LL + t.tv_nsec;
-        return ns;
-    }
-    return -1;
-}
-
 static void* feeding_thread(void* arg)
 {
     esplayer_unit_test* unit = (esplayer_unit_test*)arg;
@@ -365,6 +373,68 @@ TEST_F(esplayer_unit_test, NDL_EsplayerLoad)
     ASSERT_EQ(NDL_ESP_RESULT_SUCCESS, result);
 }
 
+// formats beyond the meta data : size of the caller checked, fields after it take the defaults
+TEST_F(esplayer_unit_test, NDL_EsplayerLoadWithFormat)
+{
+    player = NDL_EsplayerCreate("com.webos.app.ndl.unit.test",::esplayer_callback, this);
+    NDL_EsplayerSetAppForegroundState(player, NDL_ESP_APP_STATE_FOREGROUND);
+    NDL_EsplayerSetVideoDisplayWindow(player, 0, 0, 1920, 1080, 1);
+
+    NDL_ESP_META_FORMAT format = {};
+    format.size = sizeof(format) + 4;
+    result = NDL_EsplayerLoadWithFormat(player, &metadata, &format, NULL, NULL);
+    ASSERT_EQ(NDL_ESP_RESULT_FAIL, result);
+
+    format.size = 0;
+    result = NDL_EsplayerLoadWithFormat(player, &metadata, &format, NULL, NULL);
+    ASSERT_EQ(NDL_ESP_RESULT_FAIL, result);
+
+    // a caller built before the framing fields : garbage after its size is not read
+    memset(&format, 0xff, sizeof(format));
+    format.size = offsetof(NDL_ESP_META_FORMAT, audio_framing);
+    format.pcm_flags = 0;
+    memset(format.pcm_channel_map, 0, sizeof(format.pcm_channel_map));
+    result = NDL_EsplayerLoadWithFormat(player, &metadata, &format, NULL, NULL);
+    ASSERT_EQ(NDL_ESP_RESULT_SUCCESS, result);
+}
+
+// flags of the video buffers : the first frame starts the time, also when it is decoded only
+TEST(esplayer_video_flags, StartTime)
+{
+    using NDL_Esplayer::Esplayer;
+    NDL_Esplayer::AvSyncController av_sync;
+    uint8_t data[16] = {};
+    NDL_ESP_STREAM_BUFFER frame = {data, sizeof(data), 0, NDL_ESP_VIDEO_ES, 1000000, NDL_ESP_FLAG_KEY_FRAME};
+
+    NDL_Esplayer::AvSyncController::Decision sync = av_sync.feed(NDL_ESP_VIDEO_ES, frame.timestamp, 0);
+    uint32_t flags = Esplayer::getVideoBufferFlags(&frame, sync, Esplayer::FRAME_TYPE_KEY);
+    EXPECT_EQ((uint32_t)(OMX_BUFFERFLAG_STARTTIME | OMX_BUFFERFLAG_SYNCFRAME), flags);
+
+    sync.drop = true;
+    flags = Esplayer::getVideoBufferFlags(&frame, sync, Esplayer::FRAME_TYPE_UNKNOWN);
+    EXPECT_TRUE(flags & OMX_BUFFERFLAG_STARTTIME);
+    EXPECT_TRUE(flags & OMX_BUFFERFLAG_DECODEONLY);
+
+    // the next frames do not, a frame without pts has an unknown time
+    frame.timestamp += 40000;
+    frame.flags = 0;
+    sync = av_sync.feed(NDL_ESP_VIDEO_ES, frame.timestamp, 0);
+    flags = Esplayer::getVideoBufferFlags(&frame, sync, Esplayer::FRAME_TYPE_REFERENCE);
+    EXPECT_EQ(0u, flags & OMX_BUFFERFLAG_STARTTIME);
+#ifdef OMX_BUFFERFLAG_TIME_UNKNOWN
+    frame.timestamp = INT64_MIN;    // no pts
+    flags = Esplayer::getVideoBufferFlags(&frame, sync, Esplayer::FRAME_TYPE_REFERENCE);
+    EXPECT_TRUE(flags & OMX_BUFFERFLAG_TIME_UNKNOWN);
+#endif
+
+    // EOS buffer : the flags of the client only
+    frame.data_len = 0;
+    frame.flags = NDL_ESP_FLAG_END_OF_STREAM;
+    sync.start_time = true;
+    flags = Esplayer::getVideoBufferFlags(&frame, sync, Esplayer::FRAME_TYPE_UNKNOWN);
+    EXPECT_EQ((uint32_t)OMX_BUFFERFLAG_EOS, flags);
+}
+
 TEST_F(esplayer_unit_test, NDL_EsplayerPlay)
 {
     UNITTEST_PRECONDITION_LOAD;
@@ -381,6 +451,56 @@ TEST_F(esplayer_unit_test, NDL_EsplayerFlush)
     ASSERT_EQ(NDL_ESP_RESULT_SUCCESS, result);
 }
 
+TEST_F(esplayer_unit_test, NDL_EsplayerFlushEx)
+{
+    UNITTEST_PRECONDITION_LOAD;
+    result = NDL_EsplayerFlushEx(player, NDL_ESP_FLUSH_FAST);
+
+    ASSERT_EQ(NDL_ESP_RESULT_SUCCESS, result);
+}
+
+// measure seek latency : flush call to the first frame presented event
+TEST_F(esplayer_unit_test, NDL_EsplayerFlushEx_SeekLatency)
+{
+    UNITTEST_PRECONDITION_LOAD;
+    UNITTEST_PRECONDITION_FEED;
+    UNITTEST_PRECONDITION_PLAY;
+
+    const NDL_ESP_FLUSH_MODE modes[] = {NDL_ESP_FLUSH_NORMAL, NDL_ESP_FLUSH_FAST};
+    int64_t latency[2] = {-1, -1};
+
+    for (int i = 0; i < 2; i++) {
+        pthread_mutex_lock(&event_lock);
+        flushing = true;
+        first_frame_time = 0;
+        pthread_mutex_unlock(&event_lock);
+
+        int64_t flush_time = current_time_ns();
+        result = NDL_EsplayerFlushEx(player, modes[i]);
+
+        pthread_mutex_lock(&event_lock);
+        flushing = false;
+        need_more_data = true;
+        pthread_mutex_unlock(&event_lock);
+        pthread_cond_signal(&event_cond);
+
+        if (result != NDL_ESP_RESULT_SUCCESS)
+            break;
+
+        for (int wait = 0; wait < SEEK_LATENCY_WAIT_LIMIT && first_frame_time == 0; wait += 10)
+            usleep(10000);
+
+        if (first_frame_time != 0)
+            latency[i] = (first_frame_time - flush_time) / 1000000;
+        printf("[Test] seek latency (%s flush) : %lld ms\n",
+                modes[i] == NDL_ESP_FLUSH_FAST ? "fast" : "normal", latency[i]);
+    }
+    UNITTEST_POSTCONDITION_FEED;
+    ASSERT_EQ(NDL_ESP_RESULT_SUCCESS, result);
+    EXPECT_GE(latency[0], 0);
+    EXPECT_GE(latency[1], 0);
+}
+
 TEST_F(esplayer_unit_test, NDL_EsplayerPause)
 {
     UNITTEST_PRECONDITION_LOAD;
@@ -120,6 +120,11 @@ bool FfmpegReader::init(const char* input_file)
                     ||(avfctx_->streams[i]->codec->codec_id == CODEC_ID_AAC)
                     ||(avfctx_->streams[i]->codec->codec_id == CODEC_ID_AAC_LATM)
                     ||(avfctx_->streams[i]->codec->codec_id == AV_CODEC_ID_PCM_S16LE)
+                    ||(avfctx_->streams[i]->codec->codec_id == AV_CODEC_ID_PCM_S16BE)
+                    ||(avfctx_->streams[i]->codec->codec_id == AV_CODEC_ID_PCM_S24LE)
+                    ||(avfctx_->streams[i]->codec->codec_id == AV_CODEC_ID_PCM_S24BE)
+                    ||(avfctx_->streams[i]->codec->codec_id == AV_CODEC_ID_PCM_S32LE)
+                    ||(avfctx_->streams[i]->codec->codec_id == AV_CODEC_ID_PCM_S32BE)
               )
             {
                 if(stream_index_audio_ != -1) {
@@ -137,6 +142,7 @@ bool FfmpegReader::init(const char* input_file)
                 audio_config_->blockalign    = codec_context->block_align;
                 audio_config_->bitrate       = codec_context->bit_rate;
                 audio_config_->bitspersample = codec_context->bits_per_coded_sample;
+                audio_config_->pcm_flags     = 0;
                 if (audio_config_->bitspersample == 0)
                     audio_config_->bitspersample = 16;
                 printf("Audio channel:%d, samplerate:%d, align:%d, bitrate:%d, bitper:%d\n",
@@ -170,6 +176,18 @@ bool FfmpegReader::init(const char* input_file)
                 case AV_CODEC_ID_PCM_S16LE:
                     audio_codec_ = NDL_ESP_AUDIO_CODEC_PCM_44100_2CH;
                     break;
+                case AV_CODEC_ID_PCM_S16BE:
+                case AV_CODEC_ID_PCM_S24LE:
+                case AV_CODEC_ID_PCM_S24BE:
+                case AV_CODEC_ID_PCM_S32LE:
+                case AV_CODEC_ID_PCM_S32BE:
+                    audio_codec_ = NDL_ESP_AUDIO_CODEC_LPCM;
+                    audio_config_->bitspersample = av_get_bits_per_sample(avfctx_->streams[i]->codec->codec_id);
+                    audio_config_->blockalign = 0;
+                    audio_config_->pcm_flags = avfctx_->streams[i]->codec->codec_id == AV_CODEC_ID_PCM_S16BE ||
+                        avfctx_->streams[i]->codec->codec_id == AV_CODEC_ID_PCM_S24BE ||
+                        avfctx_->streams[i]->codec->codec_id == AV_CODEC_ID_PCM_S32BE ? NDL_ESP_PCM_FLAG_BIG_ENDIAN : 0;
+                    break;
                 default:
                     fprintf(stderr, "unsupported audio codec_id:%d\n",
                             avfctx_->streams[i]->codec->codec_id);
@@ -41,6 +41,7 @@ typedef struct audio_stream_config_t {
     uint32_t blockalign;
     uint32_t bitrate;
     uint32_t bitspersample;
+    uint32_t pcm_flags;
 } audio_stream_config;
 
 class Frame : public NDL_ESP_STREAM_BUFFER {
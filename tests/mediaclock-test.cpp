@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+
+// MediaClock (mediaclock.h) : media time interpolated between render events,
+// rate changes, master source and consistent reads while render events come
+//
+//   mediaclock-test
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <atomic>
+#include <thread>
+
+#include "mediaclock.h"
+
+using namespace NDL_Esplayer;
+
+#define MS_NS 1000000LL
+
+static bool near(int64_t value, int64_t expected, int64_t tolerance)
+{
+    return llabs(value - expected) <= tolerance;
+}
+
+/**
+ * Frames every 20ms rendered with up to 8ms of callback jitter :
+ * the media time stays within the jitter of the frames and grows at the rate
+ */
+static bool checkInterpolation()
+{
+    MediaClock clock;
+    int64_t start = 0, current = 0;
+    bool ok = !clock.get(&start, &current, 0);
+
+    const int64_t wall0 = 1000 * MS_NS;
+    for (int i = 0; i < 100; i++) {
+        int64_t jitter = ((i * 7) % 5) * 2 * MS_NS;
+        clock.onRender(MediaClock::SOURCE_VIDEO, 500000 + i * 20000, wall0 + i * 20 * MS_NS + jitter);
+    }
+    ok &= clock.get(&start, &current, wall0 + 99 * 20 * MS_NS + 10 * MS_NS);
+    ok &= start == 500000;
+    ok &= near(current, 500000 + 99 * 20000 + 10000, 8000);
+
+    // half speed, then paused
+    int64_t at = wall0 + 2000 * MS_NS;
+    int64_t before = 0;
+    clock.get(nullptr, &before, at);
+    clock.setRate(500, at);
+    clock.get(nullptr, &current, at + 100 * MS_NS);
+    ok &= near(current, before + 50000, 1);
+    clock.setRate(0, at + 100 * MS_NS);
+    int64_t paused = 0;
+    clock.get(nullptr, &paused, at + 900 * MS_NS);
+    ok &= paused == current;
+
+    // seek : the next frame moves the clock at once
+    clock.reset();
+    ok &= !clock.get(&start, &current, at);
+    clock.setRate(1000, at);
+    clock.onRender(MediaClock::SOURCE_VIDEO, 90000000, at);
+    ok &= clock.get(&start, &current, at + 5 * MS_NS) && start == 90000000 && current == 90005000;
+    clock.onRender(MediaClock::SOURCE_VIDEO, 95000000, at + 10 * MS_NS);
+    ok &= clock.get(nullptr, &current, at + 10 * MS_NS) && current == 95000000;
+
+    printf("interpolation : %s\n", ok ? "passed" : "FAILED");
+    return ok;
+}
+
+/**
+ * The video anchors the clock until the first audio render event, then only the audio does
+ */
+static bool checkMaster()
+{
+    MediaClock clock;
+    clock.setMaster(MediaClock::SOURCE_AUDIO);
+    int64_t current = 0;
+    bool ok = true;
+
+    clock.onRender(MediaClock::SOURCE_VIDEO, 1000000, 0);
+    ok &= clock.get(nullptr, &current, 0) && current == 1000000;
+    clock.onRender(MediaClock::SOURCE_AUDIO, 3000000, 10 * MS_NS);
+    ok &= clock.get(nullptr, &current, 10 * MS_NS) && current == 3000000;
+    clock.onRender(MediaClock::SOURCE_VIDEO, 7000000, 20 * MS_NS);
+    ok &= clock.get(nullptr, &current, 20 * MS_NS) && current == 3010000;
+
+    printf("master source : %s\n", ok ? "passed" : "FAILED");
+    return ok;
+}
+
+/**
+ * Readers never see a torn anchor : every render event keeps media - wall/1000 constant
+ * at 1x, a mix of two anchors would not
+ */
+static bool checkConcurrentReads()
+{
+    MediaClock clock;
+    std::atomic<bool> done(false);
+    std::atomic<int> torn(0);
+    const int64_t offset = 123456;
+
+    clock.onRender(MediaClock::SOURCE_VIDEO, offset, 0);
+    std::thread writer([&] {
+        for (int64_t i = 1; i < 2000000; i++)
+            clock.onRender(MediaClock::SOURCE_VIDEO, offset + i * 1000, i * MS_NS);
+        done = true;
+    });
+    std::thread reader([&] {
+        int64_t start = 0, current = 0;
+        while (!done) {
+            // at the wall time of the anchor, the media time is exact
+            if (clock.get(&start, &current, 0) && (start != offset || current != offset))
+                torn++;
+        }
+    });
+    writer.join();
+    reader.join();
+
+    int64_t current = 0;
+    clock.get(nullptr, &current, 0);
+    bool ok = torn == 0 && current == offset;
+    printf("concurrent reads : %s\n", ok ? "passed" : "FAILED");
+    return ok;
+}
+
+int main()
+{
+    bool ok = checkInterpolation();
+    ok &= checkMaster();
+    ok &= checkConcurrentReads();
+    return ok ? 0 : 1;
+}
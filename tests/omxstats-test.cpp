@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+// OmxStats (omx/omxstats.h) : counts, errors and latency percentiles of the summary,
+// commands measured from begin to end by key, reset, and the timer doing nothing when disabled
+//
+//   omxstats-test
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "omx/omxstats.h"
+
+using namespace NDL_Esplayer;
+
+static bool expect(const std::string& summary, const char* item)
+{
+    if (summary.find(item) != std::string::npos)
+        return true;
+    printf("'%s' not in '%s'\n", item, summary.c_str());
+    return false;
+}
+
+static bool checkRecord()
+{
+    OmxStats stats;
+    stats.setName("OMX.test");
+    for (int i = 0; i < 90; i++)
+        stats.record(OMX_STATS_EMPTY_THIS_BUFFER, 10000, false);
+    for (int i = 0; i < 10; i++)
+        stats.record(OMX_STATS_EMPTY_THIS_BUFFER, 1500000, i == 0);
+    stats.record(OMX_STATS_SET_CONFIG, 0, true);
+
+    std::string summary = stats.summary();
+    bool ok = expect(summary, "OMX.test ");
+    ok &= expect(summary, " etb(n:100 err:1 avg:159us p50:<16us p99:<2048us max:1500us)");
+    ok &= expect(summary, " set_config(n:1 err:1 avg:0us p50:<1us p99:<1us max:0us)");
+    // calls never made are skipped
+    ok &= summary.find("ftb(") == std::string::npos;
+
+    stats.reset();
+    ok &= stats.summary() == "OMX.test";
+    printf("omx stats record : %s\n", ok ? "passed" : "FAILED");
+    return ok;
+}
+
+static bool checkCommand()
+{
+    OmxStats stats;
+    stats.begin(OMX_STATS_FLUSH, 0);
+    stats.begin(OMX_STATS_FLUSH, 1);
+    stats.begin(OMX_STATS_PORT_ENABLE, 0);
+    stats.end(OMX_STATS_FLUSH, 1, true);
+    stats.end(OMX_STATS_FLUSH, 0);
+    // completed twice, and never begun : not counted
+    stats.end(OMX_STATS_FLUSH, 0);
+    stats.end(OMX_STATS_PORT_DISABLE, 0);
+
+    std::string summary = stats.summary();
+    bool ok = expect(summary, " flush(n:2 err:1 ");
+    ok &= summary.find("port_enable(") == std::string::npos;
+    ok &= summary.find("port_disable(") == std::string::npos;
+
+    // a command pending at reset is dropped with it
+    stats.reset();
+    stats.end(OMX_STATS_PORT_ENABLE, 0);
+    ok &= stats.summary() == "omx";
+    printf("omx stats command : %s\n", ok ? "passed" : "FAILED");
+    return ok;
+}
+
+static bool checkTimer()
+{
+    OmxStats stats;
+    OmxStats::setEnabled(false);
+    {
+        OmxStatsTimer timer(stats, OMX_STATS_GET_PARAM);
+        timer.done(0);
+    }
+    bool ok = stats.summary() == "omx";
+
+    OmxStats::setEnabled(true);
+    {
+        OmxStatsTimer timer(stats, OMX_STATS_GET_PARAM);
+        timer.done(-1);
+    }
+    ok &= expect(stats.summary(), " get_param(n:1 err:1 ");
+    OmxStats::setEnabled(false);
+    printf("omx stats timer : %s\n", ok ? "passed" : "FAILED");
+    return ok;
+}
+
+/**
+ * IL calls of several threads on the same component
+ */
+static bool checkThreads()
+{
+    OmxStats stats;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&stats, t] {
+            for (int i = 0; i < 10000; i++) {
+                stats.record(OMX_STATS_FILL_THIS_BUFFER, (t + 1) * 1000000, false);
+                stats.begin(OMX_STATS_STATE_SET, t);
+                stats.end(OMX_STATS_STATE_SET, t);
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    std::string summary = stats.summary();
+    bool ok = expect(summary, " ftb(n:40000 err:0 avg:2500us ");
+    ok &= expect(summary, " max:4000us)");
+    ok &= expect(summary, " state(n:40000 err:0 ");
+    printf("omx stats threads : %s\n", ok ? "passed" : "FAILED");
+    return ok;
+}
+
+int main()
+{
+    bool ok = checkRecord();
+    ok &= checkCommand();
+    ok &= checkTimer();
+    ok &= checkThreads();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+
+// PtsTimeline (ptstimeline.h) : exact tick to microsecond conversion for rational timebases
+// and wraparound/discontinuity handling of counters of any width
+//
+//   ptstimeline-test
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "ptstimeline.h"
+
+using namespace NDL_Esplayer;
+
+struct Conversion {
+    uint32_t num;
+    uint32_t den;
+    int64_t ticks;
+    int64_t us;
+};
+
+// floor(ticks * num * 1000000 / den), products beyond 64 bit
+static const Conversion conversions[] = {
+    {1, 90000, 8589934591LL, 95443717677LL},
+    {1, 1000000, 1234567890123LL, 1234567890123LL},
+    {1, 600, 123456789LL, 205761315000LL},
+    {1001, 30000, 1099511627776LL, 36687037980125866LL},
+    {1, 48000, 4503599627370503LL, 93824992236885479LL},
+    {4294967295U, 4294967291U, 1000000000000LL, 1000000000931322575LL},
+    {4294967295U, 7, 7003LL, 4296807995269285714LL},
+    {3, 4294967295U, 4611686018427387904LL, 3221225472750000LL},
+};
+
+static const int wrap_bits[] = { 8, 12, 16, 31, 32, 33, 40, 62 };
+
+static bool checkConversions()
+{
+    bool ok = true;
+    for (const Conversion& c : conversions) {
+        PtsTimeline timeline(c.num, c.den, 0);
+        int64_t us = timeline.toMicrosecond(c.ticks);
+        if (us != c.us) {
+            printf("  %u/%u %lld ticks : %lld us, expected %lld\n", c.num, c.den,
+                    (long long)c.ticks, (long long)us, (long long)c.us);
+            ok = false;
+        }
+    }
+
+    // 90kHz as converted before (*100/9)
+    PtsTimeline ticks;
+    for (int64_t t = 0; t < 2000000; t += 7) {
+        if (ticks.toMicrosecond(t) != t * 100 / 9) {
+            printf("  90kHz %lld ticks : %lld us\n", (long long)t, (long long)ticks.toMicrosecond(t));
+            ok = false;
+            break;
+        }
+    }
+    return ok;
+}
+
+/**
+ * A counter running over several wraparounds, with the small backward steps of
+ * reordered frames, comes out as the counter before wrapping
+ */
+static bool checkWraparound(int bits)
+{
+    PtsTimeline timeline(1, 90000, bits);
+    const int64_t wrap = (int64_t)1 << bits;
+    const int64_t step = wrap / 37 + 1;
+    const int64_t start = wrap - 5 * step;
+
+    for (int64_t i = 0; i < 200; i++) {
+        // decoding order I P B B : the B frames go back by up to 2 steps
+        int64_t t = start + i * step - ((i % 4 == 2) ? 2 * step : (i % 4 == 3) ? step : 0);
+        int64_t unwrapped = timeline.unwrap(t & (wrap - 1));
+        if (unwrapped != t) {
+            printf("  %d bits, frame %lld : %lld, expected %lld\n", bits, (long long)i,
+                    (long long)unwrapped, (long long)t);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * A few pts far back (splice, broken stream) move up by the wrap without
+ * changing the base, the stream continues as before after them
+ */
+static bool checkDiscontinuity(int bits)
+{
+    PtsTimeline timeline(1, 90000, bits);
+    const int64_t wrap = (int64_t)1 << bits;
+    const int64_t high = wrap - wrap / 8;
+    bool ok = true;
+
+    timeline.unwrap(high);
+    for (int i = 0; i < PTS_WRAP_DROP_THRESHOLD; i++)
+        ok &= timeline.unwrap(i) == wrap + i;
+    ok &= timeline.unwrap(high + 1) == high + 1;
+
+    // alternate track a little across the wraparound of the main one
+    ok &= timeline.unwrapNear(wrap / 16) == wrap + wrap / 16;
+    ok &= timeline.unwrapNear(high - 5) == high - 5;
+
+    // the same far pts in a row : a wraparound
+    for (int i = 0; i <= PTS_WRAP_DROP_THRESHOLD; i++)
+        ok &= timeline.unwrap(i) == wrap + i;
+    ok &= timeline.unwrap(PTS_WRAP_DROP_THRESHOLD + 1) == wrap + PTS_WRAP_DROP_THRESHOLD + 1;
+    ok &= timeline.unwrapNear(high) == high;
+
+    timeline.reset();
+    ok &= timeline.unwrap(5) == 5;
+
+    if (!ok)
+        printf("  %d bits : discontinuity\n", bits);
+    return ok;
+}
+
+int main()
+{
+    int failures = 0;
+
+    if (!checkConversions())
+        failures++;
+    printf("timebase conversion : %s\n", failures ? "FAILED" : "passed");
+
+    int wrap_failures = 0;
+    for (int bits : wrap_bits) {
+        if (!checkWraparound(bits) || !checkDiscontinuity(bits))
+            wrap_failures++;
+    }
+    printf("pts wraparound : %s\n", wrap_failures ? "FAILED" : "passed");
+
+    // 64 bit pts without a wraparound
+    PtsTimeline flat(1, 1000, 0);
+    bool flat_ok = flat.unwrap(1LL << 50) == 1LL << 50 && flat.unwrap(3) == 3;
+    flat_ok &= !PtsTimeline::isValid(0, 1000, 33) && !PtsTimeline::isValid(1, 0, 33)
+        && !PtsTimeline::isValid(1, 1000, PTS_MAX_WRAP_BITS + 1);
+    printf("no wraparound, invalid timebases : %s\n", flat_ok ? "passed" : "FAILED");
+
+    return (failures || wrap_failures || !flat_ok) ? 1 : 0;
+}
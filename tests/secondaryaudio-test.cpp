@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+
+// Secondary audio (secondaryaudio.h) mixed into silent main chunks : the samples land at the frame
+// of their pts, late ones are dropped, a packet without pts continues the previous one and
+// without pts on both sides the packets are mixed in feeding order
+//
+//   secondaryaudio-test
+
+#include <stdio.h>
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+#include "secondaryaudio.h"
+
+using namespace NDL_Esplayer;
+
+#define TEST_CHANNELS 2
+#define TEST_RATE 48000
+// 10ms
+#define TEST_FRAMES 480
+
+/**
+ * LPCM decoder of the main layout and rate : the samples come out as they are fed
+ */
+static std::shared_ptr<AudioSwDecoder> openDecoder()
+{
+    auto decoder = std::make_shared<AudioSwDecoder>();
+    decoder->audio_stream_info_.codec_id = AV_CODEC_ID_NONE;
+    decoder->audio_stream_info_.channels = TEST_CHANNELS;
+    decoder->audio_stream_info_.sample_rate = TEST_RATE;
+    decoder->audio_stream_info_.bit_rate = 0;
+    decoder->audio_stream_info_.block_align = 0;
+    decoder->audio_stream_info_.bits_per_coded_sample = 16;
+    AudioLpcmFormat format;
+    if (!decoder->OpenLpcm(format))
+        return nullptr;
+    return decoder;
+}
+
+static std::vector<uint8_t> packet(int16_t value, int frames)
+{
+    std::vector<uint8_t> data;
+    for (int i = 0; i < frames * TEST_CHANNELS; i++) {
+        data.push_back((uint8_t)(value & 0xFF));
+        data.push_back((uint8_t)((value >> 8) & 0xFF));
+    }
+    return data;
+}
+
+static bool push(SecondaryAudio* secondary, int16_t value, int frames, int64_t pts)
+{
+    std::vector<uint8_t> data = packet(value, frames);
+    return secondary->push(data.data(), (int)data.size(), pts) == (int)data.size();
+}
+
+/**
+ * Mix into silent main frames at pts, true if they are value from first to last (excluded) and 0 elsewhere
+ */
+static bool mix(SecondaryAudio* secondary, int frames, int64_t pts, int first, int last, int16_t value)
+{
+    std::vector<int16_t> samples(frames * TEST_CHANNELS, 0);
+    secondary->mix(samples.data(), frames, pts);
+    for (int i = 0; i < frames; i++) {
+        int16_t expected = (i >= first && i < last) ? value : 0;
+        for (int c = 0; c < TEST_CHANNELS; c++) {
+            if (samples[i * TEST_CHANNELS + c] != expected) {
+                printf("frame %d : %d, expected %d\n", i, samples[i * TEST_CHANNELS + c], expected);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool checkAlignment(SecondaryAudio* secondary)
+{
+    secondary->flush();
+    // 5ms after the start of the main chunk, over two chunks
+    bool ok = push(secondary, 100, TEST_FRAMES, 1005000);
+    ok &= mix(secondary, TEST_FRAMES, 1000000, TEST_FRAMES / 2, TEST_FRAMES, 100);
+    ok &= mix(secondary, TEST_FRAMES, 1010000, 0, TEST_FRAMES / 2, 100);
+    ok &= mix(secondary, TEST_FRAMES, 1020000, 0, 0, 0) && !secondary->isActive();
+    // within SECONDARY_AUDIO_SYNC_US : continuous
+    ok &= push(secondary, 50, TEST_FRAMES, 1030000 + SECONDARY_AUDIO_SYNC_US / 2);
+    ok &= mix(secondary, TEST_FRAMES, 1030000, 0, TEST_FRAMES, 50);
+    printf("secondary alignment : %s\n", ok ? "passed" : "FAILED");
+    return ok;
+}
+
+static bool checkLate(SecondaryAudio* secondary)
+{
+    secondary->flush();
+    // its first half is passed
+    bool ok = push(secondary, 100, TEST_FRAMES, 2000000);
+    ok &= mix(secondary, TEST_FRAMES, 2005000, 0, TEST_FRAMES / 2, 100);
+    // all of it is passed
+    ok &= push(secondary, 100, TEST_FRAMES, 3000000);
+    ok &= mix(secondary, TEST_FRAMES, 3100000, 0, 0, 0) && !secondary->isActive();
+    printf("secondary late : %s\n", ok ? "passed" : "FAILED");
+    return ok;
+}
+
+static bool checkNoPts(SecondaryAudio* secondary)
+{
+    secondary->flush();
+    // the packet without pts follows the previous one
+    bool ok = push(secondary, 100, TEST_FRAMES, 4000000);
+    ok &= push(secondary, 200, TEST_FRAMES, -1);
+    ok &= mix(secondary, TEST_FRAMES, 4000000, 0, TEST_FRAMES, 100);
+    ok &= mix(secondary, TEST_FRAMES, 4000000 + TEST_FRAMES * 1000000LL / TEST_RATE, 0, TEST_FRAMES, 200);
+    printf("secondary packet without pts : %s\n", ok ? "passed" : "FAILED");
+    return ok;
+}
+
+/**
+ * Audio only playback : no pts on either side, mixed as fed
+ */
+static bool checkFeedOrder()
+{
+    SecondaryAudio secondary;
+    secondary.open(openDecoder(), TEST_CHANNELS, TEST_RATE);
+    secondary.setMix(100, 100);
+    bool ok = push(&secondary, 100, TEST_FRAMES / 2, -1);
+    ok &= push(&secondary, 100, TEST_FRAMES / 2, -1);
+    ok &= mix(&secondary, TEST_FRAMES / 4, -1, 0, TEST_FRAMES / 4, 100);
+    ok &= mix(&secondary, TEST_FRAMES, -1, 0, TEST_FRAMES * 3 / 4, 100);
+    printf("secondary feeding order : %s\n", ok ? "passed" : "FAILED");
+    return ok;
+}
+
+int main()
+{
+    std::shared_ptr<AudioSwDecoder> decoder = openDecoder();
+    if (!decoder) {
+        printf("secondary lpcm decoder : FAILED\n");
+        return 1;
+    }
+    SecondaryAudio secondary;
+    secondary.open(decoder, TEST_CHANNELS, TEST_RATE);
+    secondary.setMix(100, 100);    // no ducking : the main frames stay silent
+
+    bool ok = checkAlignment(&secondary);
+    ok &= checkLate(&secondary);
+    ok &= checkNoPts(&secondary);
+    ok &= checkFeedOrder();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+
+// Standby audio tracks (standbyaudio.h) spliced over a constant main pcm : the track samples
+// replace the main ones at their pts after a crossfade, the switch back fades to the main audio,
+// and a flush while another thread decodes neither blocks the output nor leaves old samples
+//
+//   standbyaudio-test
+
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "standbyaudio.h"
+#include "ndl-directmedia2/media-common.h"
+
+using namespace NDL_Esplayer;
+
+#define TEST_CHANNELS 2
+#define TEST_RATE 48000
+// 10ms
+#define TEST_FRAMES 480
+#define FADE_FRAMES (TEST_RATE * AUDIO_STANDBY_CROSSFADE_MS / 1000)
+#define MAIN_LEVEL 1000
+#define TRACK_LEVEL 300
+
+/**
+ * LPCM decoder of the main layout and rate : the samples come out as they are fed
+ */
+static std::shared_ptr<AudioSwDecoder> openDecoder()
+{
+    auto decoder = std::make_shared<AudioSwDecoder>();
+    decoder->audio_stream_info_.codec_id = AV_CODEC_ID_NONE;
+    decoder->audio_stream_info_.channels = TEST_CHANNELS;
+    decoder->audio_stream_info_.sample_rate = TEST_RATE;
+    decoder->audio_stream_info_.bit_rate = 0;
+    decoder->audio_stream_info_.block_align = 0;
+    decoder->audio_stream_info_.bits_per_coded_sample = 16;
+    AudioLpcmFormat format;
+    if (!decoder->OpenLpcm(format))
+        return nullptr;
+    return decoder;
+}
+
+static int push(StandbyAudioTracks* tracks, int id, int16_t value, int frames, int64_t pts)
+{
+    std::vector<uint8_t> data;
+    for (int i = 0; i < frames * TEST_CHANNELS; i++) {
+        data.push_back((uint8_t)(value & 0xFF));
+        data.push_back((uint8_t)((value >> 8) & 0xFF));
+    }
+    return tracks->push(id, data.data(), (int)data.size(), pts);
+}
+
+/**
+ * Main frames of MAIN_LEVEL at pts through process, expected(i) gives each frame
+ */
+template <typename Expected>
+static bool process(StandbyAudioTracks* tracks, int frames, int64_t pts, Expected expected)
+{
+    std::vector<int16_t> samples(frames * TEST_CHANNELS, MAIN_LEVEL);
+    tracks->process(samples.data(), frames, TEST_CHANNELS, TEST_RATE, pts);
+    for (int i = 0; i < frames; i++) {
+        for (int c = 0; c < TEST_CHANNELS; c++) {
+            if (samples[i * TEST_CHANNELS + c] != expected(i)) {
+                printf("frame %d : %d, expected %d\n", i, samples[i * TEST_CHANNELS + c], expected(i));
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static int16_t crossfade(int from, int to, int frame)
+{
+    float in = (float)(frame + 1) / FADE_FRAMES;
+    return (int16_t)lrintf(from * (1.0f - in) + to * in);
+}
+
+/**
+ * The track starts 5ms into the chunk after the switch : the crossfade runs on the main audio
+ * until then, the track replaces it from its first sample
+ */
+static bool checkSplice()
+{
+    StandbyAudioTracks tracks;
+    int id = tracks.add(openDecoder(), TEST_CHANNELS, TEST_RATE);
+    const int start = TEST_FRAMES / 2;
+    bool ok = id > 0 && push(&tracks, id, TRACK_LEVEL, TEST_FRAMES * 3, 1005000) > 0;
+    // not selected : the main audio stays
+    ok &= process(&tracks, TEST_FRAMES, 990000, [] (int) { return MAIN_LEVEL; });
+
+    ok &= tracks.select(id) == NDL_ESP_RESULT_SUCCESS;
+    ok &= process(&tracks, TEST_FRAMES, 1000000, [start] (int i) {
+            return i < start ? crossfade(MAIN_LEVEL, MAIN_LEVEL, i) : crossfade(MAIN_LEVEL, TRACK_LEVEL, i);
+            });
+    ok &= process(&tracks, TEST_FRAMES, 1010000, [] (int) { return TRACK_LEVEL; });
+    printf("standby splice : %s\n", ok ? "passed" : "FAILED");
+
+    // back to the main audio : crossfade from the track
+    bool back = tracks.select(0) == NDL_ESP_RESULT_SUCCESS;
+    back &= process(&tracks, TEST_FRAMES, 1020000, [] (int i) { return crossfade(TRACK_LEVEL, MAIN_LEVEL, i); });
+    back &= process(&tracks, TEST_FRAMES, 1030000, [] (int) { return MAIN_LEVEL; });
+    printf("standby crossfade back : %s\n", back ? "passed" : "FAILED");
+    return ok && back;
+}
+
+/**
+ * A thread decodes into the selected track while the output processes chunks and flushes :
+ * process and flush do not wait on each other, nothing from before the last flush is spliced
+ */
+static bool checkFlushInFlight()
+{
+    StandbyAudioTracks tracks;
+    int id = tracks.add(openDecoder(), TEST_CHANNELS, TEST_RATE);
+    bool ok = id > 0 && tracks.select(id) == NDL_ESP_RESULT_SUCCESS;
+
+    std::atomic<bool> stop(false);
+    std::thread feeder([&tracks, &stop, id] {
+            int64_t pts = 0;
+            while (!stop) {
+                int ret = push(&tracks, id, TRACK_LEVEL, TEST_FRAMES, pts);
+                if (ret == NDL_ESP_RESULT_FEED_FULL)
+                    std::this_thread::yield();
+                else
+                    pts += 10000;
+            }
+            });
+
+    int64_t pts = 0;
+    for (int i = 0; i < 2000; i++) {
+        std::vector<int16_t> samples(TEST_FRAMES * TEST_CHANNELS, MAIN_LEVEL);
+        tracks.process(samples.data(), TEST_FRAMES, TEST_CHANNELS, TEST_RATE, pts);
+        pts += 10000;
+        if (i % 10 == 0)
+            tracks.flush();
+    }
+    stop = true;
+    feeder.join();
+
+    tracks.flush();
+    // nothing left after the flush : the main audio stays until the track is fed again
+    ok &= process(&tracks, TEST_FRAMES, 100000000, [] (int) { return MAIN_LEVEL; });
+    ok &= push(&tracks, id, TRACK_LEVEL, TEST_FRAMES, 100010000) > 0;
+    ok &= process(&tracks, TEST_FRAMES, 100010000, [] (int) { return TRACK_LEVEL; });
+    printf("standby flush during decode : %s\n", ok ? "passed" : "FAILED");
+    return ok;
+}
+
+int main()
+{
+    bool ok = checkSplice();
+    ok &= checkFlushInFlight();
+    return ok ? 0 : 1;
+}
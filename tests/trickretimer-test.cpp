@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+
+// TrickRetimer (trickretimer.h) : pts of the key frames in I-frame trick play, forward and backward,
+// the key frames closer than TRICK_MIN_INTERVAL_US skipped, continuity over a rate change and flush
+//
+//   trickretimer-test
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+
+#include "trickretimer.h"
+
+using namespace NDL_Esplayer;
+
+#define KEY_INTERVAL_US 500000
+#define START_PTS_US    10000000LL
+
+/**
+ * Retime count key frames from pts, KEY_INTERVAL_US apart (backward if step < 0),
+ * the skipped ones give -1
+ */
+static std::vector<int64_t> retime(TrickRetimer& retimer, int64_t pts, int step, int count)
+{
+    std::vector<int64_t> out;
+    for (int i = 0; i < count; i++, pts += step * KEY_INTERVAL_US) {
+        int64_t retimed = pts;
+        out.push_back(retimer.retime(&retimed) ? retimed : -1);
+    }
+    return out;
+}
+
+static bool checkForward()
+{
+    // 4x : the key frames 125 ms apart from the first one
+    TrickRetimer retimer;
+    retimer.setRate(4 * TRICK_NORMAL_RATE);
+    std::vector<int64_t> out = retime(retimer, START_PTS_US, 1, 8);
+    bool ok = true;
+    for (size_t i = 0; i < out.size(); i++)
+        ok &= out[i] == START_PTS_US + (int64_t)i * KEY_INTERVAL_US / 4;
+    printf("forward 4x : %s\n", ok ? "passed" : "FAILED");
+    return ok;
+}
+
+static bool checkBackward()
+{
+    // -2x : key frames fed in reverse order, retimed forward 250 ms apart
+    TrickRetimer retimer;
+    retimer.setRate(-2 * TRICK_NORMAL_RATE);
+    std::vector<int64_t> out = retime(retimer, START_PTS_US, -1, 8);
+    bool ok = true;
+    for (size_t i = 0; i < out.size(); i++)
+        ok &= out[i] == START_PTS_US + (int64_t)i * KEY_INTERVAL_US / 2;
+    printf("backward -2x : %s\n", ok ? "passed" : "FAILED");
+    return ok;
+}
+
+static bool checkMinInterval()
+{
+    // 16x : 31.25 ms apart, every other key frame skipped, the kept ones on the timeline of the rate
+    TrickRetimer retimer;
+    retimer.setRate(16 * TRICK_NORMAL_RATE);
+    std::vector<int64_t> out = retime(retimer, START_PTS_US, 1, 9);
+    bool ok = true;
+    for (size_t i = 0; i < out.size(); i++)
+        ok &= out[i] == (i % 2 ? -1 : START_PTS_US + (int64_t)i * KEY_INTERVAL_US / 16);
+
+    // -32x : 15.6 ms apart, 2 of 3 skipped
+    retimer.setRate(0);
+    retimer.setRate(-32 * TRICK_NORMAL_RATE);
+    out = retime(retimer, START_PTS_US, -1, 10);
+    int64_t last = -1;
+    int kept = 0;
+    for (int64_t pts : out) {
+        if (pts < 0)
+            continue;
+        ok &= last < 0 || pts - last >= TRICK_MIN_INTERVAL_US;
+        last = pts;
+        kept++;
+    }
+    ok &= kept == 4;
+    printf("minimum interval : %s\n", ok ? "passed" : "FAILED");
+    return ok;
+}
+
+static bool checkRateChange()
+{
+    TrickRetimer retimer;
+    retimer.setRate(4 * TRICK_NORMAL_RATE);
+    std::vector<int64_t> out = retime(retimer, START_PTS_US, 1, 4);
+    const int64_t last = out.back();
+
+    // 8x from the next key frame, TRICK_MIN_INTERVAL_US after the last one retimed
+    retimer.setRate(8 * TRICK_NORMAL_RATE);
+    const int64_t next_pts = START_PTS_US + 4 * KEY_INTERVAL_US;
+    out = retime(retimer, next_pts, 1, 4);
+    bool ok = retimer.getRate() == 8 * TRICK_NORMAL_RATE;
+    for (size_t i = 0; i < out.size(); i++)
+        ok &= out[i] == last + TRICK_MIN_INTERVAL_US + (int64_t)i * KEY_INTERVAL_US / 8;
+
+    // backward from there
+    const int64_t turn = out.back();
+    retimer.setRate(-4 * TRICK_NORMAL_RATE);
+    out = retime(retimer, next_pts + 3 * KEY_INTERVAL_US, -1, 3);
+    for (size_t i = 0; i < out.size(); i++)
+        ok &= out[i] == turn + TRICK_MIN_INTERVAL_US + (int64_t)i * KEY_INTERVAL_US / 4;
+    printf("rate change : %s\n", ok ? "passed" : "FAILED");
+    return ok;
+}
+
+static bool checkResetAndOff()
+{
+    // flush : the next key frame starts again at its own pts
+    TrickRetimer retimer;
+    retimer.setRate(4 * TRICK_NORMAL_RATE);
+    retime(retimer, START_PTS_US, 1, 4);
+    retimer.reset();
+    std::vector<int64_t> out = retime(retimer, 2 * START_PTS_US, 1, 2);
+    bool ok = retimer.getRate() == 4 * TRICK_NORMAL_RATE && out[0] == 2 * START_PTS_US &&
+        out[1] == 2 * START_PTS_US + KEY_INTERVAL_US / 4;
+
+    // off : pts kept, the timing forgotten for the next trick play
+    retimer.setRate(0);
+    out = retime(retimer, START_PTS_US, 1, 2);
+    ok &= retimer.getRate() == 0 && out[0] == START_PTS_US && out[1] == START_PTS_US + KEY_INTERVAL_US;
+    retimer.setRate(2 * TRICK_NORMAL_RATE + 500);
+    out = retime(retimer, 3 * START_PTS_US, 1, 1);
+    ok &= out[0] == 3 * START_PTS_US;
+    printf("flush and off : %s\n", ok ? "passed" : "FAILED");
+    return ok;
+}
+
+int main()
+{
+    bool ok = checkForward();
+    ok &= checkBackward();
+    ok &= checkMinInterval();
+    ok &= checkRateChange();
+    ok &= checkResetAndOff();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) 2008-2018 LG Electronics, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+// Throughput of the Annex-B access unit splitter (MB/s) over synthetic H.264/HEVC byte streams
+// cut into TS sized chunks, and of the start code scan alone, with each scan kernel the cpu has.
+// The access units found and their frame types are checked against the ones written,
+// also for an HEVC stream of 3 temporal sub-layers.
+//
+//   videoparser-bench [repeat count]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <vector>
+
+#include "parser/videoparser.h"
+#include "ndl-directmedia2/media-common.h"
+
+using namespace NDL_Esplayer;
+
+// payload of 7 TS packets, as a demuxer gives a PES
+#define BENCH_CHUNK_SIZE        1316
+#define BENCH_STREAM_FRAMES     600
+#define BENCH_GOP_SIZE          30
+#define BENCH_SLICES            2
+
+struct AccessUnitInfo {
+    unsigned int size;
+    uint32_t flags;
+};
+
+struct Stream {
+    const char* name;
+    NDL_ESP_VIDEO_CODEC codec;
+    std::vector<unsigned char> data;
+    std::vector<AccessUnitInfo> units;
+    int nals;
+    int sub_layers;     // HEVC temporal sub-layers
+};
+
+static int64_t current_time_ns()
+{
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+/**
+ * NAL with a random payload, emulation prevented as an encoder writes it
+ */
+static void appendNal(Stream* stream, bool long_start_code, const unsigned char* header, int header_size, int size)
+{
+    static const unsigned char start_code[4] = {0, 0, 0, 1};
+    stream->data.insert(stream->data.end(), start_code + (long_start_code ? 0 : 1), start_code + 4);
+    stream->data.insert(stream->data.end(), header, header + header_size);
+
+    int zeros = 0;
+    for (int i = header_size; i < size - 1; i++) {
+        // slice data has many zero bytes
+        unsigned char byte = (rand() % 4 == 0) ? 0 : (unsigned char)rand();
+        if (zeros == 2 && byte <= 3) {
+            stream->data.push_back(3);
+            zeros = 0;
+        }
+        stream->data.push_back(byte);
+        zeros = byte == 0 ? zeros + 1 : 0;
+    }
+    stream->data.push_back(0x80);   // rbsp_stop_one_bit
+    stream->nals++;
+}
+
+static void appendAccessUnit(Stream* stream, int index)
+{
+    const bool hevc = (stream->codec == NDL_ESP_VIDEO_CODEC_H265);
+    const bool key = (index % BENCH_GOP_SIZE == 0);
+    // IBBPBBP.. in decoding order : P, B, B.
+    // HEVC sub-layers : P in the lowest one, the first B in the one above (referenced by the second B
+    // when there are 3), the second B in the highest one
+    const int temporal_id = (key || index % 3 == 1) ? 0 :
+        (index % 3 == 2 ? std::min(1, stream->sub_layers - 1) : stream->sub_layers - 1);
+    const bool reference = key || (index % 3 == 1) || (hevc && temporal_id < stream->sub_layers - 1);
+    const int slice_size = key ? 20000 : (reference ? 4000 : 1000) + rand() % 1000;
+    const size_t start = stream->data.size();
+
+    if (hevc) {
+        if (key) {
+            for (int type = 32; type <= 34; type++) {
+                // SPS : sps_max_sub_layers_minus1, sps_temporal_id_nesting_flag
+                const unsigned char header[3] = {(unsigned char)(type << 1), 1,
+                    (unsigned char)(type == 33 ? ((stream->sub_layers - 1) << 1) | 1 : 0x0C)};
+                appendNal(stream, stream->data.size() == start, header, 3, 30);
+            }
+        }
+        const unsigned char sei[2] = {39 << 1, 1};
+        appendNal(stream, stream->data.size() == start, sei, 2, 20);
+        // IDR_W_RADL, TRAIL_R or TRAIL_N
+        const int type = key ? 19 : (index % 3 == 1 ? 1 : 0);
+        for (int slice = 0; slice < BENCH_SLICES; slice++) {
+            const unsigned char header[3] = {(unsigned char)(type << 1), (unsigned char)(temporal_id + 1),
+                (unsigned char)(slice == 0 ? 0xC0 : 0x40)};
+            appendNal(stream, false, header, 3, slice_size);
+        }
+        const unsigned char suffix_sei[2] = {40 << 1, 1};
+        appendNal(stream, false, suffix_sei, 2, 20);
+    } else {
+        const unsigned char aud[2] = {0x09, 0xF0};
+        appendNal(stream, true, aud, 2, 2);
+        if (key) {
+            const unsigned char sps[1] = {0x67};
+            const unsigned char pps[1] = {0x68};
+            appendNal(stream, false, sps, 1, 30);
+            appendNal(stream, false, pps, 1, 8);
+        }
+        // nal_ref_idc 3 for IDR, 2 for P, 0 for B
+        const unsigned char nal = key ? 0x65 : (reference ? 0x41 : 0x01);
+        for (int slice = 0; slice < BENCH_SLICES; slice++) {
+            const unsigned char header[2] = {nal, (unsigned char)(slice == 0 ? 0x88 : 0x40)};
+            appendNal(stream, false, header, 2, slice_size);
+        }
+    }
+
+    AccessUnitInfo info;
+    info.size = stream->data.size() - start;
+    info.flags = (key ? NDL_ESP_FLAG_KEY_FRAME : 0) | (reference ? 0 : NDL_ESP_FLAG_NON_REFERENCE);
+    stream->units.push_back(info);
+}
+
+static void buildStream(Stream* stream)
+{
+    srand(1);
+    // joined in the middle of a byte stream : dropped up to the first start code
+    for (int i = 0; i < 100; i++)
+        stream->data.push_back((unsigned char)(rand() % 255 + 1));
+    for (int i = 0; i < BENCH_STREAM_FRAMES; i++)
+        appendAccessUnit(stream, i);
+}
+
+/**
+ * Split the stream in chunks (the first one of first_chunk bytes),
+ * return the ns taken or -1 if the access units differ from the ones written
+ * (check_data : their bytes too, views into a chunk or stitched ones)
+ */
+static int64_t parseStream(const Stream& stream, CPU_SIMD simd, size_t first_chunk = BENCH_CHUNK_SIZE,
+        bool check_data = false)
+{
+    std::shared_ptr<videoparser> video_parser = createVideoParser(stream.codec, simd);
+    if (!video_parser)
+        return -1;
+
+    std::vector<AccessUnitInfo> units;
+    units.reserve(stream.units.size());
+    videoparser::AccessUnit au;
+    size_t offset = stream.data.size();
+    for (const AccessUnitInfo& unit : stream.units)
+        offset -= unit.size;
+    bool same_data = true;
+
+    int64_t start = current_time_ns();
+    for (size_t pos = 0, len = first_chunk; pos < stream.data.size(); pos += len, len = BENCH_CHUNK_SIZE) {
+        len = std::min(len, stream.data.size() - pos);
+        video_parser->push(stream.data.data() + pos, len);
+        if (pos + len >= stream.data.size())
+            video_parser->end();
+        while (video_parser->next(&au)) {
+            units.push_back({au.size, au.flags});
+            if (check_data) {
+                same_data = same_data && offset + au.size <= stream.data.size() &&
+                    memcmp(au.data, stream.data.data() + offset, au.size) == 0;
+                offset += au.size;
+            }
+        }
+    }
+    int64_t elapsed = current_time_ns() - start;
+
+    bool same = same_data && units.size() == stream.units.size();
+    for (size_t i = 0; same && i < units.size(); i++)
+        same = units[i].size == stream.units[i].size && units[i].flags == stream.units[i].flags;
+    if (!same) {
+        printf("%s (%s) : %zu access units of %zu\n", stream.name, cpuSimdName(simd),
+                units.size(), stream.units.size());
+        return -1;
+    }
+    return elapsed;
+}
+
+/**
+ * First chunk cut around the first start code (00 00 00 01 67 | ..) : the first access unit is kept whole,
+ * return false if one cut loses it
+ */
+static bool parseSplitStartCode(const Stream& stream, CPU_SIMD simd)
+{
+    size_t code = 0;
+    while (code + 3 < stream.data.size() && !(stream.data[code] == 0 && stream.data[code + 1] == 0 &&
+                stream.data[code + 2] == 0 && stream.data[code + 3] == 1))
+        code++;
+
+    for (size_t cut = code + 1; cut <= code + 6; cut++) {
+        if (parseStream(stream, simd, cut, true) < 0) {
+            printf("%s (%s) : first chunk cut at %zu of the start code\n", stream.name, cpuSimdName(simd),
+                    cut - code);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Scan kernel alone over the stream, return the ns taken or -1 if it misses a start code
+ */
+static int64_t scanStream(StartCodeScanFunc scan, const Stream& stream)
+{
+    const unsigned char* data = stream.data.data();
+    const unsigned int len = stream.data.size();
+    int found = 0;
+
+    int64_t start = current_time_ns();
+    unsigned int pos = 0;
+    while (pos < len) {
+        int offset = scan(data + pos, len - pos);
+        if (offset < 0)
+            break;
+        found++;
+        pos += offset + 3;
+    }
+    int64_t elapsed = current_time_ns() - start;
+    return found == stream.nals ? elapsed : -1;
+}
+
+int main(int argc, char* argv[])
+{
+    int repeat = argc > 1 ? std::max(atoi(argv[1]), 1) : 20;
+
+    Stream streams[] = {
+        {"h264", NDL_ESP_VIDEO_CODEC_H264, {}, {}, 0, 1},
+        {"hevc", NDL_ESP_VIDEO_CODEC_H265, {}, {}, 0, 1},
+        {"hevc 3 sub-layers", NDL_ESP_VIDEO_CODEC_H265, {}, {}, 0, 3},
+    };
+    for (Stream& stream : streams)
+        buildStream(&stream);
+
+    int failed = 0;
+    for (int simd = CPU_SIMD_SCALAR; simd <= CPU_SIMD_NEON; simd++) {
+        StartCodeScanFunc scan = getStartCodeScanFunc((CPU_SIMD)simd);
+        if (!scan)
+            continue;
+        const char* name = cpuSimdName((CPU_SIMD)simd);
+
+        for (Stream& stream : streams) {
+            int64_t scan_ns = 0;
+            int64_t total_ns = 0;
+            for (int i = 0; i < repeat && scan_ns >= 0 && total_ns >= 0; i++) {
+                int64_t ns = scanStream(scan, stream);
+                scan_ns = ns < 0 ? -1 : scan_ns + ns;
+                ns = parseStream(stream, (CPU_SIMD)simd);
+                total_ns = ns < 0 ? -1 : total_ns + ns;
+            }
+            if (scan_ns < 0) {
+                printf("%-6s %s start code scan missed start codes\n", name, stream.name);
+                failed++;
+                continue;
+            }
+            if (total_ns < 0 || !parseSplitStartCode(stream, (CPU_SIMD)simd)) {
+                failed++;
+                continue;
+            }
+            double mb = (double)stream.data.size() * repeat / 1e6;
+            printf("%-6s %s scan  : %8.1f MB/s, %d NAL units\n", name, stream.name, mb / (scan_ns / 1e9), stream.nals);
+            printf("%-6s %s split : %8.1f MB/s, %zu access units\n", name, stream.name, mb / (total_ns / 1e9),
+                    stream.units.size());
+        }
+    }
+    return failed ? 1 : 0;
+}